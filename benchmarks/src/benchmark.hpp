@@ -0,0 +1,342 @@
+#ifndef VIENNAMESH_BENCHMARKS_BENCHMARK_HPP
+#define VIENNAMESH_BENCHMARKS_BENCHMARK_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "viennameshpp/core.hpp"
+
+namespace viennamesh
+{
+  namespace benchmark
+  {
+    // size levels every scenario is run at
+    inline std::vector<std::string> const & size_names()
+    {
+      static std::vector<std::string> names = {"small", "medium", "large"};
+      return names;
+    }
+
+
+    // The timed step of a scenario, returns the amount of work done in the scenario's work unit
+    // (usually cells). Inputs are prepared before, so only the step itself is measured.
+    typedef std::function<long ()> timed_step;
+
+    struct scenario
+    {
+      std::string name;
+      std::string work_unit;
+
+      // prepares the inputs of a size level (index into size_names) and returns the timed step
+      std::function<timed_step (viennamesh::context_handle &, int)> prepare;
+    };
+
+
+    struct result
+    {
+      result() : size_level(0), work(0), peak_rss(0), success(false) {}
+
+      std::string scenario;
+      std::string work_unit;
+      int size_level;
+
+      long work;
+      std::vector<double> latencies;   // seconds per repetition
+      long peak_rss;                   // KiB, peak resident set size of the process running the scenario
+      bool success;
+      std::string message;
+
+      std::string key() const { return scenario + "/" + size_names()[size_level]; }
+
+      // nearest rank percentile of the latencies in milliseconds
+      double percentile(double p) const
+      {
+        if (latencies.empty())
+          return 0.0;
+
+        std::vector<double> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        std::size_t rank = static_cast<std::size_t>( std::ceil(p / 100.0 * sorted.size()) );
+        return 1000.0 * sorted[ std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1 ];
+      }
+
+      double mean() const
+      {
+        double sum = 0.0;
+        for (std::size_t i = 0; i != latencies.size(); ++i)
+          sum += latencies[i];
+        return latencies.empty() ? 0.0 : 1000.0 * sum / latencies.size();
+      }
+
+      double throughput() const
+      {
+        double median = percentile(50.0) / 1000.0;
+        return median > 0.0 ? work / median : 0.0;
+      }
+    };
+
+
+
+    // Runs one scenario at one size in a child process. Every scenario starts with a fresh heap
+    // and loaded plugins, so the peak RSS reported by the kernel for the child is the scenario's.
+    inline result run_isolated(scenario const & s, int size_level, int warmup_count, int repetition_count)
+    {
+      result r;
+      r.scenario = s.name;
+      r.work_unit = s.work_unit;
+      r.size_level = size_level;
+
+      int fds[2];
+      if (pipe(fds) != 0)
+      {
+        r.message = "pipe failed";
+        return r;
+      }
+
+      std::cout.flush();
+      pid_t pid = fork();
+      if (pid < 0)
+      {
+        close(fds[0]);
+        close(fds[1]);
+        r.message = "fork failed";
+        return r;
+      }
+
+      if (pid == 0)
+      {
+        close(fds[0]);
+        std::ostringstream out;
+        out.precision(17);
+
+        try
+        {
+          viennamesh::context_handle context;
+          timed_step step = s.prepare(context, size_level);
+
+          for (int i = 0; i < warmup_count; ++i)
+            step();
+
+          long work = 0;
+          std::vector<double> latencies;
+          for (int i = 0; i < repetition_count; ++i)
+          {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            work = step();
+            latencies.push_back( std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() );
+          }
+
+          out << "ok " << work;
+          for (std::size_t i = 0; i != latencies.size(); ++i)
+            out << " " << latencies[i];
+        }
+        catch (std::exception const & e)
+        {
+          out << "error " << e.what();
+        }
+
+        std::string message = out.str();
+        ssize_t written = write(fds[1], message.c_str(), message.size());
+        close(fds[1]);
+        _exit( (written == static_cast<ssize_t>(message.size())) ? 0 : 1 );
+      }
+
+      close(fds[1]);
+      std::string message;
+      char buffer[4096];
+      ssize_t count;
+      while ((count = read(fds[0], buffer, sizeof(buffer))) > 0)
+        message.append(buffer, count);
+      close(fds[0]);
+
+      int status = 0;
+      rusage usage;
+      wait4(pid, &status, 0, &usage);
+      r.peak_rss = usage.ru_maxrss;
+
+      std::istringstream in(message);
+      std::string state;
+      in >> state;
+      if (state == "ok" && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+      {
+        in >> r.work;
+        double latency;
+        while (in >> latency)
+          r.latencies.push_back(latency);
+        r.success = !r.latencies.empty();
+      }
+      else if (state == "error")
+        std::getline(in >> std::ws, r.message);
+      else
+        r.message = "scenario process terminated abnormally";
+
+      return r;
+    }
+
+
+
+    inline std::string escape_json(std::string const & str)
+    {
+      std::string escaped;
+      for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+      {
+        if (*it == '"' || *it == '\\')
+          escaped += '\\';
+        if (static_cast<unsigned char>(*it) >= 0x20)
+          escaped += *it;
+      }
+      return escaped;
+    }
+
+    inline bool write_json(std::string const & filename, std::vector<result> const & results,
+                           int warmup_count, int repetition_count, int thread_count)
+    {
+      std::ofstream out(filename.c_str());
+      if (!out)
+        return false;
+
+      out << std::fixed << std::setprecision(6);
+      out << "{\n";
+      out << "  \"version\": 1,\n";
+      out << "  \"warmup_runs\": " << warmup_count << ",\n";
+      out << "  \"repetitions\": " << repetition_count << ",\n";
+      out << "  \"threads\": " << thread_count << ",\n";
+      out << "  \"results\": [\n";
+
+      for (std::size_t i = 0; i != results.size(); ++i)
+      {
+        result const & r = results[i];
+        out << "    {\"key\": \"" << escape_json(r.key()) << "\", \"scenario\": \"" << escape_json(r.scenario) << "\""
+            << ", \"size\": \"" << size_names()[r.size_level] << "\", \"success\": " << (r.success ? "true" : "false");
+
+        if (r.success)
+        {
+          out << ", \"work\": " << r.work << ", \"work_unit\": \"" << escape_json(r.work_unit) << "\""
+              << ", \"latency_ms\": {\"min\": " << r.percentile(0.0) << ", \"mean\": " << r.mean()
+              << ", \"p50\": " << r.percentile(50.0) << ", \"p90\": " << r.percentile(90.0)
+              << ", \"p99\": " << r.percentile(99.0) << ", \"max\": " << r.percentile(100.0) << "}"
+              << ", \"throughput_per_s\": " << r.throughput();
+        }
+        else
+          out << ", \"message\": \"" << escape_json(r.message) << "\"";
+
+        out << ", \"peak_rss_kib\": " << r.peak_rss << "}" << (i+1 != results.size() ? "," : "") << "\n";
+      }
+
+      out << "  ]\n}\n";
+      return true;
+    }
+
+
+
+    struct baseline_entry
+    {
+      baseline_entry() : p50(0.0), peak_rss(0) {}
+
+      double p50;   // ms
+      long peak_rss;  // KiB
+    };
+
+    // reads the median latencies and peak memory of a results file written by write_json
+    inline bool read_baseline(std::string const & filename, std::map<std::string, baseline_entry> & baseline)
+    {
+      boost::property_tree::ptree tree;
+      try
+      {
+        boost::property_tree::read_json(filename, tree);
+      }
+      catch (boost::property_tree::json_parser_error const & e)
+      {
+        viennamesh::error(1) << "Could not read baseline \"" << filename << "\": " << e.what() << std::endl;
+        return false;
+      }
+
+      boost::property_tree::ptree const & results = tree.get_child("results", boost::property_tree::ptree());
+      for (boost::property_tree::ptree::const_iterator it = results.begin(); it != results.end(); ++it)
+      {
+        if (!it->second.get<bool>("success", false))
+          continue;
+
+        baseline_entry entry;
+        entry.p50 = it->second.get<double>("latency_ms.p50", 0.0);
+        entry.peak_rss = it->second.get<long>("peak_rss_kib", 0);
+        baseline[ it->second.get<std::string>("key", "") ] = entry;
+      }
+
+      return true;
+    }
+
+
+    // Prints the change of every result against the baseline, returns the number of regressions.
+    // A result regresses if its median latency or its peak memory exceeds the baseline by more
+    // than tolerance (relative).
+    inline int compare(std::vector<result> const & results, std::map<std::string, baseline_entry> const & baseline, double tolerance)
+    {
+      int regressions = 0;
+
+      std::cout << std::endl << "Comparison against baseline (tolerance " << 100.0*tolerance << "%)" << std::endl;
+      std::cout << std::left << std::setw(40) << "  scenario" << std::right
+                << std::setw(14) << "p50 [ms]" << std::setw(14) << "baseline" << std::setw(10) << "change"
+                << std::setw(12) << "rss change" << "  status" << std::endl;
+
+      for (std::size_t i = 0; i != results.size(); ++i)
+      {
+        result const & r = results[i];
+        std::map<std::string, baseline_entry>::const_iterator it = baseline.find( r.key() );
+        if (!r.success || it == baseline.end() || it->second.p50 <= 0.0)
+        {
+          std::cout << std::left << std::setw(40) << ("  " + r.key()) << std::right << "  "
+                    << (r.success ? "not in baseline" : "FAILED") << std::endl;
+          continue;
+        }
+
+        double time_change = r.percentile(50.0) / it->second.p50 - 1.0;
+        double rss_change = (it->second.peak_rss > 0) ? static_cast<double>(r.peak_rss) / it->second.peak_rss - 1.0 : 0.0;
+
+        bool regression = time_change > tolerance || rss_change > tolerance;
+        if (regression)
+          ++regressions;
+
+        std::cout << std::left << std::setw(40) << ("  " + r.key()) << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(14) << r.percentile(50.0) << std::setw(14) << it->second.p50
+                  << std::setw(9) << 100.0*time_change << "%" << std::setw(11) << 100.0*rss_change << "%"
+                  << "  " << (regression ? "REGRESSION" : "ok") << std::endl;
+      }
+
+      return regressions;
+    }
+  }
+}
+
+#endif
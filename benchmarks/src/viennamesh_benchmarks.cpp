@@ -0,0 +1,483 @@
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <omp.h>
+
+#include "benchmark.hpp"
+#include "viennameshpp/sizing_function.hpp"
+#include "boost/algorithm/string.hpp"
+#include <tclap/CmdLine.h>
+
+#ifndef VIENNAMESH_BENCHMARK_DATA_DIRECTORY
+#define VIENNAMESH_BENCHMARK_DATA_DIRECTORY "../examples/data"
+#endif
+
+typedef viennagrid::mesh                                          MeshType;
+typedef viennagrid::result_of::element<MeshType>::type            VertexType;
+typedef viennagrid::result_of::const_cell_range<MeshType>::type   ConstCellRangeType;
+
+
+// directories of the scenario inputs and of files written by scenarios
+std::string data_directory = VIENNAMESH_BENCHMARK_DATA_DIRECTORY;
+std::string work_directory = ".";
+int thread_count = 1;
+
+
+long cell_count(MeshType const & mesh)
+{
+  ConstCellRangeType cells(mesh);
+  return cells.size();
+}
+
+
+// Structured tetrahedral mesh of the unit cube, every one of the n^3 sub cubes is split into
+// 6 tetrahedra. Cells with a centroid x < 0.5 are in region 0, the others in region 1.
+void make_tetrahedral_box(MeshType mesh, int n)
+{
+  std::vector<VertexType> vertices;
+  vertices.reserve( (n+1)*(n+1)*(n+1) );
+
+  for (int k = 0; k <= n; ++k)
+    for (int j = 0; j <= n; ++j)
+      for (int i = 0; i <= n; ++i)
+        vertices.push_back( viennagrid::make_vertex(mesh, viennagrid::make_point(double(i)/n, double(j)/n, double(k)/n)) );
+
+  // the 6 tetrahedra of a cube along its diagonal from corner 0 to corner 7
+  static const int tetrahedra[6][4] = { {0,1,3,7}, {0,3,2,7}, {0,2,6,7}, {0,6,4,7}, {0,4,5,7}, {0,5,1,7} };
+
+  for (int k = 0; k != n; ++k)
+    for (int j = 0; j != n; ++j)
+      for (int i = 0; i != n; ++i)
+      {
+        VertexType corners[8];
+        for (int c = 0; c != 8; ++c)
+          corners[c] = vertices[ (k + (c>>2&1))*(n+1)*(n+1) + (j + (c>>1&1))*(n+1) + i + (c&1) ];
+
+        int region_id = (2*i < n) ? 0 : 1;
+        for (int t = 0; t != 6; ++t)
+        {
+          viennagrid::add( mesh.get_or_create_region(region_id),
+                           viennagrid::make_tetrahedron(mesh, corners[tetrahedra[t][0]], corners[tetrahedra[t][1]],
+                                                              corners[tetrahedra[t][2]], corners[tetrahedra[t][3]]) );
+        }
+      }
+}
+
+// structured triangle mesh of the unit square with n^2 sub squares, each split into 2 triangles
+void make_triangle_square(MeshType mesh, int n)
+{
+  std::vector<VertexType> vertices;
+  vertices.reserve( (n+1)*(n+1) );
+
+  for (int j = 0; j <= n; ++j)
+    for (int i = 0; i <= n; ++i)
+      vertices.push_back( viennagrid::make_vertex(mesh, viennagrid::make_point(double(i)/n, double(j)/n)) );
+
+  for (int j = 0; j != n; ++j)
+    for (int i = 0; i != n; ++i)
+    {
+      int v = j*(n+1) + i;
+      viennagrid::make_triangle(mesh, vertices[v], vertices[v+1], vertices[v+n+2]);
+      viennagrid::make_triangle(mesh, vertices[v], vertices[v+n+2], vertices[v+n+1]);
+    }
+}
+
+
+viennamesh::data_handle<viennagrid_mesh> make_tetrahedral_box(viennamesh::context_handle & context, int n)
+{
+  viennamesh::data_handle<viennagrid_mesh> mesh = context.make_data<viennagrid_mesh>();
+  make_tetrahedral_box(mesh(), n);
+  return mesh;
+}
+
+
+
+// sub cubes per axis of the structured tetrahedral meshes for the size levels
+static const int box_resolution[3] = {10, 20, 40};
+
+
+// writes the structured tetrahedral mesh to a file with the given extension
+viennamesh::benchmark::scenario make_write_scenario(std::string const & extension)
+{
+  using viennamesh::benchmark::scenario;
+  using viennamesh::benchmark::timed_step;
+
+  scenario s;
+  s.name = "write_" + extension;
+  s.work_unit = "cells";
+  s.prepare = [extension](viennamesh::context_handle & context, int size_level) -> timed_step
+  {
+    viennamesh::data_handle<viennagrid_mesh> mesh = make_tetrahedral_box(context, box_resolution[size_level]);
+    std::string filename = work_directory + "/benchmark_write." + extension;
+
+    return [context, mesh, filename]() mutable
+    {
+      viennamesh::algorithm_handle writer = context.make_algorithm("mesh_writer");
+      writer.set_input( "mesh", mesh );
+      writer.set_input( "filename", filename );
+      writer.run();
+      return cell_count(mesh());
+    };
+  };
+  return s;
+}
+
+// reads the structured tetrahedral mesh from a file with the given extension, written beforehand
+viennamesh::benchmark::scenario make_read_scenario(std::string const & extension)
+{
+  using viennamesh::benchmark::scenario;
+  using viennamesh::benchmark::timed_step;
+
+  scenario s;
+  s.name = "read_" + extension;
+  s.work_unit = "cells";
+  s.prepare = [extension](viennamesh::context_handle & context, int size_level) -> timed_step
+  {
+    std::string filename = work_directory + "/benchmark_read." + extension;
+
+    viennamesh::algorithm_handle writer = context.make_algorithm("mesh_writer");
+    writer.set_input( "mesh", make_tetrahedral_box(context, box_resolution[size_level]) );
+    writer.set_input( "filename", filename );
+    writer.run();
+
+    return [context, filename]() mutable
+    {
+      viennamesh::algorithm_handle reader = context.make_algorithm("mesh_reader");
+      reader.set_input( "filename", filename );
+      reader.run();
+      return cell_count( reader.get_output<viennagrid_mesh>("mesh")() );
+    };
+  };
+  return s;
+}
+
+
+std::vector<viennamesh::benchmark::scenario> make_scenarios()
+{
+  using viennamesh::benchmark::scenario;
+  using viennamesh::benchmark::timed_step;
+
+  std::vector<scenario> scenarios;
+
+  // the native binary format (.vmb) is compared against VTK XML (.vtu) on the same meshes
+  scenarios.push_back( make_write_scenario("vtu") );
+  scenarios.push_back( make_read_scenario("vtu") );
+  scenarios.push_back( make_write_scenario("vmb") );
+  scenarios.push_back( make_read_scenario("vmb") );
+
+  {
+    scenario s;
+    s.name = "triangle_hull_meshing";
+    s.work_unit = "cells";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      static const double cell_size[3] = {1.0, 0.5, 0.25};
+
+      viennamesh::algorithm_handle reader = context.make_algorithm("plc_reader");
+      reader.set_input( "filename", data_directory + "/cube.poly" );
+      reader.run();
+
+      double size = cell_size[size_level];
+      return [context, reader, size]() mutable
+      {
+        viennamesh::algorithm_handle mesher = context.make_algorithm("triangle_make_hull");
+        mesher.set_default_source(reader);
+        mesher.set_input( "cell_size", size );
+        mesher.run();
+        return cell_count( mesher.get_output<viennagrid_mesh>("mesh")() );
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  {
+    scenario s;
+    s.name = "tetgen_volume_meshing";
+    s.work_unit = "cells";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      // maximum tetrahedron volumes in the 10x10x10 cube
+      static const double cell_size[3] = {1.0, 0.125, 0.015625};
+
+      viennamesh::algorithm_handle reader = context.make_algorithm("mesh_reader");
+      reader.set_input( "filename", data_directory + "/cube.poly" );
+      reader.run();
+
+      double size = cell_size[size_level];
+      return [context, reader, size]() mutable
+      {
+        viennamesh::algorithm_handle mesher = context.make_algorithm("tetgen_make_mesh");
+        mesher.set_default_source(reader);
+        mesher.set_input( "cell_size", size );
+        mesher.run();
+        return cell_count( mesher.get_output<viennagrid_mesh>("mesh")() );
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  {
+    scenario s;
+    s.name = "sizing_function_evaluation";
+    s.work_unit = "points";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      static const int point_resolution[3] = {10, 20, 40};
+
+      viennamesh::data_handle<viennagrid_mesh> mesh = make_tetrahedral_box(context, 8);
+
+      std::string xml =
+        "<interpolate transform_type=\"linear\">"
+        "  <lower type=\"double\">0.1</lower><upper type=\"double\">0.4</upper>"
+        "  <lower_to type=\"double\">0.01</lower_to><upper_to type=\"double\">0.1</upper_to>"
+        "  <source><distance_to_interface>"
+        "    <region type=\"region_id\">0</region><region type=\"region_id\">1</region>"
+        "  </distance_to_interface></source>"
+        "</interpolate>";
+
+      viennamesh::sizing_function::base_functor::function_type function =
+          viennamesh::sizing_function::from_xml(xml, mesh());
+
+      int n = point_resolution[size_level];
+      std::vector<viennagrid::point> points;
+      for (int k = 0; k != n; ++k)
+        for (int j = 0; j != n; ++j)
+          for (int i = 0; i != n; ++i)
+            points.push_back( viennagrid::make_point((i+0.5)/n, (j+0.5)/n, (k+0.5)/n) );
+
+      return [mesh, function, points]()
+      {
+        long evaluated = 0;
+        for (std::size_t i = 0; i != points.size(); ++i)
+          if (function(points[i]))
+            ++evaluated;
+        return evaluated;
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  {
+    scenario s;
+    s.name = "statistics";
+    s.work_unit = "cells";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      viennamesh::data_handle<viennagrid_mesh> mesh = make_tetrahedral_box(context, box_resolution[size_level]);
+
+      return [context, mesh]() mutable
+      {
+        viennamesh::algorithm_handle statistic = context.make_algorithm("make_statistic");
+        statistic.set_input( "mesh", mesh );
+        statistic.set_input( "metric_type", "radius_ratio" );
+        statistic.set_input( "histogram_min", 0.0 );
+        statistic.set_input( "histogram_max", 10.0 );
+        statistic.set_input( "histogram_bin_count", 20 );
+        statistic.run();
+        return cell_count(mesh());
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  {
+    scenario s;
+    s.name = "metis_partitioning";
+    s.work_unit = "cells";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      viennamesh::data_handle<viennagrid_mesh> mesh = make_tetrahedral_box(context, box_resolution[size_level]);
+
+      return [context, mesh]() mutable
+      {
+        viennamesh::algorithm_handle partitioning = context.make_algorithm("metis_mesh_partitioning");
+        partitioning.set_input( "mesh", mesh );
+        partitioning.set_input( "region_count", 8 );
+        partitioning.run();
+        return cell_count(mesh());
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  {
+    scenario s;
+    s.name = "color_refinement";
+    s.work_unit = "cells";
+    s.prepare = [](viennamesh::context_handle & context, int size_level) -> timed_step
+    {
+      static const int square_resolution[3] = {32, 64, 128};
+
+      viennamesh::data_handle<viennagrid_mesh> mesh = context.make_data<viennagrid_mesh>();
+      make_triangle_square(mesh(), square_resolution[size_level]);
+
+      return [context, mesh]() mutable
+      {
+        viennamesh::algorithm_handle color = context.make_algorithm("color_refinement");
+        color.set_input( "mesh", mesh );
+        color.set_input( "coloring", "greedy" );
+        color.set_input( "algorithm", "triangle" );
+        color.set_input( "options", "zpq" );
+        color.set_input( "num_partitions", 4 );
+        color.set_input( "num_threads", thread_count );
+        color.set_input( "filename", work_directory + "/benchmark_square.vtu" );
+        color.set_input( "single_mesh_output", true );
+        color.set_input( "max_num_iterations", 1 );
+        color.run();
+        return cell_count( color.get_output<viennagrid_mesh>("mesh")() );
+      };
+    };
+    scenarios.push_back(s);
+  }
+
+  return scenarios;
+}
+
+
+
+int main(int argc, char **argv)
+{
+  try
+  {
+    TCLAP::CmdLine cmd("ViennaMesh benchmark suite, runs fixed scenarios at several sizes and compares against a baseline", ' ', "1.0");
+
+    TCLAP::ValueArg<std::string> output_filename("o","output", "JSON file the results are written to (default is benchmark_results.json)", false, "benchmark_results.json", "string");
+    cmd.add( output_filename );
+
+    TCLAP::ValueArg<std::string> baseline_filename("b","baseline", "Results of an earlier run to compare against, regressions make the program fail", false, "", "string");
+    cmd.add( baseline_filename );
+
+    TCLAP::ValueArg<double> tolerance("t","tolerance", "Relative slowdown or memory growth against the baseline which is still accepted (default is 0.1)", false, 0.1, "double");
+    cmd.add( tolerance );
+
+    TCLAP::ValueArg<std::string> scenario_filter("s","scenarios", "Comma separated list of scenarios to run (default is all)", false, "", "string");
+    cmd.add( scenario_filter );
+
+    TCLAP::ValueArg<std::string> size_filter("","sizes", "Comma separated list of sizes to run: small, medium, large (default is all)", false, "", "string");
+    cmd.add( size_filter );
+
+    TCLAP::ValueArg<int> repetitions("r","repetitions", "Timed repetitions per scenario and size (default is 5)", false, 5, "int");
+    cmd.add( repetitions );
+
+    TCLAP::ValueArg<int> warmups("w","warmups", "Untimed warmup runs per scenario and size (default is 1)", false, 1, "int");
+    cmd.add( warmups );
+
+    TCLAP::ValueArg<int> threads("","threads", "Number of OpenMP threads (default is 1 for reproducible timings)", false, 1, "int");
+    cmd.add( threads );
+
+    TCLAP::ValueArg<std::string> data_dir("d","data-dir", "Directory of the example data", false, VIENNAMESH_BENCHMARK_DATA_DIRECTORY, "string");
+    cmd.add( data_dir );
+
+    TCLAP::ValueArg<std::string> work_dir("","work-dir", "Directory for files written by the scenarios (default is the current directory)", false, ".", "string");
+    cmd.add( work_dir );
+
+    TCLAP::SwitchArg list_scenarios("l","list", "List the scenarios and exit");
+    cmd.add( list_scenarios );
+
+    TCLAP::ValueArg<int> info_loglevel("i","info-loglevel", "Info Loglevel (default is 0)", false, 0, "int");
+    cmd.add( info_loglevel );
+
+    cmd.parse( argc, argv );
+
+    viennamesh_log_set_info_level( info_loglevel.getValue() );
+    viennamesh_log_set_stack_level( info_loglevel.getValue() );
+
+    data_directory = data_dir.getValue();
+    work_directory = work_dir.getValue();
+    thread_count = std::max(1, threads.getValue());
+    omp_set_num_threads(thread_count);
+
+    std::vector<viennamesh::benchmark::scenario> scenarios = make_scenarios();
+
+    if (list_scenarios.getValue())
+    {
+      for (std::size_t i = 0; i != scenarios.size(); ++i)
+        std::cout << scenarios[i].name << std::endl;
+      return 0;
+    }
+
+    std::vector<std::string> selected_scenarios;
+    if (!scenario_filter.getValue().empty())
+      boost::algorithm::split( selected_scenarios, scenario_filter.getValue(), boost::is_any_of(",") );
+
+    std::vector<std::string> selected_sizes;
+    if (!size_filter.getValue().empty())
+      boost::algorithm::split( selected_sizes, size_filter.getValue(), boost::is_any_of(",") );
+
+    std::map<std::string, viennamesh::benchmark::baseline_entry> baseline;
+    if (!baseline_filename.getValue().empty())
+    {
+      if (!std::ifstream(baseline_filename.getValue().c_str()))
+        viennamesh::warning(1) << "Baseline \"" << baseline_filename.getValue() << "\" does not exist, results are not compared" << std::endl;
+      else if (!viennamesh::benchmark::read_baseline(baseline_filename.getValue(), baseline))
+        return 1;
+    }
+
+
+    std::vector<viennamesh::benchmark::result> results;
+    for (std::size_t i = 0; i != scenarios.size(); ++i)
+    {
+      if (!selected_scenarios.empty() &&
+          std::find(selected_scenarios.begin(), selected_scenarios.end(), scenarios[i].name) == selected_scenarios.end())
+        continue;
+
+      for (std::size_t size_level = 0; size_level != viennamesh::benchmark::size_names().size(); ++size_level)
+      {
+        std::string const & size_name = viennamesh::benchmark::size_names()[size_level];
+        if (!selected_sizes.empty() && std::find(selected_sizes.begin(), selected_sizes.end(), size_name) == selected_sizes.end())
+          continue;
+
+        viennamesh::benchmark::result r = viennamesh::benchmark::run_isolated(scenarios[i], size_level, warmups.getValue(), std::max(1, repetitions.getValue()));
+        results.push_back(r);
+
+        std::cout << std::left << std::setw(40) << r.key() << std::right;
+        if (r.success)
+          std::cout << std::fixed << std::setprecision(2) << " p50 " << std::setw(10) << r.percentile(50.0) << " ms"
+                    << "  p90 " << std::setw(10) << r.percentile(90.0) << " ms"
+                    << "  " << std::setw(12) << std::setprecision(0) << r.throughput() << " " << r.work_unit << "/s"
+                    << "  peak " << r.peak_rss / 1024 << " MiB" << std::endl;
+        else
+          std::cout << " FAILED: " << r.message << std::endl;
+      }
+    }
+
+    if (!viennamesh::benchmark::write_json(output_filename.getValue(), results, warmups.getValue(), std::max(1, repetitions.getValue()), thread_count))
+    {
+      viennamesh::error(1) << "Could not write results to \"" << output_filename.getValue() << "\"" << std::endl;
+      return 1;
+    }
+    std::cout << "Results written to " << output_filename.getValue() << std::endl;
+
+    int failed = 0;
+    for (std::size_t i = 0; i != results.size(); ++i)
+      if (!results[i].success)
+        ++failed;
+
+    int regressions = 0;
+    if (!baseline.empty())
+      regressions = viennamesh::benchmark::compare(results, baseline, tolerance.getValue());
+
+    if (failed != 0 || regressions != 0)
+    {
+      std::cout << failed << " scenarios failed, " << regressions << " regressions" << std::endl;
+      return 1;
+    }
+  }
+  catch (TCLAP::ArgException &e)  // catch any exceptions
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+
+#include "viennameshpp/core.hpp"
+
+// Vertex coordinates, cell vertices and quantity values of a refined mesh, two pipelines computed
+// the same result if all of them are identical
+struct pipeline_result
+{
+  std::vector<viennagrid_numeric> coords;
+  std::vector<viennagrid_int> cell_vertices;
+  std::vector<std::string> quantity_names;
+  std::vector<char> quantity_valid;
+  std::vector<viennagrid_numeric> quantity_values;
+
+  bool operator==(pipeline_result const & rhs) const
+  {
+    return coords == rhs.coords && cell_vertices == rhs.cell_vertices && quantity_names == rhs.quantity_names &&
+           quantity_valid == rhs.quantity_valid && quantity_values == rhs.quantity_values;
+  }
+};
+
+pipeline_result make_result(viennamesh::algorithm_handle & refine)
+{
+  typedef viennagrid::mesh                                                MeshType;
+  typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
+  typedef viennagrid::result_of::const_cell_range<MeshType>::type         ConstCellRangeType;
+  typedef viennagrid::result_of::iterator<ConstCellRangeType>::type       ConstCellIteratorType;
+  typedef viennagrid::result_of::const_vertex_range<ElementType>::type    ConstVertexOnCellRangeType;
+  typedef viennagrid::result_of::iterator<ConstVertexOnCellRangeType>::type ConstVertexOnCellIteratorType;
+
+  pipeline_result result;
+
+  viennagrid::mesh mesh = refine.get_output<viennagrid_mesh>("mesh")();
+
+  viennagrid_int vertex_count = viennagrid::vertex_count(mesh);
+  if (vertex_count > 0)
+  {
+    viennagrid_numeric * coords;
+    viennagrid_mesh_vertex_coords_pointer(mesh.internal(), &coords);
+    result.coords.assign(coords, coords + vertex_count*viennagrid::geometric_dimension(mesh));
+  }
+
+  ConstCellRangeType cells(mesh);
+  for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+  {
+    ConstVertexOnCellRangeType vertices(*cit);
+    for (ConstVertexOnCellIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+      result.cell_vertices.push_back( (*vit).id().index() );
+  }
+
+  viennamesh::data_handle<viennagrid_quantity_field> quantities = refine.get_output<viennagrid_quantity_field>("quantities");
+  if (quantities.valid())
+  {
+    for (int i = 0; i != quantities.size(); ++i)
+    {
+      viennagrid::quantity_field field = quantities(i);
+      result.quantity_names.push_back( field.get_name() );
+
+      for (viennagrid_int j = 0; j != static_cast<viennagrid_int>(field.size()); ++j)
+      {
+        result.quantity_valid.push_back( field.valid(j) ? 1 : 0 );
+        if (!field.valid(j))
+          continue;
+
+        void * values;
+        viennagrid_quantity_field_value_get(field.internal(), j, &values);
+        viennagrid_numeric const * numeric_values = static_cast<viennagrid_numeric const *>(values);
+        result.quantity_values.insert(result.quantity_values.end(), numeric_values, numeric_values + field.values_per_quantity());
+      }
+    }
+  }
+
+  return result;
+}
+
+// Runs many independent pipelines concurrently on one context which shares its loaded plugins.
+// Every pipeline reads the mesh, refines it together with a refinement of the shared input
+// mesh and compares both refined meshes and their quantities with a serially computed reference.
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Correct use of parameters: <filename> [<pipeline count>]" << std::endl;
+        return -1;
+    }
+
+    std::string filename = argv[1];
+    int pipeline_count = (argc > 2) ? std::atoi(argv[2]) : 64;
+
+    viennamesh::context_handle context;
+
+    //mesh and quantities shared by all pipelines, their reference counts are changed concurrently
+    viennamesh::algorithm_handle shared_reader = context.make_algorithm("mesh_reader");
+    shared_reader.set_input( "filename", filename.c_str() );
+    shared_reader.run();
+
+    //reference result, computed before any pipeline runs concurrently
+    viennamesh::algorithm_handle reference_refine = context.make_algorithm("uniform_refine");
+    reference_refine.set_default_source(shared_reader);
+    reference_refine.run();
+    pipeline_result reference = make_result(reference_refine);
+
+    std::vector<char> own_matches(pipeline_count, 0);
+    std::vector<char> shared_matches(pipeline_count, 0);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < pipeline_count; ++i)
+    {
+        viennamesh::algorithm_handle mesh_reader = context.make_algorithm("mesh_reader");
+        mesh_reader.set_input( "filename", filename.c_str() );
+        mesh_reader.run();
+
+        viennamesh::algorithm_handle own_refine = context.make_algorithm("uniform_refine");
+        own_refine.set_default_source(mesh_reader);
+        own_refine.run();
+
+        viennamesh::algorithm_handle shared_refine = context.make_algorithm("uniform_refine");
+        shared_refine.set_default_source(shared_reader);
+        shared_refine.run();
+
+        own_matches[i] = (make_result(own_refine) == reference) ? 1 : 0;
+        shared_matches[i] = (make_result(shared_refine) == reference) ? 1 : 0;
+    }
+
+    int failed = 0;
+    for (int i = 0; i != pipeline_count; ++i)
+    {
+        if (!own_matches[i] || !shared_matches[i])
+        {
+            std::cout << "Pipeline " << i << " differs from the reference:"
+                      << (own_matches[i] ? "" : " own mesh") << (shared_matches[i] ? "" : " shared mesh") << std::endl;
+            ++failed;
+        }
+    }
+
+    std::cout << pipeline_count - failed << " of " << pipeline_count << " pipelines succeeded" << std::endl;
+
+    return (failed == 0) ? 0 : -1;
+}
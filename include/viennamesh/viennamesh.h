@@ -85,6 +85,46 @@ DYNAMIC_EXPORT viennamesh_error viennamesh_seed_point_get(viennamesh_seed_point
                                                           viennagrid_numeric ** values, int * size, int * region);
 
 
+/* Point cloud with contiguous storage: the coordinates of point i are
+   coords[i*dimension] ... coords[i*dimension + dimension-1]. Normals (optional) have the
+   dimension of the points, named attributes have a fixed number of components per point.
+   Point clouds are reference counted, make returns a point cloud with a reference count of one. */
+typedef struct viennamesh_point_cloud_t * viennamesh_point_cloud;
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_make(viennamesh_point_cloud * point_cloud);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_retain(viennamesh_point_cloud point_cloud);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_release(viennamesh_point_cloud point_cloud);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_copy(viennamesh_point_cloud src,
+                                                            viennamesh_point_cloud dst);
+
+/* resizing keeps the values of the remaining points, normals and attributes are resized as well */
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_resize(viennamesh_point_cloud point_cloud,
+                                                              int dimension, int point_count);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_get(viennamesh_point_cloud point_cloud,
+                                                           int * dimension, int * point_count,
+                                                           viennagrid_numeric ** coords);
+
+/* normals is NULL if the point cloud has no normals */
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_normals_make(viennamesh_point_cloud point_cloud,
+                                                                    viennagrid_numeric ** normals);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_normals_get(viennamesh_point_cloud point_cloud,
+                                                                   viennagrid_numeric ** normals);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_normals_clear(viennamesh_point_cloud point_cloud);
+
+/* values is NULL if the point cloud has no attribute with that name */
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_attribute_make(viennamesh_point_cloud point_cloud,
+                                                                      const char * name, int components,
+                                                                      viennagrid_numeric ** values);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_attribute_get(viennamesh_point_cloud point_cloud,
+                                                                     const char * name, int * components,
+                                                                     viennagrid_numeric ** values);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_attribute_remove(viennamesh_point_cloud point_cloud,
+                                                                        const char * name);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_attribute_get_count(viennamesh_point_cloud point_cloud,
+                                                                           int * count);
+DYNAMIC_EXPORT viennamesh_error viennamesh_point_cloud_attribute_get_name(viennamesh_point_cloud point_cloud,
+                                                                          int index, const char ** name);
+
+
 
 /*****************************************************************************************************
  *                                Context
@@ -182,6 +222,17 @@ DYNAMIC_EXPORT viennamesh_error viennamesh_data_conversion_register(viennamesh_c
                                                                     const char * data_type_to,
                                                                     viennamesh_data_convert_function convert_function);
 
+/* Converts a whole data wrapper at once instead of element by element, e.g. to gather a container
+   of points into a single point cloud. Takes precedence over an element conversion between the
+   same data types. */
+typedef viennamesh_error (*viennamesh_data_container_convert_function)(viennamesh_data_wrapper from,
+                                                                       viennamesh_data_wrapper to);
+
+DYNAMIC_EXPORT viennamesh_error viennamesh_data_container_conversion_register(viennamesh_context context,
+                                                                              const char * data_type_from,
+                                                                              const char * data_type_to,
+                                                                              viennamesh_data_container_convert_function convert_function);
+
 DYNAMIC_EXPORT viennamesh_error viennamesh_data_wrapper_convert(viennamesh_data_wrapper data_from,
                                                                 viennamesh_data_wrapper data_to);
 
@@ -227,6 +278,8 @@ DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_base_path(viennamesh_al
 
 DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_type(viennamesh_algorithm_wrapper algorithm,
                                                               const char ** algorithm_type);
+DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_build_id(viennamesh_algorithm_wrapper algorithm,
+                                                                  const char ** build_id);
 DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_context(viennamesh_algorithm_wrapper algorithm,
                                                                  viennamesh_context * context);
 
@@ -266,6 +319,11 @@ DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_output_with_type(vienna
                                                                           const char * name,
                                                                           const char * data_type,
                                                                           viennamesh_data_wrapper * data);
+DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_output_count(viennamesh_algorithm_wrapper algorithm,
+                                                                      int * count);
+DYNAMIC_EXPORT viennamesh_error viennamesh_algorithm_get_output_name(viennamesh_algorithm_wrapper algorithm,
+                                                                     int index,
+                                                                     const char ** name);
 
 
 
@@ -307,6 +365,34 @@ DYNAMIC_EXPORT viennamesh_error viennamesh_log_set_stack_level(int log_level);
 
 
 DYNAMIC_EXPORT viennamesh_error viennamesh_log_add_logging_file(char const * filename, viennamesh_log_callback_handle * handle);
+/* the file only receives messages logged by the calling thread */
+DYNAMIC_EXPORT viennamesh_error viennamesh_log_add_thread_logging_file(char const * filename, viennamesh_log_callback_handle * handle);
+DYNAMIC_EXPORT viennamesh_error viennamesh_log_remove_logging_file(viennamesh_log_callback_handle handle);
+
+
+
+/*****************************************************************************************************
+ *                                Profiling
+ *****************************************************************************************************/
+
+/* algorithm runs and data conversions are recorded as spans while profiling is enabled */
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_set_enabled(int enabled);
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_get_enabled(int * enabled);
+/* fails if a span of any thread is still open */
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_clear();
+
+/* nested spans of the calling thread, started is set to false if profiling is disabled */
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_span_begin(const char * name,
+                                                                const char * category,
+                                                                int * started);
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_span_end();
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_span_add_argument(const char * key,
+                                                                       const char * value);
+
+/* report with all spans and per algorithm totals */
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_write_json(const char * filename);
+/* Chrome trace event file, viewable in chrome://tracing or Perfetto */
+DYNAMIC_EXPORT viennamesh_error viennamesh_profiling_write_trace(const char * filename);
 
 
 
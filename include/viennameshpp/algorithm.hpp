@@ -136,6 +136,9 @@ namespace viennamesh
     void set_output(std::string const & name, abstract_data_handle data);
     abstract_data_handle get_output(std::string const & name);
 
+    int output_count() const;
+    std::string output_name(int index) const;
+
     template<typename DataT>
     data_handle< typename result_of::unpack_data<DataT>::type > get_output(std::string const & name)
     {
@@ -159,6 +162,7 @@ namespace viennamesh
 
     viennamesh_algorithm_wrapper internal() const;
     std::string type() const;
+    std::string build_id() const;
 
 
     std::string base_path() const;
@@ -0,0 +1,99 @@
+#ifndef VIENNAMESH_CORE_ALGORITHM_CACHE_HPP
+#define VIENNAMESH_CORE_ALGORITHM_CACHE_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <atomic>
+#include "viennameshpp/core.hpp"
+
+namespace viennamesh
+{
+
+  // 64 bit FNV-1a hash, used to build cache keys. A key describes the provenance of a result: the
+  // algorithm type, the build of the plugin providing it, its parameters, the keys of its upstream
+  // results and the content of files named in string parameters. It does not hash the content of
+  // input data passed in any other way.
+  class cache_key_builder
+  {
+  public:
+
+    cache_key_builder() : hash_(14695981039346656037ULL) {}
+
+    void add(void const * data, std::size_t size);
+    void add(std::string const & str);
+    void add(std::size_t value);
+
+    // hashes the content of the file, returns false if the file could not be opened
+    bool add_file_content(std::string const & filename);
+
+    std::string str() const;
+
+  private:
+    unsigned long long hash_;
+  };
+
+
+
+  // updated by all pipelines sharing the cache, possibly concurrently
+  struct algorithm_cache_statistics
+  {
+    algorithm_cache_statistics() : hits(0), misses(0), stores(0), skipped_stores(0), evictions(0), bytes_read(0), bytes_written(0) {}
+
+    std::atomic<std::size_t> hits;
+    std::atomic<std::size_t> misses;
+    std::atomic<std::size_t> stores;
+    std::atomic<std::size_t> skipped_stores;
+    std::atomic<std::size_t> evictions;
+    std::atomic<std::size_t> bytes_read;
+    std::atomic<std::size_t> bytes_written;
+  };
+
+
+  // Persistent on-disk cache of algorithm outputs. Every entry is a single binary file named
+  // after its key, entries are evicted least recently used first once the total size of the
+  // cache directory exceeds max_size bytes. Meshes are stored with their vertices, regions (ids
+  // and names), cells and the lower dimensional elements which are not on the boundary of a cell.
+  // Meshes with child meshes are not cacheable, storing outputs containing them is refused.
+  class algorithm_cache
+  {
+  public:
+
+    algorithm_cache(std::string const & directory_, std::size_t max_size_);
+
+    // restores all outputs stored under key into algorithm, returns false on a cache miss
+    bool load(std::string const & key, algorithm_handle & algorithm);
+
+    // stores all outputs of algorithm under key, returns false if an output type is not supported
+    bool store(std::string const & key, algorithm_handle & algorithm);
+
+    std::string const & directory() const { return directory_; }
+    std::size_t max_size() const { return max_size_; }
+
+    algorithm_cache_statistics const & statistics() const { return statistics_; }
+    void log_statistics() const;
+
+  private:
+
+    std::string filename(std::string const & key) const;
+    void evict();
+
+    std::string directory_;
+    std::size_t max_size_;
+    algorithm_cache_statistics statistics_;
+  };
+
+}
+
+#endif
@@ -16,16 +16,76 @@
 =============================================================================== */
 
 #include "viennameshpp/core.hpp"
+#include "viennameshpp/algorithm_cache.hpp"
 #include "pugixml.hpp"
 
 #include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
 
 namespace viennamesh
 {
 
+  // Outputs of pipeline inputs (algorithms without upstream algorithms, e.g. mesh readers) shared
+  // by several pipelines running concurrently on one context. An input is computed by the first
+  // pipeline which needs it, the others wait for it and reuse its outputs. Meshes and quantity
+  // fields are stored as a private copy and every reusing pipeline gets its own copy of them, so
+  // pipelines may modify their outputs and never share mesh reference counts.
+  class shared_pipeline_inputs
+  {
+  public:
+
+    shared_pipeline_inputs() : hits_(0) {}
+
+    // restores the outputs stored under key into algorithm, returns false if the caller has to
+    // compute them, which it has to finish with store or abandon
+    bool acquire(std::string const & key, algorithm_handle & algorithm);
+    void store(std::string const & key, algorithm_handle & algorithm);
+    void abandon(std::string const & key);
+
+    std::size_t hits() const;
+
+  private:
+
+    struct entry
+    {
+      entry() : ready(false) {}
+
+      bool ready;
+      std::vector< std::pair<std::string, abstract_data_handle> > outputs;
+    };
+
+    std::map<std::string, entry> entries;
+    std::size_t hits_;
+
+    mutable std::mutex mutex;
+    std::condition_variable ready_condition;
+  };
+
+
+  // Expands the <sweep> node of a pipeline into parameter variants, every variant maps parameter
+  // names to values which are substituted for ${name} in the pipeline. A parameter is declared by
+  //   <parameter name="size" values="0.1,0.2,0.5"/>  or  <parameter name="angle" from="20" to="30" step="5"/>
+  // mode="cartesian" (default) yields all combinations, mode="zip" the i-th value of every parameter.
+  // Every variant additionally defines sweep_variant (its index) and sweep_name (e.g. size-0.1_angle-20)
+  // for per variant output file names. A pipeline without a <sweep> node has no variants.
+  bool expand_sweep( pugi::xml_node const & xml, std::vector< std::map<std::string, std::string> > & variants );
+
+
+  // <statistic name="cells" source="mesher/mesh"/> reports an output of an algorithm after the
+  // pipeline has run: numbers and strings as they are, meshes by their number of cells
+  struct algorithm_pipeline_statistic
+  {
+    std::string name;
+    std::string algorithm_name;
+    std::string output_name;
+  };
+
+
   struct algorithm_pipeline_element
   {
-    algorithm_pipeline_element(std::string const & name_) : name(name_), reference_count(0), info_log_level(-1), error_log_level(-1), warning_log_level(-1), debug_log_level(-1), stack_log_level(-1) {}
+    algorithm_pipeline_element(std::string const & name_) : name(name_), reference_count(0), info_log_level(-1), error_log_level(-1), warning_log_level(-1), debug_log_level(-1), stack_log_level(-1), cacheable(true) {}
 
     std::string name;
     algorithm_handle algorithm;
@@ -39,6 +99,12 @@ namespace viennamesh
     int warning_log_level;
     int debug_log_level;
     int stack_log_level;
+
+    // algorithm type and parameters, input files and upstream keys are added when the key is built
+    std::string cache_signature;
+    std::vector<std::string> cache_input_files;
+    std::string cache_key;
+    bool cacheable;
   };
 
 
@@ -46,9 +112,10 @@ namespace viennamesh
   {
   public:
 
-    algorithm_pipeline(viennamesh::context_handle & context_) : context(context_) {}
+    algorithm_pipeline(viennamesh::context_handle & context_) : context(context_), share_intermediate_(false) {}
 
     bool add_algorithm( pugi::xml_node const & algorithm_node );
+    bool add_statistic( pugi::xml_node const & statistic_node );
     bool from_xml( pugi::xml_node const & xml );
 
     bool run(bool cleanup_after_algorithm_step = false);
@@ -57,12 +124,35 @@ namespace viennamesh
 
     void set_base_path( std::string const & path );
 
+    // reuse outputs of algorithms whose type, parameters and inputs did not change since a previous run
+    void enable_cache( std::string const & directory, std::size_t max_size );
+    void disable_cache();
+    boost::shared_ptr<algorithm_cache> const & cache() const { return cache_; }
+
+    // reuse outputs of pipeline inputs computed by other pipelines sharing inputs, with
+    // share_intermediate also outputs of all other algorithms with identical parameters and upstream
+    // results (e.g. variants of a parameter sweep which differ in downstream parameters only)
+    void share_inputs( boost::shared_ptr<shared_pipeline_inputs> const & inputs, bool share_intermediate = false )
+    {
+      shared_inputs_ = inputs;
+      share_intermediate_ = share_intermediate;
+    }
+
+    // values of the statistics declared in the pipeline, in declaration order, call after run
+    std::vector< std::pair<std::string, std::string> > statistics();
+
   private:
 
     algorithm_pipeline_element * get_element(std::string const & algorithm_name);
+    bool make_cache_key(algorithm_pipeline_element & element);
+    bool run_element(algorithm_pipeline_element & element, bool has_cache_key);
 
     viennamesh::context_handle & context;
     std::list<algorithm_pipeline_element> algorithms;
+    std::vector<algorithm_pipeline_statistic> statistics_;
+    boost::shared_ptr<algorithm_cache> cache_;
+    boost::shared_ptr<shared_pipeline_inputs> shared_inputs_;
+    bool share_intermediate_;
   };
 
 
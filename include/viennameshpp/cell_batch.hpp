@@ -0,0 +1,66 @@
+#ifndef _VIENNAMESH_CELL_BATCH_HPP_
+#define _VIENNAMESH_CELL_BATCH_HPP_
+
+#include <vector>
+
+#include "viennagrid/viennagrid.hpp"
+
+namespace viennamesh
+{
+  // Creates cell_count cells with their regions in one batch. Cell i has the vertices
+  // cell_vertices[cell_vertex_offsets[i], cell_vertex_offsets[i+1]) and the regions
+  // cell_region_ids[cell_region_offsets[r], cell_region_offsets[r+1]) with r = region_rows[i], or r = i
+  // without region_rows (several cells can share the regions of one row, e.g. refined cells the regions
+  // of their parent cell). The regions have to exist in mesh. Cells get their first region in the batch
+  // and further regions afterwards, if a cell has no region all regions are added afterwards.
+  // Returns the id of the first created cell, the cells have consecutive ids.
+  template<typename RegionIdT>
+  viennagrid_element_id batch_create_cells(viennagrid::mesh const & mesh,
+                                           viennagrid_int cell_count,
+                                           viennagrid_element_type const * cell_types,
+                                           viennagrid_int const * cell_vertex_offsets,
+                                           viennagrid_element_id const * cell_vertices,
+                                           viennagrid_int const * cell_region_offsets,
+                                           RegionIdT const * cell_region_ids,
+                                           viennagrid_int const * region_rows = NULL)
+  {
+    typedef viennagrid::result_of::element<viennagrid::mesh>::type ElementType;
+
+    bool all_cells_have_region = true;
+    std::vector<viennagrid_region_id> first_region_ids(cell_count);
+
+    #pragma omp parallel for schedule(static) reduction(&&:all_cells_have_region)
+    for (viennagrid_int i = 0; i < cell_count; ++i)
+    {
+      viennagrid_int row = region_rows ? region_rows[i] : i;
+      if (cell_region_offsets[row] == cell_region_offsets[row+1])
+        all_cells_have_region = false;
+      else
+        first_region_ids[i] = cell_region_ids[ cell_region_offsets[row] ];
+    }
+
+    viennagrid_element_id first_cell_id;
+    viennagrid_mesh_element_batch_create(mesh.internal(),
+                                         cell_count, const_cast<viennagrid_element_type *>(cell_types),
+                                         const_cast<viennagrid_int *>(cell_vertex_offsets),
+                                         const_cast<viennagrid_element_id *>(cell_vertices),
+                                         all_cells_have_region ? &first_region_ids[0] : NULL,
+                                         &first_cell_id);
+
+    for (viennagrid_int i = 0; i != cell_count; ++i)
+    {
+      viennagrid_int row = region_rows ? region_rows[i] : i;
+      viennagrid_int first_additional_region = cell_region_offsets[row] + (all_cells_have_region ? 1 : 0);
+      if (first_additional_region >= cell_region_offsets[row+1])
+        continue;
+
+      ElementType cell(mesh, first_cell_id + i);
+      for (viennagrid_int j = first_additional_region; j != cell_region_offsets[row+1]; ++j)
+        viennagrid::add(mesh.get_or_create_region(cell_region_ids[j]), cell);
+    }
+
+    return first_cell_id;
+  }
+}
+
+#endif
@@ -122,6 +122,11 @@ namespace viennamesh
   inline viennamesh_error delete_seed_point(viennamesh_data data)
   { return delete_viennamesh_data<viennamesh_seed_point>(data, viennamesh_seed_point_delete); }
 
+  inline viennamesh_error make_point_cloud(viennamesh_data * data)
+  { return make_viennamesh_data<viennamesh_point_cloud>(data, viennamesh_point_cloud_make); }
+  inline viennamesh_error delete_point_cloud(viennamesh_data data)
+  { return delete_viennamesh_data<viennamesh_point_cloud>(data, viennamesh_point_cloud_release); }
+
   inline viennamesh_error make_quantities(viennamesh_data * data)
   { return make_viennamesh_data<viennagrid_quantity_field>(data, viennagrid_quantity_field_create); }
   inline viennamesh_error delete_quantities(viennamesh_data data)
@@ -250,6 +255,12 @@ namespace viennamesh
       typedef viennamesh_seed_point type;
     };
 
+    template<>
+    struct c_type<point_cloud>
+    {
+      typedef viennamesh_point_cloud type;
+    };
+
 
 
 
@@ -289,6 +300,12 @@ namespace viennamesh
       typedef seed_point type;
     };
 
+    template<>
+    struct cpp_type<viennamesh_point_cloud>
+    {
+      typedef point_cloud type;
+    };
+
 
 
 
@@ -330,6 +347,12 @@ namespace viennamesh
       typedef seed_point type;
     };
 
+    template<>
+    struct cpp_result_type<viennamesh_point_cloud>
+    {
+      typedef point_cloud type;
+    };
+
 
     template<typename DataT>
     struct data_handle
@@ -417,6 +440,14 @@ namespace viennamesh
       static viennamesh_data_delete_function delete_function() { return viennamesh::delete_seed_point; }
     };
 
+    template<>
+    struct data_information<viennamesh_point_cloud>
+    {
+      static std::string type_name() { return "viennamesh_point_cloud"; }
+      static viennamesh_data_make_function make_function() { return viennamesh::make_point_cloud; }
+      static viennamesh_data_delete_function delete_function() { return viennamesh::delete_point_cloud; }
+    };
+
     template<>
     struct data_information<viennagrid_quantity_field>
     {
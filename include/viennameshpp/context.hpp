@@ -59,6 +59,19 @@ namespace viennamesh
                           convert_function);
     }
 
+    // converts a whole data container at once, preferred over an elementwise conversion
+    void register_container_conversion(std::string const & data_type_from,
+                                       std::string const & data_type_to,
+                                       viennamesh_data_container_convert_function convert_function);
+
+    template<typename FromT, typename ToT>
+    void register_container_conversion(viennamesh_data_container_convert_function convert_function)
+    {
+      register_container_conversion(result_of::data_information<FromT>::type_name(),
+                                    result_of::data_information<ToT>::type_name(),
+                                    convert_function);
+    }
+
     template<typename FromT, typename ToT>
     void register_conversion()
     {
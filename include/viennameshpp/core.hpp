@@ -6,6 +6,7 @@
 #include "viennameshpp/algorithm.hpp"
 #include "viennameshpp/context.hpp"
 #include "viennameshpp/logger.hpp"
+#include "viennameshpp/profiling.hpp"
 // #include "viennameshpp/utils/string_tools.hpp"
 
 // using stringtools::lexical_cast;
@@ -4,6 +4,7 @@
 #include <cassert>
 #include "viennameshpp/forwards.hpp"
 #include "viennameshpp/common.hpp"
+#include "viennameshpp/point_cloud.hpp"
 #include "viennagrid/viennagrid.hpp"
 
 namespace viennamesh
@@ -87,6 +88,10 @@ namespace viennamesh
   seed_point to_cpp(viennamesh_seed_point & src);
   void to_c(seed_point const & src, viennamesh_seed_point & dst);
 
+  // viennamesh::point_cloud
+  point_cloud to_cpp(viennamesh_point_cloud & src);
+  void to_c(point_cloud const & src, viennamesh_point_cloud & dst);
+
   // std::string
   std::string to_cpp(viennamesh_string & src);
   void to_c(std::string const & src, viennamesh_string dst);
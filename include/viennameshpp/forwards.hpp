@@ -36,6 +36,8 @@ namespace viennamesh
 
   class algorithm_handle;
 
+  class point_cloud;
+
   using viennagrid::mesh;
   using viennagrid::quantity_field;
   using viennagrid::point;
@@ -18,6 +18,7 @@ namespace viennamesh
     typedef data_handle<viennamesh_string> string_handle;
     typedef data_handle<viennamesh_point> point_handle;
     typedef data_handle<viennamesh_seed_point> seed_point_handle;
+    typedef data_handle<viennamesh_point_cloud> point_cloud_handle;
 
 
     bool init(viennamesh::algorithm_handle algorithm_in)
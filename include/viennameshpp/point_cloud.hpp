@@ -0,0 +1,190 @@
+#ifndef _VIENNAMESH_POINT_CLOUD_HPP_
+#define _VIENNAMESH_POINT_CLOUD_HPP_
+
+#include <string>
+#include <vector>
+#include "viennamesh/viennamesh.h"
+#include "viennamesh/cpp_error.hpp"
+#include "viennagrid/viennagrid.hpp"
+
+namespace viennamesh
+{
+  // Handle to a point cloud with contiguous storage: all coordinates in one array
+  // (point i at coords()[i*dimension()]), optional normals with the same layout and
+  // optional named per-point attributes. Copies of a handle share the cloud.
+  class point_cloud
+  {
+  public:
+
+    point_cloud() : pc(0)
+    {
+      viennamesh_point_cloud_make(&pc);
+    }
+
+    point_cloud(int dimension_, int size_) : pc(0)
+    {
+      viennamesh_point_cloud_make(&pc);
+      resize(dimension_, size_);
+    }
+
+    explicit point_cloud(viennamesh_point_cloud pc_) : pc(pc_) { retain(); }
+    point_cloud(point_cloud const & other) : pc(other.pc) { retain(); }
+
+    ~point_cloud() { release(); }
+
+    point_cloud & operator=(point_cloud const & other)
+    {
+      if (other.pc)
+        viennamesh_point_cloud_retain(other.pc);
+      release();
+      pc = other.pc;
+      return *this;
+    }
+
+
+    int dimension() const
+    {
+      int dimension_;
+      viennamesh_point_cloud_get(pc, &dimension_, NULL, NULL);
+      return dimension_;
+    }
+
+    int size() const
+    {
+      int size_;
+      viennamesh_point_cloud_get(pc, NULL, &size_, NULL);
+      return size_;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void resize(int dimension_, int size_)
+    {
+      viennamesh_error err = viennamesh_point_cloud_resize(pc, dimension_, size_);
+      if (err != VIENNAMESH_SUCCESS)
+        VIENNAMESH_ERROR(err, "Resizing point cloud failed");
+    }
+
+    // deep copy
+    point_cloud copy() const
+    {
+      point_cloud result;
+      viennamesh_point_cloud_copy(pc, result.pc);
+      return result;
+    }
+
+
+    viennagrid_numeric * coords()
+    {
+      viennagrid_numeric * coords_;
+      viennamesh_point_cloud_get(pc, NULL, NULL, &coords_);
+      return coords_;
+    }
+
+    viennagrid_numeric const * coords() const
+    { return const_cast<point_cloud*>(this)->coords(); }
+
+    viennagrid_numeric * operator[](int index) { return coords() + index*dimension(); }
+    viennagrid_numeric const * operator[](int index) const { return coords() + index*dimension(); }
+
+    viennagrid::point point(int index) const
+    {
+      int dimension_ = dimension();
+      viennagrid_numeric const * begin = coords() + index*dimension_;
+      viennagrid::point result(dimension_);
+      std::copy(begin, begin + dimension_, result.begin());
+      return result;
+    }
+
+    void set_point(int index, viennagrid::point const & p)
+    {
+      int dimension_ = dimension();
+      std::copy(p.begin(), p.begin() + std::min<int>(dimension_, p.size()), coords() + index*dimension_);
+    }
+
+
+    bool has_normals() const { return normals() != NULL; }
+
+    // NULL if the cloud has no normals
+    viennagrid_numeric * normals()
+    {
+      viennagrid_numeric * normals_;
+      viennamesh_point_cloud_normals_get(pc, &normals_);
+      return normals_;
+    }
+
+    viennagrid_numeric const * normals() const
+    { return const_cast<point_cloud*>(this)->normals(); }
+
+    // creates zero normals if the cloud has none
+    viennagrid_numeric * make_normals()
+    {
+      viennagrid_numeric * normals_;
+      viennamesh_point_cloud_normals_make(pc, &normals_);
+      return normals_;
+    }
+
+    void clear_normals() { viennamesh_point_cloud_normals_clear(pc); }
+
+
+    // NULL if the attribute does not exist
+    viennagrid_numeric * attribute(std::string const & name, int * components = NULL)
+    {
+      viennagrid_numeric * values;
+      viennamesh_point_cloud_attribute_get(pc, name.c_str(), components, &values);
+      return values;
+    }
+
+    viennagrid_numeric const * attribute(std::string const & name, int * components = NULL) const
+    { return const_cast<point_cloud*>(this)->attribute(name, components); }
+
+    viennagrid_numeric * make_attribute(std::string const & name, int components)
+    {
+      viennagrid_numeric * values;
+      viennamesh_error err = viennamesh_point_cloud_attribute_make(pc, name.c_str(), components, &values);
+      if (err != VIENNAMESH_SUCCESS)
+        VIENNAMESH_ERROR(err, "Creating point cloud attribute \"" + name + "\" failed");
+      return values;
+    }
+
+    void remove_attribute(std::string const & name)
+    { viennamesh_point_cloud_attribute_remove(pc, name.c_str()); }
+
+    std::vector<std::string> attribute_names() const
+    {
+      int count;
+      viennamesh_point_cloud_attribute_get_count(pc, &count);
+
+      std::vector<std::string> names;
+      names.reserve(count);
+      for (int i = 0; i != count; ++i)
+      {
+        const char * name;
+        viennamesh_point_cloud_attribute_get_name(pc, i, &name);
+        names.push_back(name);
+      }
+      return names;
+    }
+
+
+    viennamesh_point_cloud internal() const { return pc; }
+
+  private:
+
+    void retain()
+    {
+      if (pc)
+        viennamesh_point_cloud_retain(pc);
+    }
+
+    void release()
+    {
+      if (pc)
+        viennamesh_point_cloud_release(pc);
+    }
+
+    viennamesh_point_cloud pc;
+  };
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _VIENNAMESH_PROFILING_HPP_
+#define _VIENNAMESH_PROFILING_HPP_
+
+#include <string>
+#include <sstream>
+#include "viennamesh/viennamesh.h"
+
+namespace viennamesh
+{
+  // Scoped profiling span for plugins, nests into the span of the running algorithm.
+  // Does nothing if profiling is disabled.
+  //
+  //   viennamesh::profiling_span span("build octree");
+  //   span.add("points", point_count);
+  class profiling_span
+  {
+  public:
+
+    profiling_span(std::string const & name, std::string const & category = "plugin") : started(0)
+    {
+      viennamesh_profiling_span_begin( name.c_str(), category.c_str(), &started );
+    }
+
+    ~profiling_span() { end(); }
+
+    bool active() const { return started != 0; }
+
+    template<typename T>
+    void add(std::string const & key, T const & value)
+    {
+      if (!active())
+        return;
+
+      std::ostringstream ss;
+      ss << value;
+      viennamesh_profiling_span_add_argument( key.c_str(), ss.str().c_str() );
+    }
+
+    // closes the span before the end of the scope
+    void end()
+    {
+      if (active())
+        viennamesh_profiling_span_end();
+      started = 0;
+    }
+
+  private:
+
+    profiling_span(profiling_span const &);
+    profiling_span & operator=(profiling_span const &);
+
+    int started;
+  };
+
+
+  inline void enable_profiling(bool enabled = true)
+  { viennamesh_profiling_set_enabled( enabled ? 1 : 0 ); }
+
+  inline bool write_profiling_report(std::string const & filename)
+  { return viennamesh_profiling_write_json( filename.c_str() ) == VIENNAMESH_SUCCESS; }
+
+  inline bool write_profiling_trace(std::string const & filename)
+  { return viennamesh_profiling_write_trace( filename.c_str() ) == VIENNAMESH_SUCCESS; }
+}
+
+#endif
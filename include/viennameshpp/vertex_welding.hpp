@@ -0,0 +1,195 @@
+#ifndef _VIENNAMESH_VERTEX_WELDING_HPP_
+#define _VIENNAMESH_VERTEX_WELDING_HPP_
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <boost/cstdint.hpp>
+
+#include "viennagrid/viennagrid.h"
+
+namespace viennamesh
+{
+  // Welding of close vertices given as a contiguous coordinate array (vertex i at coords[i*dimension]).
+  //
+  // Vertices are hashed into a grid with cell size tolerance, so all vertices closer than tolerance
+  // are found in the 3^dimension neighboring grid cells. Close vertices are joined in parallel with
+  // a lock free union-find which always links the larger root to the smaller one, the cluster of a
+  // vertex is therefore represented by its smallest vertex index, independent of the number of
+  // threads. Merging is transitive: chains of close vertices form one cluster.
+  //
+  //   std::vector<viennagrid_int> new_index;
+  //   std::vector<viennagrid_numeric> new_coords;
+  //   viennagrid_int new_count = viennamesh::weld_vertices(coords, count, dimension, tolerance, new_index, new_coords);
+  namespace welding
+  {
+    inline viennagrid_int find_root(std::atomic<viennagrid_int> * parent, viennagrid_int i)
+    {
+      while (true)
+      {
+        viennagrid_int p = parent[i].load(std::memory_order_relaxed);
+        if (p == i)
+          return i;
+
+        // path halving
+        viennagrid_int gp = parent[p].load(std::memory_order_relaxed);
+        if (gp != p)
+          parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+        i = gp;
+      }
+    }
+
+    inline void unite(std::atomic<viennagrid_int> * parent, viennagrid_int a, viennagrid_int b)
+    {
+      while (true)
+      {
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+        if (a == b)
+          return;
+
+        if (a < b)
+          std::swap(a, b);
+
+        // a is a root now and is linked to the smaller root b, fails if a got linked in between
+        viennagrid_int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+          return;
+      }
+    }
+
+    inline boost::uint64_t hash_cell(boost::int64_t const * cell, int dimension)
+    {
+      boost::uint64_t hash = 14695981039346656037ULL;
+      for (int d = 0; d != dimension; ++d)
+      {
+        hash ^= static_cast<boost::uint64_t>(cell[d]);
+        hash *= 1099511628211ULL;
+        hash ^= hash >> 29;
+      }
+      return hash;
+    }
+  }
+
+
+  // Welds all vertices closer than tolerance. new_index[i] is the index of vertex i after welding,
+  // new vertices are numbered in the order of their smallest input vertex and keep its coordinates.
+  // Returns the number of vertices after welding. With tolerance <= 0 no vertices are welded.
+  inline viennagrid_int weld_vertices(viennagrid_numeric const * coords, viennagrid_int count, int dimension,
+                                      double tolerance,
+                                      std::vector<viennagrid_int> & new_index,
+                                      std::vector<viennagrid_numeric> & new_coords)
+  {
+    new_index.resize(count);
+
+    std::vector< std::atomic<viennagrid_int> > parent(count);
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int i = 0; i < count; ++i)
+      parent[i].store(i, std::memory_order_relaxed);
+
+    if (tolerance > 0 && count > 1 && dimension > 0 && dimension <= 3)
+    {
+      // grid cell of every vertex, relative to the lower corner of the bounding box
+      std::vector<viennagrid_numeric> min(dimension, std::numeric_limits<viennagrid_numeric>::max());
+      for (viennagrid_int i = 0; i < count; ++i)
+        for (int d = 0; d != dimension; ++d)
+          min[d] = std::min(min[d], coords[i*dimension+d]);
+
+      std::vector<boost::int64_t> cells(count*dimension);
+      std::vector<boost::uint64_t> buckets(count);
+      boost::uint64_t bucket_count = count;
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int i = 0; i < count; ++i)
+      {
+        for (int d = 0; d != dimension; ++d)
+          cells[i*dimension+d] = static_cast<boost::int64_t>( std::floor((coords[i*dimension+d] - min[d]) / tolerance) );
+        buckets[i] = welding::hash_cell(&cells[i*dimension], dimension) % bucket_count;
+      }
+
+      // vertices of every bucket in CSR format, the order within a bucket does not matter
+      std::vector< std::atomic<viennagrid_int> > bucket_sizes(bucket_count+1);
+      for (boost::uint64_t b = 0; b <= bucket_count; ++b)
+        bucket_sizes[b].store(0, std::memory_order_relaxed);
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int i = 0; i < count; ++i)
+        bucket_sizes[buckets[i]+1].fetch_add(1, std::memory_order_relaxed);
+
+      std::vector<viennagrid_int> bucket_offsets(bucket_count+1, 0);
+      for (boost::uint64_t b = 0; b != bucket_count; ++b)
+        bucket_offsets[b+1] = bucket_offsets[b] + bucket_sizes[b+1].load(std::memory_order_relaxed);
+
+      for (boost::uint64_t b = 0; b != bucket_count; ++b)
+        bucket_sizes[b].store(bucket_offsets[b], std::memory_order_relaxed);
+
+      std::vector<viennagrid_int> bucket_vertices(count);
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int i = 0; i < count; ++i)
+        bucket_vertices[ bucket_sizes[buckets[i]].fetch_add(1, std::memory_order_relaxed) ] = i;
+
+      int neighbor_cell_count = 1;
+      for (int d = 0; d != dimension; ++d)
+        neighbor_cell_count *= 3;
+
+      double squared_tolerance = tolerance*tolerance;
+
+      #pragma omp parallel for schedule(dynamic, 1024)
+      for (viennagrid_int i = 0; i < count; ++i)
+      {
+        boost::int64_t neighbor_cell[3];
+        viennagrid_numeric const * p = coords + i*dimension;
+
+        for (int n = 0; n != neighbor_cell_count; ++n)
+        {
+          for (int d = 0, code = n; d != dimension; ++d, code /= 3)
+            neighbor_cell[d] = cells[i*dimension+d] + (code % 3) - 1;
+
+          boost::uint64_t b = welding::hash_cell(neighbor_cell, dimension) % bucket_count;
+          for (viennagrid_int k = bucket_offsets[b]; k != bucket_offsets[b+1]; ++k)
+          {
+            viennagrid_int j = bucket_vertices[k];
+            if (j <= i)
+              continue;
+
+            viennagrid_numeric const * q = coords + j*dimension;
+            double distance = 0.0;
+            for (int d = 0; d != dimension; ++d)
+              distance += (p[d]-q[d])*(p[d]-q[d]);
+
+            if (distance < squared_tolerance)
+              welding::unite(&parent[0], i, j);
+          }
+        }
+      }
+    }
+
+    // representatives (roots) are the smallest vertices of their cluster and are numbered in order
+    std::vector<viennagrid_int> roots(count);
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int i = 0; i < count; ++i)
+      roots[i] = welding::find_root(&parent[0], i);
+
+    viennagrid_int new_count = 0;
+    for (viennagrid_int i = 0; i < count; ++i)
+      if (roots[i] == i)
+        new_index[i] = new_count++;
+
+    new_coords.resize(new_count*dimension);
+
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int i = 0; i < count; ++i)
+    {
+      if (roots[i] == i)
+        std::copy(coords + i*dimension, coords + (i+1)*dimension, new_coords.begin() + new_index[i]*dimension);
+      else
+        new_index[i] = new_index[ roots[i] ];
+    }
+
+    return new_count;
+  }
+}
+
+#endif
@@ -0,0 +1,297 @@
+#include "vtk_bulk_conversion.hpp"
+
+#include <algorithm>
+#include <type_traits>
+
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkVersion.h>
+
+namespace viennamesh
+{
+  namespace vtk_bulk
+  {
+    namespace
+    {
+      bool has_duplicate_vertex(viennagrid_element_id const * begin, viennagrid_element_id const * end)
+      {
+        for (viennagrid_element_id const * it = begin; it != end; ++it)
+          if (std::find(it+1, end, *it) != end)
+            return true;
+        return false;
+      }
+
+#if VTK_MAJOR_VERSION >= 9
+      template<typename ArrayT>
+      void copy_connectivity(ArrayT * offsets_array, ArrayT * connectivity_array,
+                             std::vector<viennagrid_int> & offsets,
+                             std::vector<vtkIdType> & connectivity)
+      {
+        vtkIdType offset_count = offsets_array->GetNumberOfValues();
+        vtkIdType connectivity_count = connectivity_array->GetNumberOfValues();
+
+        offsets.assign( offsets_array->GetPointer(0), offsets_array->GetPointer(0) + offset_count );
+        connectivity.assign( connectivity_array->GetPointer(0), connectivity_array->GetPointer(0) + connectivity_count );
+      }
+#endif
+    }
+
+
+
+    vtkSmartPointer<vtkPoints> make_points(viennagrid::mesh const & mesh)
+    {
+      viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension(mesh);
+      viennagrid_int vertex_count = viennagrid::vertex_count(mesh);
+
+      vtkSmartPointer<vtkDoubleArray> data = vtkSmartPointer<vtkDoubleArray>::New();
+      data->SetNumberOfComponents(3);
+
+      viennagrid_numeric * coords = NULL;
+      if (vertex_count > 0)
+        viennagrid_mesh_vertex_coords_pointer(mesh.internal(), &coords);
+
+      if (vertex_count > 0 && geometric_dimension == 3 && std::is_same<viennagrid_numeric, double>::value)
+      {
+        // save = 1: the buffer belongs to the mesh and is never freed by VTK
+        data->SetArray(reinterpret_cast<double *>(coords), 3*vertex_count, 1);
+      }
+      else
+      {
+        data->SetNumberOfTuples(vertex_count);
+        double * points = data->GetPointer(0);
+
+        #pragma omp parallel for
+        for (viennagrid_int i = 0; i < vertex_count; ++i)
+          for (int j = 0; j != 3; ++j)
+            points[3*i+j] = (j < geometric_dimension) ? coords[geometric_dimension*i+j] : 0.0;
+      }
+
+      vtkSmartPointer<vtkPoints> result = vtkSmartPointer<vtkPoints>::New();
+      result->SetData(data);
+      return result;
+    }
+
+
+    vtkSmartPointer<vtkCellArray> make_cells(viennagrid::mesh const & mesh,
+                                             viennagrid_dimension topologic_dimension,
+                                             bool skip_degenerate)
+    {
+      viennagrid_element_id * element_ids_begin;
+      viennagrid_element_id * element_ids_end;
+      viennagrid_mesh_elements_get(mesh.internal(), topologic_dimension, &element_ids_begin, &element_ids_end);
+
+      vtkIdType element_count = element_ids_end - element_ids_begin;
+
+      // vertices of all elements, degenerate ones are dropped later
+      std::vector<viennagrid_element_id *> vertex_ids_begin(element_count);
+      std::vector<viennagrid_element_id *> vertex_ids_end(element_count);
+      for (vtkIdType i = 0; i != element_count; ++i)
+        viennagrid_element_boundary_elements(mesh.internal(), element_ids_begin[i], 0, &vertex_ids_begin[i], &vertex_ids_end[i]);
+
+      std::vector<char> keep(element_count, 1);
+      if (skip_degenerate)
+      {
+        #pragma omp parallel for
+        for (vtkIdType i = 0; i < element_count; ++i)
+          keep[i] = !has_duplicate_vertex(vertex_ids_begin[i], vertex_ids_end[i]);
+      }
+
+      vtkIdType cell_count = 0;
+      vtkIdType connectivity_count = 0;
+      for (vtkIdType i = 0; i != element_count; ++i)
+      {
+        if (!keep[i])
+          continue;
+        ++cell_count;
+        connectivity_count += vertex_ids_end[i] - vertex_ids_begin[i];
+      }
+
+      vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+
+#if VTK_MAJOR_VERSION >= 9
+      vtkSmartPointer<vtkIdTypeArray> offsets = vtkSmartPointer<vtkIdTypeArray>::New();
+      vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+      offsets->SetNumberOfValues(cell_count+1);
+      connectivity->SetNumberOfValues(connectivity_count);
+
+      vtkIdType * offset_ptr = offsets->GetPointer(0);
+      vtkIdType * connectivity_ptr = connectivity->GetPointer(0);
+
+      vtkIdType cell = 0;
+      offset_ptr[0] = 0;
+      for (vtkIdType i = 0; i != element_count; ++i)
+      {
+        if (!keep[i])
+          continue;
+        for (viennagrid_element_id * vit = vertex_ids_begin[i]; vit != vertex_ids_end[i]; ++vit)
+          *connectivity_ptr++ = viennagrid_index_from_element_id(*vit);
+        offset_ptr[cell+1] = offset_ptr[cell] + (vertex_ids_end[i] - vertex_ids_begin[i]);
+        ++cell;
+      }
+
+      cells->SetData(offsets, connectivity);
+#else
+      // legacy layout: every cell is stored as its vertex count followed by its vertices
+      vtkSmartPointer<vtkIdTypeArray> legacy = vtkSmartPointer<vtkIdTypeArray>::New();
+      legacy->SetNumberOfValues(cell_count + connectivity_count);
+
+      vtkIdType * legacy_ptr = legacy->GetPointer(0);
+      for (vtkIdType i = 0; i != element_count; ++i)
+      {
+        if (!keep[i])
+          continue;
+        *legacy_ptr++ = vertex_ids_end[i] - vertex_ids_begin[i];
+        for (viennagrid_element_id * vit = vertex_ids_begin[i]; vit != vertex_ids_end[i]; ++vit)
+          *legacy_ptr++ = viennagrid_index_from_element_id(*vit);
+      }
+
+      cells->SetCells(cell_count, legacy);
+#endif
+
+      return cells;
+    }
+
+
+
+    viennagrid_element_id create_vertices(viennagrid::mesh & mesh, vtkPoints * points)
+    {
+      viennagrid_element_id first_vertex_id = 0;
+      viennagrid_mesh_geometric_dimension_set(mesh.internal(), 3);
+
+      vtkIdType vertex_count = points ? points->GetNumberOfPoints() : 0;
+      if (vertex_count == 0)
+        return first_vertex_id;
+
+      vtkDoubleArray * double_data = vtkDoubleArray::SafeDownCast( points->GetData() );
+      if (double_data && double_data->GetNumberOfComponents() == 3 && std::is_same<viennagrid_numeric, double>::value)
+      {
+        // same layout, the batch create copies directly from the VTK buffer
+        viennagrid_mesh_vertex_batch_create(mesh.internal(), vertex_count,
+                                            reinterpret_cast<viennagrid_numeric *>(double_data->GetPointer(0)),
+                                            &first_vertex_id);
+        return first_vertex_id;
+      }
+
+      std::vector<viennagrid_numeric> coords(3*vertex_count);
+
+      vtkFloatArray * float_data = vtkFloatArray::SafeDownCast( points->GetData() );
+      if (float_data && float_data->GetNumberOfComponents() == 3)
+      {
+        float const * src = float_data->GetPointer(0);
+
+        #pragma omp parallel for
+        for (vtkIdType i = 0; i < 3*vertex_count; ++i)
+          coords[i] = src[i];
+      }
+      else
+      {
+        double point[3];
+        for (vtkIdType i = 0; i != vertex_count; ++i)
+        {
+          points->GetPoint(i, point);
+          std::copy(point, point+3, coords.begin() + 3*i);
+        }
+      }
+
+      viennagrid_mesh_vertex_batch_create(mesh.internal(), vertex_count, coords.data(), &first_vertex_id);
+      return first_vertex_id;
+    }
+
+
+    void get_connectivity(vtkCellArray * cells,
+                          std::vector<viennagrid_int> & offsets,
+                          std::vector<vtkIdType> & connectivity)
+    {
+      offsets.assign(1, 0);
+      connectivity.clear();
+      if (!cells)
+        return;
+
+#if VTK_MAJOR_VERSION >= 9
+      if (cells->IsStorage64Bit())
+        copy_connectivity(cells->GetOffsetsArray64(), cells->GetConnectivityArray64(), offsets, connectivity);
+      else
+        copy_connectivity(cells->GetOffsetsArray32(), cells->GetConnectivityArray32(), offsets, connectivity);
+
+      if (offsets.empty())
+        offsets.assign(1, 0);
+#else
+      vtkIdType cell_count = cells->GetNumberOfCells();
+      vtkIdType const * legacy = cells->GetPointer();
+
+      offsets.resize(cell_count+1);
+      connectivity.resize(cells->GetNumberOfConnectivityEntries() - cell_count);
+
+      vtkIdType position = 0;
+      for (vtkIdType i = 0; i != cell_count; ++i)
+      {
+        vtkIdType size = *legacy++;
+        std::copy(legacy, legacy + size, connectivity.begin() + position);
+        legacy += size;
+        position += size;
+        offsets[i+1] = position;
+      }
+#endif
+    }
+
+
+    bool valid_connectivity(std::vector<vtkIdType> const & connectivity, vtkIdType point_count)
+    {
+      bool valid = true;
+
+      #pragma omp parallel for reduction(&&:valid)
+      for (vtkIdType i = 0; i < static_cast<vtkIdType>(connectivity.size()); ++i)
+        valid = valid && connectivity[i] >= 0 && connectivity[i] < point_count;
+
+      return valid;
+    }
+
+
+    viennagrid_int create_cells(viennagrid::mesh & mesh,
+                                std::vector<viennagrid_element_type> const & types,
+                                std::vector<viennagrid_int> const & offsets,
+                                std::vector<vtkIdType> const & connectivity,
+                                viennagrid_element_id first_vertex_id)
+    {
+      viennagrid_int cell_count = types.size();
+
+      std::vector<viennagrid_int> created(cell_count+1, 0);
+      for (viennagrid_int i = 0; i != cell_count; ++i)
+        created[i+1] = created[i] + ((types[i] == VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT) ? 0 : 1);
+
+      viennagrid_int created_count = created[cell_count];
+      if (created_count == 0)
+        return 0;
+
+      std::vector<viennagrid_element_type> created_types(created_count);
+      std::vector<viennagrid_int> created_offsets(created_count+1, 0);
+
+      for (viennagrid_int i = 0; i != cell_count; ++i)
+        if (types[i] != VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT)
+        {
+          created_types[created[i]] = types[i];
+          created_offsets[created[i]+1] = offsets[i+1] - offsets[i];
+        }
+      for (viennagrid_int i = 0; i != created_count; ++i)
+        created_offsets[i+1] += created_offsets[i];
+
+      std::vector<viennagrid_element_id> vertex_ids( created_offsets[created_count] );
+
+      #pragma omp parallel for
+      for (viennagrid_int i = 0; i < cell_count; ++i)
+      {
+        if (types[i] == VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT)
+          continue;
+
+        viennagrid_int out = created_offsets[created[i]];
+        for (viennagrid_int j = offsets[i]; j != offsets[i+1]; ++j)
+          vertex_ids[out++] = first_vertex_id + connectivity[j];
+      }
+
+      viennagrid_mesh_element_batch_create(mesh.internal(), created_count, created_types.data(), created_offsets.data(),
+                                           vertex_ids.data(), NULL, NULL);
+      return created_count;
+    }
+  }
+}
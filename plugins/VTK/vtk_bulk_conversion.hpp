@@ -0,0 +1,69 @@
+#ifndef VIENNAMESH_ALGORITHM_VTK_BULK_CONVERSION_HPP
+#define VIENNAMESH_ALGORITHM_VTK_BULK_CONVERSION_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <vector>
+
+#include "viennagrid/viennagrid.hpp"
+
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Array based conversion between ViennaGrid meshes and VTK data objects. Points and cells are
+// transferred as whole arrays instead of one vertex or cell at a time, VTK cell arrays are built
+// from offsets and connectivity in one shot and ViennaGrid meshes are built with the batch create
+// functions.
+namespace viennamesh
+{
+  namespace vtk_bulk
+  {
+    // Returns the vertices of mesh as VTK points. If the mesh is three dimensional and
+    // viennagrid_numeric is double, the points share the coordinate buffer of the mesh, which
+    // then has to outlive the points and must not get vertices added or removed meanwhile.
+    vtkSmartPointer<vtkPoints> make_points(viennagrid::mesh const & mesh);
+
+    // Returns all elements of dimension topologic_dimension as VTK cell array, vertex indices
+    // are the indices of the ViennaGrid vertices. Elements with duplicate vertices are skipped
+    // if skip_degenerate is set.
+    vtkSmartPointer<vtkCellArray> make_cells(viennagrid::mesh const & mesh,
+                                             viennagrid_dimension topologic_dimension,
+                                             bool skip_degenerate);
+
+
+    // Creates the points as vertices of mesh in one batch and returns the id of the first one.
+    viennagrid_element_id create_vertices(viennagrid::mesh & mesh, vtkPoints * points);
+
+    // Exports the connectivity of cells, the vertices of cell i are
+    // connectivity[offsets[i]] ... connectivity[offsets[i+1]-1].
+    void get_connectivity(vtkCellArray * cells,
+                          std::vector<viennagrid_int> & offsets,
+                          std::vector<vtkIdType> & connectivity);
+
+    // Returns true if every vertex index in connectivity refers to one of point_count points.
+    bool valid_connectivity(std::vector<vtkIdType> const & connectivity, vtkIdType point_count);
+
+    // Creates the cells of type types[i] with VTK connectivity in one batch, cells with
+    // VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT are skipped. Returns the number of created cells.
+    viennagrid_int create_cells(viennagrid::mesh & mesh,
+                                std::vector<viennagrid_element_type> const & types,
+                                std::vector<viennagrid_int> const & offsets,
+                                std::vector<vtkIdType> const & connectivity,
+                                viennagrid_element_id first_vertex_id);
+  }
+}
+
+#endif
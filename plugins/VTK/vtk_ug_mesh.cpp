@@ -1,67 +1,29 @@
 #include "vtk_ug_mesh.hpp"
+#include "vtk_bulk_conversion.hpp"
 #include "viennagrid/viennagrid.hpp"
 
 #include <vtkCellArray.h>
 
 namespace viennamesh 
 {
-    typedef viennagrid::mesh                                                        ViennaGridMeshType;
-    typedef viennagrid::result_of::const_vertex_range<ViennaGridMeshType>::type     ConstVertexRangeType;
-    typedef viennagrid::result_of::iterator<ConstVertexRangeType>::type             ConstVertexIteratorType;
-    typedef viennagrid::result_of::const_element_range<ViennaGridMeshType, 3>::type ConstCellRangeType;
-    typedef viennagrid::result_of::iterator<ConstCellRangeType>::type               ConstCellIteratorType;
-
-    typedef viennagrid::mesh                                                        MeshType;
-    typedef viennagrid::result_of::element<MeshType>::type                          ElementType;
-    typedef viennagrid::result_of::const_element_range<ElementType>::type           ConstBoundaryElementRangeType;
-    typedef viennagrid::result_of::iterator<ConstBoundaryElementRangeType>::type    ConstBoundaryElementIteratorType;
-
     //conversion from viennagrid to VTK_UnstructuredGrid
     viennamesh_error convert(viennagrid::mesh const &input, VTK_UnstructuredGrid::mesh &output) 
     {
-        viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension( input );
         viennagrid_dimension cell_dimension = viennagrid::cell_dimension( input );
 
-        ConstVertexRangeType    vertices(input);
-        ConstCellRangeType      cells(input);
-
-        vtkSmartPointer<vtkPoints> lVertices = vtkSmartPointer<vtkPoints>::New();
-        vtkSmartPointer<vtkCellArray> lCells = vtkSmartPointer<vtkCellArray>::New();
-
-        for (ConstVertexIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit) 
+        if (cell_dimension != 2 && cell_dimension != 3)
         {
-            lVertices->InsertNextPoint( viennagrid::get_point(input, *vit)[0],
-                                        viennagrid::get_point(input, *vit)[1],
-                                        viennagrid::get_point(input, *vit)[2] );
+            error(1) << "Conversion to VTK_UnstructuredGrid requires a triangle or tetrahedral mesh, cell dimension is " << cell_dimension << std::endl;
+            return VIENNAMESH_ERROR_CONVERSION_FAILED;
         }
 
-        output.SetPoints(lVertices);   
+        //points share the coordinate buffer of the input mesh where possible
+        output.SetPoints( vtk_bulk::make_points(input) );
+        output.SetCoordinateOwner( input );
 
         //std::cout << std::endl << "NNodes: " << output.GetMesh()->GetNumberOfPoints() << std::endl;
 
-        vtkIdType lVertexIndices[4] = {0, 0, 0, 0};  
-
-        for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit) 
-        {         
-            ConstBoundaryElementRangeType boundary_vertices(*cit, 0);
-
-            vtkSmartPointer<vtkTetra> tetra = vtkSmartPointer<vtkTetra>::New();
-
-            int lIndex = 0;
-            for (ConstBoundaryElementIteratorType vit = boundary_vertices.begin(); vit != boundary_vertices.end(); ++vit, ++lIndex) 
-            {
-                lVertexIndices[lIndex] = (vtkIdType) (*vit).id().index();
-            }
-
-            for (size_t j = 0; j < 4; ++j)
-            {
-                tetra->GetPointIds()->SetId(j, lVertexIndices[j]);
-            }
-
-            lCells->InsertNextCell(tetra);
-        }
-
-        output.SetCells(lCells);
+        output.SetCells( (cell_dimension == 3) ? VTK_TETRA : VTK_TRIANGLE, vtk_bulk::make_cells(input, cell_dimension, false) );
 
         return VIENNAMESH_SUCCESS;
     } //end of conversion from viennagrid to VTK_UnstructuredGrid
@@ -69,40 +31,42 @@ namespace viennamesh
     //conversion from VTK_UnstructuredGrid to ViennaGrid
     viennamesh_error convert(VTK_UnstructuredGrid::mesh const & input, viennagrid::mesh & output) 
     {
-        //ViennaGrid typedefs
-        typedef viennagrid::mesh                                                        MeshType;
-        typedef viennagrid::result_of::element<MeshType>::type                          VertexType;
-        typedef viennagrid::result_of::element<MeshType>::type							TetrahedronType;
+        vtkUnstructuredGrid * grid = input.GetMesh();
 
-        //create empty vector of size NumberOfVertices containing viennagrid vertices
-        std::vector<TetrahedronType> tet_handles(input.GetMesh()->GetNumberOfPoints());        
+        std::vector<viennagrid_int> offsets;
+        std::vector<vtkIdType> connectivity;
+        vtk_bulk::get_connectivity( grid->GetCells(), offsets, connectivity );
 
-        //Iterate all points and store their coordinates in the viennagrid tet_handles vector
-        double point[3];
-        for (size_t i = 0; i < input.GetMesh()->GetNumberOfPoints(); ++i)
+        //looking for input cells which do refer to non existing vertices
+        if ( !vtk_bulk::valid_connectivity(connectivity, grid->GetNumberOfPoints()) )
         {
-            input.GetMesh()->GetPoint(i, point);
-            //std::cout << "vertex " << i << ": " << point[0] << " " << point[1] << " " << point[2] << std::endl;
-            tet_handles[i] = viennagrid::make_vertex(output,
-                                                     viennagrid::make_point( point[0],
-                                                                             point[1],
-                                                                             point[2]) 
-                                                    );
-        } //end of Iterate all points and store their coordinates in the viennagrid tet_handles vector
-
-        //Iterating all elements and create their corresponding viennagrid tetrahedrons
-        vtkSmartPointer<vtkIdList> IdList = vtkSmartPointer<vtkIdList>::New();
-
-        for (size_t i = 0; i < input.GetMesh()->GetNumberOfCells(); ++i)
+            error(1) << "Cell refers to non existing vertex." << std::endl;
+            return VIENNAMESH_ERROR_CONVERSION_FAILED;
+        }
+
+        //create all vertices in one batch directly from the VTK point buffer
+        viennagrid_element_id first_vertex_id = vtk_bulk::create_vertices( output, grid->GetPoints() );
+
+        vtkIdType cell_count = offsets.size() - 1;
+        std::vector<viennagrid_element_type> types(cell_count, VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT);
+
+        vtkIdType skipped = 0;
+        for (vtkIdType i = 0; i != cell_count; ++i)
         {
-            input.GetMesh()->GetCellPoints(i, IdList);
-            viennagrid::make_tetrahedron(output,
-                                         tet_handles[IdList->GetId(0)],
-                                         tet_handles[IdList->GetId(1)],
-                                         tet_handles[IdList->GetId(2)],
-                                         tet_handles[IdList->GetId(3)]);
+            int cell_type = grid->GetCellType(i);
+            if (cell_type == VTK_TETRA)
+                types[i] = VIENNAGRID_ELEMENT_TYPE_TETRAHEDRON;
+            else if (cell_type == VTK_TRIANGLE)
+                types[i] = VIENNAGRID_ELEMENT_TYPE_TRIANGLE;
+            else
+                ++skipped;
         }
 
+        if (skipped > 0)
+            warning(1) << "Skipped " << skipped << " cells which are neither tetrahedra nor triangles" << std::endl;
+
+        vtk_bulk::create_cells( output, types, offsets, connectivity, first_vertex_id );
+
         return VIENNAMESH_SUCCESS;
     } //end of conversion from VTK_UnstructuredGrid to ViennaGrid
 
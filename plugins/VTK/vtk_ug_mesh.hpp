@@ -15,6 +15,7 @@
    License:         MIT (X11), see file LICENSE in the base directory
 =============================================================================== */
 
+#include <memory>
 #include "viennameshpp/plugin.hpp"
 #include <vtkUnstructuredGrid.h>
 #include <vtkSmartPointer.h>
@@ -32,11 +33,16 @@ namespace viennamesh
 
                 void SetPoints(vtkPoints * points) { m_mesh->SetPoints(points); }
                 void SetCells(vtkCellArray * cells) { m_mesh->SetCells(VTK_TETRA, cells); }
+                void SetCells(int cell_type, vtkCellArray * cells) { m_mesh->SetCells(cell_type, cells); }
+
+                //keeps a mesh alive whose coordinate buffer is shared by the points
+                void SetCoordinateOwner(viennagrid::mesh const & owner) { m_coordinate_owner = std::make_shared<viennagrid::mesh>(owner); }
             
                 vtkPoints* GetPoints() const { return m_mesh->GetPoints(); }
                 vtkCellArray* GetCells() const { return m_mesh->GetCells(); }
             private:
                 vtkSmartPointer<vtkUnstructuredGrid> m_mesh;
+                std::shared_ptr<viennagrid::mesh> m_coordinate_owner;
         };
 
         typedef VTK_UG_Wrapper mesh;
@@ -5,20 +5,14 @@
 #include <vtkSmartPointer.h>
 #include "viennagrid/viennagrid.hpp"
 #include "vtp_mesh.hpp"
+#include "vtk_bulk_conversion.hpp"
 #include <vtkDoubleArray.h>
 #include <vtkTetra.h>
 
 typedef viennagrid::mesh                                                        ViennaGridMeshType;
-typedef viennagrid::result_of::const_vertex_range<ViennaGridMeshType>::type     ConstVertexRangeType;
-typedef viennagrid::result_of::iterator<ConstVertexRangeType>::type             ConstVertexIteratorType;
 typedef viennagrid::result_of::const_element_range<ViennaGridMeshType, 2>::type ConstCellRangeType;
 typedef viennagrid::result_of::iterator<ConstCellRangeType>::type               ConstCellIteratorType;
 
-typedef viennagrid::mesh                                                        MeshType;
-typedef viennagrid::result_of::element<MeshType>::type                          ElementType;
-typedef viennagrid::result_of::const_element_range<ElementType>::type           ConstBoundaryElementRangeType;
-typedef viennagrid::result_of::iterator<ConstBoundaryElementRangeType>::type    ConstBoundaryElementIteratorType;
-
 namespace viennamesh {
 
     viennamesh_error convert(viennagrid::mesh const &input, VTK_PolyData::mesh &output) {
@@ -28,56 +22,24 @@ namespace viennamesh {
         viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension( input );
         viennagrid_dimension cell_dimension = viennagrid::cell_dimension( input );
 
-        ConstVertexRangeType    vertices(input);
-        ConstCellRangeType      cells(input);
-
-        vtkSmartPointer<vtkPoints> lVertices = vtkSmartPointer<vtkPoints>::New();
-        vtkSmartPointer<vtkCellArray> lCells = vtkSmartPointer<vtkCellArray>::New();
-
         //Hull mesh
         if (geometric_dimension == 3 && cell_dimension == 2)
         {
-
-            for (ConstVertexIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit) {
-                lVertices->InsertNextPoint(
-                        viennagrid::get_point(input, *vit)[0],
-                        viennagrid::get_point(input, *vit)[1],
-                        viennagrid::get_point(input, *vit)[2]
-                );
-            }
-
-            vtkIdType lVertexIndices[3] = {0, 0, 0};
-
+            ConstCellRangeType cells(input);
             for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit) {
                 if (!(*cit).is_triangle())
                 {
                     error(1) << "vtk_simplify_mesh just operates on triangle meshes" << std::endl;
                     return false; // This plugin just operates on triangle meshes
                 }
-
-                ConstBoundaryElementRangeType boundary_vertices(*cit, 0);
-
-                int lIndex = 0;
-                for (ConstBoundaryElementIteratorType vit = boundary_vertices.begin(); vit != boundary_vertices.end(); ++vit, ++lIndex) {
-                    lVertexIndices[lIndex] = (vtkIdType) (*vit).id().index();
-
-                    // Looking for input cells which do refer to non existing vertices.
-                    if (lVertexIndices[lIndex] >= lVertices->GetNumberOfPoints())
-                        error(1) << "Cell refers to non existing vertex." << std::endl;
-                }
-
-                // Looking for degenerated cells after viennagrid removed duplicate vertices
-                // TODO: Solve degenerated cells problem in viennagrid vtk reader
-                if (lVertexIndices[0] != lVertexIndices[1]
-                && lVertexIndices[0] != lVertexIndices[2]
-                && lVertexIndices[1] != lVertexIndices[2])
-                {
-                    lCells->InsertNextCell(3, lVertexIndices);
-                }
             }
 
-            output.SetPoints(lVertices);
-            output.SetPolys(lCells);
+            // Points share the coordinate buffer of the input mesh, cells are built from one
+            // connectivity array. Degenerated cells after viennagrid removed duplicate vertices are skipped
+            // TODO: Solve degenerated cells problem in viennagrid vtk reader
+            output.SetPoints(vtk_bulk::make_points(input));
+            output.SetCoordinateOwner(input);
+            output.SetPolys(vtk_bulk::make_cells(input, cell_dimension, true));
         } // end of if (geometric_dimension == 2)
 
         //3D Volume mesh
@@ -102,42 +64,35 @@ namespace viennamesh {
         /*debug(5) << "Converting from vtk to viennagrid. (2D)" << std::endl;
         debug(5) << "Input has: " << input.GetMesh()->GetNumberOfCells() << " cells" << std::endl;*/
 
-        typedef viennagrid::mesh                                MeshType;
-        typedef viennagrid::result_of::element<MeshType>::type  VertexType;
-
-        vtkSmartPointer<vtkPoints> lVertices = vtkSmartPointer<vtkPoints>::New();
-        lVertices = input.GetPoints();
+        std::vector<viennagrid_int> offsets;
+        std::vector<vtkIdType> connectivity;
+        vtk_bulk::get_connectivity(input.GetPolys(), offsets, connectivity);
 
-        vtkSmartPointer<vtkCellArray> lCells = vtkSmartPointer<vtkCellArray>::New();
-        lCells = input.GetPolys();
+        // Looking for input cells which do refer to non existing vertices.
+        vtkIdType point_count = input.GetPoints() ? input.GetPoints()->GetNumberOfPoints() : 0;
+        if (!vtk_bulk::valid_connectivity(connectivity, point_count)) {
+            error(1) << "Cell refers to non existing vertex." << std::endl;
+            return VIENNAMESH_ERROR_CONVERSION_FAILED;
+        }
 
-        vtkIdType lNumberOfVertices = lVertices->GetNumberOfPoints();
+        // all vertices are created in one batch directly from the VTK point buffer
+        viennagrid_element_id first_vertex_id = vtk_bulk::create_vertices(output, input.GetPoints());
 
-        std::vector<VertexType> vertex_handles;
-        vertex_handles.reserve(lNumberOfVertices);
+        vtkIdType cell_count = offsets.size() - 1;
+        std::vector<viennagrid_element_type> types(cell_count, VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT);
 
-        for(vtkIdType i = 0; i < lNumberOfVertices; ++i)
-        {
-            double* lVertex = lVertices->GetPoint(i);
-
-            vertex_handles[i] = viennagrid::make_vertex
-                                    (
-                                    output,
-                                    viennagrid::make_point(lVertex[0],
-                                                           lVertex[1],
-                                                           lVertex[2])
-                                    );
+        vtkIdType skipped = 0;
+        for (vtkIdType i = 0; i != cell_count; ++i) {
+            if (offsets[i+1] - offsets[i] == 3)
+                types[i] = VIENNAGRID_ELEMENT_TYPE_TRIANGLE;
+            else
+                ++skipped;
         }
 
-        vtkIdList *lVertexIndices = vtkIdList::New();
-        while(lCells->GetNextCell(lVertexIndices)) {
-            viennagrid::make_triangle(
-                    output,
-                    vertex_handles[lVertexIndices->GetId(0)],
-                    vertex_handles[lVertexIndices->GetId(1)],
-                    vertex_handles[lVertexIndices->GetId(2)]
-            );
-        }
+        if (skipped > 0)
+            warning(1) << "Skipped " << skipped << " polygons which are not triangles" << std::endl;
+
+        vtk_bulk::create_cells(output, types, offsets, connectivity, first_vertex_id);
 
         info(5) << "Finished converting from VTK_PolyData to viennagrid." << std::endl;
         return VIENNAMESH_SUCCESS;
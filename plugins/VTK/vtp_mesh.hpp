@@ -16,6 +16,7 @@
 =============================================================================== */
 
 #include <list>
+#include <memory>
 #include "viennameshpp/plugin.hpp"
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
@@ -51,7 +52,8 @@ namespace viennamesh
               vtkPolyDataWrapper(const vtkPolyDataWrapper& cpy) :
                       m_Mesh(cpy.m_Mesh),
                       m_ID(cpy.m_ID),
-                      m_IsCopy(true)
+                      m_IsCopy(true),
+                      m_CoordinateOwner(cpy.m_CoordinateOwner)
               {
                   debug(5) << "MESH GETS COPIED, id: " << m_ID << std::endl;
               }
@@ -62,6 +64,9 @@ namespace viennamesh
               void SetPoints(vtkPoints * points) { m_Mesh->SetPoints(points); }
               void SetPolys(vtkCellArray * polys) { m_Mesh->SetPolys(polys); }
 
+              //keeps a mesh alive whose coordinate buffer is shared by the points
+              void SetCoordinateOwner(viennagrid::mesh const & owner) { m_CoordinateOwner = std::make_shared<viennagrid::mesh>(owner); }
+
               vtkPoints* GetPoints() const { return m_Mesh->GetPoints(); }
               vtkCellArray* GetPolys() const { return m_Mesh->GetPolys(); }
 
@@ -69,6 +74,7 @@ namespace viennamesh
               vtkSmartPointer<vtkPolyData> m_Mesh;
               int m_ID;
               bool m_IsCopy;
+              std::shared_ptr<viennagrid::mesh> m_CoordinateOwner;
       };
 
       typedef vtkPolyDataWrapper mesh;
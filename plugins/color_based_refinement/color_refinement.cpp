@@ -21,6 +21,8 @@ namespace viennamesh
 			string_handle algorithm = get_input<string_handle>("algorithm");
 			string_handle coloring_algorithm = get_input<string_handle>("coloring");
 			data_handle<int> max_num_iterations = get_required_input<int>("max_num_iterations");
+			quantity_field_handle metric_field = get_input<viennagrid::quantity_field>("metric");
+			quantity_field_handle sizing_field = get_input<viennagrid::quantity_field>("sizing_field");
 
 			Mesh<double> * in_mesh = input_mesh().mesh;
 
@@ -177,6 +179,67 @@ namespace viennamesh
 
 			MeshPartitions InputMesh(input_mesh().mesh, num_partitions(), input_file().substr(found+1), num_threads(), algorithm()); 
 
+			//per-vertex metric tensors (upper triangle, row-wise) or isotropic sizes enable the coarsen-refine-swap-smooth cycle
+			//of pragmatic and pragmaticcavity, triangle and tetgen refine by their options only
+			if ((metric_field.valid() || sizing_field.valid()) && (algo == "triangle" || algo == "tetgen"))
+			{
+				viennamesh::error(1) << "Metric and sizing fields are not supported by algorithm '" << algo << "'" << std::endl;
+				return false;
+			}
+
+			if (metric_field.valid() || sizing_field.valid())
+			{
+				size_t dim = in_mesh->get_number_dimensions();
+				size_t msize = (dim == 2) ? 3 : 6;
+				size_t NNodes = in_mesh->get_number_nodes();
+
+				viennagrid::quantity_field field = metric_field.valid() ? metric_field() : sizing_field();
+				size_t values_per_quantity = metric_field.valid() ? msize : 1;
+
+				if (field.topologic_dimension() != 0 || field.values_per_quantity() != values_per_quantity || field.size() < NNodes)
+				{
+					viennamesh::error(1) << "Quantity field \"" << field.get_name() << "\" needs " << values_per_quantity
+										 << " values on each of the " << NNodes << " vertices" << std::endl;
+					return false;
+				}
+
+				std::vector<double> metric(msize*NNodes);
+
+				for (size_t i = 0; i < NNodes; ++i)
+				{
+					void * values;
+					viennagrid_quantity_field_value_get(field.internal(), i, &values);
+					viennagrid_numeric const * v = static_cast<viennagrid_numeric const *>(values);
+
+					if (metric_field.valid())
+					{
+						std::copy(v, v+msize, &metric[msize*i]);
+					}
+
+					else
+					{
+						//isotropic metric for the desired edge length h: M = I/h^2
+						double m = 1.0/(v[0]*v[0]);
+
+						if (dim == 2)
+						{
+							metric[3*i] = m; metric[3*i+1] = 0.0; metric[3*i+2] = m;
+						}
+
+						else
+						{
+							metric[6*i] = m; metric[6*i+1] = 0.0; metric[6*i+2] = 0.0;
+							metric[6*i+3] = m; metric[6*i+4] = 0.0; metric[6*i+5] = m;
+						}
+					}
+				}
+
+				if (!InputMesh.SetMetricField(metric))
+					return false;
+
+				viennamesh::info(1) << "  Metric: " << (metric_field.valid() ? "tensor field" : "sizing field") << " \"" << field.get_name() << "\", adaptation cycle enabled" << std::endl;
+			}
+
 			//SERIAL PART
 			auto overall_tic = std::chrono::system_clock::now();
 			
@@ -88,6 +88,7 @@ public:
         delete_slivers = false;
         surface_coarsening = false;
         quality_constrained = false;
+        boundary_locking = false;
     }
 
     /// Default destructor.
@@ -103,15 +104,39 @@ public:
     void coarsen(real_t L_low, real_t L_max,
                  bool enable_surface_coarsening=false,
                  bool enable_delete_slivers=false,
-                 bool enable_quality_constrained=false)
+                 bool enable_quality_constrained=false,
+                 bool enable_boundary_locking=false)
     {
 
         surface_coarsening = enable_surface_coarsening;
         delete_slivers = enable_delete_slivers;
         quality_constrained = enable_quality_constrained;
+        boundary_locking = enable_boundary_locking;
 
         size_t NNodes = _mesh->get_number_nodes();
 
+        //MY IMPLEMENTATION
+        //vertices on boundary facets are never removed if boundary locking is enabled, for mesh partitions
+        //this keeps the interface vertices shared with neighboring partitions untouched
+        is_boundary.assign(NNodes, 0);
+        if(boundary_locking) {
+            size_t NElements = _mesh->get_number_elements();
+            for(size_t i=0; i<NElements; i++) {
+                const int *n=_mesh->get_element(i);
+                if(n[0]<0)
+                    continue;
+
+                for(size_t j=0; j<nloc; j++) {
+                    if(_mesh->boundary[i*nloc+j]>0) {
+                        for(size_t k=1; k<nloc; k++) {
+                            is_boundary[n[(j+k)%nloc]] = 1;
+                        }
+                    }
+                }
+            }
+        }
+        //END OF MY IMPLEMENTATION
+
         _L_low = L_low;
         _L_max = L_max;
 
@@ -236,6 +261,10 @@ private:
         if(_mesh->is_halo_node(rm_vertex))
             return -1;
 
+        // Locked boundary vertex.
+        if(is_boundary[rm_vertex])
+            return -1;
+
         //
         bool delete_with_extreme_prejudice = false;
         if(delete_slivers && dim==3) {
@@ -600,7 +629,8 @@ private:
     std::vector<Lock> vLocks;
 
     real_t _L_low, _L_max;
-    bool delete_slivers, surface_coarsening, quality_constrained;
+    bool delete_slivers, surface_coarsening, quality_constrained, boundary_locking;
+    std::vector<char> is_boundary;
 
     const static size_t ndims=dim;
     const static size_t nloc=dim+1;
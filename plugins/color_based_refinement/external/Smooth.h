@@ -283,6 +283,85 @@ public:
         return;
     }
 
+    //MY IMPLEMENTATION
+    // Smart laplacian smoothing driven by a vertex coloring instead of vertex locks. color_vertices
+    // holds the vertices of each color, vertices of the same color must not be adjacent. The
+    // vertices of one color are smoothed concurrently by nthreads threads, the colors are processed
+    // one after another. Because no two vertices of a color share an element the result does not
+    // depend on the thread count or the scheduling.
+    void smart_laplacian_colored(const std::vector< std::vector<index_t> >& color_vertices, int nthreads,
+                                 int max_iterations=10, double quality_tol=-1.0)
+    {
+        int NNodes = _mesh->get_number_nodes();
+        int NElements = _mesh->get_number_elements();
+
+        if(NElements==0)
+            return;
+
+        std::vector<char> is_boundary(NNodes, 0);
+        std::vector< std::atomic<bool> > active_vertices(NNodes);
+
+        for(int n=0; n<NNodes; ++n)
+            active_vertices[n].store(!_mesh->NNList[n].empty(), std::memory_order_relaxed);
+
+        for(int i=0; i<NElements; i++) {
+            const int *n=_mesh->get_element(i);
+            if(n[0]<0)
+                continue;
+
+            for(size_t j=0; j<nloc; j++) {
+                if(_mesh->boundary[i*nloc+j]>0) {
+                    for(size_t k=1; k<nloc; k++) {
+                        is_boundary[n[(j+k)%nloc]] = 1;
+                    }
+                }
+            }
+        }
+
+        good_q = quality_tol;
+        if(good_q<0) {
+            double qsum=0;
+            for(int i=0; i<NElements; i++) {
+                const int *n=_mesh->get_element(i);
+                if(n[0]<0)
+                    continue;
+
+                assert(std::isfinite(_mesh->quality[i]));
+                qsum+=_mesh->quality[i];
+            }
+            good_q = qsum/NElements;
+        }
+
+        for(int iter=0; iter<max_iterations; ++iter) {
+            bool moved = false;
+
+            for(const auto& vertices : color_vertices) {
+                int nvertices = vertices.size();
+
+                // Vertices of one color are independent, all writes of smart_laplacian_kernel go to the
+                // vertex itself and its elements. A neighbor only ever gets activated, never deactivated.
+                #pragma omp parallel for schedule(static) num_threads(nthreads) reduction(||:moved)
+                for(int v=0; v<nvertices; ++v) {
+                    index_t node = vertices[v];
+                    if(node>=NNodes || _mesh->is_halo_node(node) || is_boundary[node] || !active_vertices[node].load(std::memory_order_relaxed))
+                        continue;
+
+                    if(smart_laplacian_kernel(node)) {
+                        for(const auto& it : _mesh->NNList[node])
+                            active_vertices[it].store(true, std::memory_order_relaxed);
+                        moved = true;
+                    } else {
+                        active_vertices[node].store(false, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            if(!moved)
+                break;
+        }
+    }
+    //END OF MY IMPLEMENTATION
+
     // Linf optimisation based smoothing..
     void optimisation_linf(int max_iterations=10, double quality_tol=-1.0)
     {
@@ -372,8 +372,165 @@ public:
         }
     }
 
+    //MY IMPLEMENTATION
+    // Edge swapping driven by a distance-2 vertex coloring instead of vertex locks. color_vertices
+    // holds the vertices of each color, vertices of the same color must not share a neighbor. A
+    // vertex swaps the edges it is the smaller end point of, which only modifies its own patch, so
+    // the vertices of one color are processed concurrently by nthreads threads. Swaps of earlier
+    // colors add edges and can leave the coloring stale, hence a vertex first claims its patch and
+    // vertices which lose a claim are deferred and processed serially after the last color. The
+    // result does not depend on the thread count or the scheduling. Only 2D meshes are swapped
+    // concurrently, 3D swaps append elements to the mesh and fall back to the serial swap().
+    void swap_colored(real_t quality_tolerance, const std::vector< std::vector<index_t> >& color_vertices,
+                      int nthreads, int max_sweeps=10)
+    {
+        if(dim==3 || nthreads<2) {
+            swap(quality_tolerance);
+            return;
+        }
+
+        size_t NNodes = _mesh->get_number_nodes();
+        size_t NElements = _mesh->get_number_elements();
+
+        std::vector<char> is_boundary(NNodes, 0);
+        for(size_t i=0; i<NElements; i++) {
+            const int *n=_mesh->get_element(i);
+            if(n[0]<0)
+                continue;
+
+            for(size_t j=0; j<nloc; j++) {
+                if(_mesh->boundary[i*nloc+j]>0) {
+                    for(size_t k=1; k<nloc; k++)
+                        is_boundary[n[(j+k)%nloc]] = 1;
+                }
+            }
+        }
+
+        min_Q = quality_tolerance;
+
+        if(nnodes_reserve<NNodes) {
+            nnodes_reserve = NNodes;
+            marked_edges.resize(NNodes);
+            vLocks.resize(NNodes);
+        }
+
+        // A claim stores the stage in the upper and the claiming vertex in the lower 32 bit, the
+        // smallest vertex of the current stage wins. Claims of previous stages are simply overwritten.
+        std::vector< std::atomic<long long> > owner(NNodes);
+        for(size_t n=0; n<NNodes; ++n)
+            owner[n].store(-1, std::memory_order_relaxed);
+
+        long long stage = 0;
+        for(int sweep=0; sweep<max_sweeps; ++sweep) {
+            bool swapped = false;
+            std::vector<index_t> deferred;
+
+            for(const auto& vertices : color_vertices) {
+                int nvertices = vertices.size();
+                std::vector<char> state(nvertices, 0);   // 0 idle, 1 claimed, 2 deferred
+                ++stage;
+
+                #pragma omp parallel for schedule(static) num_threads(nthreads)
+                for(int v=0; v<nvertices; ++v) {
+                    index_t node = vertices[v];
+                    if(node>=(index_t)NNodes || is_boundary[node] || _mesh->NNList[node].empty())
+                        continue;
+                    if(sweep>0 && marked_edges[node].empty())
+                        continue;
+
+                    state[v] = 1;
+                    claim(owner[node], stage, node);
+                    for(const auto& it : _mesh->NNList[node])
+                        claim(owner[it], stage, node);
+                }
+
+                #pragma omp parallel for schedule(static) num_threads(nthreads)
+                for(int v=0; v<nvertices; ++v) {
+                    if(state[v]!=1)
+                        continue;
+
+                    index_t node = vertices[v];
+                    const long long key = (stage<<32) | node;
+                    bool owns_patch = owner[node].load(std::memory_order_relaxed)==key;
+                    for(const auto& it : _mesh->NNList[node])
+                        owns_patch = owns_patch && owner[it].load(std::memory_order_relaxed)==key;
+
+                    if(!owns_patch)
+                        state[v] = 2;
+                }
+
+                #pragma omp parallel for schedule(static) num_threads(nthreads) reduction(||:swapped)
+                for(int v=0; v<nvertices; ++v) {
+                    if(state[v]==1)
+                        swapped = swap_vertex(vertices[v], sweep==0) || swapped;
+                }
+
+                for(int v=0; v<nvertices; ++v)
+                    if(state[v]==2)
+                        deferred.push_back(vertices[v]);
+            }
+
+            for(const auto& node : deferred)
+                swapped = swap_vertex(node, sweep==0) || swapped;
+
+            if(!swapped)
+                break;
+        }
+    }
+    //END OF MY IMPLEMENTATION
+
 private:
 
+    //MY IMPLEMENTATION
+    // Swaps the marked edges of node and, if check_quality is set, the edges of its poor elements.
+    // Only edges to current neighbors are touched, so all modifications stay within the patch of node.
+    inline bool swap_vertex(index_t node, bool check_quality)
+    {
+        std::set< Edge<index_t> > active_edges;
+        if(check_quality) {
+            for(auto& ele : _mesh->NEList[node]) {
+                if(_mesh->quality[ele] < min_Q) {
+                    const index_t* n = _mesh->get_element(ele);
+                    for(int i=0; i<nloc; ++i) {
+                        if(node < n[i])
+                            active_edges.insert(Edge<index_t>(node, n[i]));
+                    }
+                }
+            }
+        }
+        for(auto& target : marked_edges[node])
+            active_edges.insert(Edge<index_t>(node, target));
+        marked_edges[node].clear();
+
+        bool swapped = false;
+        for(auto& edge : active_edges) {
+            index_t target = edge.edge.first==node ? edge.edge.second : edge.edge.first;
+            if(std::find(_mesh->NNList[node].begin(), _mesh->NNList[node].end(), target)==_mesh->NNList[node].end())
+                continue;
+
+            marked_edges[edge.edge.first].erase(edge.edge.second);
+            propagation_map pMap;
+            if(swap_kernel(edge, pMap)) {
+                swapped = true;
+                for(auto& entry : pMap) {
+                    for(auto& v : entry.second)
+                        marked_edges[entry.first].insert(v);
+                }
+            }
+        }
+
+        return swapped;
+    }
+
+    inline static void claim(std::atomic<long long>& owner, long long stage, index_t node)
+    {
+        const long long key = (stage<<32) | node;
+        long long current = owner.load(std::memory_order_relaxed);
+        while(((current>>32)<stage || current>key) && !owner.compare_exchange_weak(current, key, std::memory_order_relaxed)) {
+        }
+    }
+    //END OF MY IMPLEMENTATION
+
     inline bool swap_kernel(const Edge<index_t>& edge, propagation_map& pMap)
     {
         if(dim==2)
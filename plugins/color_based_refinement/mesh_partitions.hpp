@@ -11,6 +11,7 @@
 #include "Swapping.h"
 #include "Refine_cavity.h"
 #include "Smooth.h"
+#include "Coarsen.h"
 
 //TODO: DEBUG
 #include "VTKTools.h"
@@ -24,6 +25,7 @@
 #include "mtmetis.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <numeric>  
 #include <chrono>
@@ -119,6 +121,8 @@ class MeshPartitions
 
         bool ConsistencyCheck();                                                                //Check the consistency of the mesh
 
+        bool SetMetricField(std::vector<double> const & metric);                               //Per-vertex metric tensors of the original mesh, enables the adaptation cycle
+
     private:
 /*
         bool MetisPartitioning(Mesh<double>* original_mesh, int num_regions);                 //Partition mesh using metis
@@ -180,9 +184,11 @@ class MeshPartitions
         std::vector<int> partition_colors;                                                    //Contains the color assigned to each partition
         std::vector<std::vector<int>> color_partitions;                                       //Contains the partition ids assigned to each color
 
-        std::vector<int> vertex_colors;
-        std::vector<std::vector<int>> color_vertices;
-        std::vector<int> num_color_vertices;
+        std::vector<std::vector<int>> vertex_colors;                                          //Contains the color assigned to each vertex of each partition
+        std::vector<std::vector<std::vector<int>>> color_vertices;                            //Contains the vertex ids assigned to each color of each partition
+        std::vector<int> num_color_vertices;                                                  //Stores the number of vertex colors used in each partition
+
+        void ColorPartitionVertices(Mesh<double>* partition, int part_id, int distance);      //Greedy distance-1 or distance-2 vertex coloring of a partition
 
         std::vector<int> previous_nelements;
 
@@ -200,6 +206,11 @@ class MeshPartitions
 
         std::string algorithm;
 
+        //Metric tensor per vertex of the original mesh (3 values in 2D, 6 values in 3D), empty for the default constant metric
+        std::vector<double> vertex_metric;
+        //If true, every partition runs coarsen, refine, swap and smooth instead of refinement only
+        bool adapt = false;
+
         //ElementProperty<double> *property;
 
         //DEBUG
@@ -349,6 +360,25 @@ MeshPartitions::MeshPartitions(Mesh<double> * orig_mesh, int nregions, std::stri
         ndims = 3;
 } //end of Constructor
 
+//SetMetricField
+//
+//Tasks: Stores the metric tensors of the original mesh, which are scattered to the partitions via l2g_vertex
+bool MeshPartitions::SetMetricField(std::vector<double> const & metric)
+{
+    size_t msize = (original_mesh->get_number_dimensions() == 2) ? 3 : 6;
+
+    if (metric.size() != msize * original_mesh->get_number_nodes())
+    {
+        viennamesh::error(1) << " Metric field has " << metric.size() << " values, expected " << msize * original_mesh->get_number_nodes() << std::endl;
+        return false;
+    }
+
+    vertex_metric = metric;
+    adapt = true;
+
+    return true;
+} //end of SetMetricField
+
 //Destructor
 //
 //Tasks: TODO
@@ -1763,6 +1793,10 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
     interfaces.resize(num_regions);
     NNInterfaces.resize(num_regions);
 
+    vertex_colors.resize(num_regions);
+    color_vertices.resize(num_regions);
+    num_color_vertices.resize(num_regions);
+
     std::fill(threads_log.begin(), threads_log.end(), 0.0);
     std::fill(mesh_log.begin(), mesh_log.end(), 0.0);
     std::fill(heal_log.begin(), heal_log.end(), 0.0);
@@ -1845,6 +1879,12 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
     }
 
 
+    //in the adaptation cycle, colors with fewer partitions than threads hand the idle threads to the 2D swapping and the
+    //smoothing inside the partitions
+    int max_active_levels = omp_get_max_active_levels();
+    if (adapt)
+        omp_set_max_active_levels(std::max(max_active_levels, 2));
+
     //iterate the partitions several times
     for (size_t act_iter = 0; act_iter < max_num_iterations; act_iter++)
     {
@@ -1894,6 +1934,11 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
             std::cout << "      " << color << " / " << colors-1 << std::endl;
             std::cout << "      " << "color " << color << " has " << color_partitions[color].size() << " partitions" << std::endl;
             //*/
+            //threads per partition for the 2D swapping and the smoothing of the adaptation cycle (metric field set), only
+            //larger than 1 if this color has fewer partitions than threads. Refinement and 3D swapping are serial within a
+            //partition and always get a single thread.
+            int inner_threads = adapt ? std::max<int>(1, nthreads / std::max<size_t>(1, color_partitions[color].size())) : 1;
+
             #pragma omp parallel for schedule(dynamic) num_threads(nthreads)
             for (size_t part_iter = 0; part_iter < color_partitions[color].size(); ++part_iter)
             {
@@ -2282,7 +2327,11 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                             for (auto i = 0; i < partition->get_number_nodes(); ++i)
                             {
                                 double m[] = {1.0, 1.0, 0.0};
-                                metric_field.set_metric(m, i);
+
+                                if (!vertex_metric.empty())
+                                    metric_field.set_metric(&vertex_metric[3*l2g_vertices_tmp[i]], i);
+                                else
+                                    metric_field.set_metric(m, i);
                             }
                             
                             //           auto metric_update_tic = std::chrono::system_clock::now();
@@ -2325,7 +2374,10 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                                     m[j]/=eta;
                                 m[5] = 1.0;
                                 */
-                                metric_field.set_metric(m, i);
+                                if (!vertex_metric.empty())
+                                    metric_field.set_metric(&vertex_metric[6*l2g_vertices_tmp[i]], i);
+                                else
+                                    metric_field.set_metric(m, i);
                             }
 
                             //auto metric_update_tic = std::chrono::system_clock::now();
@@ -2870,10 +2922,45 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                 //Output timings
                 auto heal_toc = omp_get_wtime();
 
+                //Coarsen the partition once per adaptation cycle, i.e. before its first refinement, if a metric field is given.
+                //Vertices on the partition boundary are locked and the interfaces stay untouched. Removed vertices are compacted
+                //by the defragmentation below.
+                std::unordered_set<int> vertices_before_healing;
+
+                if (adapt && act_iter == 0 && (algorithm == "pragmatic" || algorithm == "pragmaticcavity"))
+                {
+                    double L_max = std::stod(options);
+                    double L_low = 0.5*L_max;
+
+                    vertices_before_healing.insert(l2g_vertices_tmp.begin(), l2g_vertices_tmp.begin() + NNodes_before_healing);
+
+                    if (dim == 2)
+                    {
+                        Coarsen<double,2> coarsener(*partition);
+                        coarsener.coarsen(L_low, L_max, false, false, false, true);
+                    }
+
+                    else
+                    {
+                        Coarsen<double,3> coarsener(*partition);
+                        coarsener.coarsen(L_low, L_max, false, false, false, true);
+                    }
+                }
+
                 auto defrag0_tic = omp_get_wtime();
                 partition->defragment(part_id, l2g_vertices_tmp, g2l_vertices_tmp, act_iter);
                 auto defrag0_toc = omp_get_wtime();
 
+                //defragmentation keeps the vertex order, NNodes_before_healing becomes the number of remaining vertices
+                //which existed before healing, i.e. it points at the first vertex inserted by healing again
+                if (!vertices_before_healing.empty())
+                {
+                    NNodes_before_healing = 0;
+                    for (size_t i = 0; i < partition->get_number_nodes(); ++i)
+                        if (vertices_before_healing.count(l2g_vertices_tmp[i]))
+                            ++NNodes_before_healing;
+                }
+
                 defrag_log[omp_get_thread_num()]+= defrag0_toc- defrag0_tic;
 
                 auto interfaces_tic = omp_get_wtime();
@@ -3044,6 +3131,32 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                         l2g_element[part_id] = l2g_elements_tmp;
                         g2l_element[part_id] = g2l_elements_tmp;
                         outboxes[part_id]=outbox_data;
+
+                        //complete the adaptation cycle, swapping and smoothing leave boundary and therefore interface vertices untouched
+                        if (adapt)
+                        {
+                            Swapping<double,2> swapper(*partition);
+                            double swap_tic = omp_get_wtime();
+                            if (inner_threads > 1)
+                            {
+                                ColorPartitionVertices(partition, part_id, 2);
+                                swapper.swap_colored(0.7, color_vertices[part_id], inner_threads);
+                            }
+                            else
+                                swapper.swap(0.7);
+                            swap_time = omp_get_wtime() - swap_tic;
+
+                            Smooth<double,2> smoother(*partition);
+                            double smooth_tic = omp_get_wtime();
+                            if (inner_threads > 1)
+                            {
+                                ColorPartitionVertices(partition, part_id, 1);
+                                smoother.smart_laplacian_colored(color_vertices[part_id], inner_threads);
+                            }
+                            else
+                                smoother.smart_laplacian();
+                            smooth_time = omp_get_wtime() - smooth_tic;
+                        }
                     }
 
                     else
@@ -3112,12 +3225,21 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                         Swapping<double,3> swapper(*partition);
                         double swap_tic = omp_get_wtime();
                         //swapper.swap(0.1);
+                        if (adapt)
+                            swapper.swap(0.1);
                         swap_time = omp_get_wtime() - swap_tic;
 
                         Smooth<double,3> smoother(*partition);
 
                         double smooth_tic = omp_get_wtime();
                         //smoother.smart_laplacian();//*/
+                        if (adapt && inner_threads > 1)
+                        {
+                            ColorPartitionVertices(partition, part_id, 1);
+                            smoother.smart_laplacian_colored(color_vertices[part_id], inner_threads);
+                        }
+                        else if (adapt)
+                            smoother.smart_laplacian();
                         smooth_time = omp_get_wtime() - smooth_tic;
                         /*
                         //Output smoothed partition in each iteration
@@ -3682,6 +3804,26 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
                     //END OF DEBUG*/
 
                     //std::cout << "NElements after refinement " <<  partition->get_number_elements() << " NVertices after refinement " << partition->get_number_nodes() << std::endl;
+
+                    //complete the adaptation cycle like the 3D pragmatic path does
+                    if (adapt)
+                    {
+                        Swapping<double,3> swapper(*partition);
+                        double swap_tic = omp_get_wtime();
+                        swapper.swap(0.1);
+                        swap_time = omp_get_wtime() - swap_tic;
+
+                        Smooth<double,3> smoother(*partition);
+                        double smooth_tic = omp_get_wtime();
+                        if (inner_threads > 1)
+                        {
+                            ColorPartitionVertices(partition, part_id, 1);
+                            smoother.smart_laplacian_colored(color_vertices[part_id], inner_threads);
+                        }
+                        else
+                            smoother.smart_laplacian();
+                        smooth_time = omp_get_wtime() - smooth_tic;
+                    }
                 } //end of pragmaticcavity
 
                 auto refine_toc = omp_get_wtime();
@@ -3762,6 +3904,8 @@ bool MeshPartitions::CreatePragmaticDataStructures_par(std::string algorithm, st
         //std::cout << std::endl;
     } //end of number_iterations
 
+    omp_set_max_active_levels(max_active_levels);
+
     auto for_toc = omp_get_wtime();
 
     for_time = for_toc - for_tic;
@@ -3864,6 +4008,62 @@ void MeshPartitions::GetRefinementStats(int* nodes, int* elements, std::string a
 }
 //end of GetRefinementStats
 
+//MeshPartitions::ColorPartitionVertices
+//
+//Tasks: Greedy vertex coloring of a partition in vertex order. With distance 1 adjacent vertices get different colors,
+//with distance 2 vertices sharing a neighbor get different colors as well. Vertices without neighbors are not colored.
+//The coloring only depends on the partition, hence it is the same for any number of threads.
+void MeshPartitions::ColorPartitionVertices(Mesh<double>* partition, int part_id, int distance)
+{
+    int NNodes = partition->get_number_nodes();
+
+    std::vector<int>& colors = vertex_colors[part_id];
+    std::vector<std::vector<int>>& vertices = color_vertices[part_id];
+
+    colors.assign(NNodes, -1);
+    vertices.clear();
+
+    //forbidden[c] == n marks color c as used in the neighborhood of vertex n
+    std::vector<int> forbidden;
+
+    for (int n = 0; n < NNodes; ++n)
+    {
+        if (partition->NNList[n].empty())
+            continue;
+
+        for (auto neighbor : partition->NNList[n])
+        {
+            if (colors[neighbor] >= 0)
+                forbidden[colors[neighbor]] = n;
+
+            if (distance > 1)
+            {
+                for (auto second_neighbor : partition->NNList[neighbor])
+                {
+                    if (second_neighbor != n && colors[second_neighbor] >= 0)
+                        forbidden[colors[second_neighbor]] = n;
+                }
+            }
+        }
+
+        size_t color = 0;
+        while (color < vertices.size() && forbidden[color] == n)
+            ++color;
+
+        if (color == vertices.size())
+        {
+            vertices.push_back(std::vector<int>());
+            forbidden.push_back(-1);
+        }
+
+        colors[n] = color;
+        vertices[color].push_back(n);
+    }
+
+    num_color_vertices[part_id] = vertices.size();
+}
+//end of ColorPartitionVertices
+
 //MeshPartitions::edgeNumber
 //
 //Tasks: Returns edge number
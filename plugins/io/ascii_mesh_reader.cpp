@@ -0,0 +1,425 @@
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include "ascii_mesh_reader.hpp"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include "ascii_parser.hpp"
+#include "mapped_file.hpp"
+
+namespace viennamesh
+{
+  namespace
+  {
+    // moves it to the next line which is neither empty nor a comment, returns false at the end
+    bool next_valid_line(char const * & it, char const * end, ascii::chunk & line, char comment)
+    {
+      while (it != end)
+      {
+        line = ascii::get_line(it, end);
+
+        char const * first = line.begin;
+        ascii::skip_blanks(first, line.end);
+        if (first != line.end && *first != comment)
+          return true;
+      }
+
+      return false;
+    }
+
+
+    // creates all vertices in one batch and returns the id of the first one
+    viennagrid_element_id create_vertices(viennagrid::mesh & mesh,
+                                          std::vector<viennagrid_numeric> & coords,
+                                          viennagrid_dimension geometric_dimension)
+    {
+      viennagrid_element_id first_vertex_id = 0;
+      viennagrid_mesh_geometric_dimension_set(mesh.internal(), geometric_dimension);
+      if (coords.empty())
+        return first_vertex_id;
+
+      viennagrid_mesh_vertex_batch_create(mesh.internal(), coords.size() / geometric_dimension,
+                                          &coords[0], &first_vertex_id);
+      return first_vertex_id;
+    }
+
+    // creates triangles from vertex indices (three per triangle) in one batch
+    void create_triangles(viennagrid::mesh & mesh,
+                          std::vector<viennagrid_int> const & vertex_indices,
+                          viennagrid_element_id first_vertex_id)
+    {
+      viennagrid_int triangle_count = vertex_indices.size() / 3;
+      if (triangle_count == 0)
+        return;
+
+      std::vector<viennagrid_element_type> types(triangle_count, VIENNAGRID_ELEMENT_TYPE_TRIANGLE);
+      std::vector<viennagrid_int> offsets(triangle_count+1);
+      std::vector<viennagrid_element_id> vertex_ids(vertex_indices.size());
+
+      #pragma omp parallel for
+      for (viennagrid_int i = 0; i < triangle_count; ++i)
+      {
+        offsets[i] = 3*i;
+        for (int j = 0; j != 3; ++j)
+          vertex_ids[3*i+j] = first_vertex_id + vertex_indices[3*i+j];
+      }
+      offsets[triangle_count] = 3*triangle_count;
+
+      viennagrid_mesh_element_batch_create(mesh.internal(), triangle_count, &types[0], &offsets[0], &vertex_ids[0], NULL, NULL);
+    }
+
+
+    template<typename T>
+    void concatenate(std::vector< std::vector<T> > const & parts, std::vector<T> & result)
+    {
+      std::vector<std::size_t> offsets(parts.size()+1, 0);
+      for (std::size_t i = 0; i != parts.size(); ++i)
+        offsets[i+1] = offsets[i] + parts[i].size();
+
+      result.resize(offsets.back());
+
+      #pragma omp parallel for schedule(dynamic)
+      for (int i = 0; i < static_cast<int>(parts.size()); ++i)
+        std::copy(parts[i].begin(), parts[i].end(), result.begin() + offsets[i]);
+    }
+
+
+
+    struct silvaco_chunk_result
+    {
+      silvaco_chunk_result() : error_line(NULL) {}
+
+      std::vector<long> vertex_ids;
+      std::vector<viennagrid_numeric> coords;
+      std::vector<long> triangle_vertex_ids;
+      char const * error_line;
+    };
+
+    void parse_silvaco_chunk(ascii::chunk const & chunk, silvaco_chunk_result & result)
+    {
+      char const * it = chunk.begin;
+      ascii::chunk line;
+      ascii::chunk type;
+
+      while (next_valid_line(it, chunk.end, line, '#'))
+      {
+        char const * pos = line.begin;
+        ascii::parse_token(pos, line.end, type);
+
+        if (ascii::token_equals(type, "c"))
+        {
+          long id;
+          double point[3];
+          if (!ascii::parse_long(pos, line.end, id) ||
+              !ascii::parse_double(pos, line.end, point[0]) ||
+              !ascii::parse_double(pos, line.end, point[1]) ||
+              !ascii::parse_double(pos, line.end, point[2]))
+          {
+            result.error_line = line.begin;
+            return;
+          }
+
+          result.vertex_ids.push_back(id);
+          result.coords.insert(result.coords.end(), point, point+3);
+        }
+        else if (ascii::token_equals(type, "t"))
+        {
+          long id;
+          ascii::chunk region;
+          long vertex_ids[3];
+          if (!ascii::parse_long(pos, line.end, id) ||
+              !ascii::parse_token(pos, line.end, region) ||
+              !ascii::parse_long(pos, line.end, vertex_ids[0]) ||
+              !ascii::parse_long(pos, line.end, vertex_ids[1]) ||
+              !ascii::parse_long(pos, line.end, vertex_ids[2]))
+          {
+            result.error_line = line.begin;
+            return;
+          }
+
+          result.triangle_vertex_ids.insert(result.triangle_vertex_ids.end(), vertex_ids, vertex_ids+3);
+        }
+      }
+    }
+
+
+    void throw_error_line(std::string const & filename, std::string const & message, char const * line, char const * end)
+    {
+      char const * line_end = line;
+      ascii::next_line(line_end, end);
+      throw ascii_mesh_error("File " + filename + ": " + message + " \"" + std::string(line, line_end) + "\"");
+    }
+  }
+
+
+
+
+  void read_silvaco_str(std::string const & filename, viennagrid::mesh & mesh)
+  {
+    mapped_file file(filename);
+    char const * it = file.begin();
+    char const * end = file.end();
+
+    // the header is short and parsed sequentially up to the "k 3" line holding the counts
+    long vertex_count = -1;
+    long triangle_count = -1;
+
+    ascii::chunk line;
+    while (vertex_count < 0)
+    {
+      if (!next_valid_line(it, end, line, '#'))
+        throw ascii_mesh_error("File " + filename + ": EOF encountered when reading information");
+
+      char const * pos = line.begin;
+      ascii::chunk token;
+      ascii::parse_token(pos, line.end, token);
+      if (!ascii::token_equals(token, "k"))
+        continue;
+
+      ascii::parse_token(pos, line.end, token);
+      if (!ascii::token_equals(token, "3"))
+        continue;
+
+      if (!ascii::parse_long(pos, line.end, vertex_count) ||
+          !ascii::parse_token(pos, line.end, token) ||
+          !ascii::parse_long(pos, line.end, triangle_count) ||
+          vertex_count < 0 || triangle_count < 0)
+        throw_error_line(filename, "invalid header line", line.begin, end);
+    }
+
+
+    std::vector<ascii::chunk> chunks = ascii::split_lines(it, end, ascii::default_chunk_count());
+    std::vector<silvaco_chunk_result> results(chunks.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(chunks.size()); ++i)
+      parse_silvaco_chunk(chunks[i], results[i]);
+
+    for (std::size_t i = 0; i != results.size(); ++i)
+    {
+      if (results[i].error_line)
+        throw_error_line(filename, "invalid line", results[i].error_line, end);
+    }
+
+
+    std::vector< std::vector<long> > vertex_id_parts(results.size());
+    std::vector< std::vector<viennagrid_numeric> > coord_parts(results.size());
+    std::vector< std::vector<long> > triangle_parts(results.size());
+    for (std::size_t i = 0; i != results.size(); ++i)
+    {
+      vertex_id_parts[i].swap(results[i].vertex_ids);
+      coord_parts[i].swap(results[i].coords);
+      triangle_parts[i].swap(results[i].triangle_vertex_ids);
+    }
+
+    std::vector<long> vertex_ids;
+    std::vector<viennagrid_numeric> coords;
+    std::vector<long> triangle_vertex_ids;
+    concatenate(vertex_id_parts, vertex_ids);
+    concatenate(coord_parts, coords);
+    concatenate(triangle_parts, triangle_vertex_ids);
+
+    if (static_cast<long>(vertex_ids.size()) < vertex_count || static_cast<long>(triangle_vertex_ids.size()) < 3*triangle_count)
+      throw ascii_mesh_error("File " + filename + ": EOF encountered when reading information");
+
+    // only the number of entities given in the header are used, like the sequential reader does
+    vertex_ids.resize(vertex_count);
+    coords.resize(3*vertex_count);
+    triangle_vertex_ids.resize(3*triangle_count);
+
+
+    // map the vertex ids of the file to vertex indices, ids are usually dense and a table is used
+    // in that case, arbitrary ids are looked up in a sorted list
+    std::vector<viennagrid_int> triangle_vertex_indices(triangle_vertex_ids.size());
+    bool invalid_vertex_id = false;
+
+    if (vertex_count > 0)
+    {
+      long min_id = *std::min_element(vertex_ids.begin(), vertex_ids.end());
+      long max_id = *std::max_element(vertex_ids.begin(), vertex_ids.end());
+
+      if (max_id - min_id < 2*vertex_count + 1024)
+      {
+        std::vector<viennagrid_int> index_of_id(max_id - min_id + 1, -1);
+        for (long i = 0; i != vertex_count; ++i)
+          index_of_id[vertex_ids[i] - min_id] = i;
+
+        #pragma omp parallel for reduction(||:invalid_vertex_id)
+        for (long i = 0; i < static_cast<long>(triangle_vertex_ids.size()); ++i)
+        {
+          long id = triangle_vertex_ids[i];
+          triangle_vertex_indices[i] = (id < min_id || id > max_id) ? -1 : index_of_id[id - min_id];
+          invalid_vertex_id = invalid_vertex_id || triangle_vertex_indices[i] < 0;
+        }
+      }
+      else
+      {
+        std::vector< std::pair<long, viennagrid_int> > sorted_ids(vertex_count);
+        for (long i = 0; i != vertex_count; ++i)
+          sorted_ids[i] = std::make_pair(vertex_ids[i], i);
+        std::sort(sorted_ids.begin(), sorted_ids.end());
+
+        #pragma omp parallel for reduction(||:invalid_vertex_id)
+        for (long i = 0; i < static_cast<long>(triangle_vertex_ids.size()); ++i)
+        {
+          std::vector< std::pair<long, viennagrid_int> >::const_iterator found =
+              std::lower_bound(sorted_ids.begin(), sorted_ids.end(), std::make_pair(triangle_vertex_ids[i], viennagrid_int(-1)));
+
+          triangle_vertex_indices[i] = (found == sorted_ids.end() || found->first != triangle_vertex_ids[i]) ? -1 : found->second;
+          invalid_vertex_id = invalid_vertex_id || triangle_vertex_indices[i] < 0;
+        }
+      }
+    }
+    else
+      invalid_vertex_id = !triangle_vertex_ids.empty();
+
+    if (invalid_vertex_id)
+      throw ascii_mesh_error("File " + filename + ": triangle references unknown vertex");
+
+    viennagrid_element_id first_vertex_id = create_vertices(mesh, coords, 3);
+    create_triangles(mesh, triangle_vertex_indices, first_vertex_id);
+  }
+
+
+
+
+  bool is_stl_ascii(std::string const & filename)
+  {
+    mapped_file file(filename);
+
+    char const * it = file.begin();
+    ascii::chunk token;
+    while (it != file.end() && (ascii::is_blank(*it) || *it == '\n'))
+      ++it;
+    if (!ascii::parse_token(it, file.end(), token) || !ascii::token_equals(token, "solid"))
+      return false;
+
+    // binary files may start with "solid" as well, their size is determined by the triangle count
+    if (file.size() >= 84)
+    {
+      boost::uint32_t triangle_count;
+      std::memcpy(&triangle_count, file.data() + 80, sizeof(triangle_count));
+      if (file.size() == 84 + 50 * static_cast<std::size_t>(triangle_count))
+        return false;
+    }
+
+    return true;
+  }
+
+
+  namespace
+  {
+    struct stl_chunk_result
+    {
+      stl_chunk_result() : error_line(NULL) {}
+
+      std::vector<viennagrid_numeric> coords;
+      char const * error_line;
+    };
+
+    void parse_stl_chunk(ascii::chunk const & chunk, stl_chunk_result & result)
+    {
+      char const * it = chunk.begin;
+      ascii::chunk line;
+      ascii::chunk keyword;
+
+      while (next_valid_line(it, chunk.end, line, '\0'))
+      {
+        char const * pos = line.begin;
+        ascii::parse_token(pos, line.end, keyword);
+
+        if (!ascii::token_equals(keyword, "vertex"))
+          continue;
+
+        double point[3];
+        if (!ascii::parse_double(pos, line.end, point[0]) ||
+            !ascii::parse_double(pos, line.end, point[1]) ||
+            !ascii::parse_double(pos, line.end, point[2]))
+        {
+          result.error_line = line.begin;
+          return;
+        }
+
+        result.coords.insert(result.coords.end(), point, point+3);
+      }
+    }
+
+    struct coords_less
+    {
+      coords_less(viennagrid_numeric const * coords_) : coords(coords_) {}
+
+      bool operator()(viennagrid_int lhs, viennagrid_int rhs) const
+      {
+        return std::lexicographical_compare(coords + 3*lhs, coords + 3*lhs + 3,
+                                            coords + 3*rhs, coords + 3*rhs + 3);
+      }
+
+      viennagrid_numeric const * coords;
+    };
+  }
+
+
+  void read_stl_ascii(std::string const & filename, viennagrid::mesh & mesh)
+  {
+    mapped_file file(filename);
+
+    std::vector<ascii::chunk> chunks = ascii::split_lines(file.begin(), file.end(), ascii::default_chunk_count());
+    std::vector<stl_chunk_result> results(chunks.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < static_cast<int>(chunks.size()); ++i)
+      parse_stl_chunk(chunks[i], results[i]);
+
+    std::vector< std::vector<viennagrid_numeric> > coord_parts(results.size());
+    for (std::size_t i = 0; i != results.size(); ++i)
+    {
+      if (results[i].error_line)
+        throw_error_line(filename, "invalid vertex line", results[i].error_line, file.end());
+      coord_parts[i].swap(results[i].coords);
+    }
+
+    // every facet has three vertex lines, the facet vertices are consecutive in the file
+    std::vector<viennagrid_numeric> facet_coords;
+    concatenate(coord_parts, facet_coords);
+
+    viennagrid_int facet_vertex_count = facet_coords.size() / 3;
+    if (facet_vertex_count % 3 != 0)
+      throw ascii_mesh_error("File " + filename + ": number of facet vertices is not a multiple of three");
+
+
+    // vertices shared by several facets are written once per facet, merge identical coordinates
+    std::vector<viennagrid_int> order(facet_vertex_count);
+    for (viennagrid_int i = 0; i != facet_vertex_count; ++i)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), coords_less(facet_vertex_count > 0 ? &facet_coords[0] : NULL));
+
+    std::vector<viennagrid_numeric> coords;
+    std::vector<viennagrid_int> vertex_indices(facet_vertex_count);
+    coords.reserve(facet_coords.size());
+
+    for (viennagrid_int i = 0; i != facet_vertex_count; ++i)
+    {
+      viennagrid_int current = order[i];
+      if (i == 0 || !std::equal(&facet_coords[3*current], &facet_coords[3*current] + 3, &facet_coords[3*order[i-1]]))
+        coords.insert(coords.end(), &facet_coords[3*current], &facet_coords[3*current] + 3);
+      vertex_indices[current] = coords.size() / 3 - 1;
+    }
+
+    viennagrid_element_id first_vertex_id = create_vertices(mesh, coords, 3);
+    create_triangles(mesh, vertex_indices, first_vertex_id);
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef VIENNAMESH_ALGORITHM_IO_ASCII_MESH_READER_HPP
+#define VIENNAMESH_ALGORITHM_IO_ASCII_MESH_READER_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <string>
+#include <stdexcept>
+
+#include "viennagrid/viennagrid.hpp"
+
+// Multithreaded readers for ASCII mesh formats. The file is mapped into memory, split into
+// line aligned chunks which are parsed in parallel and the vertices and elements are
+// created with the batch create functions of ViennaGrid.
+namespace viennamesh
+{
+  class ascii_mesh_error : public std::runtime_error
+  {
+  public:
+    ascii_mesh_error(std::string const & message) : std::runtime_error(message) {}
+  };
+
+  // reads a Silvaco .str surface mesh (coordinates "c" and triangles "t")
+  void read_silvaco_str(std::string const & filename, viennagrid::mesh & mesh);
+
+  // returns true if filename looks like an ASCII STL file rather than a binary one
+  bool is_stl_ascii(std::string const & filename);
+
+  // reads an ASCII STL file, vertices with identical coordinates are merged
+  void read_stl_ascii(std::string const & filename, viennagrid::mesh & mesh);
+}
+
+#endif
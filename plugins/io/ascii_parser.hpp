@@ -0,0 +1,250 @@
+#ifndef VIENNAMESH_ALGORITHM_IO_ASCII_PARSER_HPP
+#define VIENNAMESH_ALGORITHM_IO_ASCII_PARSER_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+#include <algorithm>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Building blocks for fast parsing of ASCII mesh files. Files are split into line aligned
+// chunks which are parsed independently, numbers are parsed without iostreams and without
+// depending on the current locale.
+namespace viennamesh
+{
+  namespace ascii
+  {
+    struct chunk
+    {
+      chunk() : begin(NULL), end(NULL) {}
+      chunk(char const * begin_, char const * end_) : begin(begin_), end(end_) {}
+
+      char const * begin;
+      char const * end;
+    };
+
+
+    // splits [begin, end) into at most chunk_count chunks, every chunk ends after a newline or at end
+    inline std::vector<chunk> split_lines(char const * begin, char const * end, std::size_t chunk_count)
+    {
+      std::vector<chunk> chunks;
+      if (chunk_count == 0)
+        chunk_count = 1;
+
+      std::size_t chunk_size = (end - begin) / chunk_count + 1;
+
+      char const * chunk_begin = begin;
+      while (chunk_begin != end)
+      {
+        char const * chunk_end = chunk_begin + std::min<std::size_t>(chunk_size, end - chunk_begin);
+        if (chunk_end != end)
+        {
+          char const * newline = static_cast<char const *>( std::memchr(chunk_end, '\n', end - chunk_end) );
+          chunk_end = newline ? newline + 1 : end;
+        }
+
+        chunks.push_back( chunk(chunk_begin, chunk_end) );
+        chunk_begin = chunk_end;
+      }
+
+      return chunks;
+    }
+
+    // number of chunks used for parsing, a few chunks per thread to balance uneven lines
+    inline std::size_t default_chunk_count()
+    {
+#ifdef _OPENMP
+      return 4 * omp_get_max_threads();
+#else
+      return 1;
+#endif
+    }
+
+
+
+    inline bool is_blank(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline void skip_blanks(char const * & it, char const * end)
+    {
+      while (it != end && is_blank(*it))
+        ++it;
+    }
+
+    // moves it to the beginning of the next line
+    inline void next_line(char const * & it, char const * end)
+    {
+      char const * newline = static_cast<char const *>( std::memchr(it, '\n', end - it) );
+      it = newline ? newline + 1 : end;
+    }
+
+    // returns the current line without the line break and moves it to the next line
+    inline chunk get_line(char const * & it, char const * end)
+    {
+      char const * line_begin = it;
+      next_line(it, end);
+
+      char const * line_end = it;
+      while (line_end != line_begin && (line_end[-1] == '\n' || line_end[-1] == '\r'))
+        --line_end;
+
+      return chunk(line_begin, line_end);
+    }
+
+    // reads the next whitespace separated token of the current line
+    inline bool parse_token(char const * & it, char const * end, chunk & token)
+    {
+      skip_blanks(it, end);
+      token.begin = it;
+      while (it != end && !is_blank(*it) && *it != '\n')
+        ++it;
+      token.end = it;
+      return token.begin != token.end;
+    }
+
+    inline bool token_equals(chunk const & token, char const * str)
+    {
+      std::size_t length = std::strlen(str);
+      return static_cast<std::size_t>(token.end - token.begin) == length && std::memcmp(token.begin, str, length) == 0;
+    }
+
+
+    inline bool parse_long(char const * & it, char const * end, long & value)
+    {
+      skip_blanks(it, end);
+
+      bool negative = false;
+      if (it != end && (*it == '-' || *it == '+'))
+        negative = (*it++ == '-');
+
+      if (it == end || *it < '0' || *it > '9')
+        return false;
+
+      long result = 0;
+      while (it != end && *it >= '0' && *it <= '9')
+        result = 10*result + (*it++ - '0');
+
+      value = negative ? -result : result;
+      return true;
+    }
+
+
+    // Parses a floating point number. Numbers with at most 19 significant digits and a
+    // decimal exponent in [-22,22] are converted exactly (Clinger's fast path), all others
+    // fall back to strtod on a copy of the token with the decimal point adjusted to the C locale.
+    inline bool parse_double(char const * & it, char const * end, double & value)
+    {
+      static double const powers_of_ten[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+      skip_blanks(it, end);
+      char const * token_begin = it;
+
+      bool negative = false;
+      if (it != end && (*it == '-' || *it == '+'))
+        negative = (*it++ == '-');
+
+      boost::uint64_t mantissa = 0;
+      int digits = 0;
+      int exponent = 0;
+      bool any_digit = false;
+
+      for (; it != end && *it >= '0' && *it <= '9'; ++it)
+      {
+        any_digit = true;
+        if (digits < 19)
+        {
+          mantissa = 10*mantissa + (*it - '0');
+          if (mantissa != 0)
+            ++digits;
+        }
+        else
+          ++exponent;
+      }
+
+      if (it != end && *it == '.')
+      {
+        ++it;
+        for (; it != end && *it >= '0' && *it <= '9'; ++it)
+        {
+          any_digit = true;
+          if (digits < 19)
+          {
+            mantissa = 10*mantissa + (*it - '0');
+            if (mantissa != 0)
+              ++digits;
+            --exponent;
+          }
+        }
+      }
+
+      if (!any_digit)
+      {
+        it = token_begin;
+        return false;
+      }
+
+      if (it != end && (*it == 'e' || *it == 'E' || *it == 'd' || *it == 'D'))
+      {
+        char const * exponent_begin = it++;
+        long exponent_value;
+        if (parse_long(it, end, exponent_value) && exponent_begin+1 != it && !is_blank(exponent_begin[1]))
+          exponent += exponent_value;
+        else
+          it = exponent_begin;
+      }
+
+      if (digits >= 19 || mantissa > (boost::uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+      {
+        char buffer[128];
+        std::size_t length = std::min<std::size_t>(it - token_begin, sizeof(buffer)-1);
+        for (std::size_t i = 0; i != length; ++i)
+        {
+          char c = token_begin[i];
+          buffer[i] = (c == 'd' || c == 'D') ? 'e' : c;
+        }
+        buffer[length] = 0;
+
+        // strtod honors the locale decimal point, replace '.' by it
+        char decimal_point = *std::localeconv()->decimal_point;
+        if (decimal_point != '.')
+          std::replace(buffer, buffer+length, '.', decimal_point);
+
+        value = std::strtod(buffer, NULL);
+        return true;
+      }
+
+      double result = static_cast<double>(mantissa);
+      if (exponent < 0)
+        result /= powers_of_ten[-exponent];
+      else
+        result *= powers_of_ten[exponent];
+
+      value = negative ? -result : result;
+      return true;
+    }
+  }
+}
+
+#endif
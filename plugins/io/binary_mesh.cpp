@@ -0,0 +1,591 @@
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include "binary_mesh.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <boost/cstdint.hpp>
+
+#include "mapped_file.hpp"
+#include "viennameshpp/cell_batch.hpp"
+
+namespace viennamesh
+{
+  namespace
+  {
+    char const binary_mesh_magic[8] = {'V', 'M', 'B', 'I', 'N', 'A', 'R', 'Y'};
+    boost::uint32_t const binary_mesh_version = 1;
+    boost::uint64_t const binary_mesh_alignment = 64;
+
+    enum block_type
+    {
+      VERTEX_COORDS = 1,
+      CELL_TYPES,
+      CELL_VERTEX_OFFSETS,
+      CELL_VERTEX_INDICES,
+      REGION_IDS,
+      REGION_NAME_OFFSETS,
+      REGION_NAMES,
+      CELL_REGION_OFFSETS,
+      CELL_REGION_IDS,
+      QUANTITY_FIELD_DESCRIPTOR,
+      QUANTITY_FIELD_NAME,
+      QUANTITY_FIELD_VALID,
+      QUANTITY_FIELD_VALUES
+    };
+
+    struct file_header
+    {
+      char magic[8];
+      boost::uint32_t version;
+      boost::uint32_t numeric_size;
+      boost::uint32_t int_size;
+      boost::uint32_t element_type_size;
+      boost::uint32_t geometric_dimension;
+      boost::uint32_t cell_dimension;
+      boost::uint64_t vertex_count;
+      boost::uint64_t cell_count;
+      boost::uint64_t region_count;
+      boost::uint64_t quantity_field_count;
+      boost::uint64_t block_count;
+    };
+
+    struct block_entry
+    {
+      boost::uint32_t type;
+      boost::uint32_t index;
+      boost::uint64_t offset;
+      boost::uint64_t size;
+    };
+
+    struct quantity_field_descriptor
+    {
+      boost::int32_t topologic_dimension;
+      boost::int32_t values_per_quantity;
+      boost::int32_t storage_layout;
+      boost::int32_t reserved;
+      boost::uint64_t size;
+    };
+
+
+    boost::uint64_t aligned(boost::uint64_t offset)
+    {
+      return (offset + binary_mesh_alignment - 1) / binary_mesh_alignment * binary_mesh_alignment;
+    }
+
+
+    // collects the blocks of a file before writing, the data pointers have to stay valid until write
+    class block_writer
+    {
+    public:
+
+      template<typename T>
+      void add(block_type type, boost::uint32_t index, std::vector<T> const & values)
+      { add(type, index, values.empty() ? NULL : &values[0], sizeof(T)*values.size()); }
+
+      void add(block_type type, boost::uint32_t index, void const * data, std::size_t size)
+      {
+        block_entry entry;
+        entry.type = type;
+        entry.index = index;
+        entry.offset = 0;
+        entry.size = size;
+
+        entries.push_back(entry);
+        data_pointers.push_back(data);
+      }
+
+      void write(std::string const & filename, file_header header)
+      {
+        header.block_count = entries.size();
+
+        boost::uint64_t offset = aligned( aligned(sizeof(file_header)) + sizeof(block_entry)*entries.size() );
+        for (std::size_t i = 0; i != entries.size(); ++i)
+        {
+          entries[i].offset = offset;
+          offset = aligned(offset + entries[i].size);
+        }
+
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        if (!file)
+          throw binary_mesh_error("Could not open file \"" + filename + "\" for writing");
+
+        boost::uint64_t position = 0;
+        write_at(file, position, 0, &header, sizeof(file_header));
+        write_at(file, position, aligned(sizeof(file_header)), entries.empty() ? NULL : &entries[0], sizeof(block_entry)*entries.size());
+        for (std::size_t i = 0; i != entries.size(); ++i)
+          write_at(file, position, entries[i].offset, data_pointers[i], entries[i].size);
+
+        if (!file)
+          throw binary_mesh_error("Error writing file \"" + filename + "\"");
+      }
+
+    private:
+
+      static void write_at(std::ostream & file, boost::uint64_t & position, boost::uint64_t offset, void const * data, std::size_t size)
+      {
+        static char const padding[binary_mesh_alignment] = {0};
+
+        while (position < offset)
+        {
+          std::size_t count = std::min<boost::uint64_t>(offset - position, binary_mesh_alignment);
+          file.write(padding, count);
+          position += count;
+        }
+
+        if (size > 0)
+          file.write(static_cast<char const *>(data), size);
+        position += size;
+      }
+
+      std::vector<block_entry> entries;
+      std::vector<void const *> data_pointers;
+    };
+
+
+
+    class block_reader
+    {
+    public:
+
+      block_reader(mapped_file & file_) : file(file_)
+      {
+        if (file.size() < sizeof(file_header))
+          throw binary_mesh_error("File too small for a ViennaMesh binary mesh");
+
+        std::memcpy(&header, file.data(), sizeof(file_header));
+
+        if (std::memcmp(header.magic, binary_mesh_magic, sizeof(binary_mesh_magic)) != 0)
+          throw binary_mesh_error("File is not a ViennaMesh binary mesh");
+        if (header.version != binary_mesh_version)
+          throw binary_mesh_error("Unsupported ViennaMesh binary mesh version");
+        if (header.numeric_size != sizeof(viennagrid_numeric) ||
+            header.int_size != sizeof(viennagrid_int) ||
+            header.element_type_size != sizeof(viennagrid_element_type))
+          throw binary_mesh_error("ViennaMesh binary mesh was written with different ViennaGrid type sizes");
+
+        boost::uint64_t directory_offset = aligned(sizeof(file_header));
+        if (header.block_count > (file.size() - std::min<boost::uint64_t>(directory_offset, file.size())) / sizeof(block_entry))
+          throw binary_mesh_error("Corrupt block directory");
+
+        entries = reinterpret_cast<block_entry const *>(file.data() + directory_offset);
+        for (boost::uint64_t i = 0; i != header.block_count; ++i)
+        {
+          if (entries[i].offset % binary_mesh_alignment != 0 ||
+              entries[i].offset > file.size() || entries[i].size > file.size() - entries[i].offset)
+            throw binary_mesh_error("Corrupt block directory");
+        }
+      }
+
+      file_header const & get_header() const { return header; }
+
+      // returns the block of the given type and index, count is the expected number of elements
+      template<typename T>
+      T * get(block_type type, boost::uint32_t index, boost::uint64_t count)
+      {
+        block_entry const * entry = find(type, index);
+        if (!entry)
+        {
+          if (count == 0)
+            return NULL;
+          throw binary_mesh_error("Missing block in ViennaMesh binary mesh");
+        }
+
+        if (count > std::numeric_limits<boost::uint64_t>::max() / sizeof(T) || entry->size != count*sizeof(T))
+          throw binary_mesh_error("Block has unexpected size");
+        return count == 0 ? NULL : reinterpret_cast<T *>(file.data() + entry->offset);
+      }
+
+      // returns the number of elements of a block of the given type and index, 0 if the block is missing
+      template<typename T>
+      boost::uint64_t count(block_type type, boost::uint32_t index) const
+      {
+        block_entry const * entry = find(type, index);
+        if (!entry)
+          return 0;
+
+        if (entry->size % sizeof(T) != 0)
+          throw binary_mesh_error("Block has unexpected size");
+        return entry->size / sizeof(T);
+      }
+
+      // returns the content of a variable sized block as string, an empty string if the block is missing
+      std::string get_string(block_type type, boost::uint32_t index)
+      {
+        block_entry const * entry = find(type, index);
+        if (!entry)
+          return std::string();
+        return std::string(file.data() + entry->offset, file.data() + entry->offset + entry->size);
+      }
+
+    private:
+
+      block_entry const * find(block_type type, boost::uint32_t index) const
+      {
+        for (boost::uint64_t i = 0; i != header.block_count; ++i)
+        {
+          if (entries[i].type == static_cast<boost::uint32_t>(type) && entries[i].index == index)
+            return entries + i;
+        }
+        return NULL;
+      }
+
+      mapped_file & file;
+      file_header header;
+      block_entry const * entries;
+    };
+
+
+    // offsets into a CSR array have to start at 0 and must not decrease (and are therefore not negative)
+    void check_offsets(viennagrid_int const * offsets, boost::uint64_t count, std::string const & what)
+    {
+      if (offsets[0] != 0)
+        throw binary_mesh_error("Corrupt " + what + ": offsets do not start at 0");
+
+      for (boost::uint64_t i = 0; i != count; ++i)
+      {
+        if (offsets[i] > offsets[i+1])
+          throw binary_mesh_error("Corrupt " + what + ": offsets decrease");
+      }
+    }
+
+    // number of vertices of an element type, -1 for types with a variable number of vertices
+    int vertex_count(viennagrid_element_type type)
+    {
+      switch (type)
+      {
+        case VIENNAGRID_ELEMENT_TYPE_VERTEX:        return 1;
+        case VIENNAGRID_ELEMENT_TYPE_LINE:          return 2;
+        case VIENNAGRID_ELEMENT_TYPE_TRIANGLE:      return 3;
+        case VIENNAGRID_ELEMENT_TYPE_QUADRILATERAL: return 4;
+        case VIENNAGRID_ELEMENT_TYPE_TETRAHEDRON:   return 4;
+        default:                                    return -1;
+      }
+    }
+
+    // counts are stored as 64 bit values but have to be representable as viennagrid_int
+    boost::uint64_t checked_count(boost::uint64_t count, std::string const & what)
+    {
+      if (count > static_cast<boost::uint64_t>(std::numeric_limits<viennagrid_int>::max()))
+        throw binary_mesh_error("Corrupt " + what + ": count exceeds the ViennaGrid index range");
+      return count;
+    }
+
+    boost::uint64_t checked_product(boost::uint64_t lhs, boost::uint64_t rhs, std::string const & what)
+    {
+      if (rhs != 0 && lhs > std::numeric_limits<boost::uint64_t>::max() / rhs)
+        throw binary_mesh_error("Corrupt " + what + ": size overflows");
+      return lhs*rhs;
+    }
+
+
+    // elements of one dimension in CSR form, element i has the vertices
+    // vertex_indices[vertex_offsets[i], vertex_offsets[i+1]) and the regions region_ids[region_offsets[i], region_offsets[i+1]).
+    // Block index 0 holds the cells, index d > 0 the elements of dimension d which are not on the
+    // boundary of a cell (e.g. lines of a PLC), boundary elements are recreated with the cells.
+    struct element_table
+    {
+      element_table() : vertex_offsets(1, 0), region_offsets(1, 0) {}
+
+      template<typename ElementT>
+      void push_back(ElementT const & element)
+      {
+        typedef typename viennagrid::result_of::const_element_range<ElementT>::type   ConstBoundaryRangeType;
+        typedef typename viennagrid::result_of::iterator<ConstBoundaryRangeType>::type ConstBoundaryIteratorType;
+        typedef typename viennagrid::result_of::region_range<ElementT>::type          RegionRangeType;
+        typedef typename viennagrid::result_of::iterator<RegionRangeType>::type       RegionIteratorType;
+
+        types.push_back(element.tag().internal());
+
+        ConstBoundaryRangeType vertices(element, 0);
+        for (ConstBoundaryIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+          vertex_indices.push_back((*vit).id().index());
+        vertex_offsets.push_back(vertex_indices.size());
+
+        RegionRangeType element_regions(element);
+        for (RegionIteratorType rit = element_regions.begin(); rit != element_regions.end(); ++rit)
+          region_ids.push_back((*rit).id());
+        region_offsets.push_back(region_ids.size());
+      }
+
+      // the table has to stay alive until the blocks are written
+      void add_to(block_writer & blocks, boost::uint32_t index) const
+      {
+        blocks.add(CELL_TYPES, index, types);
+        blocks.add(CELL_VERTEX_OFFSETS, index, vertex_offsets);
+        blocks.add(CELL_VERTEX_INDICES, index, vertex_indices);
+        blocks.add(CELL_REGION_OFFSETS, index, region_offsets);
+        blocks.add(CELL_REGION_IDS, index, region_ids);
+      }
+
+      std::vector<viennagrid_element_type> types;
+      std::vector<viennagrid_int> vertex_offsets;
+      std::vector<viennagrid_int> vertex_indices;
+      std::vector<viennagrid_int> region_offsets;
+      std::vector<viennagrid_int> region_ids;
+    };
+
+
+    // validates the element table with the given block index and creates its elements in mesh
+    void read_elements(block_reader & blocks, boost::uint32_t index, boost::uint64_t count,
+                       boost::uint64_t mesh_vertex_count, viennagrid_element_id first_vertex_id,
+                       std::set<viennagrid_int> const & known_region_ids, viennagrid::mesh & mesh)
+    {
+      if (count == 0)
+        return;
+
+      viennagrid_element_type * types = blocks.get<viennagrid_element_type>(CELL_TYPES, index, count);
+      viennagrid_int * vertex_offsets = blocks.get<viennagrid_int>(CELL_VERTEX_OFFSETS, index, count+1);
+      check_offsets(vertex_offsets, count, "element vertex table");
+      viennagrid_int * vertex_indices = blocks.get<viennagrid_int>(CELL_VERTEX_INDICES, index, vertex_offsets[count]);
+      viennagrid_int * region_offsets = blocks.get<viennagrid_int>(CELL_REGION_OFFSETS, index, count+1);
+      check_offsets(region_offsets, count, "element region table");
+      viennagrid_int * region_ids = blocks.get<viennagrid_int>(CELL_REGION_IDS, index, region_offsets[count]);
+
+      for (boost::uint64_t i = 0; i != count; ++i)
+      {
+        int expected_vertex_count = vertex_count(types[i]);
+        viennagrid_int element_vertex_count = vertex_offsets[i+1] - vertex_offsets[i];
+        if (types[i] == VIENNAGRID_ELEMENT_TYPE_NO_ELEMENT || element_vertex_count == 0 ||
+            (expected_vertex_count >= 0 && element_vertex_count != expected_vertex_count))
+          throw binary_mesh_error("Element type does not match its number of vertices");
+      }
+
+      // regions of elements have to be in the region table
+      for (viennagrid_int i = 0; i != region_offsets[count]; ++i)
+      {
+        if (known_region_ids.find(region_ids[i]) == known_region_ids.end())
+          throw binary_mesh_error("Element references unknown region");
+      }
+
+      std::vector<viennagrid_element_id> element_vertices(vertex_offsets[count]);
+      for (std::size_t i = 0; i != element_vertices.size(); ++i)
+      {
+        if (vertex_indices[i] < 0 || static_cast<boost::uint64_t>(vertex_indices[i]) >= mesh_vertex_count)
+          throw binary_mesh_error("Element references invalid vertex");
+        element_vertices[i] = first_vertex_id + vertex_indices[i];
+      }
+
+      batch_create_cells(mesh, count, types, vertex_offsets,
+                         element_vertices.empty() ? NULL : &element_vertices[0],
+                         region_offsets, region_ids);
+    }
+  }
+
+
+
+
+  void write_binary_mesh(std::string const & filename,
+                         viennagrid::mesh const & mesh,
+                         std::vector<viennagrid::quantity_field> const & quantity_fields)
+  {
+    typedef viennagrid::mesh                                                      MeshType;
+    typedef viennagrid::result_of::const_element_range<MeshType>::type           ConstElementRangeType;
+    typedef viennagrid::result_of::iterator<ConstElementRangeType>::type         ConstElementIteratorType;
+    typedef viennagrid::result_of::const_region_range<MeshType>::type            ConstRegionRangeType;
+    typedef viennagrid::result_of::iterator<ConstRegionRangeType>::type          ConstRegionIteratorType;
+    typedef viennagrid::result_of::const_coboundary_range<MeshType>::type        ConstCoboundaryRangeType;
+
+    block_writer blocks;
+
+    file_header header;
+    std::memset(&header, 0, sizeof(file_header));
+    std::memcpy(header.magic, binary_mesh_magic, sizeof(binary_mesh_magic));
+    header.version = binary_mesh_version;
+    header.numeric_size = sizeof(viennagrid_numeric);
+    header.int_size = sizeof(viennagrid_int);
+    header.element_type_size = sizeof(viennagrid_element_type);
+
+    viennagrid_int vertex_count = viennagrid::vertex_count(mesh);
+    header.vertex_count = vertex_count;
+
+    std::vector<viennagrid_int> region_ids;
+    std::vector<viennagrid_int> region_name_offsets(1, 0);
+    std::vector<char> region_names;
+    std::vector<element_table> element_tables;
+
+    if (vertex_count > 0)
+    {
+      header.geometric_dimension = viennagrid::geometric_dimension(mesh);
+      header.cell_dimension = viennagrid::cell_dimension(mesh);
+
+      viennagrid_numeric * coords;
+      viennagrid_mesh_vertex_coords_pointer(mesh.internal(), &coords);
+      blocks.add(VERTEX_COORDS, 0, coords, sizeof(viennagrid_numeric)*vertex_count*header.geometric_dimension);
+
+
+      ConstRegionRangeType regions(mesh);
+      for (ConstRegionIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
+      {
+        std::string name = (*rit).get_name();
+        region_ids.push_back((*rit).id());
+        region_names.insert(region_names.end(), name.begin(), name.end());
+        region_name_offsets.push_back(region_names.size());
+      }
+      header.region_count = region_ids.size();
+
+      blocks.add(REGION_IDS, 0, region_ids);
+      blocks.add(REGION_NAME_OFFSETS, 0, region_name_offsets);
+      blocks.add(REGION_NAMES, 0, region_names);
+
+
+      // cells in block index 0, the free elements of every lower dimension in the index of their dimension
+      element_tables.resize(header.cell_dimension+1);
+      for (viennagrid_int dimension = header.cell_dimension; dimension > 0; --dimension)
+      {
+        bool cells = (dimension == static_cast<viennagrid_int>(header.cell_dimension));
+        element_table & table = element_tables[dimension];
+
+        ConstElementRangeType elements(mesh, dimension);
+        for (ConstElementIteratorType eit = elements.begin(); eit != elements.end(); ++eit)
+        {
+          if (cells || ConstCoboundaryRangeType(mesh, *eit, header.cell_dimension).size() == 0)
+            table.push_back(*eit);
+        }
+
+        if (cells)
+          header.cell_count = table.types.size();
+        if (cells || !table.types.empty())
+          table.add_to(blocks, cells ? 0 : dimension);
+      }
+    }
+
+
+    // quantity fields are stored with one validity flag per element and a dense value array
+    header.quantity_field_count = quantity_fields.size();
+
+    std::vector<quantity_field_descriptor> descriptors(quantity_fields.size());
+    std::vector<std::string> names(quantity_fields.size());
+    std::vector< std::vector<char> > valid_flags(quantity_fields.size());
+    std::vector< std::vector<viennagrid_numeric> > values(quantity_fields.size());
+
+    for (std::size_t i = 0; i != quantity_fields.size(); ++i)
+    {
+      viennagrid::quantity_field const & field = quantity_fields[i];
+      viennagrid_int size = field.size();
+      viennagrid_int values_per_quantity = field.values_per_quantity();
+
+      std::memset(&descriptors[i], 0, sizeof(quantity_field_descriptor));
+      descriptors[i].topologic_dimension = field.topologic_dimension();
+      descriptors[i].values_per_quantity = values_per_quantity;
+      descriptors[i].storage_layout = field.storage_layout();
+      descriptors[i].size = size;
+      names[i] = field.get_name();
+
+      valid_flags[i].resize(size, 0);
+      values[i].resize(size*values_per_quantity, 0);
+
+      for (viennagrid_int j = 0; j != size; ++j)
+      {
+        if (!field.valid(j))
+          continue;
+
+        void * value;
+        viennagrid_quantity_field_value_get(field.internal(), j, &value);
+        std::memcpy(&values[i][j*values_per_quantity], value, sizeof(viennagrid_numeric)*values_per_quantity);
+        valid_flags[i][j] = 1;
+      }
+
+      blocks.add(QUANTITY_FIELD_DESCRIPTOR, i, &descriptors[i], sizeof(quantity_field_descriptor));
+      blocks.add(QUANTITY_FIELD_NAME, i, names[i].data(), names[i].size());
+      blocks.add(QUANTITY_FIELD_VALID, i, valid_flags[i]);
+      blocks.add(QUANTITY_FIELD_VALUES, i, values[i]);
+    }
+
+    blocks.write(filename, header);
+  }
+
+
+
+
+  void read_binary_mesh(std::string const & filename,
+                        viennagrid::mesh & mesh,
+                        std::vector<viennagrid::quantity_field> & quantity_fields)
+  {
+    typedef viennagrid::result_of::region<viennagrid::mesh>::type RegionType;
+
+    mapped_file file(filename);
+    block_reader blocks(file);
+    file_header const & header = blocks.get_header();
+
+    checked_count(header.vertex_count, "vertex table");
+    checked_count(header.cell_count, "cell table");
+    checked_count(header.region_count, "region table");
+    checked_count(header.quantity_field_count, "quantity field table");
+
+    if (header.vertex_count > 0)
+    {
+      if (header.geometric_dimension < 1 || header.geometric_dimension > 3 || header.cell_dimension > 3)
+        throw binary_mesh_error("Corrupt header: invalid geometric or cell dimension");
+
+      viennagrid_numeric * coords = blocks.get<viennagrid_numeric>(VERTEX_COORDS, 0,
+          checked_product(header.vertex_count, header.geometric_dimension, "vertex table"));
+
+      viennagrid_element_id first_vertex_id;
+      viennagrid_mesh_geometric_dimension_set(mesh.internal(), header.geometric_dimension);
+      viennagrid_mesh_vertex_batch_create(mesh.internal(), header.vertex_count, coords, &first_vertex_id);
+
+
+      viennagrid_int * region_ids = blocks.get<viennagrid_int>(REGION_IDS, 0, header.region_count);
+      viennagrid_int * region_name_offsets = blocks.get<viennagrid_int>(REGION_NAME_OFFSETS, 0, header.region_count+1);
+      check_offsets(region_name_offsets, header.region_count, "region table");
+      char * region_names = blocks.get<char>(REGION_NAMES, 0, region_name_offsets[header.region_count]);
+
+      for (boost::uint64_t i = 0; i != header.region_count; ++i)
+      {
+        RegionType region = mesh.get_or_create_region(region_ids[i]);
+        region.set_name( std::string(region_names + region_name_offsets[i], region_names + region_name_offsets[i+1]) );
+      }
+
+
+      // cells first, then the free elements of every lower dimension
+      std::set<viennagrid_int> known_region_ids(region_ids, region_ids + header.region_count);
+      read_elements(blocks, 0, header.cell_count, header.vertex_count, first_vertex_id, known_region_ids, mesh);
+      for (viennagrid_int dimension = header.cell_dimension-1; dimension > 0; --dimension)
+      {
+        boost::uint64_t element_count = checked_count(blocks.count<viennagrid_element_type>(CELL_TYPES, dimension), "element table");
+        read_elements(blocks, dimension, element_count, header.vertex_count, first_vertex_id, known_region_ids, mesh);
+      }
+    }
+
+
+    quantity_fields.resize(header.quantity_field_count);
+    for (boost::uint64_t i = 0; i != header.quantity_field_count; ++i)
+    {
+      quantity_field_descriptor const & descriptor = *blocks.get<quantity_field_descriptor>(QUANTITY_FIELD_DESCRIPTOR, i, 1);
+      if (descriptor.values_per_quantity < 0)
+        throw binary_mesh_error("Corrupt quantity field descriptor");
+      checked_count(descriptor.size, "quantity field");
+
+      char * valid = blocks.get<char>(QUANTITY_FIELD_VALID, i, descriptor.size);
+      viennagrid_numeric * values = blocks.get<viennagrid_numeric>(QUANTITY_FIELD_VALUES, i,
+          checked_product(descriptor.size, descriptor.values_per_quantity, "quantity field"));
+
+      viennagrid::quantity_field field(descriptor.topologic_dimension, descriptor.values_per_quantity, descriptor.storage_layout);
+      field.set_name( blocks.get_string(QUANTITY_FIELD_NAME, i) );
+
+      for (boost::uint64_t j = 0; j != descriptor.size; ++j)
+      {
+        if (valid[j])
+          viennagrid_quantity_field_value_set(field.internal(), j, values + j*descriptor.values_per_quantity);
+      }
+
+      quantity_fields[i] = field;
+    }
+  }
+}
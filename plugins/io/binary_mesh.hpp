@@ -0,0 +1,50 @@
+#ifndef VIENNAMESH_ALGORITHM_IO_BINARY_MESH_HPP
+#define VIENNAMESH_ALGORITHM_IO_BINARY_MESH_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "viennagrid/viennagrid.hpp"
+
+namespace viennamesh
+{
+  // Native ViennaMesh binary mesh format (.vmb)
+  //
+  // A file consists of a fixed size header, a block directory and a sequence of data blocks.
+  // Every block starts at a 64 byte aligned offset and holds one contiguous array (coordinates,
+  // cell types, cell vertex offsets and indices, region table, cell regions, quantity field
+  // values, ...) in the native representation of viennagrid_numeric and viennagrid_int, so the
+  // reader can map the file into memory and hand the arrays directly to the batch create
+  // functions of ViennaGrid. Lower dimensional elements which are not on the boundary of a cell
+  // (e.g. lines of a PLC) are stored in additional element tables, one per dimension.
+  class binary_mesh_error : public std::runtime_error
+  {
+  public:
+    binary_mesh_error(std::string const & message) : std::runtime_error(message) {}
+  };
+
+  void write_binary_mesh(std::string const & filename,
+                         viennagrid::mesh const & mesh,
+                         std::vector<viennagrid::quantity_field> const & quantity_fields);
+
+  void read_binary_mesh(std::string const & filename,
+                        viennagrid::mesh & mesh,
+                        std::vector<viennagrid::quantity_field> & quantity_fields);
+}
+
+#endif
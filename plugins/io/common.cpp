@@ -41,6 +41,9 @@ namespace viennamesh
     if ( extension_found(filename, "vmesh") )
       return VMESH;
 
+    if ( extension_found(filename, "vmb") )
+      return VIENNAMESH_BINARY;
+
     if ( extension_found(filename, "poly") )
       return TETGEN_POLY;
 
@@ -133,6 +136,8 @@ namespace viennamesh
       file_type = STL_BINARY;
     else if (str == "GRD")
       file_type = GRD;
+    else if (str == "VIENNAMESH_BINARY")
+      file_type = VIENNAMESH_BINARY;
     else if (str == "VTP")
       file_type = VTP;
     else
@@ -199,6 +204,9 @@ namespace viennamesh
       case GRD:
         stream << "GRD";
         break;
+      case VIENNAMESH_BINARY:
+        stream << "VIENNAMESH_BINARY";
+        break;
       case VTP:
         stream << "VTP";
         break;
@@ -40,7 +40,8 @@ namespace viennamesh
     STL,
     STL_ASCII,
     STL_BINARY,
-    GRD
+    GRD,
+    VIENNAMESH_BINARY
   };
 
   FileType from_filename( std::string filename );
@@ -0,0 +1,93 @@
+#ifndef VIENNAMESH_ALGORITHM_IO_MAPPED_FILE_HPP
+#define VIENNAMESH_ALGORITHM_IO_MAPPED_FILE_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <string>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace viennamesh
+{
+  class mapped_file_error : public std::runtime_error
+  {
+  public:
+    mapped_file_error(std::string const & message) : std::runtime_error(message) {}
+  };
+
+
+  // A file mapped into memory. Pages are mapped copy-on-write so that the content can be
+  // passed to non-const functions without ever touching the file on disk.
+  class mapped_file
+  {
+  public:
+
+    mapped_file(std::string const & filename) : data_(NULL), size_(0)
+    {
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw mapped_file_error("Could not open file \"" + filename + "\"");
+
+      struct stat file_stat;
+      if (::fstat(fd, &file_stat) != 0)
+      {
+        ::close(fd);
+        throw mapped_file_error("Could not stat file \"" + filename + "\"");
+      }
+
+      size_ = file_stat.st_size;
+      if (size_ > 0)
+      {
+        void * data = ::mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+          ::close(fd);
+          throw mapped_file_error("Could not map file \"" + filename + "\" into memory");
+        }
+
+        data_ = static_cast<char *>(data);
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+      }
+
+      ::close(fd);
+    }
+
+    ~mapped_file()
+    {
+      if (data_)
+        ::munmap(data_, size_);
+    }
+
+    char * data() { return data_; }
+    char const * data() const { return data_; }
+
+    char const * begin() const { return data_; }
+    char const * end() const { return data_ + size_; }
+
+    std::size_t size() const { return size_; }
+
+  private:
+    mapped_file(mapped_file const &);
+    mapped_file & operator=(mapped_file const &);
+
+    char * data_;
+    std::size_t size_;
+  };
+}
+
+#endif
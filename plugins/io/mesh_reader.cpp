@@ -25,6 +25,9 @@
 #include "viennagrid/io/gts_deva_reader.hpp"
 #include "viennagrid/io/dfise_grd_dat_reader.hpp"
 
+#include "binary_mesh.hpp"
+#include "ascii_mesh_reader.hpp"
+
 #include <vtkXMLPolyDataReader.h>
 #include <vtkSmartPointer.h>
 #include <vtkIdList.h>
@@ -80,6 +83,21 @@ namespace viennamesh
 
         data_handle<double> vertex_tolerance = get_input<double>("vertex_tolerance");
 
+        // ASCII files without a merge tolerance are read with the multithreaded reader
+        if ( !vertex_tolerance.valid() && filetype != STL_BINARY && (filetype == STL_ASCII || is_stl_ascii(filename)) )
+        {
+          try
+          {
+            read_stl_ascii(filename, output_mesh());
+            success = true;
+          }
+          catch(std::runtime_error const & e)
+          {
+            error(1) << "STL ASCII reader: got error: " << e.what() << std::endl;
+          }
+          break;
+        }
+
         viennagrid::io::stl_reader<> reader;
         if (vertex_tolerance.valid())
           reader = viennagrid::io::stl_reader<>( vertex_tolerance() );
@@ -95,6 +113,22 @@ namespace viennamesh
         break;
       }
 
+    case SILVACO_STR:
+      {
+        info(5) << "Found .str extension, using ViennaMesh Silvaco STR Reader" << std::endl;
+
+        try
+        {
+          read_silvaco_str(filename, output_mesh());
+          success = true;
+        }
+        catch(std::runtime_error const & e)
+        {
+          error(1) << "Silvaco STR reader: got error: " << e.what() << std::endl;
+        }
+        break;
+      }
+
     case GTS_DEVA:
       {
         info(5) << "Found .deva extension, using ViennaMesh GTS deva Reader" << std::endl;
@@ -239,6 +273,30 @@ namespace viennamesh
         }
         break;
       }
+    case VIENNAMESH_BINARY:
+      {
+        info(5) << "Found .vmb extension, using ViennaMesh binary mesh reader" << std::endl;
+
+        try
+        {
+          std::vector<viennagrid::quantity_field> quantity_fields;
+          read_binary_mesh(filename, output_mesh(), quantity_fields);
+
+          if (!quantity_fields.empty())
+          {
+            quantity_field_handle output_quantity_fields = make_data<viennagrid::quantity_field>();
+            output_quantity_fields.set(quantity_fields);
+            set_output( "quantities", output_quantity_fields );
+          }
+
+          success = true;
+        }
+        catch(std::runtime_error const & e)
+        {
+          error(1) << "ViennaMesh binary mesh reader: got error: " << e.what() << std::endl;
+        }
+        break;
+      }
     default:
       {
         error(1) << "Unsupported extension: " << lexical_cast<std::string>(filetype) << std::endl;
@@ -17,6 +17,8 @@
 #include "viennagrid/io/vtk_writer.hpp"
 #include "viennagrid/io/mphtxt_writer.hpp"
 
+#include "binary_mesh.hpp"
+
 #include "pugixml.hpp"
 
 #include "viennameshpp/core.hpp"
@@ -256,6 +258,23 @@ namespace viennamesh
           break;
         }
 
+        case VIENNAMESH_BINARY:
+        {
+          std::vector<viennagrid::quantity_field> quantity_fields;
+          if (input_mesh.size() == 1 && quantity_field.valid())
+            quantity_fields = quantity_field.get_vector();
+
+          try
+          {
+            write_binary_mesh(local_filename, mesh, quantity_fields);
+          }
+          catch(binary_mesh_error const & e)
+          {
+            VIENNAMESH_ERROR(VIENNAMESH_ERROR_ALGORITHM_RUN_FAILED, e.what());
+          }
+          break;
+        }
+
         default:
           VIENNAMESH_ERROR(VIENNAMESH_ERROR_ALGORITHM_RUN_FAILED, "File type \"" + lexical_cast<std::string>(ft) + "\" not supported");
       }
@@ -13,8 +13,7 @@
 =============================================================================== */
 
 #include "merge_close_points.hpp"
-#include "viennagrid/core/ntree.hpp"
-#include "viennagrid/algorithm/geometry.hpp"
+#include "viennameshpp/vertex_welding.hpp"
 
 namespace viennamesh
 {
@@ -30,95 +29,61 @@ namespace viennamesh
 
     typedef viennagrid::mesh                                                MeshType;
     typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
-    typedef viennagrid::result_of::point<MeshType>::type                    PointType;
 
     typedef viennagrid::result_of::const_element_range<MeshType>::type      ConstElementRangeType;
     typedef viennagrid::result_of::iterator<ConstElementRangeType>::type    ConstElementIteratorType;
 
-    ConstElementRangeType vertices( input_mesh(), 0 );
-    info(1) << "Old vertex count = " << vertices.size() << std::endl;
-
-
-//     OLD IMPLEMENTATION
-//
-//     std::vector<ElementType> new_vertices;
-//     for (ConstElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
-//     {
-//       PointType p = viennagrid::get_point(*vit);
-//
-//       std::vector<ElementType>::iterator nvit = new_vertices.begin();
-//       for (; nvit != new_vertices.end(); ++nvit)
-//       {
-//         if (viennagrid::norm_2(p - viennagrid::get_point(*nvit)) < merge_distance )
-//         {
-//           new_vertices.push_back(*nvit);
-//           break;
-//         }
-//       }
-//
-//       if (nvit == new_vertices.end())
-//         new_vertices.push_back( viennagrid::make_vertex(output_mesh(), p) );
-//     }
-
-
-    // build up ntree
-    std::pair<PointType, PointType> bb = viennagrid::bounding_box( input_mesh() );
-    PointType center = (bb.first + bb.second)/2;
-    PointType size = bb.second - bb.first;
-
-    typedef viennagrid::vertex_with_distance_wrapper<ElementType> WrapperType;
-    typedef viennagrid::ntree_node<WrapperType> NodeType;
-    boost::shared_ptr<NodeType> root( new NodeType( center-size/2*1.1 , center+size/2*1.1 ) );
-
-    int element_per_node = 10;
-    for (ConstElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
-      root->add( WrapperType(*vit, merge_distance),
-                 element_per_node,
-                 vertices.size()/element_per_node);
-
-    // create new vertices
-    viennagrid::vector<ElementType> new_vertices( vertices.size() );
-    for (ConstElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+    typedef viennagrid::result_of::const_element_range<ElementType>::type   ConstBoundaryRangeType;
+    typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type   ConstBoundaryIteratorType;
+
+    viennagrid_int vertex_count = viennagrid::vertex_count( input_mesh() );
+    info(1) << "Old vertex count = " << vertex_count << std::endl;
+
+    if (vertex_count == 0)
     {
-      PointType p = viennagrid::get_point(*vit);
-
-      viennagrid::element_id new_vertex_id = (*vit).id();
-      NodeType * node = root->get(p);
-      for (std::size_t i = 0; i != node->elements().size(); ++i)
-      {
-        if (viennagrid::norm_2(p - viennagrid::get_point(node->elements()[i]())) < merge_distance )
-        {
-          if ( node->elements()[i]().id() < new_vertex_id )
-          {
-            new_vertex_id = node->elements()[i]().id();
-            break;
-          }
-        }
-      }
-
-      if ( new_vertex_id == (*vit).id() )
-        new_vertices[(*vit).id()] = viennagrid::make_vertex(output_mesh(), p);
-      else
-        new_vertices[(*vit).id()] = new_vertices[new_vertex_id];
+      set_output( "mesh", output_mesh );
+      return true;
     }
 
+    viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension( input_mesh() );
+    viennagrid_numeric * coords;
+    viennagrid_mesh_vertex_coords_pointer(input_mesh().internal(), &coords);
+
+    // vertices closer than merge_distance are welded, each cluster keeps the point of its first vertex
+    std::vector<viennagrid_int> new_index;
+    std::vector<viennagrid_numeric> new_coords;
+    viennagrid_int new_vertex_count = weld_vertices(coords, vertex_count, geometric_dimension, merge_distance,
+                                                    new_index, new_coords);
+
+    viennagrid_element_id first_vertex_id;
+    viennagrid_mesh_geometric_dimension_set(output_mesh().internal(), geometric_dimension);
+    viennagrid_mesh_vertex_batch_create(output_mesh().internal(), new_vertex_count, &new_coords[0], &first_vertex_id);
+
     // create cell for new mesh using merged vertices
+    std::vector<viennagrid_element_type> cell_types;
+    std::vector<viennagrid_int> cell_vertex_offsets(1, 0);
+    std::vector<viennagrid_element_id> cell_vertices;
+
     ConstElementRangeType cells( input_mesh(), viennagrid::cell_dimension(input_mesh()) );
+    cell_types.reserve( cells.size() );
+    cell_vertex_offsets.reserve( cells.size()+1 );
     for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
     {
-      std::vector<ElementType> local_vertices;
-
-      typedef viennagrid::result_of::const_element_range<ElementType>::type ConstCoundaryRangeType;
-      typedef viennagrid::result_of::iterator<ConstCoundaryRangeType>::type ConstCoundaryIteratorType;
+      cell_types.push_back( (*cit).tag().internal() );
 
-      ConstCoundaryRangeType boundary_vertices(*cit, 0);
-      for (ConstCoundaryIteratorType bvit = boundary_vertices.begin(); bvit != boundary_vertices.end(); ++bvit)
-        local_vertices.push_back( new_vertices[(*bvit).id()] );
-
-      viennagrid::make_element( output_mesh(), (*cit).tag(), local_vertices.begin(), local_vertices.end() );
+      ConstBoundaryRangeType boundary_vertices(*cit, 0);
+      for (ConstBoundaryIteratorType bvit = boundary_vertices.begin(); bvit != boundary_vertices.end(); ++bvit)
+        cell_vertices.push_back( first_vertex_id + new_index[(*bvit).id().index()] );
+      cell_vertex_offsets.push_back( cell_vertices.size() );
     }
 
-    info(1) << "New vertex count = " << viennagrid::vertices(output_mesh()).size() << std::endl;
+    if (!cell_types.empty())
+      viennagrid_mesh_element_batch_create(output_mesh().internal(),
+                                           cell_types.size(), &cell_types[0],
+                                           &cell_vertex_offsets[0], &cell_vertices[0],
+                                           NULL, NULL);
+
+    info(1) << "New vertex count = " << new_vertex_count << std::endl;
     set_output( "mesh", output_mesh );
 
     return true;
@@ -20,10 +20,349 @@
 #include "viennagrid/algorithm/distance.hpp"
 #include "viennagrid/algorithm/spanned_volume.hpp"
 
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <omp.h>
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <boost/cstdint.hpp>
+
 namespace viennamesh
 {
   namespace netgen
   {
+    namespace
+    {
+      // netgen 5.1 is not reentrant, the volume meshing and optimization write process globals (e.g. the quality
+      // class statistics in CalcTotalBad, multithread.task/percent, testout and the profiler timers). All netgen
+      // meshing calls within the process, including those of concurrently running pipelines, are therefore serialized.
+      std::mutex & netgen_mutex()
+      {
+        static std::mutex mutex;
+        return mutex;
+      }
+
+      void mesh_volume_unlocked(::netgen::MeshingParameters & mesh_parameters, netgen::mesh & mesh)
+      {
+        mesh.CalcLocalH(mesh_parameters.grading);
+        MeshVolume (mesh_parameters, mesh);
+        RemoveIllegalElements (mesh);
+        OptimizeVolume (mesh_parameters, mesh);
+      }
+
+      void mesh_volume(::netgen::MeshingParameters & mesh_parameters, netgen::mesh & mesh)
+      {
+        std::lock_guard<std::mutex> lock( netgen_mutex() );
+        mesh_volume_unlocked(mesh_parameters, mesh);
+      }
+
+
+      // volume mesh of one domain, sent from the worker process to the parent
+      struct domain_result
+      {
+        std::vector<double> points;     // coordinates of the inner points, they follow the surface points of the domain mesh
+        std::vector<int> elements;      // point count followed by the domain mesh point indices of every volume element
+        std::string error;
+      };
+
+      domain_result make_domain_result(netgen::mesh const & domain_mesh, int surface_point_count)
+      {
+        domain_result result;
+
+        for (int pi = surface_point_count + ::netgen::PointIndex::BASE; pi < domain_mesh.GetNP() + ::netgen::PointIndex::BASE; ++pi)
+        {
+          ::netgen::MeshPoint const & p = domain_mesh.Point(pi);
+          result.points.push_back(p[0]);
+          result.points.push_back(p[1]);
+          result.points.push_back(p[2]);
+        }
+
+        for (int i = 1; i <= domain_mesh.GetNE(); ++i)
+        {
+          ::netgen::Element const & el = domain_mesh.VolumeElement(i);
+          result.elements.push_back( el.GetNP() );
+          for (int j = 1; j <= el.GetNP(); ++j)
+            result.elements.push_back( el.PNum(j) );
+        }
+
+        return result;
+      }
+
+
+      template<typename T>
+      void append_array(std::string & message, std::vector<T> const & values)
+      {
+        boost::uint64_t size = values.size();
+        message.append( reinterpret_cast<char const *>(&size), sizeof(size) );
+        if (!values.empty())
+          message.append( reinterpret_cast<char const *>(&values[0]), sizeof(T)*values.size() );
+      }
+
+      template<typename T>
+      bool extract_array(std::string const & message, std::size_t & position, std::vector<T> & values)
+      {
+        boost::uint64_t size;
+        if (message.size() - position < sizeof(size))
+          return false;
+        std::memcpy(&size, message.data() + position, sizeof(size));
+        position += sizeof(size);
+
+        if (size > (message.size() - position) / sizeof(T))
+          return false;
+        values.resize(size);
+        if (size > 0)
+          std::memcpy(&values[0], message.data() + position, sizeof(T)*size);
+        position += sizeof(T)*size;
+        return true;
+      }
+
+      std::string serialize(domain_result const & result)
+      {
+        std::string message;
+        append_array( message, std::vector<char>(result.error.begin(), result.error.end()) );
+        append_array( message, result.points );
+        append_array( message, result.elements );
+        return message;
+      }
+
+      bool deserialize(std::string const & message, domain_result & result)
+      {
+        std::size_t position = 0;
+        std::vector<char> error;
+        if (!extract_array(message, position, error) || !extract_array(message, position, result.points) ||
+            !extract_array(message, position, result.elements) || position != message.size() || result.points.size() % 3 != 0)
+          return false;
+
+        result.error.assign(error.begin(), error.end());
+        return true;
+      }
+
+
+      bool write_all(int fd, std::string const & message)
+      {
+        std::size_t position = 0;
+        while (position != message.size())
+        {
+          ssize_t count = write(fd, message.data() + position, message.size() - position);
+          if (count < 0 && errno == EINTR)
+            continue;
+          if (count <= 0)
+            return false;
+          position += count;
+        }
+        return true;
+      }
+
+      std::string read_all(int fd)
+      {
+        std::string message;
+        char buffer[4096];
+        for (;;)
+        {
+          ssize_t count = read(fd, buffer, sizeof(buffer));
+          if (count < 0 && errno == EINTR)
+            continue;
+          if (count <= 0)
+            break;
+          message.append(buffer, count);
+        }
+        return message;
+      }
+
+
+      // Meshes the volume of one domain in a forked worker process, which has its own copy of the netgen globals, and
+      // reads the result back over a pipe. If no worker can be started, the domain is meshed in this process.
+      domain_result mesh_domain_isolated(::netgen::MeshingParameters const & mesh_parameters, netgen::mesh & domain_mesh,
+                                         int surface_point_count)
+      {
+        ::netgen::MeshingParameters domain_parameters = mesh_parameters;
+
+        int fds[2];
+        pid_t pid = -1;
+        if (pipe(fds) == 0)
+        {
+          std::cout.flush();
+          pid = fork();
+          if (pid < 0)
+          {
+            close(fds[0]);
+            close(fds[1]);
+          }
+        }
+
+        if (pid < 0)
+        {
+          domain_result result;
+          try
+          {
+            mesh_volume(domain_parameters, domain_mesh);
+            result = make_domain_result(domain_mesh, surface_point_count);
+          }
+          catch (::netgen::NgException const & ex)
+          {
+            result.error = ex.What();
+          }
+          return result;
+        }
+
+        if (pid == 0)
+        {
+          // the worker only has the forking thread, locks held by other threads of the parent (e.g. the netgen
+          // mutex) are never released in it and must not be taken
+          close(fds[0]);
+
+          domain_result result;
+          try
+          {
+            mesh_volume_unlocked(domain_parameters, domain_mesh);
+            result = make_domain_result(domain_mesh, surface_point_count);
+          }
+          catch (::netgen::NgException const & ex)
+          {
+            result.error = ex.What();
+          }
+          catch (...)
+          {
+            result.error = "Unknown error";
+          }
+
+          bool written = write_all(fds[1], serialize(result));
+          close(fds[1]);
+          _exit(written ? 0 : 1);
+        }
+
+        close(fds[1]);
+        std::string message = read_all(fds[0]);
+        close(fds[0]);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+        domain_result result;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !deserialize(message, result))
+        {
+          result = domain_result();
+          result.error = "Worker process failed";
+        }
+        return result;
+      }
+
+
+      /* Meshes the volume of every domain of a surface mesh in its own netgen mesh. Every domain is meshed in a forked
+      worker process (see mesh_domain_isolated), up to process_count workers run at the same time.
+
+      The surface elements of a domain are the surface elements whose face descriptor has the domain as inner domain (or as
+      outer domain, these are flipped). Interface surfaces are therefore meshed once and shared by the adjacent domains, their
+      points are fixed in the domain meshes. The domain meshes are stitched into mesh afterwards: the surface points keep their
+      index (they are added first to a domain mesh and are never removed, so they keep their order), the inner points are
+      appended and the volume elements get the domain as index.
+
+      Returns the error messages of failed domains. */
+      std::vector<std::string> mesh_volume_by_domain(::netgen::MeshingParameters const & mesh_parameters, netgen::mesh & mesh,
+                                                     std::vector<int> const & domains,
+                                                     std::vector< std::vector<int> > const & domain_surface_elements,
+                                                     int process_count)
+      {
+        netgen::mesh const & surface_mesh = mesh;
+        int domain_count = domains.size();
+
+        std::vector<domain_result> results(domain_count);
+        std::vector< std::vector<int> > domain_points(domain_count);   // global point index of the surface points of a domain mesh
+
+        #pragma omp parallel for num_threads(process_count) schedule(dynamic)
+        for (int d = 0; d < domain_count; ++d)
+        {
+          std::vector<int> & points = domain_points[d];
+
+          try
+          {
+            netgen::mesh domain_mesh;
+            std::vector<int> local_index( surface_mesh.GetNP() + ::netgen::PointIndex::BASE, 0 );
+            domain_mesh.AddFaceDescriptor( ::netgen::FaceDescriptor(1, 1, 0, 1) );
+
+            for (std::size_t i = 0; i != domain_surface_elements[d].size(); ++i)
+            {
+              int sei = domain_surface_elements[d][i];
+              ::netgen::Element2d el = surface_mesh.SurfaceElement( std::abs(sei) );
+
+              for (int j = 1; j <= el.GetNP(); ++j)
+              {
+                int pi = el.PNum(j);
+                if (local_index[pi] == 0)
+                {
+                  ::netgen::MeshPoint const & p = surface_mesh.Point(pi);
+                  local_index[pi] = domain_mesh.AddPoint( ::netgen::Point3d(p[0], p[1], p[2]), 1, ::netgen::FIXEDPOINT );
+                  points.push_back(pi);
+                }
+                el.PNum(j) = local_index[pi];
+              }
+
+              if (sei < 0)
+                std::swap( el.PNum(2), el.PNum(3) );
+
+              el.SetIndex(1);
+              domain_mesh.AddSurfaceElement(el);
+            }
+
+            results[d] = mesh_domain_isolated(mesh_parameters, domain_mesh, points.size());
+          }
+          catch (::netgen::NgException const & ex)
+          {
+            results[d].error = ex.What();
+          }
+        }
+
+        std::vector<std::string> errors(domain_count);
+        for (int d = 0; d < domain_count; ++d)
+        {
+          domain_result const & result = results[d];
+          if (!result.error.empty())
+          {
+            errors[d] = result.error;
+            continue;
+          }
+
+          std::vector<int> global_index( domain_points[d] );
+          global_index.insert( global_index.begin(), ::netgen::PointIndex::BASE, 0 );
+
+          for (std::size_t i = 0; i != result.points.size(); i += 3)
+            global_index.push_back( mesh.AddPoint( ::netgen::Point3d(result.points[i], result.points[i+1], result.points[i+2]) ) );
+
+          for (std::size_t i = 0; i < result.elements.size(); i += result.elements[i] + 1)
+          {
+            int np = result.elements[i];
+            if (np <= 0 || i + np >= result.elements.size())
+            {
+              errors[d] = "Invalid volume element in worker result";
+              break;
+            }
+
+            ::netgen::Element el(np);
+            for (int j = 1; j <= np; ++j)
+            {
+              int pi = result.elements[i+j];
+              if (pi < ::netgen::PointIndex::BASE || pi >= static_cast<int>(global_index.size()))
+              {
+                errors[d] = "Invalid volume element in worker result";
+                break;
+              }
+              el.PNum(j) = global_index[pi];
+            }
+            if (!errors[d].empty())
+              break;
+
+            el.SetIndex( domains[d] );
+            mesh.AddVolumeElement(el);
+          }
+        }
+
+        return errors;
+      }
+    }
+
+
     make_mesh::make_mesh() {}
 
     std::string make_mesh::name() { return "netgen_make_mesh"; }
@@ -33,6 +372,10 @@ namespace viennamesh
       data_handle<netgen::mesh> input_mesh = get_input<netgen::mesh>("mesh");
       data_handle<double> cell_size = get_input<double>("cell_size");
 
+      // mesh the regions (netgen domains) independently in up to num_threads worker processes
+      data_handle<bool> parallel_regions = get_input<bool>("parallel_regions");
+      data_handle<int> num_threads = get_input<int>("num_threads");
+
       data_handle<netgen::mesh> output_mesh = make_data<netgen::mesh>();
       netgen::mesh & mesh = const_cast<netgen::mesh&>(output_mesh());
 
@@ -69,17 +412,67 @@ namespace viennamesh
         mesh_parameters.maxh = cell_size();
       }
 
-      try
+      bool by_region = parallel_regions.valid() && parallel_regions();
+
+      // surface elements of every domain, negative for surface elements which have the domain as outer domain
+      std::vector< std::vector<int> > surface_elements;
+      for (int i = 1; by_region && i <= mesh.GetNSE(); ++i)
       {
-        mesh.CalcLocalH(mesh_parameters.grading);
-        MeshVolume (mesh_parameters, mesh);
-        RemoveIllegalElements (mesh);
-        OptimizeVolume (mesh_parameters, mesh);
+        ::netgen::FaceDescriptor const & fd = mesh.GetFaceDescriptor( mesh.SurfaceElement(i).GetIndex() );
+        int domain_in = fd.DomainIn();
+        int domain_out = fd.DomainOut();
+
+        if (std::max(domain_in, domain_out) >= static_cast<int>(surface_elements.size()))
+          surface_elements.resize( std::max(domain_in, domain_out)+1 );
+
+        if (domain_in > 0)
+          surface_elements[domain_in].push_back(i);
+        if (domain_out > 0)
+          surface_elements[domain_out].push_back(-i);
       }
-      catch (::netgen::NgException const & ex)
+
+      std::vector<int> domains;
+      std::vector< std::vector<int> > domain_surface_elements;
+      for (std::size_t i = 0; i != surface_elements.size(); ++i)
       {
-        error(1) << "Netgen Error: " << ex.What() << std::endl;
-        return false;
+        if (surface_elements[i].empty())
+          continue;
+
+        domains.push_back(i);
+        domain_surface_elements.push_back( surface_elements[i] );
+      }
+
+      if (by_region && domains.size() > 1)
+      {
+        int process_count = std::max(1, num_threads.valid() ? num_threads() : omp_get_max_threads());
+        info(1) << "Meshing " << domains.size() << " regions independently using up to " << process_count << " worker processes" << std::endl;
+
+        std::vector<std::string> errors = mesh_volume_by_domain(mesh_parameters, mesh, domains, domain_surface_elements, process_count);
+
+        bool success = true;
+        for (std::size_t i = 0; i != errors.size(); ++i)
+        {
+          if (!errors[i].empty())
+          {
+            error(1) << "Netgen Error in region " << domains[i]-1 << ": " << errors[i] << std::endl;
+            success = false;
+          }
+        }
+
+        if (!success)
+          return false;
+      }
+      else
+      {
+        try
+        {
+          mesh_volume(mesh_parameters, mesh);
+        }
+        catch (::netgen::NgException const & ex)
+        {
+          error(1) << "Netgen Error: " << ex.What() << std::endl;
+          return false;
+        }
       }
 
       set_output("mesh", output_mesh);
@@ -7,16 +7,19 @@ namespace viennamesh
   {
     typedef viennagrid::mesh                                                MeshType;
 
-    typedef viennagrid::result_of::point<MeshType>::type                    PointType;
     typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
 
     typedef viennagrid::result_of::const_element_range<MeshType>::type      ConstElementRangeType;
     typedef viennagrid::result_of::iterator<ConstElementRangeType>::type    ConstElementIteratorType;
 
+    typedef viennagrid::result_of::const_element_range<ElementType>::type   ConstBoundaryRangeType;
+    typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type   ConstBoundaryIteratorType;
 
     typedef viennagrid::result_of::region_range<MeshType>::type             RegionRangeType;
     typedef viennagrid::result_of::iterator<RegionRangeType>::type          RegionIteratorType;
 
+    typedef viennagrid::result_of::region_range<ElementType>::type          ElementRegionRangeType;
+
     int region_count = input.region_count();
 
     RegionRangeType regions(input);
@@ -26,22 +29,27 @@ namespace viennamesh
       output.AddFaceDescriptor( (::netgen::FaceDescriptor (netgen_sid, netgen_sid, 0, netgen_sid)) );
     }
 
-    std::map<ElementType, int> vertex_index_map;
-    ConstElementRangeType vertices(input, 0);
-    for (ConstElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
-    {
-      PointType p = viennagrid::get_point(*vit);
-      vertex_index_map[*vit] = output.AddPoint( ::netgen::Point3d( p[0], p[1], p[2] ) );
-    }
+    viennagrid_int vertex_count = viennagrid::vertex_count(input);
+    if (vertex_count == 0)
+      return VIENNAMESH_SUCCESS;
+
 
+    // Netgen point indices are the viennagrid vertex indices shifted by the netgen index base,
+    // the surface elements are collected in arrays first so that the netgen containers can be sized once
     ConstElementRangeType triangles(input, 2);
+
+    std::vector<int> surface_element_points;
+    std::vector<int> surface_element_regions;
+    surface_element_points.reserve( 3*triangles.size() );
+    surface_element_regions.reserve( triangles.size() );
+
     for (ConstElementIteratorType tit = triangles.begin(); tit != triangles.end(); ++tit)
     {
-      typedef viennagrid::result_of::region_range<ElementType>::type ElementRegionRangeType;
-
       int indices[3];
-      for (int i = 0; i < 3; ++i)
-        indices[i] = vertex_index_map[ viennagrid::vertices(*tit)[i] ];
+      int i = 0;
+      ConstBoundaryRangeType vertices(*tit, 0);
+      for (ConstBoundaryIteratorType vit = vertices.begin(); vit != vertices.end() && i < 3; ++vit, ++i)
+        indices[i] = (*vit).id().index() + ::netgen::PointIndex::BASE;
 
       ElementRegionRangeType element_regions(*tit);
 
@@ -66,24 +74,46 @@ namespace viennamesh
           std::swap(region_id0, region_id1);
       }
 
-      ::netgen::Element2d el(3);
-      el.SetIndex ( region_id0+1 );
-      el.PNum(1) = indices[0];
-      el.PNum(2) = indices[2];
-      el.PNum(3) = indices[1];
-      output.AddSurfaceElement (el);
+      surface_element_points.push_back(indices[0]);
+      surface_element_points.push_back(indices[2]);
+      surface_element_points.push_back(indices[1]);
+      surface_element_regions.push_back(region_id0);
 
       if (element_regions.size() == 2)
       {
-        ::netgen::Element2d el(3);
-        el.SetIndex ( region_id1+1 );
-        el.PNum(1) = indices[0];
-        el.PNum(2) = indices[1];
-        el.PNum(3) = indices[2];
-        output.AddSurfaceElement (el);
+        surface_element_points.push_back(indices[0]);
+        surface_element_points.push_back(indices[1]);
+        surface_element_points.push_back(indices[2]);
+        surface_element_regions.push_back(region_id1);
       }
     }
 
+
+    int surface_element_count = surface_element_regions.size();
+    output.SetAllocSize(vertex_count, 0, surface_element_count, 0);
+
+    viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension(input);
+    viennagrid_numeric * coords;
+    viennagrid_mesh_vertex_coords_pointer(input.internal(), &coords);
+
+    for (viennagrid_int i = 0; i < vertex_count; ++i)
+    {
+      viennagrid_numeric const * p = coords + i*geometric_dimension;
+      output.AddPoint( ::netgen::Point3d( p[0],
+                                          geometric_dimension > 1 ? p[1] : 0.0,
+                                          geometric_dimension > 2 ? p[2] : 0.0 ) );
+    }
+
+    ::netgen::Element2d el(3);
+    for (int i = 0; i < surface_element_count; ++i)
+    {
+      el.SetIndex( surface_element_regions[i]+1 );
+      el.PNum(1) = surface_element_points[3*i+0];
+      el.PNum(2) = surface_element_points[3*i+1];
+      el.PNum(3) = surface_element_points[3*i+2];
+      output.AddSurfaceElement(el);
+    }
+
     return VIENNAMESH_SUCCESS;
   }
 
@@ -91,34 +121,63 @@ namespace viennamesh
 
   viennamesh_error convert(netgen::mesh const & input, viennagrid::mesh & output)
   {
-    typedef viennagrid::mesh                                    MeshType;
-    typedef viennagrid::result_of::point<MeshType>::type        PointType;
-    typedef viennagrid::result_of::element<MeshType>::type      ElementType;
-    typedef viennagrid::result_of::region<MeshType>::type       RegionType;
-
-
     int num_points = input.GetNP();
     int num_tets = input.GetNE();
 
-    std::vector<ElementType> vertices( num_points );
+    if (num_points == 0)
+      return VIENNAMESH_SUCCESS;
 
-    for (int i = 1; i <= num_points; ++i)
+    std::vector<viennagrid_numeric> coords( 3*num_points );
+    for (int i = 0; i < num_points; ++i)
     {
-      PointType point = viennagrid::make_point(input.Point(i)[0], input.Point(i)[1], input.Point(i)[2]);
-      vertices[i-1] = viennagrid::make_vertex( output, point );
+      ::netgen::MeshPoint const & point = input.Point(i + ::netgen::PointIndex::BASE);
+      coords[3*i+0] = point[0];
+      coords[3*i+1] = point[1];
+      coords[3*i+2] = point[2];
     }
 
+    // vertex i is netgen point i + PointIndex::BASE
+    viennagrid_element_id first_vertex_id;
+    viennagrid_mesh_geometric_dimension_set(output.internal(), 3);
+    viennagrid_mesh_vertex_batch_create(output.internal(), num_points, &coords[0], &first_vertex_id);
+
+    if (num_tets == 0)
+      return VIENNAMESH_SUCCESS;
+
+
+    // netgen volume element indices are the regions
+    std::vector<viennagrid_element_type> cell_types( num_tets, VIENNAGRID_ELEMENT_TYPE_TETRAHEDRON );
+    std::vector<viennagrid_int> cell_vertex_offsets( num_tets+1 );
+    std::vector<viennagrid_element_id> cell_vertices( 4*num_tets );
+    std::vector<viennagrid_region_id> cell_region_ids( num_tets );
+    std::vector<char> region_created;
 
     for (int i = 0; i < num_tets; ++i)
     {
-        ::netgen::ElementIndex ei = i;
-        RegionType region = output.get_or_create_region( input[ei].GetIndex() );
-        viennagrid::make_tetrahedron( region,
-                                      vertices[input[ei][0]-1],
-                                      vertices[input[ei][1]-1],
-                                      vertices[input[ei][2]-1],
-                                      vertices[input[ei][3]-1]);
+      ::netgen::ElementIndex ei = i;
+      ::netgen::Element const & element = input[ei];
+
+      cell_vertex_offsets[i] = 4*i;
+      for (int j = 0; j < 4; ++j)
+        cell_vertices[4*i+j] = first_vertex_id + (element[j] - ::netgen::PointIndex::BASE);
+
+      int region_id = element.GetIndex();
+      if (region_id >= static_cast<int>(region_created.size()))
+        region_created.resize(region_id+1, false);
+      if (!region_created[region_id])
+      {
+        output.get_or_create_region(region_id);
+        region_created[region_id] = true;
+      }
+      cell_region_ids[i] = region_id;
     }
+    cell_vertex_offsets[num_tets] = 4*num_tets;
+
+    viennagrid_mesh_element_batch_create(output.internal(),
+                                         num_tets, &cell_types[0],
+                                         &cell_vertex_offsets[0], &cell_vertices[0],
+                                         &cell_region_ids[0],
+                                         NULL);
 
     return VIENNAMESH_SUCCESS;
   }
@@ -0,0 +1,416 @@
+#ifndef VIENNAMESH_ALGORITHM_POISSON_NORMAL_ESTIMATION_HPP
+#define VIENNAMESH_ALGORITHM_POISSON_NORMAL_ESTIMATION_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cmath>
+#include <limits>
+
+#include "viennagrid/viennagrid.h"
+
+// Normal estimation on contiguous 3D point arrays (point i at coords[3*i]): the k nearest neighbors
+// of all points are queried in parallel from a kd-tree, the normals are the directions of least
+// variance of the neighborhoods (PCA) and are oriented consistently by traversing a minimum spanning
+// tree of the neighbor graph (Hoppe et al., "Surface reconstruction from unorganized points", 1992).
+namespace viennamesh
+{
+  namespace poisson
+  {
+    // kd-tree stored implicitly in a permutation of the points: the node of the range [begin, end)
+    // is the point at mid = (begin+end)/2 which splits the range along axes[mid]
+    class kd_tree
+    {
+    public:
+
+      kd_tree(viennagrid_numeric const * coords_, int count) : coords(coords_), indices(count), axes(count, -1)
+      {
+        for (int i = 0; i != count; ++i)
+          indices[i] = i;
+
+        // the tree is built level by level, all ranges of a level are split in parallel
+        std::vector< std::pair<int, int> > ranges;
+        if (count > leaf_size())
+          ranges.push_back( std::make_pair(0, count) );
+
+        while (!ranges.empty())
+        {
+          int range_count = ranges.size();
+
+          #pragma omp parallel for schedule(dynamic)
+          for (int r = 0; r < range_count; ++r)
+            split(ranges[r].first, ranges[r].second);
+
+          std::vector< std::pair<int, int> > next;
+          for (int r = 0; r != range_count; ++r)
+          {
+            int begin = ranges[r].first;
+            int end = ranges[r].second;
+            int mid = (begin + end) / 2;
+            if (mid - begin > leaf_size())
+              next.push_back( std::make_pair(begin, mid) );
+            if (end - mid - 1 > leaf_size())
+              next.push_back( std::make_pair(mid+1, end) );
+          }
+          ranges.swap(next);
+        }
+      }
+
+      int size() const { return indices.size(); }
+
+      // the points in tree order, consecutive points are close to each other
+      std::vector<int> const & order() const { return indices; }
+
+      // indices of the k nearest points to p (including p itself if it is part of the tree), nearest first
+      void nearest(viennagrid_numeric const * p, int k, std::vector< std::pair<viennagrid_numeric, int> > & heap) const
+      {
+        heap.clear();
+        k = std::min(k, size());
+        if (k > 0)
+          search(0, size(), p, k, heap);
+        std::sort_heap(heap.begin(), heap.end());
+      }
+
+    private:
+
+      static int leaf_size() { return 8; }
+
+      void split(int begin, int end)
+      {
+        viennagrid_numeric lower[3];
+        viennagrid_numeric upper[3];
+        for (int d = 0; d != 3; ++d)
+        {
+          lower[d] = std::numeric_limits<viennagrid_numeric>::max();
+          upper[d] = -std::numeric_limits<viennagrid_numeric>::max();
+        }
+        for (int i = begin; i != end; ++i)
+          for (int d = 0; d != 3; ++d)
+          {
+            lower[d] = std::min(lower[d], coords[3*indices[i]+d]);
+            upper[d] = std::max(upper[d], coords[3*indices[i]+d]);
+          }
+
+        int axis = 0;
+        for (int d = 1; d != 3; ++d)
+          if (upper[d] - lower[d] > upper[axis] - lower[axis])
+            axis = d;
+
+        int mid = (begin + end) / 2;
+        std::nth_element( indices.begin() + begin, indices.begin() + mid, indices.begin() + end, axis_less(coords, axis) );
+        axes[mid] = axis;
+      }
+
+      void add_candidate(viennagrid_numeric const * p, int index, int k, std::vector< std::pair<viennagrid_numeric, int> > & heap) const
+      {
+        viennagrid_numeric const * q = coords + 3*index;
+        viennagrid_numeric distance = (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]);
+
+        std::pair<viennagrid_numeric, int> candidate(distance, index);
+        if (static_cast<int>(heap.size()) < k)
+        {
+          heap.push_back(candidate);
+          std::push_heap(heap.begin(), heap.end());
+        }
+        else if (candidate < heap.front())
+        {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.back() = candidate;
+          std::push_heap(heap.begin(), heap.end());
+        }
+      }
+
+      void search(int begin, int end, viennagrid_numeric const * p, int k, std::vector< std::pair<viennagrid_numeric, int> > & heap) const
+      {
+        if (end - begin <= leaf_size())
+        {
+          for (int i = begin; i != end; ++i)
+            add_candidate(p, indices[i], k, heap);
+          return;
+        }
+
+        int mid = (begin + end) / 2;
+        int axis = axes[mid];
+        add_candidate(p, indices[mid], k, heap);
+
+        viennagrid_numeric difference = p[axis] - coords[3*indices[mid]+axis];
+        if (difference < 0)
+        {
+          search(begin, mid, p, k, heap);
+          if (static_cast<int>(heap.size()) < k || difference*difference < heap.front().first)
+            search(mid+1, end, p, k, heap);
+        }
+        else
+        {
+          search(mid+1, end, p, k, heap);
+          if (static_cast<int>(heap.size()) < k || difference*difference < heap.front().first)
+            search(begin, mid, p, k, heap);
+        }
+      }
+
+      struct axis_less
+      {
+        axis_less(viennagrid_numeric const * coords_, int axis_) : coords(coords_), axis(axis_) {}
+        bool operator()(int a, int b) const { return coords[3*a+axis] < coords[3*b+axis]; }
+
+        viennagrid_numeric const * coords;
+        int axis;
+      };
+
+      viennagrid_numeric const * coords;
+      std::vector<int> indices;
+      std::vector<int> axes;
+    };
+
+
+
+    // eigenvector of the smallest eigenvalue of the symmetric matrix m (row major), cyclic Jacobi rotations
+    inline void smallest_eigenvector(viennagrid_numeric m[9], viennagrid_numeric * result)
+    {
+      viennagrid_numeric v[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+      for (int sweep = 0; sweep != 32; ++sweep)
+      {
+        viennagrid_numeric off = m[1]*m[1] + m[2]*m[2] + m[5]*m[5];
+        viennagrid_numeric diagonal = m[0]*m[0] + m[4]*m[4] + m[8]*m[8];
+        if (off <= 1e-24 * diagonal || off == 0.0)
+          break;
+
+        for (int p = 0; p != 2; ++p)
+          for (int q = p+1; q != 3; ++q)
+          {
+            viennagrid_numeric apq = m[3*p+q];
+            if (apq == 0.0)
+              continue;
+
+            viennagrid_numeric theta = (m[3*q+q] - m[3*p+p]) / (2*apq);
+            viennagrid_numeric t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta*theta + 1));
+            viennagrid_numeric c = 1 / std::sqrt(t*t + 1);
+            viennagrid_numeric s = t*c;
+
+            for (int k = 0; k != 3; ++k)
+            {
+              viennagrid_numeric mkp = m[3*k+p];
+              viennagrid_numeric mkq = m[3*k+q];
+              m[3*k+p] = c*mkp - s*mkq;
+              m[3*k+q] = s*mkp + c*mkq;
+            }
+            for (int k = 0; k != 3; ++k)
+            {
+              viennagrid_numeric mpk = m[3*p+k];
+              viennagrid_numeric mqk = m[3*q+k];
+              m[3*p+k] = c*mpk - s*mqk;
+              m[3*q+k] = s*mpk + c*mqk;
+            }
+            for (int k = 0; k != 3; ++k)
+            {
+              viennagrid_numeric vkp = v[3*k+p];
+              viennagrid_numeric vkq = v[3*k+q];
+              v[3*k+p] = c*vkp - s*vkq;
+              v[3*k+q] = s*vkp + c*vkq;
+            }
+          }
+      }
+
+      int smallest = 0;
+      for (int i = 1; i != 3; ++i)
+        if (m[4*i] < m[4*smallest])
+          smallest = i;
+
+      for (int k = 0; k != 3; ++k)
+        result[k] = v[3*k+smallest];
+    }
+
+
+    // Unoriented unit normals, normal i is the direction of least variance of the k nearest neighbors of point i.
+    // neighbors[i*k] ... neighbors[i*k+k-1] receive the neighbors of point i (including i), nearest first.
+    // The points are processed in kd-tree order so that consecutive queries touch the same memory.
+    // Returns k, which is reduced for small point clouds.
+    inline int pca_estimate_normals(viennagrid_numeric const * coords, int count, int k,
+                                    viennagrid_numeric * normals, std::vector<int> & neighbors)
+    {
+      k = std::max(1, std::min(k, count));
+      neighbors.resize( static_cast<std::size_t>(count)*k );
+      if (count == 0)
+        return k;
+
+      kd_tree tree(coords, count);
+      std::vector<int> const & order = tree.order();
+
+      #pragma omp parallel
+      {
+        std::vector< std::pair<viennagrid_numeric, int> > heap;
+        heap.reserve(k);
+
+        #pragma omp for schedule(dynamic, 1024)
+        for (int position = 0; position < count; ++position)
+        {
+          int i = order[position];
+          tree.nearest(coords + 3*i, k, heap);
+
+          viennagrid_numeric center[3] = {0, 0, 0};
+          for (int j = 0; j != k; ++j)
+          {
+            neighbors[static_cast<std::size_t>(i)*k+j] = heap[j].second;
+            for (int d = 0; d != 3; ++d)
+              center[d] += coords[3*heap[j].second+d] / k;
+          }
+
+          viennagrid_numeric covariance[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+          for (int j = 0; j != k; ++j)
+          {
+            viennagrid_numeric x[3];
+            for (int d = 0; d != 3; ++d)
+              x[d] = coords[3*heap[j].second+d] - center[d];
+            for (int r = 0; r != 3; ++r)
+              for (int c = 0; c != 3; ++c)
+                covariance[3*r+c] += x[r]*x[c];
+          }
+
+          viennagrid_numeric * normal = normals + 3*i;
+          smallest_eigenvector(covariance, normal);
+
+          viennagrid_numeric length = std::sqrt(normal[0]*normal[0] + normal[1]*normal[1] + normal[2]*normal[2]);
+          if (length > 0)
+            for (int d = 0; d != 3; ++d)
+              normal[d] /= length;
+          else
+          {
+            normal[0] = normal[1] = 0;
+            normal[2] = 1;
+          }
+        }
+      }
+
+      return k;
+    }
+
+
+    inline viennagrid_numeric dot(viennagrid_numeric const * normals, int a, int b)
+    {
+      return normals[3*a]*normals[3*b] + normals[3*a+1]*normals[3*b+1] + normals[3*a+2]*normals[3*b+2];
+    }
+
+    inline viennagrid_numeric edge_weight(viennagrid_numeric const * normals, int a, int b)
+    {
+      return 1.0 - std::abs( dot(normals, a, b) );
+    }
+
+    struct z_greater
+    {
+      z_greater(viennagrid_numeric const * coords_) : coords(coords_) {}
+      bool operator()(int a, int b) const
+      {
+        return coords[3*a+2] > coords[3*b+2] || (coords[3*a+2] == coords[3*b+2] && a < b);
+      }
+
+      viennagrid_numeric const * coords;
+    };
+
+    // Orients the normals along a minimum spanning tree of the symmetric neighbor graph (the Riemannian
+    // graph) with edge weights 1 - |n_i . n_j|, so that orientation is propagated across flat regions
+    // first. Every connected component starts at its point with the largest z coordinate, whose normal
+    // points upwards. Returns the component of every point, components are numbered in traversal order.
+    inline int mst_orient_normals(viennagrid_numeric const * coords, int count, std::vector<int> const & neighbors, int k,
+                                  viennagrid_numeric * normals, std::vector<int> & components)
+    {
+      // symmetric neighbor graph in CSR format
+      std::vector<int> offsets(count+1, 0);
+      for (int i = 0; i != count; ++i)
+        for (int j = 0; j != k; ++j)
+        {
+          int n = neighbors[static_cast<std::size_t>(i)*k+j];
+          if (n != i)
+          {
+            ++offsets[i+1];
+            ++offsets[n+1];
+          }
+        }
+      for (int i = 0; i != count; ++i)
+        offsets[i+1] += offsets[i];
+
+      std::vector<int> adjacency( offsets[count] );
+      {
+        std::vector<int> position(offsets.begin(), offsets.end()-1);
+        for (int i = 0; i != count; ++i)
+          for (int j = 0; j != k; ++j)
+          {
+            int n = neighbors[static_cast<std::size_t>(i)*k+j];
+            if (n != i)
+            {
+              adjacency[position[i]++] = n;
+              adjacency[position[n]++] = i;
+            }
+          }
+      }
+
+      // seeds in order of decreasing z
+      std::vector<int> seeds(count);
+      for (int i = 0; i != count; ++i)
+        seeds[i] = i;
+      std::sort( seeds.begin(), seeds.end(), z_greater(coords) );
+
+      typedef std::pair<viennagrid_numeric, std::pair<int, int> > EdgeType;    // (weight, (from, to))
+      std::priority_queue< EdgeType, std::vector<EdgeType>, std::greater<EdgeType> > queue;
+
+      components.assign(count, -1);
+      int component_count = 0;
+
+      for (int s = 0; s != count; ++s)
+      {
+        int seed = seeds[s];
+        if (components[seed] >= 0)
+          continue;
+
+        if (normals[3*seed+2] < 0)
+          for (int d = 0; d != 3; ++d)
+            normals[3*seed+d] = -normals[3*seed+d];
+
+        components[seed] = component_count;
+        for (int e = offsets[seed]; e != offsets[seed+1]; ++e)
+          queue.push( EdgeType(edge_weight(normals, seed, adjacency[e]), std::make_pair(seed, adjacency[e])) );
+
+        while (!queue.empty())
+        {
+          int from = queue.top().second.first;
+          int to = queue.top().second.second;
+          queue.pop();
+
+          if (components[to] >= 0)
+            continue;
+
+          if (dot(normals, from, to) < 0)
+            for (int d = 0; d != 3; ++d)
+              normals[3*to+d] = -normals[3*to+d];
+
+          components[to] = component_count;
+          for (int e = offsets[to]; e != offsets[to+1]; ++e)
+            if (components[adjacency[e]] < 0)
+              queue.push( EdgeType(edge_weight(normals, to, adjacency[e]), std::make_pair(to, adjacency[e])) );
+        }
+
+        ++component_count;
+      }
+
+      return component_count;
+    }
+  }
+}
+
+#endif
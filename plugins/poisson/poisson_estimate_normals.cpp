@@ -13,7 +13,7 @@
 =============================================================================== */
 #include "poisson_mesh.hpp"
 #include "poisson_estimate_normals.hpp"
-#include <CGAL/pca_estimate_normals.h>
+#include "normal_estimation.hpp"
 #include <CGAL/jet_estimate_normals.h>
 #include <CGAL/mst_orient_normals.h>
 namespace viennamesh
@@ -26,33 +26,22 @@ namespace viennamesh
       bool del;       //delete unoriented normals (some can't be oriented)
       bool jet;       //use jet approximation and not pca (slower and better for curves)
       int jet_degree; //the degree of the jet approximation
+      int neighbors;  //number of nearest neighbors
     };
 
-    void out(PairList & input)
-    {
-      std::cout << "size: "<<input.size()<<"\n";
-      for (PairList::iterator it=input.begin() ; it != input.end(); ++it)
-        std::cout << it->first<< " - "<<it->second<<"\n";
-    }
-
-    void estimate_normals_impl(PairList & input,
+    // jet fitting and orientation with CGAL
+    void estimate_normals_impl(PairVector & input,
                         struct estimate_options options)
     {
-      out(input);
-      const int nb_neighbors = 6; // K-nearest neighbors = 3 rings
+      const int nb_neighbors = options.neighbors;
 
-      if(!options.jet)
-        CGAL::pca_estimate_normals(input.begin(), input.end(),
-                                 CGAL::First_of_pair_property_map<PointVectorPair>(),
-                                 CGAL::Second_of_pair_property_map<PointVectorPair>(),
-                                 nb_neighbors);
-      else
-        CGAL::jet_estimate_normals(input.begin(), input.end(),
+      CGAL::jet_estimate_normals(input.begin(), input.end(),
                                  CGAL::First_of_pair_property_map<PointVectorPair>(),
                                  CGAL::Second_of_pair_property_map<PointVectorPair>(),
                                  nb_neighbors,poisson::Kernel(),options.jet_degree);
 
-      PairList::iterator unoriented_points_begin =
+      // mst_orient_normals moves the unoriented points to the end, the points are reordered
+      PairVector::iterator unoriented_points_begin =
           CGAL::mst_orient_normals(input.begin(), input.end(),
                                    CGAL::First_of_pair_property_map<PointVectorPair>(),
                                    CGAL::Second_of_pair_property_map<PointVectorPair>(),
@@ -61,7 +50,39 @@ namespace viennamesh
       // if you plan to call a reconstruction algorithm that expects oriented normals.
       if(options.del)
         input.erase(unoriented_points_begin, input.end());
-      out(input);
+    }
+
+    // PCA normals from parallel kd-tree queries, oriented along a minimum spanning tree, on contiguous arrays.
+    // The points keep their order, with options.del only the points connected to the topmost point are kept.
+    void pca_estimate_normals_impl(std::vector<viennagrid_numeric> & coords,
+                                   std::vector<viennagrid_numeric> & normals,
+                                   struct estimate_options options)
+    {
+      int count = coords.size() / 3;
+      normals.resize(coords.size());
+      if (count == 0)
+        return;
+
+      std::vector<int> neighbors;
+      int k = pca_estimate_normals(&coords[0], count, options.neighbors, &normals[0], neighbors);
+
+      std::vector<int> components;
+      mst_orient_normals(&coords[0], count, neighbors, k, &normals[0], components);
+
+      if(options.del)
+      {
+        int kept = 0;
+        for (int i = 0; i != count; ++i)
+        {
+          if (components[i] != 0)
+            continue;
+          std::copy(coords.begin() + 3*i, coords.begin() + 3*i+3, coords.begin() + 3*kept);
+          std::copy(normals.begin() + 3*i, normals.begin() + 3*i+3, normals.begin() + 3*kept);
+          ++kept;
+        }
+        coords.resize(3*kept);
+        normals.resize(3*kept);
+      }
     }
 
     estimate_normals::estimate_normals() {}
@@ -73,11 +94,9 @@ namespace viennamesh
       data_handle<bool> delete_option = get_input<bool>("delete_unoriented");
       data_handle<bool> jet_option = get_input<bool>("use_jet_estimation");
       data_handle<int> jet_degree_option = get_input<int>("jet_degree");
-      point_handle input_points = get_required_input<point_handle>("points");
+      point_cloud_handle input_points = get_required_input<point_cloud_handle>("points");
+      data_handle<int> neighbors_option = get_input<int>("neighbors");
       struct estimate_options options;
-      PairList mypoints;
-      for (int i = 0; i != input_points.size(); ++i)
-        mypoints.push_back(std::pair<Point,Vector>(Point(input_points(i)[0],input_points(i)[1],input_points(i)[2]),Vector()));
 
       options.del=0;
       if(delete_option.valid())
@@ -90,34 +109,74 @@ namespace viennamesh
         if(jet_degree_option.valid() && jet_degree_option()>0)
           options.jet_degree=jet_degree_option();
       }
+      options.neighbors=6; // K-nearest neighbors = 3 rings
+      if(neighbors_option.valid() && neighbors_option()>0)
+        options.neighbors=neighbors_option();
 
-      PairList sm = mypoints;
-      PairList & im = sm;
-      std::cout << "options: " << options.del <<" - " <<options.jet <<" - " << options.jet_degree;
-      estimate_normals_impl(im,options);
+      info(5) << "Estimating normals of " << point_count(input_points) << " points (delete unoriented: " << options.del
+              << ", jet: " << options.jet << ", jet degree: " << options.jet_degree << ", neighbors: " << options.neighbors << ")" << std::endl;
 
-      point_handle output_normals = make_data<viennamesh_point>();
-      output_normals.resize( im.size() );
-      int i=0;
-      for (PairList::iterator it=im.begin() ; it != im.end(); ++it,++i)
+      // "points" carries the points together with their normals, "normals" only the normals
+      viennamesh::point_cloud points;
+      viennamesh::point_cloud normals;
+
+      if(options.jet)
       {
-        output_normals(i)=viennagrid::make_point(it->second.x(),it->second.y(),it->second.z());
+        PairVector mypoints;
+        read_points(input_points, mypoints);
+        estimate_normals_impl(mypoints,options);
+
+        // the points are reordered (and possibly reduced) by the CGAL orientation
+        points.resize(3, mypoints.size());
+        normals.resize(3, mypoints.size());
+        viennagrid_numeric * point_coords = points.coords();
+        viennagrid_numeric * point_normals = points.make_normals();
+        viennagrid_numeric * normal_coords = normals.coords();
+        for (std::size_t i = 0; i != mypoints.size(); ++i)
+        {
+          for (int d = 0; d != 3; ++d)
+          {
+            point_coords[3*i+d] = mypoints[i].first[d];
+            point_normals[3*i+d] = normal_coords[3*i+d] = mypoints[i].second[d];
+          }
+        }
       }
-
-      set_output("normals", output_normals);
-      if(options.del)
+      else
       {
-        point_handle output_points = make_data<viennamesh_point>();
-        output_points.resize( im.size() );
-        int i=0;
-        for (PairList::iterator it=im.begin() ; it != im.end(); ++it,++i)
+        std::vector<viennagrid_numeric> coords;
+        coords.reserve( 3*point_count(input_points) );
+        for (int i = 0; i != input_points.size(); ++i)
         {
-          output_normals(i)=viennagrid::make_point(it->first.x(),it->first.y(),it->first.z());
+          viennamesh::point_cloud cloud = input_points(i);
+          int dimension = cloud.dimension();
+          viennagrid_numeric const * cloud_coords = cloud.coords();
+          for (int j = 0; j != cloud.size(); ++j)
+            for (int d = 0; d != 3; ++d)
+              coords.push_back( d < dimension ? cloud_coords[j*dimension+d] : 0.0 );
         }
 
-        set_output("points", output_points);
+        std::vector<viennagrid_numeric> point_normals;
+        pca_estimate_normals_impl(coords, point_normals, options);
+
+        int count = coords.size() / 3;
+        points.resize(3, count);
+        normals.resize(3, count);
+        if (count > 0)
+        {
+          std::copy(coords.begin(), coords.end(), points.coords());
+          std::copy(point_normals.begin(), point_normals.end(), points.make_normals());
+          std::copy(point_normals.begin(), point_normals.end(), normals.coords());
+        }
       }
 
+      point_cloud_handle output_points = make_data<point_cloud_handle>();
+      output_points.set(points);
+      set_output("points", output_points);
+
+      point_cloud_handle output_normals = make_data<point_cloud_handle>();
+      output_normals.set(normals);
+      set_output("normals", output_normals);
+
       return true;
     }
   }
@@ -42,11 +42,58 @@ namespace viennamesh
     typedef Kernel::Point_3 Point;
     typedef Kernel::Vector_3 Vector;
     typedef std::pair<Point, Vector> PointVectorPair;
-    typedef std::list<PointVectorPair> PairList;
+    typedef std::vector<PointVectorPair> PairVector;
     typedef CGAL::Surface_mesh_default_triangulation_3 STr;
     typedef CGAL::Surface_mesh_complex_2_in_triangulation_3<STr> C2t3;
     typedef CGAL::Scale_space_surface_reconstruction_3< Kernel >    Reconstruction;
-    typedef std::list< Point >                                      Point_collection;
+    typedef std::vector< Point >                                    Point_collection;
+
+
+    inline Point make_cgal_point(viennagrid_numeric const * coords, int dimension)
+    {
+      return Point(coords[0], dimension > 1 ? coords[1] : 0.0, dimension > 2 ? coords[2] : 0.0);
+    }
+
+    inline Vector make_cgal_vector(viennagrid_numeric const * coords, int dimension)
+    {
+      return Vector(coords[0], dimension > 1 ? coords[1] : 0.0, dimension > 2 ? coords[2] : 0.0);
+    }
+
+    // total number of points of all point clouds of a data handle
+    inline std::size_t point_count(data_handle<viennamesh_point_cloud> const & clouds)
+    {
+      std::size_t count = 0;
+      for (int i = 0; i != clouds.size(); ++i)
+        count += clouds(i).size();
+      return count;
+    }
+
+    // reads the points of all point clouds of a data handle directly from their coordinate arrays
+    inline void read_points(data_handle<viennamesh_point_cloud> const & clouds, Point_collection & points)
+    {
+      points.reserve( points.size() + point_count(clouds) );
+      for (int i = 0; i != clouds.size(); ++i)
+      {
+        viennamesh::point_cloud cloud = clouds(i);
+        int dimension = cloud.dimension();
+        viennagrid_numeric const * coords = cloud.coords();
+        for (int j = 0; j != cloud.size(); ++j)
+          points.push_back( make_cgal_point(coords + j*dimension, dimension) );
+      }
+    }
+
+    inline void read_points(data_handle<viennamesh_point_cloud> const & clouds, PairVector & points)
+    {
+      points.reserve( points.size() + point_count(clouds) );
+      for (int i = 0; i != clouds.size(); ++i)
+      {
+        viennamesh::point_cloud cloud = clouds(i);
+        int dimension = cloud.dimension();
+        viennagrid_numeric const * coords = cloud.coords();
+        for (int j = 0; j != cloud.size(); ++j)
+          points.push_back( PointVectorPair(make_cgal_point(coords + j*dimension, dimension), Vector()) );
+      }
+    }
   }
 
   namespace result_of
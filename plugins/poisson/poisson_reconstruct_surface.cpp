@@ -139,8 +139,8 @@ namespace viennamesh
 
     bool reconstruct_surface::run(viennamesh::algorithm_handle &)
     {
-      point_handle input_points = get_required_input<point_handle>("points");
-      point_handle input_normals = get_required_input<point_handle>("normals");
+      point_cloud_handle input_points = get_required_input<point_cloud_handle>("points");
+      point_cloud_handle input_normals = get_input<point_cloud_handle>("normals");
       data_handle<double> min_angle = get_input<double>("min_triangle_angle");
       data_handle<double> max_size_mult = get_input<double>("max_triangle_size_times_spacing");
       data_handle<double> max_size_abs = get_input<double>("max_triangle_size");
@@ -190,19 +190,47 @@ namespace viennamesh
         options.approximation_error_abs = -1.0;
       }
 
+      // the normals are taken from the point clouds if they carry normals, otherwise from the "normals" input
       PointList points;
+      points.reserve( point_count(input_points) );
+      viennagrid_numeric const * normal_coords = NULL;
+      int normal_dimension = 0;
+      int normal_count = 0;
+      if (input_normals.valid())
+      {
+        viennamesh::point_cloud normals = input_normals();
+        normal_coords = normals.coords();
+        normal_dimension = normals.dimension();
+        normal_count = normals.size();
+      }
+
       for (int i = 0; i != input_points.size(); ++i)
       {
-        points.push_back(Point_with_normal(Point(input_points(i)[0],
-                                                 input_points(i)[1],
-                                                 input_points(i)[2]),
-                                           poisson::Vector(input_normals(i)[0],
-                                                           input_normals(i)[1],
-                                                           input_normals(i)[2])));
+        viennamesh::point_cloud cloud = input_points(i);
+        int dimension = cloud.dimension();
+        viennagrid_numeric const * coords = cloud.coords();
+        viennagrid_numeric const * normals = cloud.normals();
+
+        for (int j = 0; j != cloud.size(); ++j)
+        {
+          Vector normal;
+          if (normals)
+            normal = make_cgal_vector(normals + j*dimension, dimension);
+          else if (static_cast<int>(points.size()) < normal_count)
+            normal = make_cgal_vector(normal_coords + points.size()*normal_dimension, normal_dimension);
+          else
+          {
+            error(1) << "No normal for point " << points.size() << ": the points carry no normals and the input \"normals\" has "
+                     << normal_count << " entries" << std::endl;
+            return false;
+          }
+
+          points.push_back( Point_with_normal(make_cgal_point(coords + j*dimension, dimension), normal) );
+        }
       }
 
-      std::cout << "Done:  " <<points.size() <<" points with normals\n";
-      std::cout << "options: " << options.min_triangle_angle;
+      info(5) << "Reconstructing surface of " << points.size() << " points with normals (min triangle angle "
+              << options.min_triangle_angle << ")" << std::endl;
       PointList const & im = points;
       mesh_handle output = make_data<mesh_handle>();
       reconstruct_surface_impl(im,output(),options);
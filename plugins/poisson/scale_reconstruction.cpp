@@ -65,15 +65,12 @@ namespace viennamesh
 
     bool scale_reconstruction::run(viennamesh::algorithm_handle &)
     {
-      point_handle input_points = get_required_input<point_handle>("points");
+      point_cloud_handle input_points = get_required_input<point_cloud_handle>("points");
       data_handle<int> sample_option = get_input<int>("neighborhood_sample_size");
       data_handle<int> neighborhood_option = get_input<int>("neighborhood_size");
       data_handle<int> scale_option = get_input<int>("scale");
       Point_collection points;
-      for (int i = 0; i != input_points.size(); ++i)
-        points.push_back(Point(input_points(i)[0],
-                               input_points(i)[1],
-                               input_points(i)[2]));
+      read_points(input_points, points);
       scale_options options;
       if(sample_option.valid() && sample_option() > 0)
         options.sample_size=sample_option();
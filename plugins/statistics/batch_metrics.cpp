@@ -0,0 +1,621 @@
+/* ============================================================================
+   Copyright (c) 2011-2016, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "batch_metrics.hpp"
+
+namespace viennamesh
+{
+    namespace batch_metrics
+    {
+        namespace
+        {
+            enum metric_id
+            {
+                aspect_ratio_id,
+                min_angle_id,
+                max_angle_id,
+                min_dihedral_angle_id,
+                radius_edge_ratio_id,
+                radius_ratio_id,
+                perimeter_inradius_ratio_id,
+                edge_ratio_id,
+                circum_perimeter_ratio_id,
+                stretch_id,
+                skewness_id,
+                condition_number_id
+            };
+
+            // in the order of metric_id
+            std::vector<metric_info> make_metrics()
+            {
+                //                          name                        higher is better  triangles  tetrahedra
+                metric_info const infos[] = { {"aspect_ratio",             false,            true,      true},
+                                              {"min_angle",                true,             true,      true},
+                                              {"max_angle",                false,            true,      true},
+                                              {"min_dihedral_angle",       true,             false,     true},
+                                              {"radius_edge_ratio",        false,            true,      false},
+                                              {"radius_ratio",             false,            true,      true},
+                                              {"perimeter_inradius_ratio", false,            true,      false},
+                                              {"edge_ratio",               false,            true,      false},
+                                              {"circum_perimeter_ratio",   false,            true,      false},
+                                              {"stretch",                  false,            true,      false},
+                                              {"skewness",                 false,            true,      false},
+                                              {"condition_number",         false,            true,      true} };
+                return std::vector<metric_info>(infos, infos + sizeof(infos)/sizeof(infos[0]));
+            }
+
+            int metric_index(std::string const & name)
+            {
+                std::vector<metric_info> const & infos = metrics();
+                for (std::size_t i = 0; i != infos.size(); ++i)
+                    if (infos[i].name == name)
+                        return i;
+                return -1;
+            }
+
+
+            typedef viennagrid_numeric NumericType;
+
+            NumericType const pi = M_PI;
+            NumericType const sqrt3 = std::sqrt(3.0);
+            NumericType const sqrt6 = std::sqrt(6.0);
+            NumericType const epsilon = std::numeric_limits<NumericType>::epsilon();
+            NumericType const max_value = std::numeric_limits<NumericType>::max();
+
+            int const block_size = 256;
+
+            // coordinates of a block of cells, padded to three dimensions: x[k][i] is the x coordinate of corner k of cell i
+            template<int CornerCountV>
+            struct coordinate_block
+            {
+                int count;
+                NumericType x[CornerCountV][block_size];
+                NumericType y[CornerCountV][block_size];
+                NumericType z[CornerCountV][block_size];
+            };
+
+            template<int CornerCountV>
+            void gather(viennagrid_mesh mesh, NumericType const * coords, int geometric_dimension,
+                        viennagrid_element_id const * cell_ids, int count,
+                        coordinate_block<CornerCountV> & block)
+            {
+                block.count = count;
+                for (int i = 0; i != count; ++i)
+                {
+                    viennagrid_element_id * vertex_ids_begin;
+                    viennagrid_element_id * vertex_ids_end;
+                    viennagrid_element_boundary_elements(mesh, cell_ids[i], 0, &vertex_ids_begin, &vertex_ids_end);
+
+                    for (int k = 0; k != CornerCountV; ++k)
+                    {
+                        NumericType const * p = coords + geometric_dimension * viennagrid_index_from_element_id(vertex_ids_begin[k]);
+                        block.x[k][i] = p[0];
+                        block.y[k][i] = geometric_dimension > 1 ? p[1] : 0.0;
+                        block.z[k][i] = geometric_dimension > 2 ? p[2] : 0.0;
+                    }
+                }
+            }
+
+
+            inline NumericType clamped_acos(NumericType value)
+            {
+                return std::acos( std::max(NumericType(-1.0), std::min(NumericType(1.0), value)) );
+            }
+
+            // angle between (ux,uy,uz) and (vx,vy,vz)
+            inline NumericType angle(NumericType ux, NumericType uy, NumericType uz,
+                                     NumericType vx, NumericType vy, NumericType vz)
+            {
+                NumericType lengths = std::sqrt( (ux*ux + uy*uy + uz*uz) * (vx*vx + vy*vy + vz*vz) );
+                return clamped_acos( (ux*vx + uy*vy + uz*vz) / lengths );
+            }
+
+            // solid angle spanned by u, v and w (van Oosterom and Strackee)
+            inline NumericType solid_angle(NumericType ux, NumericType uy, NumericType uz,
+                                           NumericType vx, NumericType vy, NumericType vz,
+                                           NumericType wx, NumericType wy, NumericType wz)
+            {
+                NumericType det = ux*(vy*wz - vz*wy) + uy*(vz*wx - vx*wz) + uz*(vx*wy - vy*wx);
+                NumericType lu = std::sqrt(ux*ux + uy*uy + uz*uz);
+                NumericType lv = std::sqrt(vx*vx + vy*vy + vz*vz);
+                NumericType lw = std::sqrt(wx*wx + wy*wy + wz*wz);
+                NumericType div = lu*lv*lw + (ux*vx + uy*vy + uz*vz)*lw + (ux*wx + uy*wy + uz*wz)*lv + (vx*wx + vy*wy + vz*wz)*lu;
+                return 2 * std::atan2(std::abs(det), div);
+            }
+
+            // interior dihedral angle at the edge (e0,e1) between the faces (e0,e1,a) and (e0,e1,b)
+            inline NumericType dihedral_angle(NumericType ex, NumericType ey, NumericType ez,
+                                              NumericType ax, NumericType ay, NumericType az,
+                                              NumericType bx, NumericType by, NumericType bz)
+            {
+                // e = e1-e0, a = a-e0, b = b-e0; the angle between e x a and e x b
+                return angle( ey*az - ez*ay, ez*ax - ex*az, ex*ay - ey*ax,
+                              ey*bz - ez*by, ez*bx - ex*bz, ex*by - ey*bx );
+            }
+
+            inline NumericType triangle_area(NumericType ux, NumericType uy, NumericType uz,
+                                             NumericType vx, NumericType vy, NumericType vz)
+            {
+                NumericType cx = uy*vz - uz*vy;
+                NumericType cy = uz*vx - ux*vz;
+                NumericType cz = ux*vy - uy*vx;
+                return std::sqrt(cx*cx + cy*cy + cz*cz) / 2;
+            }
+
+
+
+            // geometric terms of a block of triangles shared by the metrics
+            struct triangle_terms
+            {
+                NumericType a[block_size];       // |p1-p0|
+                NumericType b[block_size];       // |p2-p0|
+                NumericType c[block_size];       // |p2-p1|
+                NumericType area[block_size];
+                NumericType circumradius[block_size];
+                NumericType alpha[block_size];   // angle at p0
+                NumericType beta[block_size];    // angle at p1
+                NumericType gamma[block_size];   // angle at p2
+                NumericType v1v2[block_size];    // (p1-p0) . (p2-p0)
+            };
+
+            void compute_terms(coordinate_block<3> const & block, triangle_terms & t)
+            {
+                int const count = block.count;
+
+                #pragma omp simd
+                for (int i = 0; i < count; ++i)
+                {
+                    NumericType ux = block.x[1][i] - block.x[0][i];
+                    NumericType uy = block.y[1][i] - block.y[0][i];
+                    NumericType uz = block.z[1][i] - block.z[0][i];
+                    NumericType vx = block.x[2][i] - block.x[0][i];
+                    NumericType vy = block.y[2][i] - block.y[0][i];
+                    NumericType vz = block.z[2][i] - block.z[0][i];
+                    NumericType wx = block.x[2][i] - block.x[1][i];
+                    NumericType wy = block.y[2][i] - block.y[1][i];
+                    NumericType wz = block.z[2][i] - block.z[1][i];
+
+                    NumericType a = std::sqrt(ux*ux + uy*uy + uz*uz);
+                    NumericType b = std::sqrt(vx*vx + vy*vy + vz*vz);
+                    NumericType c = std::sqrt(wx*wx + wy*wy + wz*wz);
+                    NumericType area = triangle_area(ux, uy, uz, vx, vy, vz);
+
+                    t.a[i] = a;
+                    t.b[i] = b;
+                    t.c[i] = c;
+                    t.area[i] = area;
+                    t.circumradius[i] = a*b*c / (4*area);
+                    t.v1v2[i] = ux*vx + uy*vy + uz*vz;
+
+                    t.alpha[i] = angle(ux, uy, uz, vx, vy, vz);
+                    t.beta[i] = angle(-ux, -uy, -uz, wx, wy, wz);
+                    t.gamma[i] = pi - t.alpha[i] - t.beta[i];
+                }
+            }
+
+            // Same definitions as the scalar triangle metrics in metrics/, so that both evaluations agree
+            void evaluate_triangles(int metric, triangle_terms const & t, int count, NumericType * out)
+            {
+                switch (metric)
+                {
+                    case aspect_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = (std::abs(t.area[i]) < epsilon) ? max_value :
+                                     (t.a[i]*t.a[i] + t.b[i]*t.b[i] + t.c[i]*t.c[i]) / (4 * t.area[i] * sqrt3);
+                        break;
+
+                    case min_angle_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = std::min(std::min(t.alpha[i], t.beta[i]), t.gamma[i]);
+                        break;
+
+                    case max_angle_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = std::max(std::max(t.alpha[i], t.beta[i]), t.gamma[i]);
+                        break;
+
+                    case radius_edge_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType min_length = std::min(t.a[i], std::min(t.b[i], t.c[i]));
+                            out[i] = (min_length < epsilon) ? max_value : t.circumradius[i] / min_length * sqrt3;
+                        }
+                        break;
+
+                    case radius_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType p = (t.a[i] + t.b[i] + t.c[i]) / 2;
+                            NumericType r = t.area[i] / p;
+                            NumericType ratio = t.circumradius[i] / (2*r);
+                            out[i] = (std::abs(ratio) < epsilon) ? max_value : ratio;
+                        }
+                        break;
+
+                    case perimeter_inradius_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType p = (t.a[i] + t.b[i] + t.c[i]) / 2;
+                            NumericType r = t.area[i] / p;
+                            out[i] = (r < epsilon) ? max_value : p / (r * 3 * sqrt3);
+                        }
+                        break;
+
+                    case edge_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType shortest = std::min(t.a[i], std::min(t.b[i], t.c[i]));
+                            NumericType longest = std::max(t.a[i], std::max(t.b[i], t.c[i]));
+                            out[i] = (std::abs(shortest) < epsilon) ? max_value : longest / shortest;
+                        }
+                        break;
+
+                    case circum_perimeter_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType p = (t.a[i] + t.b[i] + t.c[i]) / 2;
+                            out[i] = (p < epsilon) ? max_value : t.circumradius[i] / p * 3 * sqrt3 / 2;
+                        }
+                        break;
+
+                    case stretch_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType longest = std::max(t.a[i], std::max(t.b[i], t.c[i]));
+                            out[i] = (std::abs(longest) < epsilon) ? max_value : t.circumradius[i] * std::sqrt(12.0) / (longest * 2);
+                        }
+                        break;
+
+                    case skewness_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType max_angle = std::max(std::max(t.alpha[i], t.beta[i]), t.gamma[i]);
+                            NumericType min_angle = std::min(std::min(t.alpha[i], t.beta[i]), t.gamma[i]);
+                            NumericType equi_angle = pi/3;
+                            out[i] = std::max((max_angle - equi_angle) / (2*pi/3), (equi_angle - min_angle) / equi_angle);
+                        }
+                        break;
+
+                    case condition_number_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = (std::abs(t.area[i]) < epsilon) ? max_value :
+                                     (t.a[i]*t.a[i] + t.b[i]*t.b[i] - t.v1v2[i]) / (2 * t.area[i] * sqrt3);
+                        break;
+                }
+            }
+
+
+
+            // geometric terms of a block of tetrahedra shared by the metrics
+            struct tetrahedron_terms
+            {
+                NumericType volume[block_size];
+                NumericType surface[block_size];
+                NumericType circumradius[block_size];
+                NumericType solid_angle[4][block_size];   // solid angle at corner k
+            };
+
+            void compute_terms(coordinate_block<4> const & block, tetrahedron_terms & t)
+            {
+                int const count = block.count;
+
+                #pragma omp simd
+                for (int i = 0; i < count; ++i)
+                {
+                    // edges from p0
+                    NumericType ax = block.x[1][i] - block.x[0][i], ay = block.y[1][i] - block.y[0][i], az = block.z[1][i] - block.z[0][i];
+                    NumericType bx = block.x[2][i] - block.x[0][i], by = block.y[2][i] - block.y[0][i], bz = block.z[2][i] - block.z[0][i];
+                    NumericType cx = block.x[3][i] - block.x[0][i], cy = block.y[3][i] - block.y[0][i], cz = block.z[3][i] - block.z[0][i];
+                    // edges from p1
+                    NumericType dx = block.x[2][i] - block.x[1][i], dy = block.y[2][i] - block.y[1][i], dz = block.z[2][i] - block.z[1][i];
+                    NumericType ex = block.x[3][i] - block.x[1][i], ey = block.y[3][i] - block.y[1][i], ez = block.z[3][i] - block.z[1][i];
+                    // edge p2 -> p3
+                    NumericType fx = block.x[3][i] - block.x[2][i], fy = block.y[3][i] - block.y[2][i], fz = block.z[3][i] - block.z[2][i];
+
+                    NumericType det = ax*(by*cz - bz*cy) + ay*(bz*cx - bx*cz) + az*(bx*cy - by*cx);
+                    NumericType volume = std::abs(det) / 6;
+
+                    t.volume[i] = volume;
+                    t.surface[i] = triangle_area(ax, ay, az, bx, by, bz) + triangle_area(ax, ay, az, cx, cy, cz) +
+                                   triangle_area(bx, by, bz, cx, cy, cz) + triangle_area(dx, dy, dz, ex, ey, ez);
+
+                    // |l3|^2 (l2 x l0) + |l2|^2 (l3 x l0) + |l0|^2 (l3 x l2) / (12 volume)
+                    // with l0 = p1-p0 = a, l2 = p0-p2 = -b, l3 = p3-p0 = c
+                    NumericType l0l0 = ax*ax + ay*ay + az*az;
+                    NumericType l2l2 = bx*bx + by*by + bz*bz;
+                    NumericType l3l3 = cx*cx + cy*cy + cz*cz;
+                    NumericType l2x = -bx, l2y = -by, l2z = -bz;
+                    NumericType rx = l3l3*(l2y*az - l2z*ay) + l2l2*(cy*az - cz*ay) + l0l0*(cy*l2z - cz*l2y);
+                    NumericType ry = l3l3*(l2z*ax - l2x*az) + l2l2*(cz*ax - cx*az) + l0l0*(cz*l2x - cx*l2z);
+                    NumericType rz = l3l3*(l2x*ay - l2y*ax) + l2l2*(cx*ay - cy*ax) + l0l0*(cx*l2y - cy*l2x);
+                    t.circumradius[i] = std::sqrt(rx*rx + ry*ry + rz*rz) / (12 * volume);
+
+                    t.solid_angle[0][i] = solid_angle(ax, ay, az, bx, by, bz, cx, cy, cz);
+                    t.solid_angle[1][i] = solid_angle(-ax, -ay, -az, dx, dy, dz, ex, ey, ez);
+                    t.solid_angle[2][i] = solid_angle(-bx, -by, -bz, -dx, -dy, -dz, fx, fy, fz);
+                    t.solid_angle[3][i] = solid_angle(-cx, -cy, -cz, -ex, -ey, -ez, -fx, -fy, -fz);
+                }
+            }
+
+            // same definitions as the scalar tetrahedron metrics in metrics/
+            void evaluate_tetrahedra(int metric, coordinate_block<4> const & block, tetrahedron_terms const & t, int count, NumericType * out)
+            {
+                switch (metric)
+                {
+                    case aspect_ratio_id:
+                    case radius_ratio_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType r = 3 * t.volume[i] / t.surface[i];
+                            out[i] = t.circumradius[i] / (3*r);
+                        }
+                        break;
+
+                    case min_angle_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = std::min( std::min(t.solid_angle[0][i], t.solid_angle[1][i]),
+                                               std::min(t.solid_angle[2][i], t.solid_angle[3][i]) );
+                        break;
+
+                    case max_angle_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                            out[i] = std::max( std::max(t.solid_angle[0][i], t.solid_angle[1][i]),
+                                               std::max(t.solid_angle[2][i], t.solid_angle[3][i]) );
+                        break;
+
+                    case min_dihedral_angle_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            NumericType x[4], y[4], z[4];
+                            for (int k = 0; k != 4; ++k)
+                            {
+                                x[k] = block.x[k][i];
+                                y[k] = block.y[k][i];
+                                z[k] = block.z[k][i];
+                            }
+
+                            // the edges (j,k) with the two remaining corners l and m
+                            static int const edges[6][4] = { {0,1,2,3}, {0,2,1,3}, {0,3,1,2}, {1,2,0,3}, {1,3,0,2}, {2,3,0,1} };
+                            NumericType result = max_value;
+                            for (int e = 0; e != 6; ++e)
+                            {
+                                int j = edges[e][0], k = edges[e][1], l = edges[e][2], m = edges[e][3];
+                                result = std::min(result, dihedral_angle(x[k]-x[j], y[k]-y[j], z[k]-z[j],
+                                                                         x[l]-x[j], y[l]-y[j], z[l]-z[j],
+                                                                         x[m]-x[j], y[m]-y[j], z[m]-z[j]));
+                            }
+                            out[i] = result;
+                        }
+                        break;
+
+                    case condition_number_id:
+                        #pragma omp simd
+                        for (int i = 0; i < count; ++i)
+                        {
+                            if (std::abs(t.volume[i]) < epsilon)
+                            {
+                                out[i] = max_value;
+                                continue;
+                            }
+
+                            NumericType l0x = block.x[1][i] - block.x[0][i], l0y = block.y[1][i] - block.y[0][i], l0z = block.z[1][i] - block.z[0][i];
+                            NumericType l2x = block.x[2][i] - block.x[0][i], l2y = block.y[2][i] - block.y[0][i], l2z = block.z[2][i] - block.z[0][i];
+                            NumericType l3x = block.x[3][i] - block.x[0][i], l3y = block.y[3][i] - block.y[0][i], l3z = block.z[3][i] - block.z[0][i];
+
+                            NumericType c1x = l0x, c1y = l0y, c1z = l0z;
+                            NumericType c2x = (-2*l2x - l0x) / sqrt3, c2y = (-2*l2y - l0y) / sqrt3, c2z = (-2*l2z - l0z) / sqrt3;
+                            NumericType c3x = (3*l3x + l2x - l0x) / sqrt6, c3y = (3*l3y + l2y - l0y) / sqrt6, c3z = (3*l3z + l2z - l0z) / sqrt6;
+
+                            NumericType t1 = c1x*c1x + c1y*c1y + c1z*c1z + c2x*c2x + c2y*c2y + c2z*c2z + c3x*c3x + c3y*c3y + c3z*c3z;
+
+                            NumericType x12 = c1y*c2z - c1z*c2y, y12 = c1z*c2x - c1x*c2z, z12 = c1x*c2y - c1y*c2x;
+                            NumericType x23 = c2y*c3z - c2z*c3y, y23 = c2z*c3x - c2x*c3z, z23 = c2x*c3y - c2y*c3x;
+                            NumericType x13 = c1y*c3z - c1z*c3y, y13 = c1z*c3x - c1x*c3z, z13 = c1x*c3y - c1y*c3x;
+                            NumericType t2 = x12*x12 + y12*y12 + z12*z12 + x23*x23 + y23*y23 + z23*z23 + x13*x13 + y13*y13 + z13*z13;
+
+                            NumericType det = std::abs( c1x*x23 + c1y*y23 + c1z*z23 );
+                            out[i] = std::sqrt(t1*t2) / (3*det);
+                        }
+                        break;
+                }
+            }
+
+
+
+            template<int CornerCountV, typename TermsT, typename EvaluateT>
+            void evaluate_blocks(viennagrid::mesh const & mesh, mesh_cells const & cells,
+                                 std::vector<int> const & metric_ids,
+                                 std::vector< std::vector<NumericType> > & values,
+                                 EvaluateT evaluate_block)
+            {
+                viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension(mesh);
+                NumericType * coords;
+                viennagrid_mesh_vertex_coords_pointer(mesh.internal(), &coords);
+
+                long cell_count = cells.end - cells.begin;
+                long block_count = (cell_count + block_size - 1) / block_size;
+
+                #pragma omp parallel
+                {
+                    // per thread, the blocks are too large for the stack
+                    std::vector< coordinate_block<CornerCountV> > block(1);
+                    std::vector<TermsT> terms(1);
+
+                    #pragma omp for schedule(static)
+                    for (long b = 0; b < block_count; ++b)
+                    {
+                        long first = b * block_size;
+                        int count = static_cast<int>( std::min<long>(block_size, cell_count - first) );
+
+                        gather(mesh.internal(), coords, geometric_dimension, cells.begin + first, count, block[0]);
+                        compute_terms(block[0], terms[0]);
+
+                        for (std::size_t m = 0; m != metric_ids.size(); ++m)
+                            evaluate_block(metric_ids[m], block[0], terms[0], count, &values[m][first]);
+                    }
+                }
+            }
+
+            struct evaluate_triangle_block
+            {
+                void operator()(int metric, coordinate_block<3> const &, triangle_terms const & terms, int count, NumericType * out) const
+                { evaluate_triangles(metric, terms, count, out); }
+            };
+
+            struct evaluate_tetrahedron_block
+            {
+                void operator()(int metric, coordinate_block<4> const & block, tetrahedron_terms const & terms, int count, NumericType * out) const
+                { evaluate_tetrahedra(metric, block, terms, count, out); }
+            };
+        }
+
+
+
+        std::vector<metric_info> const & metrics()
+        {
+            static std::vector<metric_info> infos = make_metrics();
+            return infos;
+        }
+
+        metric_info const * find_metric(std::string const & name)
+        {
+            int index = metric_index(name);
+            return index < 0 ? NULL : &metrics()[index];
+        }
+
+
+        mesh_cells get_cells(viennagrid::mesh const & mesh)
+        {
+            mesh_cells cells;
+            cells.corner_count = 0;
+            cells.begin = cells.end = NULL;
+
+            if (viennagrid::vertex_count(mesh) == 0)
+                return cells;
+
+            viennagrid_dimension cell_dimension = viennagrid::cell_dimension(mesh);
+            if (cell_dimension != 2 && cell_dimension != 3)
+                return cells;
+
+            viennagrid_mesh_elements_get(mesh.internal(), cell_dimension, &cells.begin, &cells.end);
+
+            // simplices only, the cells of a dimension have the same number of vertices in that case
+            int corner_count = cell_dimension + 1;
+            long cell_count = cells.end - cells.begin;
+            bool simplices = true;
+
+            #pragma omp parallel for schedule(static) reduction(&&:simplices)
+            for (long i = 0; i < cell_count; ++i)
+            {
+                viennagrid_element_id * vertex_ids_begin;
+                viennagrid_element_id * vertex_ids_end;
+                viennagrid_element_boundary_elements(mesh.internal(), cells.begin[i], 0, &vertex_ids_begin, &vertex_ids_end);
+                simplices = simplices && (vertex_ids_end - vertex_ids_begin == corner_count);
+            }
+
+            if (simplices)
+                cells.corner_count = corner_count;
+            return cells;
+        }
+
+
+        bool supported(mesh_cells const & cells, std::vector<std::string> const & metric_names)
+        {
+            if (cells.corner_count == 0)
+                return false;
+
+            for (std::size_t i = 0; i != metric_names.size(); ++i)
+            {
+                metric_info const * info = find_metric(metric_names[i]);
+                if (!info || (cells.corner_count == 3 && !info->triangles) || (cells.corner_count == 4 && !info->tetrahedra))
+                    return false;
+            }
+
+            return true;
+        }
+
+
+        void evaluate(viennagrid::mesh const & mesh,
+                      mesh_cells const & cells,
+                      std::vector<std::string> const & metric_names,
+                      std::vector< std::vector<viennagrid_numeric> > & values)
+        {
+            std::vector<int> metric_ids(metric_names.size());
+            for (std::size_t i = 0; i != metric_names.size(); ++i)
+                metric_ids[i] = metric_index(metric_names[i]);
+
+            values.resize(metric_names.size());
+            for (std::size_t i = 0; i != values.size(); ++i)
+                values[i].resize(cells.end - cells.begin);
+
+            if (cells.begin == cells.end)
+                return;
+
+            if (cells.corner_count == 3)
+                evaluate_blocks<3, triangle_terms>(mesh, cells, metric_ids, values, evaluate_triangle_block());
+            else if (cells.corner_count == 4)
+                evaluate_blocks<4, tetrahedron_terms>(mesh, cells, metric_ids, values, evaluate_tetrahedron_block());
+        }
+
+
+        viennagrid::quantity_field make_quantity_field(mesh_cells const & cells,
+                                                       std::string const & metric_name,
+                                                       std::vector<viennagrid_numeric> const & values)
+        {
+            viennagrid_dimension cell_dimension = cells.corner_count - 1;
+
+            viennagrid::quantity_field field(cell_dimension, 1);
+            field.set_name(metric_name);
+
+            long cell_count = cells.end - cells.begin;
+            if (cell_count == 0)
+                return field;
+
+            // the largest cell index first, so the field storage is allocated once,
+            // then the values are copied straight from the output array
+            long max_position = 0;
+            for (long i = 1; i < cell_count; ++i)
+                if (viennagrid_index_from_element_id(cells.begin[i]) > viennagrid_index_from_element_id(cells.begin[max_position]))
+                    max_position = i;
+
+            viennagrid_quantity_field_value_set(field.internal(), viennagrid_index_from_element_id(cells.begin[max_position]),
+                                                const_cast<viennagrid_numeric *>(&values[max_position]));
+
+            for (long i = 0; i < cell_count; ++i)
+                viennagrid_quantity_field_value_set(field.internal(), viennagrid_index_from_element_id(cells.begin[i]),
+                                                    const_cast<viennagrid_numeric *>(&values[i]));
+
+            return field;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef VIENNAMESH_STATISTICS_BATCH_METRICS_HPP
+#define VIENNAMESH_STATISTICS_BATCH_METRICS_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2016, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <string>
+#include <vector>
+
+#include "viennagrid/viennagrid.hpp"
+
+/* Batch evaluation of cell quality metrics for triangle and tetrahedral meshes.
+
+The cell coordinates are gathered block wise into contiguous arrays (one array per corner and coordinate),
+the geometric terms shared by the metrics (edge lengths, area/volume, circumradius, angles) are computed once
+per block and all requested metrics are evaluated from them. Blocks are processed in parallel using OpenMP.
+
+The metrics have the same definitions as the scalar metrics in metrics/, the names are the metric types of
+make_statistic.
+ */
+
+namespace viennamesh
+{
+    namespace batch_metrics
+    {
+        struct metric_info
+        {
+            std::string name;
+            bool higher_is_better;
+            bool triangles;
+            bool tetrahedra;
+        };
+
+        // all metrics with a batch kernel
+        std::vector<metric_info> const & metrics();
+
+        // NULL if there is no batch kernel for the metric
+        metric_info const * find_metric(std::string const & name);
+
+
+        struct mesh_cells
+        {
+            int corner_count;   // 3 for triangles, 4 for tetrahedra, 0 otherwise
+            viennagrid_element_id * begin;
+            viennagrid_element_id * end;
+        };
+
+        // the cells of the mesh, checked once whether they are all triangles or all tetrahedra
+        mesh_cells get_cells(viennagrid::mesh const & mesh);
+
+        // true if the cells are triangles or tetrahedra only and all metrics have a batch kernel for them
+        bool supported(mesh_cells const & cells, std::vector<std::string> const & metric_names);
+
+        // Evaluates the metrics for all cells of the mesh, values[m][i] is metric m of the cell with index i.
+        // Requires supported(cells, metric_names).
+        void evaluate(viennagrid::mesh const & mesh,
+                      mesh_cells const & cells,
+                      std::vector<std::string> const & metric_names,
+                      std::vector< std::vector<viennagrid_numeric> > & values);
+
+        // cell quantity field named metric_name with the values of evaluate
+        viennagrid::quantity_field make_quantity_field(mesh_cells const & cells,
+                                                       std::string const & metric_name,
+                                                       std::vector<viennagrid_numeric> const & values);
+    }
+}
+
+#endif
@@ -12,8 +12,11 @@
    License:         MIT (X11), see file LICENSE in the base directory
 =============================================================================== */
 
+#include <sstream>
+
 #include "make_statistic.hpp"
 #include "statistic.hpp"
+#include "batch_metrics.hpp"
 
 //TODO:
 /*Histograms features seem not to be fully functionable. With HIST = 0 all histogram related functions and structs are cut out.
@@ -40,6 +43,12 @@ curvature and surface area deviation metrics (see mesh_comparison.hpp). Addition
 shape quality parameter ("metric_type") the median value for the original mesh is automatically set as threshold value, ignoring a possibly given
 "good_element_threshold".
 
+For triangle and tetrahedral meshes without "original_mesh" the metrics are evaluated by the batch kernels (see batch_metrics.hpp). In that case
+several metrics can be given ("metric_type" with multiple values or a comma separated list), they are evaluated in a single pass. The first metric
+is used for the outputs min, max, mean, median and the quality classification, with more than one metric the outputs <metric>_min, <metric>_max,
+<metric>_mean and <metric>_median are provided for every metric. The per cell values of all metrics are provided as cell quantity fields named
+after the metric (output "quality_fields").
+
  */
 
 
@@ -65,6 +74,26 @@ namespace viennamesh
          * Note that most metrics are only implemented for triangles*/
         data_handle<viennamesh_string> metric_type = get_required_input<viennamesh_string>("metric_type");
 
+        std::vector<std::string> metric_names;
+        for (int i = 0; i != metric_type.size(); ++i)
+        {
+            std::stringstream ss( metric_type(i) );
+            std::string name;
+            while (std::getline(ss, name, ','))
+            {
+                name.erase(0, name.find_first_not_of(" \t"));
+                name.erase(name.find_last_not_of(" \t") + 1);
+                if (!name.empty())
+                    metric_names.push_back(name);
+            }
+        }
+
+        if (metric_names.empty())
+        {
+            error(1) << "No metric type provided" << std::endl;
+            return false;
+        }
+
         /*Decision threshold for triangle qualitity classification
          * E.g., radius_ratio < 1.5
          * Whether '<' or '>' is used for comparison is deduced from metric_ordering_tag*/
@@ -120,68 +149,114 @@ namespace viennamesh
 
 
 
+        //All metrics have a batch kernel for the cells of the mesh, evaluate them in one pass
+        batch_metrics::mesh_cells batch_cells = batch_metrics::mesh_cells();
+        if (!original_mesh.valid())
+            batch_cells = batch_metrics::get_cells(input_mesh());
+
+        if (batch_metrics::supported(batch_cells, metric_names))
+        {
+            std::string joined_names = metric_names[0];
+            for (std::size_t i = 1; i != metric_names.size(); ++i)
+                joined_names += ", " + metric_names[i];
+            viennamesh::LoggingStack stack( std::string("Batch cell statistics with metric types \"") + joined_names + "\"" );
+
+            std::vector< std::vector<viennagrid_numeric> > values;
+            batch_metrics::evaluate(input_mesh(), batch_cells, metric_names, values);
+
+            quantity_field_handle quality_fields = make_data<viennagrid::quantity_field>();
+            quality_fields.resize( metric_names.size() );
+
+            for (std::size_t i = 0; i != metric_names.size(); ++i)
+            {
+                quality_fields.set( i, batch_metrics::make_quantity_field(batch_cells, metric_names[i], values[i]) );
+
+                if (metric_names.size() > 1)
+                {
+                    StatisticType metric_statistic;
+                    metric_statistic.cell_stats( values[i] );
+
+                    set_output( metric_names[i] + "_min", metric_statistic.min() );
+                    set_output( metric_names[i] + "_max", metric_statistic.max() );
+                    set_output( metric_names[i] + "_mean", metric_statistic.mean() );
+                    set_output( metric_names[i] + "_median", metric_statistic.median() );
+                }
+            }
+
+            set_output( "quality_fields", quality_fields );
+
+            if (good_element_threshold.valid())
+                statistic.cell_quality_count( values[0], good_element_threshold(), batch_metrics::find_metric(metric_names[0])->higher_is_better );
+            else
+                statistic.cell_stats( values[0] );
+        }
+        else if (metric_names.size() > 1)
+        {
+            error(1) << "Multiple metric types are only supported for triangle and tetrahedral meshes without original mesh" << std::endl;
+            return false;
+        }
         //Good element threshold input was set, call statistics with the appropriate metric
-        if(good_element_threshold.valid())
+        else if(good_element_threshold.valid())
         {
-            viennamesh::LoggingStack stack( std::string("High quality cell counter with metric type \"") + metric_type() + "\"" );
+            viennamesh::LoggingStack stack( std::string("High quality cell counter with metric type \"") + metric_names[0] + "\"" );
 
-            if (metric_type() == "aspect_ratio")
+            if (metric_names[0] == "aspect_ratio")
                 statistic.cell_quality_count<viennamesh::aspect_ratio_tag>( input_mesh(), viennamesh::aspect_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "min_angle")
+            else if (metric_names[0] == "min_angle")
                 statistic.cell_quality_count<viennamesh::min_angle_tag>( input_mesh(), viennamesh::min_angle<ElementType>, good_element_threshold());
-            else if (metric_type() == "max_angle")
+            else if (metric_names[0] == "max_angle")
                 statistic.cell_quality_count<viennamesh::max_angle_tag>( input_mesh(), viennamesh::max_angle<ElementType>, good_element_threshold());
-            else if (metric_type() == "min_dihedral_angle")
+            else if (metric_names[0] == "min_dihedral_angle")
                 statistic.cell_quality_count<viennamesh::min_dihedral_angle_tag>( input_mesh(), viennamesh::min_dihedral_angle<ElementType>, good_element_threshold());
-            else if (metric_type() == "radius_edge_ratio")
+            else if (metric_names[0] == "radius_edge_ratio")
                 statistic.cell_quality_count<viennamesh::radius_edge_ratio_tag>( input_mesh(), viennamesh::radius_edge_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "radius_ratio")
+            else if (metric_names[0] == "radius_ratio")
                 statistic.cell_quality_count<viennamesh::radius_ratio_tag>( input_mesh(), viennamesh::radius_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "perimeter_inradius_ratio")
+            else if (metric_names[0] == "perimeter_inradius_ratio")
                 statistic.cell_quality_count<viennamesh::perimeter_inradius_ratio_tag>( input_mesh(), viennamesh::perimeter_inradius_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "edge_ratio")
+            else if (metric_names[0] == "edge_ratio")
                 statistic.cell_quality_count<viennamesh::edge_ratio_tag>( input_mesh(), viennamesh::edge_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "circum_perimeter_ratio")
+            else if (metric_names[0] == "circum_perimeter_ratio")
                 statistic.cell_quality_count<viennamesh::circum_perimeter_ratio_tag>( input_mesh(), viennamesh::circum_perimeter_ratio<ElementType>, good_element_threshold());
-            else if (metric_type() == "stretch")
+            else if (metric_names[0] == "stretch")
                 statistic.cell_quality_count<viennamesh::stretch_tag>( input_mesh(), viennamesh::stretch<ElementType>, good_element_threshold());
-            else if (metric_type() == "skewness")
+            else if (metric_names[0] == "skewness")
                 statistic.cell_quality_count<viennamesh::skewness_tag>( input_mesh(), viennamesh::skewness<ElementType>, good_element_threshold());
             else
             {
-                error(1) << "Metric type \"" << metric_type() << "\" is not supported for cell quality classifaction" << std::endl;
+                error(1) << "Metric type \"" << metric_names[0] << "\" is not supported for cell quality classifaction" << std::endl;
                 return false;
             }
         }
         else //no triangle classifiction takes place
         {
-            viennamesh::LoggingStack stack( std::string("Cell statistics with metric type \"") + metric_type() + "\"" );
+            viennamesh::LoggingStack stack( std::string("Cell statistics with metric type \"") + metric_names[0] + "\"" );
 
-            if (metric_type() == "aspect_ratio")
+            if (metric_names[0] == "aspect_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::aspect_ratio<ElementType> );
-            else if (metric_type() == "min_angle")
+            else if (metric_names[0] == "min_angle")
                 statistic.cell_stats( input_mesh(), viennamesh::min_angle<ElementType> );
-            else if (metric_type() == "max_angle")
+            else if (metric_names[0] == "max_angle")
                 statistic.cell_stats( input_mesh(), viennamesh::max_angle<ElementType> );
-            else if (metric_type() == "min_dihedral_angle")
+            else if (metric_names[0] == "min_dihedral_angle")
                 statistic.cell_stats( input_mesh(), viennamesh::min_dihedral_angle<ElementType> );
-            else if (metric_type() == "radius_edge_ratio")
+            else if (metric_names[0] == "radius_edge_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::radius_edge_ratio<ElementType> );
-            else if (metric_type() == "radius_ratio")
+            else if (metric_names[0] == "radius_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::radius_ratio<ElementType> );
-            else if (metric_type() == "perimeter_inradius_ratio")
+            else if (metric_names[0] == "perimeter_inradius_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::perimeter_inradius_ratio<ElementType> );
-            else if (metric_type() == "edge_ratio")
+            else if (metric_names[0] == "edge_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::edge_ratio<ElementType> );
-            else if (metric_type() == "circum_perimeter_ratio")
+            else if (metric_names[0] == "circum_perimeter_ratio")
                 statistic.cell_stats( input_mesh(), viennamesh::circum_perimeter_ratio<ElementType> );
-            else if (metric_type() == "stretch")
+            else if (metric_names[0] == "stretch")
                 statistic.cell_stats( input_mesh(), viennamesh::stretch<ElementType> );
-            else if (metric_type() == "skewness")
+            else if (metric_names[0] == "skewness")
                 statistic.cell_stats( input_mesh(), viennamesh::skewness<ElementType> );
             else
             {
-                error(1) << "Metric type \"" << metric_type() << "\" is not supported" << std::endl;
+                error(1) << "Metric type \"" << metric_names[0] << "\" is not supported" << std::endl;
                 return false;
             }
         }
@@ -45,8 +45,8 @@ namespace viennamesh
             NumericType b = viennagrid::distance(p0, p2);
             NumericType c = viennagrid::distance(p1, p2);
 
-            NumericType shortest = std::min(a, std::min(a,c));
-            NumericType longest = std::max(a, std::max(a,c));
+            NumericType shortest = std::min(a, std::min(b,c));
+            NumericType longest = std::max(a, std::max(b,c));
 
 
 
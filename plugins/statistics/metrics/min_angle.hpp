@@ -58,7 +58,7 @@ namespace viennamesh
       NumericType gamma = viennagrid::solid_angle( a, b, d, c );
       NumericType delta = viennagrid::solid_angle( a, b, c, d );
 
-      return std::min( std::min( alpha, beta ), std::max(gamma, delta) );
+      return std::min( std::min( alpha, beta ), std::min(gamma, delta) );
     }
   }
 
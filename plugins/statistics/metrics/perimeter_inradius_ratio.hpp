@@ -47,7 +47,7 @@ namespace viennamesh
             NumericType c = viennagrid::distance(p1, p2);
 
             //half perimeter
-            NumericType p = a+b+c/2;
+            NumericType p = (a+b+c)/2;
 
             //in-radius
             NumericType r = area/p;
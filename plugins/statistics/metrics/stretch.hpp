@@ -47,7 +47,7 @@ namespace viennamesh
             NumericType b = viennagrid::distance(p0, p2);
             NumericType c = viennagrid::distance(p1, p2);
 
-            NumericType longest = std::max(a, std::max(a,c));
+            NumericType longest = std::max(a, std::max(b,c));
             NumericType R = viennagrid::distance(circumcenter,p0);
 
 
@@ -15,8 +15,10 @@
    License:         MIT (X11), see file LICENSE in the base directory
 =============================================================================== */
 
+#include <algorithm>
 #include <limits>
 #include <set>
+#include <vector>
 
 #include "mesh_comparison.hpp"
 #include "libigl_convert.hpp"
@@ -211,6 +213,7 @@ namespace viennamesh
             good_elements_counted_ = false;
             comparison_measures_calculated_ = false;
             ordered_values_.clear();
+            median_computed_ = false;
 
 
 #if HIST
@@ -232,12 +235,15 @@ namespace viennamesh
             ConstCellIteratorType cit = cells.begin();
 
             count_ = cells.size();
+            if (count_ == 0)
+                return;
 
-            min_ = max_ = functor(*cit++);
+            //the first cell initializes min and max and is accumulated like all other cells
+            min_ = max_ = functor(*cit);
 
             for (; cit != cells.end(); ++cit) //iterate through all cells
             {
-                NumericT cell_metric = functor(*cit);
+                NumericT cell_metric = (cit == cells.begin()) ? min_ : functor(*cit);
                 min_ = std::min(min_, cell_metric);
                 max_ = std::max(max_, cell_metric);
                 sum_ += cell_metric;
@@ -265,12 +271,15 @@ namespace viennamesh
             ConstCellIteratorType cit = cells.begin();
 
             count_ = cells.size();
+            if (count_ == 0)
+                return;
 
-            min_ = max_ = functor(*cit++);
+            //the first cell initializes min and max and is accumulated like all other cells
+            min_ = max_ = functor(*cit);
 
             for (; cit != cells.end(); ++cit) //iterate through all cells
             {
-                NumericT cell_metric = functor(*cit);
+                NumericT cell_metric = (cit == cells.begin()) ? min_ : functor(*cit);
                 min_ = std::min(min_, cell_metric);
                 max_ = std::max(max_, cell_metric);
                 sum_ += cell_metric;
@@ -288,6 +297,68 @@ namespace viennamesh
         }
 
 
+        /*
+        Same as cell_stats for metric values which were already evaluated for all cells, e.g. by the batch metrics
+        (see batch_metrics.hpp). The median is selected directly instead of ordering all values.
+        */
+        void cell_stats(std::vector<NumericT> const & values)
+        {
+            count_ = values.size();
+            if (values.empty())
+                return;
+
+            NumericT min_value = values[0];
+            NumericT max_value = values[0];
+            NumericT sum = 0;
+
+            #pragma omp parallel for reduction(min:min_value) reduction(max:max_value) reduction(+:sum)
+            for (long i = 0; i < static_cast<long>(values.size()); ++i)
+            {
+                min_value = std::min(min_value, values[i]);
+                max_value = std::max(max_value, values[i]);
+                sum += values[i];
+            }
+
+            min_ = min_value;
+            max_ = max_value;
+            sum_ += sum;
+
+#if HIST
+            for (typename std::vector<NumericT>::const_iterator it = values.begin(); it != values.end(); ++it)
+                histogram_.increase( *it );
+#endif
+
+            std::vector<NumericT> tmp(values);
+            typename std::vector<NumericT>::iterator middle = tmp.begin() + count_/2;
+            std::nth_element(tmp.begin(), middle, tmp.end());
+            median_ = *middle;
+            if (count_ % 2 == 0)
+                median_ = (median_ + *std::max_element(tmp.begin(), middle)) / 2;
+            median_computed_ = true;
+        }
+
+        /*
+        Same as cell_quality_count for already evaluated metric values. Whether '<' or '>' is used for comparison is given
+        by higher_is_better.
+        */
+        void cell_quality_count(std::vector<NumericT> const & values, NumericT good_element_threshold, bool higher_is_better)
+        {
+            cell_stats(values);
+
+            long good_element_count = 0;
+
+            #pragma omp parallel for reduction(+:good_element_count)
+            for (long i = 0; i < static_cast<long>(values.size()); ++i)
+            {
+                if ( higher_is_better ? values[i] > good_element_threshold : values[i] < good_element_threshold )
+                    ++good_element_count;
+            }
+
+            good_element_count_ += good_element_count;
+            good_elements_counted_ = true;
+        }
+
+
         /*
         * Calculates the mesh comparison metrics minimum distance RMS, mean curvature difference RMS and surface area deviation.
         * Parameter mesh is compared to parameter mesh_orig (original mesh)
@@ -372,6 +443,9 @@ namespace viennamesh
         // returns meadian value of given metric
         NumericT median() const
         {
+            if (median_computed_)
+                return median_;
+
             typename std::multiset<NumericT>::iterator it = ordered_values_.begin();
 
             NumericT tmp;
@@ -467,6 +541,8 @@ namespace viennamesh
 
 
         std::multiset<NumericT> ordered_values_;
+        NumericT median_;         // median of values given by vector, ordered_values_ is not used in that case
+        bool median_computed_;
 #if HIST
         histogram_type histogram_;
 #endif
@@ -112,8 +112,11 @@ namespace viennamesh
 
     viennautils::Timer timer;
     timer.start();
+    viennamesh::profiling_span moment_span("generalized moment");
+    moment_span.add("order", 2*p());
     RealGeneralizedMoment m_real(2*p(), mesh);
 //     , relative_integrate_tolerance(), absolute_integrate_tolerance(), max_iteration_count());
+    moment_span.end();
 
     info(1) << "After calculating generalized moment (!!! took " << timer.get() << "sec !!!)" << std::endl;
 
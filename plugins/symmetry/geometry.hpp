@@ -133,6 +133,44 @@ namespace viennamesh
   }
 
 
+  // row-major 3x3 matrix of the rotation by angle around a normalized axis, same convention as rotate
+  template<typename PointT>
+  void rotation_matrix(PointT const & axis, double angle, double * matrix)
+  {
+    double cos_angle = std::cos(angle);
+    double sin_angle = std::sin(angle);
+
+    matrix[0] = axis[0]*axis[0] * (1-cos_angle) + cos_angle;
+    matrix[1] = axis[0]*axis[1] * (1-cos_angle) - axis[2]*sin_angle;
+    matrix[2] = axis[0]*axis[2] * (1-cos_angle) + axis[1]*sin_angle;
+
+    matrix[3] = axis[1]*axis[0] * (1-cos_angle) + axis[2]*sin_angle;
+    matrix[4] = axis[1]*axis[1] * (1-cos_angle) + cos_angle;
+    matrix[5] = axis[1]*axis[2] * (1-cos_angle) - axis[0]*sin_angle;
+
+    matrix[6] = axis[2]*axis[0] * (1-cos_angle) - axis[1]*sin_angle;
+    matrix[7] = axis[2]*axis[1] * (1-cos_angle) + axis[0]*sin_angle;
+    matrix[8] = axis[2]*axis[2] * (1-cos_angle) + cos_angle;
+  }
+
+  // row-major 3x3 matrix of the reflection at the plane through the origin with normalized normal, same convention as reflect
+  template<typename PointT>
+  void reflection_matrix(PointT const & normal, double * matrix)
+  {
+    for (int i = 0; i != 3; ++i)
+      for (int j = 0; j != 3; ++j)
+        matrix[3*i+j] = (i == j ? 1.0 : 0.0) - 2*normal[i]*normal[j];
+  }
+
+  // result = lhs * rhs for row-major 3x3 matrices
+  inline void matrix_product(double const * lhs, double const * rhs, double * result)
+  {
+    for (int i = 0; i != 3; ++i)
+      for (int j = 0; j != 3; ++j)
+        result[3*i+j] = lhs[3*i+0]*rhs[0+j] + lhs[3*i+1]*rhs[3+j] + lhs[3*i+2]*rhs[6+j];
+  }
+
+
   template<bool mesh_is_const>
   double distance(viennagrid::base_mesh<mesh_is_const> const & mesh, viennagrid::point const & pt)
   {
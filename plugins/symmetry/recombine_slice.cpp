@@ -13,7 +13,7 @@
 =============================================================================== */
 
 #include <set>
-#include <map>
+#include <algorithm>
 #include <iterator>
 
 #include "recombine_slice.hpp"
@@ -29,85 +29,87 @@
 namespace viennamesh
 {
 
-  void reflect(viennagrid::mesh const & input,
-               viennagrid::mesh const & output,
-               viennagrid::point const & centroid,
-               viennagrid::point const & normal,
-               double tol)
+  // Vertex layout of the recombined mesh. Slice vertices get local ids ordered as
+  // [shared | plane 0 | no plane | plane 1], the output vertex array starts with the shared
+  // vertices followed by one block per emitted copy (even frequency: one block per pair of
+  // rotated and reflected slice). All global ids are computed in closed form so that
+  // vertices and cells of all copies can be emitted independently.
+  struct symmetric_slice_layout
   {
-    typedef viennagrid::mesh                                                MeshType;
-
-    typedef viennagrid::result_of::point<MeshType>::type                    PointType;
-    typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
-
-    typedef viennagrid::result_of::const_element_range<MeshType>::type      ConstElementRangeType;
-    typedef viennagrid::result_of::iterator<ConstElementRangeType>::type    ConstElementIteratorType;
-
-    std::map< ElementType, std::pair<ElementType,ElementType> > vertex_map;
-
-    ConstElementRangeType vertices(input, 0);
-    for (ConstElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+    symmetric_slice_layout(int rotational_frequency_,
+                           std::size_t shared_count_,
+                           std::size_t plane0_count_,
+                           std::size_t no_plane_count_,
+                           std::size_t plane1_count_) :
+        rotational_frequency(rotational_frequency_),
+        shared_count(shared_count_),
+        plane0_count(plane0_count_),
+        no_plane_count(no_plane_count_),
+        plane1_count(plane1_count_)
     {
-      PointType point = viennagrid::get_point( *vit );
-
-      double d = viennagrid::inner_prod( point-centroid, normal );
-      if (std::abs(d) < tol)
+      if (is_even())
       {
-        ElementType nv = viennagrid::make_vertex( output, point );
-        vertex_map[*vit] = std::make_pair(nv, nv);
+        block_count = rotational_frequency/2;
+        block_size = plane0_count + 2*no_plane_count + plane1_count;
       }
       else
       {
-        assert( d > 0 );
-        PointType reflected = point - 2 * normal * d;
-
-        ElementType nv0 = viennagrid::make_vertex( output, point );
-        ElementType nv1 = viennagrid::make_vertex( output, reflected );
-
-        vertex_map[*vit] = std::make_pair(nv0, nv1);
+        block_count = rotational_frequency;
+        block_size = plane0_count + no_plane_count;
       }
     }
 
+    bool is_even() const { return rotational_frequency % 2 == 0; }
+    std::size_t vertex_count() const { return shared_count + block_count*block_size; }
 
-    ConstElementRangeType cells(input, viennagrid::cell_dimension(input));
-    for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    // global id of the slice vertex with local id local_id in copy copy_index
+    viennagrid_int global_id(viennagrid_int local_id, int copy_index) const
     {
-      typedef viennagrid::result_of::const_element_range<ElementType>::type ConstBoundaryRangeType;
-      typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type ConstBoundaryIteratorType;
-
-      ConstBoundaryRangeType boundary_vertices(*cit, 0);
-
-      std::vector<ElementType> vertices[2];
+      std::size_t id = local_id;
+      if (id < shared_count)
+        return id;
+      id -= shared_count;
 
-      int i = 0;
-      for (ConstBoundaryIteratorType bvit = boundary_vertices.begin(); bvit != boundary_vertices.end(); ++bvit, ++i)
+      if (is_even())
       {
-        vertices[0].push_back( vertex_map[*bvit].first );
-        vertices[1].push_back( vertex_map[*bvit].second );
-      }
+        std::size_t block = copy_index / 2;
+        std::size_t side = copy_index % 2;
 
-      for (int i = 0; i != 2; ++i)
-      {
-        ElementType cell = viennagrid::make_element( output, (*cit).tag(), vertices[i].begin(), vertices[i].end() );
-        viennagrid::copy_region_information(*cit, cell);
-      }
-    }
-  }
+        if (id < plane0_count)
+          return shared_count + ((block+side) % block_count)*block_size + id;
+        id -= plane0_count;
 
+        if (id < no_plane_count)
+          return shared_count + block*block_size + plane0_count + side*(no_plane_count+plane1_count) + id;
+        id -= no_plane_count;
 
+        return shared_count + block*block_size + plane0_count + no_plane_count + id;
+      }
 
+      if (id < plane0_count + no_plane_count)
+        return shared_count + copy_index*block_size + id;
+      id -= plane0_count + no_plane_count;
 
+      return shared_count + ((copy_index+1) % block_count)*block_size + id;
+    }
 
+    int rotational_frequency;
+    std::size_t shared_count;
+    std::size_t plane0_count;
+    std::size_t no_plane_count;
+    std::size_t plane1_count;
 
-  struct status_logging
-  {
-    void operator()(double percentage)
-    {
-      info(5) << "Status: " << percentage*100 << "%" << std::endl;
-    }
+    std::size_t block_count;
+    std::size_t block_size;
   };
 
 
+  inline void transform_point(double const * matrix, viennagrid_numeric const * src, viennagrid_numeric * dst)
+  {
+    dst[0] = matrix[0]*src[0] + matrix[1]*src[1] + matrix[2]*src[2];
+    dst[1] = matrix[3]*src[0] + matrix[4]*src[1] + matrix[5]*src[2];
+    dst[2] = matrix[6]*src[0] + matrix[7]*src[1] + matrix[8]*src[2];
+  }
 
 
 
@@ -134,6 +136,12 @@ namespace viennamesh
 
     mesh_handle input_mesh = get_required_input<mesh_handle>("mesh");
 
+    if (viennagrid::geometric_dimension(input_mesh()) != 3)
+    {
+      error(1) << "Geometric dimension " << viennagrid::geometric_dimension(input_mesh()) << " not supported, only 3D slices can be recombined" << std::endl;
+      return false;
+    }
+
 
     PointType axis = get_required_input<point>("axis")();
     axis.normalize();
@@ -187,218 +195,11 @@ namespace viennamesh
         vertices_on_no_plane.push_back( (*vit).id() );
     }
 
-    std::size_t shared_vertex_count = vertices_on_both_planes.size();
-    std::size_t on_plane_0_count = shared_vertex_count + vertices_on_plane0.size();
-    std::size_t on_no_plane_count = on_plane_0_count + vertices_on_no_plane.size();
-    std::size_t non_shared_vertex_count = vertices_on_plane0.size() + 2*vertices_on_no_plane.size() + vertices_on_plane1.size();
-
-
-    viennagrid::vector<viennagrid::element_id> vertex_mapping( vertices.size() );
-    mesh_handle output_mesh = make_data<mesh_handle>();
-
-
-    int offset = 0;
-
-    for (std::size_t i = 0; i != vertices_on_both_planes.size(); ++i)
-      vertex_mapping[vertices_on_both_planes[i]] = i+offset;
-    offset += vertices_on_both_planes.size();
-
-    for (std::size_t i = 0; i != vertices_on_plane0.size(); ++i)
-      vertex_mapping[vertices_on_plane0[i]] = i+offset;
-    offset += vertices_on_plane0.size();
-
-    for (std::size_t i = 0; i != vertices_on_no_plane.size(); ++i)
-      vertex_mapping[vertices_on_no_plane[i]] = i+offset;
-    offset += vertices_on_no_plane.size();
 
-    for (std::size_t i = 0; i != vertices_on_plane1.size(); ++i)
-      vertex_mapping[vertices_on_plane1[i]] = i+offset;
-
-
-
-    if (rotational_frequency % 2 == 0)
-    {
-      viennagrid::vector<viennagrid::element_id> new_vertices;
-      new_vertices.reserve( vertices_on_both_planes.size() +
-                          (vertices_on_plane0.size()+vertices_on_no_plane.size()+vertices_on_plane1.size()) * rotational_frequency );
-
-
-
-      for (std::size_t i = 0; i != vertices_on_both_planes.size(); ++i)
-        new_vertices.push_back( viennagrid::make_vertex(output_mesh(), points[vertices_on_both_planes[i]]).id() );
-
-      for (int hrf = 0; hrf != rotational_frequency/2; ++hrf)
-      {
-        double current_angle = angle * hrf * 2;
-
-        for (std::size_t i = 0; i != vertices_on_plane0.size(); ++i)
-        {
-          PointType rotated = rotate( points[ vertices_on_plane0[i] ], axis, current_angle );
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotated).id() );
-        }
-
-        for (std::size_t i = 0; i != vertices_on_no_plane.size(); ++i)
-        {
-          PointType rotated = rotate( points[ vertices_on_no_plane[i] ], axis, current_angle );
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotated).id() );
-        }
-
-        for (std::size_t i = 0; i != vertices_on_plane1.size(); ++i)
-        {
-          PointType rotated = rotate( points[ vertices_on_plane1[i] ], axis, current_angle );
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotated).id() );
-        }
-
-        current_angle = angle * (hrf+1) * 2;
-        for (std::size_t i = 0; i != vertices_on_no_plane.size(); ++i)
-        {
-          PointType rotated = rotate( reflect(points[vertices_on_no_plane[i]], N[0]),
-                                      axis, current_angle );
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotated).id() );
-        }
-      }
-
-      info(1) << "New mesh has " << new_vertices.size() << " vertices (old had " << vertices.size() << ")" << std::endl;
-      info(1) << "    shared vertex count = " << vertices_on_both_planes.size() << std::endl;
-      info(1) << "    on plane count = " << vertices_on_plane0.size() << std::endl;
-      info(1) << "    on no plane count = " << vertices_on_no_plane.size() << std::endl;
-
-
-      typedef viennagrid::result_of::region<MeshType>::type RegionType;
-      typedef viennagrid::result_of::region_range<MeshType>::type RegionRangeType;
-      typedef viennagrid::result_of::iterator<RegionRangeType>::type RegionRangeIteratorType;
-      RegionRangeType regions( input_mesh() );
-      for (RegionRangeIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
-      {
-        RegionType region = output_mesh().get_or_create_region( (*rit).id() );
-        region.set_name( (*rit).get_name() );
-      }
-
-
-
-      std::vector<viennagrid_element_type> element_types( cells.size()*rotational_frequency );
-      std::vector<viennagrid_int> cell_vertex_offsets( cells.size()*rotational_frequency + 1 );
-      std::vector<viennagrid_element_id> cell_vertex_indices;
-      std::vector<viennagrid_region_id> region_ids;
-
-      if (!regions.empty())
-        region_ids.resize( cells.size()*rotational_frequency );
-
-      cell_vertex_offsets[0] = 0;
-      cell_vertex_indices.reserve( cells.size()*rotational_frequency * (viennagrid::cell_dimension(input_mesh())+1) );
-
-      viennagrid_int cid = 0;
-      for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
-      {
-        std::vector<viennagrid::element_id> vertex_ids;
-        ConstBoundaryElementRangeType vertices_on_cell(*cit, 0);
-
-        for (ConstBoundaryElementIteratorType vcit = vertices_on_cell.begin(); vcit != vertices_on_cell.end(); ++vcit)
-          vertex_ids.push_back( vertex_mapping[(*vcit).id()] );
-
-        viennagrid_region_id cell_region;
-        if (!regions.empty())
-        {
-          typedef viennagrid::result_of::region_range<ElementType>::type RegionRangeType;
-          RegionRangeType cell_regions( *cit );
-          cell_region = (*(cell_regions.begin())).id();
-        }
-
-        for (int hrf = 0; hrf != rotational_frequency/2; ++hrf)
-        {
-          viennagrid_int offset0 = cell_vertex_indices.size();
-          viennagrid_int offset1 = offset0 + vertex_ids.size();
-
-          cell_vertex_indices.resize( offset0 + 2*vertex_ids.size() );
-          cell_vertex_offsets[cid+1] = offset0 + vertex_ids.size();
-          cell_vertex_offsets[cid+2] = offset1 + vertex_ids.size();
-
-          element_types[cid+0] = (*cit).tag().internal();
-          element_types[cid+1] = (*cit).tag().internal();
-
-          if (!regions.empty())
-          {
-            region_ids[cid+0] = cell_region;
-            region_ids[cid+1] = cell_region;
-          }
-
-          cid += 2;
-
-          for (std::size_t i = 0; i != vertex_ids.size(); ++i)
-          {
-            int vertex_region;
-            if (vertex_ids[i] < static_cast<int>(shared_vertex_count))
-              vertex_region = 0;
-            else if (vertex_ids[i] < static_cast<int>(on_plane_0_count))
-              vertex_region = 1;
-            else if (vertex_ids[i] < static_cast<int>(on_no_plane_count))
-              vertex_region = 3;
-            else
-              vertex_region = 2;
-
-            viennagrid::element_id index0;
-            viennagrid::element_id index1;
-
-            switch (vertex_region)
-            {
-              case 0:
-                index0 = vertex_ids[i];
-                index1 = vertex_ids[i];
-                break;
-
-              case 1:
-                index0 = vertex_ids[i] + hrf*non_shared_vertex_count;
-                if (index0 >= static_cast<int>(new_vertices.size()))
-                  index0 -= rotational_frequency*non_shared_vertex_count/2;
-
-                index1 = vertex_ids[i] + (hrf+1)*non_shared_vertex_count;
-                if (index1 >= static_cast<int>(new_vertices.size()))
-                  index1 -= rotational_frequency*non_shared_vertex_count/2;
-                break;
-
-              case 2:
-                index0 = vertex_ids[i] + hrf*non_shared_vertex_count;
-                if (index0 >= static_cast<int>(new_vertices.size()))
-                  index0 -= rotational_frequency*non_shared_vertex_count/2;
-
-                index1 = vertex_ids[i] + hrf*non_shared_vertex_count;
-                if (index1 >= static_cast<int>(new_vertices.size()))
-                  index1 -= rotational_frequency*non_shared_vertex_count/2;
-                break;
-
-              case 3:
-                index0 = vertex_ids[i] + hrf*non_shared_vertex_count;
-                index1 = vertex_ids[i] + vertices_on_no_plane.size() + vertices_on_plane1.size() + hrf*non_shared_vertex_count;
-                break;
-
-              default:
-                assert(false);
-            }
-
-            cell_vertex_indices[offset0 + i] = new_vertices[index0].internal();
-            cell_vertex_indices[offset1 + i] = new_vertices[index1].internal();
-          }
-        }
-      }
-
-
-      if (!regions.empty())
-      {
-        viennagrid_mesh_element_batch_create( output_mesh().internal(),
-                                              element_types.size(), &element_types[0],
-                                              &cell_vertex_offsets[0], &cell_vertex_indices[0],
-                                              &region_ids[0], NULL );
-      }
-      else
-      {
-        viennagrid_mesh_element_batch_create( output_mesh().internal(),
-                                              element_types.size(), &element_types[0],
-                                              &cell_vertex_offsets[0], &cell_vertex_indices[0],
-                                              NULL, NULL );
-      }
-    }
-    else
+    if (rotational_frequency % 2 != 0)
     {
+      // plane 1 of copy i is glued to plane 0 of copy i+1, so the vertices on plane 1
+      // are reordered to match their rotated counterparts on plane 0
       PointType cs[2];
 
       cs[0] = viennagrid::make_point(1,0,0);
@@ -461,104 +262,190 @@ namespace viennamesh
       }
 
       vertices_on_plane1 = reordered_vertices_on_plane1;
-
-      std::size_t shared_vertex_count = vertices_on_both_planes.size();
-      std::size_t non_shared_vertex_count = vertices_on_plane0.size() + vertices_on_no_plane.size();
+    }
 
 
-      viennagrid::vector<ElementType> new_vertices;
-      viennagrid::vector<viennagrid::element_id> vertex_mapping( vertices.size() );
-      mesh_handle output_mesh = make_data<mesh_handle>();
+    symmetric_slice_layout layout( rotational_frequency,
+                                   vertices_on_both_planes.size(),
+                                   vertices_on_plane0.size(),
+                                   vertices_on_no_plane.size(),
+                                   vertices_on_plane1.size() );
 
+    // local vertex ids and coordinates of the slice, ordered [shared | plane 0 | no plane | plane 1]
+    std::size_t slice_vertex_count = layout.shared_count + layout.plane0_count + layout.no_plane_count + layout.plane1_count;
+    viennagrid::vector<viennagrid_int> vertex_mapping( vertices.size() );
+    std::vector<viennagrid_numeric> slice_coords( 3*slice_vertex_count );
 
-      viennamesh::LoggingStack stack("misc");
+    {
+      std::vector<viennagrid::element_id> const * groups[4] = { &vertices_on_both_planes, &vertices_on_plane0,
+                                                                &vertices_on_no_plane, &vertices_on_plane1 };
+      viennagrid_int offset = 0;
+      for (int g = 0; g != 4; ++g)
+      {
+        for (std::size_t i = 0; i != groups[g]->size(); ++i, ++offset)
+        {
+          viennagrid::element_id vertex_id = (*groups[g])[i];
+          vertex_mapping[vertex_id] = offset;
+          for (int d = 0; d != 3; ++d)
+            slice_coords[3*offset+d] = points[vertex_id][d];
+        }
+      }
+    }
 
-      int offset = 0;
 
-      for (std::size_t i = 0; i != vertices_on_both_planes.size(); ++i)
-        vertex_mapping[vertices_on_both_planes[i]] = i+offset;
-      offset += vertices_on_both_planes.size();
+    // one rotation (and for even frequencies one reflection + rotation) matrix per vertex block
+    std::vector<double> rotation_matrices( 9*layout.block_count );
+    std::vector<double> reflection_rotation_matrices;
+    {
+      double reflection[9];
+      reflection_matrix(N[0], reflection);
 
-      for (std::size_t i = 0; i != vertices_on_plane0.size(); ++i)
-        vertex_mapping[vertices_on_plane0[i]] = i+offset;
-      offset += vertices_on_plane0.size();
+      if (layout.is_even())
+        reflection_rotation_matrices.resize( 9*layout.block_count );
 
-      for (std::size_t i = 0; i != vertices_on_no_plane.size(); ++i)
-        vertex_mapping[vertices_on_no_plane[i]] = i+offset;
-      offset += vertices_on_no_plane.size();
+      for (std::size_t b = 0; b != layout.block_count; ++b)
+      {
+        if (layout.is_even())
+        {
+          double rotation[9];
+          rotation_matrix(axis, angle * (b+1) * 2, rotation);
+          rotation_matrix(axis, angle * b * 2, &rotation_matrices[9*b]);
+          matrix_product(rotation, reflection, &reflection_rotation_matrices[9*b]);
+        }
+        else
+          rotation_matrix(axis, angle * b, &rotation_matrices[9*b]);
+      }
+    }
 
-      for (std::size_t i = 0; i != vertices_on_plane1.size(); ++i)
-        vertex_mapping[vertices_on_plane1[i]] = i+offset;
 
+    std::vector<viennagrid_numeric> new_coords( 3*layout.vertex_count() );
+    std::copy( slice_coords.begin(), slice_coords.begin() + 3*layout.shared_count, new_coords.begin() );
 
+    {
+      viennamesh::LoggingStack stack("expand vertices");
 
-      typedef viennagrid::result_of::const_region_range<MeshType>::type RegionRangeType;
-      typedef viennagrid::result_of::iterator<RegionRangeType>::type RegionIteratorType;
+      std::size_t rotated_count = layout.plane0_count + layout.no_plane_count + layout.plane1_count;
+      long block_vertex_count = layout.block_count*layout.block_size;
 
-      RegionRangeType regions( input_mesh() );
-      std::vector<RegionType> new_regions;
-      for (RegionIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
+      #pragma omp parallel for schedule(static)
+      for (long k = 0; k < block_vertex_count; ++k)
       {
-        RegionType region = output_mesh().get_or_create_region( (*rit).id() );
-        region.set_name( (*rit).get_name() );
-        new_regions.push_back(region);
+        std::size_t b = k / layout.block_size;
+        std::size_t j = k % layout.block_size;
+
+        viennagrid_numeric * dst = &new_coords[3*(layout.shared_count + k)];
 
-        info(1) << "  Copy region " << region.id() << " (name = \"" << region.get_name() << "\"" << std::endl;
+        if (!layout.is_even() || j < rotated_count)
+          transform_point( &rotation_matrices[9*b], &slice_coords[3*(layout.shared_count + j)], dst );
+        else
+          transform_point( &reflection_rotation_matrices[9*b],
+                           &slice_coords[3*(layout.shared_count + layout.plane0_count + j - rotated_count)], dst );
       }
+    }
 
 
-      for (std::size_t i = 0; i != vertices_on_both_planes.size(); ++i)
-        new_vertices.push_back( viennagrid::make_vertex(output_mesh(), points[vertices_on_both_planes[i]]) );
+    mesh_handle output_mesh = make_data<mesh_handle>();
 
-      for (int rf = 0; rf != rotational_frequency; ++rf)
-      {
-        double current_angle = angle * rf;
+    viennagrid_element_id first_vertex_id = 0;
+    viennagrid_mesh_geometric_dimension_set( output_mesh().internal(), 3 );
+    viennagrid_mesh_vertex_batch_create( output_mesh().internal(),
+                                         layout.vertex_count(), &new_coords[0],
+                                         &first_vertex_id );
 
-        for (std::size_t i = 0; i != vertices_on_plane0.size(); ++i)
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotate(points[vertices_on_plane0[i]], axis, current_angle)) );
+    info(1) << "New mesh has " << layout.vertex_count() << " vertices (old had " << vertices.size() << ")" << std::endl;
+    info(1) << "    shared vertex count = " << layout.shared_count << std::endl;
+    info(1) << "    on plane count = " << layout.plane0_count << std::endl;
+    info(1) << "    on no plane count = " << layout.no_plane_count << std::endl;
 
-        for (std::size_t i = 0; i != vertices_on_no_plane.size(); ++i)
-          new_vertices.push_back( viennagrid::make_vertex(output_mesh(), rotate(points[vertices_on_no_plane[i]], axis, current_angle)) );
-      }
 
-      info(1) << "New mesh has " << new_vertices.size() << " vertices (old had " << vertices.size() << ")" << std::endl;
-      info(1) << "    shared vertex count = " << shared_vertex_count << std::endl;
-      info(1) << "    on plane count = " << vertices_on_plane0.size() << std::endl;
-      info(1) << "    on no plane count = " << vertices_on_no_plane.size() << std::endl;
+    typedef viennagrid::result_of::const_region_range<MeshType>::type RegionRangeType;
+    typedef viennagrid::result_of::iterator<RegionRangeType>::type RegionIteratorType;
+
+    RegionRangeType regions( input_mesh() );
+    for (RegionIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
+    {
+      RegionType region = output_mesh().get_or_create_region( (*rit).id() );
+      region.set_name( (*rit).get_name() );
+
+      info(1) << "  Copy region " << region.id() << " (name = \"" << region.get_name() << "\"" << std::endl;
+    }
+
 
+    // slice cells in CSR form using local vertex ids
+    std::vector<viennagrid_element_type> slice_cell_types;
+    std::vector<viennagrid_int> slice_cell_offsets(1, 0);
+    std::vector<viennagrid_int> slice_cell_vertices;
+    std::vector<viennagrid_region_id> slice_cell_regions;
 
-      for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    slice_cell_types.reserve( cells.size() );
+    slice_cell_offsets.reserve( cells.size()+1 );
+    slice_cell_vertices.reserve( cells.size() * (viennagrid::cell_dimension(input_mesh())+1) );
+    if (!regions.empty())
+      slice_cell_regions.reserve( cells.size() );
+
+    for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      ConstBoundaryElementRangeType vertices_on_cell(*cit, 0);
+      for (ConstBoundaryElementIteratorType vcit = vertices_on_cell.begin(); vcit != vertices_on_cell.end(); ++vcit)
+        slice_cell_vertices.push_back( vertex_mapping[(*vcit).id()] );
+
+      slice_cell_types.push_back( (*cit).tag().internal() );
+      slice_cell_offsets.push_back( slice_cell_vertices.size() );
+
+      if (!regions.empty())
       {
-        std::vector<viennagrid::element_id> vertex_ids;
-        ConstBoundaryElementRangeType vertices_on_cell(*cit, 0);
+        typedef viennagrid::result_of::region_range<ElementType>::type CellRegionRangeType;
+        CellRegionRangeType cell_regions( *cit );
+        slice_cell_regions.push_back( (*(cell_regions.begin())).id() );
+      }
+    }
 
-        for (ConstBoundaryElementIteratorType vcit = vertices_on_cell.begin(); vcit != vertices_on_cell.end(); ++vcit)
-          vertex_ids.push_back( vertex_mapping[(*vcit).id()] );
 
+    // output cells are ordered copy by copy, so every offset is known in advance
+    std::size_t slice_cell_count = slice_cell_types.size();
+    std::size_t slice_index_count = slice_cell_vertices.size();
+    long new_cell_count = slice_cell_count * rotational_frequency;
 
-        for (int rf = 0; rf != rotational_frequency; ++rf)
-        {
-          std::vector<ElementType> local_vertices(vertex_ids.size());
-          for (std::size_t i = 0; i != vertex_ids.size(); ++i)
-          {
-            if (vertex_ids[i] < static_cast<int>(shared_vertex_count))
-              local_vertices[i] = new_vertices[vertex_ids[i]];
-            else
-            {
-              viennagrid::element_id index = vertex_ids[i] + rf*non_shared_vertex_count;
-              if (index >= static_cast<int>(new_vertices.size()))
-                index -= rotational_frequency*non_shared_vertex_count;
-
-              local_vertices[i] = new_vertices[index];
-            }
-          }
+    std::vector<viennagrid_element_type> element_types( new_cell_count );
+    std::vector<viennagrid_int> cell_vertex_offsets( new_cell_count + 1 );
+    std::vector<viennagrid_element_id> cell_vertex_indices( slice_index_count * rotational_frequency );
+    std::vector<viennagrid_region_id> region_ids;
 
-          ElementType new_cell = viennagrid::make_element( output_mesh(), (*cit).tag(), local_vertices.begin(), local_vertices.end() );
-          viennagrid::copy_region_information(*cit, new_cell);
-        }
+    if (!regions.empty())
+      region_ids.resize( new_cell_count );
+
+    cell_vertex_offsets[new_cell_count] = cell_vertex_indices.size();
+
+    {
+      viennamesh::LoggingStack stack("expand cells");
+
+      #pragma omp parallel for schedule(static)
+      for (long cid = 0; cid < new_cell_count; ++cid)
+      {
+        int copy_index = cid / slice_cell_count;
+        std::size_t slice_cell = cid % slice_cell_count;
+
+        viennagrid_int src_offset = slice_cell_offsets[slice_cell];
+        viennagrid_int dst_offset = copy_index*slice_index_count + src_offset;
+
+        element_types[cid] = slice_cell_types[slice_cell];
+        cell_vertex_offsets[cid] = dst_offset;
+        if (!regions.empty())
+          region_ids[cid] = slice_cell_regions[slice_cell];
+
+        for (viennagrid_int i = src_offset; i != slice_cell_offsets[slice_cell+1]; ++i, ++dst_offset)
+          cell_vertex_indices[dst_offset] = first_vertex_id + layout.global_id(slice_cell_vertices[i], copy_index);
       }
     }
 
+    if (new_cell_count > 0)
+    {
+      viennagrid_mesh_element_batch_create( output_mesh().internal(),
+                                            element_types.size(), &element_types[0],
+                                            &cell_vertex_offsets[0], &cell_vertex_indices[0],
+                                            regions.empty() ? NULL : &region_ids[0], NULL );
+    }
+
     set_output( "mesh", output_mesh );
     return true;
   }
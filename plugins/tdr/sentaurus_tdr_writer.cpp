@@ -15,27 +15,19 @@
 #include "sentaurus_tdr_writer.hpp"
 
 #include <fstream>
+#include <algorithm>
 
-#include <boost/container/flat_map.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include "viennagrid/core/range.hpp"
 
-#include "H5Cpp.h"
-
 namespace viennamesh
 {
 namespace
 {
 typedef viennagrid::const_mesh                                          MeshType;
 typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
-typedef viennagrid::result_of::point<MeshType>::type                    PointType;
 typedef viennagrid::result_of::region<MeshType>::type                   RegionType;
-typedef viennagrid::result_of::id<ElementType>::type                    ElementId;
-typedef viennagrid::result_of::id<RegionType>::type                     RegionId;
-
-typedef viennagrid::result_of::const_vertex_range<MeshType>::type       MeshVertexRange;
-typedef viennagrid::result_of::iterator<MeshVertexRange>::type          MeshVertexIterator;
 
 typedef viennagrid::result_of::const_vertex_range<ElementType>::type    BoundaryVertexRange;
 typedef viennagrid::result_of::iterator<BoundaryVertexRange>::type      BoundaryVertexIterator;
@@ -49,6 +41,9 @@ typedef viennagrid::result_of::iterator<RegionVertexRange>::type        RegionVe
 typedef viennagrid::result_of::const_cell_range<RegionType>::type       CellRange;
 typedef viennagrid::result_of::iterator<CellRange>::type                CellIterator;
 
+//the tdr reader scales the vertex coordinates by this factor, the inverse is applied when writing
+double const tdr_coordinate_factor = 10000.0;
+
 void write_attribute(H5::H5Object & obj, std::string const & name, std::string const & value)
 {
   H5::StrType strdatatype(H5::PredType::C_S1, value.size());
@@ -77,16 +72,99 @@ H5::DataSet write_dataset(H5::Group & group, std::string const & name, H5::DataT
   return dataset;
 }
 
+//one dimensional, extensible dataset which is written chunk by chunk from a buffer of one chunk,
+//an entry consists of values_per_entry values of type T (e.g. the coordinates of a vertex)
+template <typename T>
+class chunked_dataset_writer
+{
+public:
+  chunked_dataset_writer(H5::Group & group, std::string const & name, H5::DataType const & type,
+                         int values_per_entry_, tdr_write_options const & options)
+    : mem_type(type), values_per_entry(values_per_entry_), chunk_size(std::max<hsize_t>(options.chunk_size, 1)), written(0)
+  {
+    hsize_t initial_size = 0;
+    hsize_t max_size = H5S_UNLIMITED;
+    H5::DataSpace dataspace(1, &initial_size, &max_size);
+
+    H5::DSetCreatPropList properties;
+    properties.setChunk(1, &chunk_size);
+    if (options.compression_level > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+      properties.setDeflate( std::min(options.compression_level, 9) );
+
+    dataset = group.createDataSet(name, type, dataspace, properties);
+    buffer.reserve(chunk_size*values_per_entry);
+  }
+
+  void push_back(T value)
+  {
+    buffer.push_back(value);
+    if (buffer.size() == chunk_size*values_per_entry)
+      flush();
+  }
+
+  void flush()
+  {
+    hsize_t count = buffer.size() / values_per_entry;
+    if (count == 0)
+      return;
+
+    hsize_t new_size = written + count;
+    dataset.extend(&new_size);
+
+    H5::DataSpace file_space = dataset.getSpace();
+    file_space.selectHyperslab(H5S_SELECT_SET, &count, &written);
+    H5::DataSpace mem_space(1, &count);
+    dataset.write(&buffer[0], mem_type, mem_space, file_space);
+
+    written = new_size;
+    buffer.clear();
+  }
+
+  //number of entries in the file after the final flush
+  hsize_t size() const { return written + buffer.size() / values_per_entry; }
+
+  H5::DataSet & finish()
+  {
+    flush();
+    return dataset;
+  }
+
+private:
+  H5::DataSet dataset;
+  H5::DataType mem_type;
+  int values_per_entry;
+  hsize_t chunk_size;
+  hsize_t written;
+  std::vector<T> buffer;
+};
+
+int32_t tdr_element_type(viennagrid::element_tag const & tag)
+{
+  if (tag.is_line())
+    return 1;
+  if (tag.is_triangle())
+    return 2;
+  if (tag.is_quadrilateral())
+    return 3;
+  if (tag.is_tetrahedron())
+    return 5;
+
+  throw viennautils::make_exception<tdr_writer_error>("TDR writer supports only lines, triangles, quadrilaterals and tetrahedra");
+}
+
 } //end of anonymous namespace
 
-void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & mesh, std::vector<viennagrid::quantity_field> const & quantities)
+void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & mesh, std::vector<viennagrid::quantity_field> const & quantities,
+                  std::vector<std::string> const & materials, tdr_write_options const & options)
 {
   unsigned int dimension = viennagrid::geometric_dimension(mesh);
-  if (dimension != 2)
+  if (dimension != 2 && dimension != 3)
   {
-    throw viennautils::make_exception<tdr_writer_error>("TDR writer currently supports only two dimensional meshes");
+    throw viennautils::make_exception<tdr_writer_error>("TDR writer supports only two and three dimensional meshes");
   }
 
+  viennagrid_int vertex_count = viennagrid::vertex_count(mesh);
+
   try
   {
     H5::H5File file(filename, H5F_ACC_TRUNC);
@@ -100,7 +178,7 @@ void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & m
 
     write_attribute(geometry, "type", 1);
     write_attribute(geometry, "dimension", static_cast<int>(dimension));
-    write_attribute(geometry, "number of vertices", static_cast<int>(viennagrid::vertices(mesh).size()));
+    write_attribute(geometry, "number of vertices", static_cast<int>(vertex_count));
     write_attribute(geometry, "number of regions", static_cast<int>(mesh.region_count()));
     write_attribute(geometry, "number of states", 1);
 
@@ -118,38 +196,25 @@ void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & m
       write_dataset(transformation, "b", H5::PredType::NATIVE_DOUBLE, 3, zero_vector);
     }
 
-    boost::container::flat_map<ElementId, int32_t> vertex_mapping; //should (and has to) be monotonous 'on both sides'
-    vertex_mapping.reserve(viennagrid::vertices(mesh).size());
-
     {
-      //vertex Dataset
-      std::vector<double> vertex_coordinates;
-      vertex_coordinates.reserve(dimension*viennagrid::vertices(mesh).size());
-      MeshVertexRange mesh_vertices(mesh);
-      int id_counter = 0;
-      for (MeshVertexIterator it = mesh_vertices.begin(); it != mesh_vertices.end(); ++it, ++id_counter)
-      {
-        vertex_mapping[(*it).id()] = id_counter;
-
-        PointType const & p = viennagrid::get_point(*it);
-        for (PointType::size_type i = 0; i < dimension; ++i)
-        {
-          vertex_coordinates.push_back(p[i]);
-        }
-      }
-
+      //vertex Dataset, streamed from the vertex coordinates of the mesh, the TDR vertex index is the vertex index
       H5::CompType vertex_type( dimension*sizeof(double) );
       vertex_type.insertMember( "x", 0, H5::PredType::NATIVE_DOUBLE);
-      if (dimension > 1)
-      {
-        vertex_type.insertMember( "y", sizeof(double), H5::PredType::NATIVE_DOUBLE);
-      }
+      vertex_type.insertMember( "y", sizeof(double), H5::PredType::NATIVE_DOUBLE);
       if (dimension > 2)
       {
         vertex_type.insertMember( "z", 2*sizeof(double), H5::PredType::NATIVE_DOUBLE);
       }
 
-      write_dataset(geometry, "vertex", vertex_type, vertex_coordinates.size()/dimension, vertex_coordinates);
+      viennagrid_numeric * coords;
+      viennagrid_mesh_vertex_coords_pointer(mesh.internal(), &coords);
+
+      chunked_dataset_writer<double> vertices(geometry, "vertex", vertex_type, dimension, options);
+      for (viennagrid_int i = 0; i < vertex_count*static_cast<viennagrid_int>(dimension); ++i)
+      {
+        vertices.push_back(coords[i] / tdr_coordinate_factor);
+      }
+      vertices.finish();
     }
 
     RegionRange regions(mesh);
@@ -162,54 +227,51 @@ void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & m
         H5::Group region_group = geometry.createGroup("region_" + boost::lexical_cast<std::string>(region_counter));
         write_attribute(region_group, "type", 0);
         write_attribute(region_group, "name", (*region_it).get_name());
-        write_attribute(region_group, "material", "unknown"); //TODO
+        write_attribute(region_group, "material", (region_counter < static_cast<int>(materials.size()) && !materials[region_counter].empty()) ?
+                                                  materials[region_counter] : std::string("unknown"));
         write_attribute(region_group, "number of parts", 1);
 
-        std::vector<int32_t> region_element_data;
+        chunked_dataset_writer<int32_t> elements(region_group, "elements_0", H5::PredType::NATIVE_INT32, 1, options);
 
         CellRange cells(*region_it);
         unsigned int num_elements = 0;
         for (CellIterator cell_it = cells.begin(); cell_it != cells.end(); ++cell_it, ++num_elements)
         {
-          if (!(*cell_it).tag().is_triangle())
-          {
-            throw viennautils::make_exception<tdr_writer_error>("Only triangles are supported at the moment");
-          }
-
-          int32_t const triangle_id = 2;
-          region_element_data.push_back(triangle_id);
+          elements.push_back(tdr_element_type((*cell_it).tag()));
 
           BoundaryVertexRange vertices(*cell_it);
           for (BoundaryVertexIterator vertex_it = vertices.begin(); vertex_it != vertices.end(); ++vertex_it)
           {
-            region_element_data.push_back(vertex_mapping[(*vertex_it).id()]);
+            elements.push_back((*vertex_it).id().index());
           }
         }
 
-        H5::DataSet elements = write_dataset(region_group, "elements_0", H5::PredType::NATIVE_INT32, region_element_data.size(), region_element_data);
-        write_attribute(elements, "number of elements", static_cast<int>(num_elements));
+        write_attribute(elements.finish(), "number of elements", static_cast<int>(num_elements));
       }
     }
 
-    if (!quantities.empty())
     {
-      //datasets
+      //datasets, the reader expects a state even if there are no quantities
       H5::Group state = geometry.createGroup("state_0");
       write_attribute(state, "name", "state_0");
       write_attribute(state, "number of plots", 0);
       write_attribute(state, "number of string streams", 0);
       write_attribute(state, "number of xy plots", 0);
 
-      typedef boost::container::flat_map<RegionId, std::vector<ElementId> > RegionVertexIdMap;
-      RegionVertexIdMap region_vert_ids;
-      region_vert_ids.reserve(mesh.region_count());
-      for (RegionIterator region_it = regions.begin(); region_it != regions.end(); ++region_it)
+      //vertex indices of every region, in the order of the region groups
+      std::vector< std::vector<viennagrid_int> > region_vertex_indices;
+      if (!quantities.empty())
       {
-        std::vector<ElementId> & vertex_ids = region_vert_ids[(*region_it).id()];
-        RegionVertexRange vertices(*region_it);
-        for (RegionVertexIterator vertex_it = vertices.begin(); vertex_it != vertices.end(); ++vertex_it)
+        region_vertex_indices.reserve(mesh.region_count());
+        for (RegionIterator region_it = regions.begin(); region_it != regions.end(); ++region_it)
         {
-          vertex_ids.push_back((*vertex_it).id());
+          region_vertex_indices.push_back( std::vector<viennagrid_int>() );
+          RegionVertexRange vertices(*region_it);
+          region_vertex_indices.back().reserve(vertices.size());
+          for (RegionVertexIterator vertex_it = vertices.begin(); vertex_it != vertices.end(); ++vertex_it)
+          {
+            region_vertex_indices.back().push_back((*vertex_it).id().index());
+          }
         }
       }
 
@@ -217,34 +279,55 @@ void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & m
       for (unsigned int i = 0; i < quantities.size(); ++i)
       {
         viennagrid::quantity_field const & quantity = quantities[i];
-        int region_num = 0;
-        for (RegionVertexIdMap::const_iterator region_it = region_vert_ids.begin(); region_it != region_vert_ids.end(); ++region_it, ++region_num)
+        if (quantity.topologic_dimension() != 0)
         {
-          std::vector<ElementId> const & vertex_ids = region_it->second;
-          std::vector<double> values;
-          values.reserve(vertex_ids.size());
-          for (unsigned int j = 0; j < vertex_ids.size(); ++j)
+          continue; //the reader supports vertex datasets only
+        }
+
+        //quantities with more than one value per vertex are written component wise as name_0, name_1, ...
+        int values_per_quantity = quantity.values_per_quantity();
+        for (int component = 0; component < values_per_quantity; ++component)
+        {
+          std::string name = quantity.get_name();
+          if (values_per_quantity > 1)
           {
-            if (!quantity.valid(vertex_ids[j].index()))
-            {
-              break;
-            }
-            values.push_back(quantity.get(vertex_ids[j].index()));
+            name += "_" + boost::lexical_cast<std::string>(component);
           }
 
-          if (values.size() == vertex_ids.size()) //only write quantities that are defined on the entire region
+          for (std::size_t region_num = 0; region_num != region_vertex_indices.size(); ++region_num)
           {
+            std::vector<viennagrid_int> const & vertex_indices = region_vertex_indices[region_num];
+
+            bool defined = true;
+            for (std::size_t j = 0; j < vertex_indices.size() && defined; ++j)
+            {
+              defined = vertex_indices[j] < static_cast<viennagrid_int>(quantity.size()) && quantity.valid(vertex_indices[j]);
+            }
+
+            if (!defined) //only write quantities that are defined on the entire region
+            {
+              continue;
+            }
+
             H5::Group dataset_group = state.createGroup("dataset_" + boost::lexical_cast<std::string>(num_datasets++));
-            write_attribute(dataset_group, "number of values", static_cast<int>(values.size()));
+            write_attribute(dataset_group, "number of values", static_cast<int>(vertex_indices.size()));
             write_attribute(dataset_group, "location type", 0);
             write_attribute(dataset_group, "structure type", 0);
             write_attribute(dataset_group, "value type", 2);
-            write_attribute(dataset_group, "name", quantity.get_name());
-            write_attribute(dataset_group, "quantity", quantity.get_name());
+            write_attribute(dataset_group, "name", name);
+            write_attribute(dataset_group, "quantity", name);
             write_attribute(dataset_group, "conversion factor", 1.0);
-            write_attribute(dataset_group, "region", region_num);
+            write_attribute(dataset_group, "region", static_cast<int>(region_num));
             write_attribute(dataset_group, "unit:name", "unknown"); //TODO
-            write_dataset(dataset_group, "values", H5::PredType::NATIVE_DOUBLE, values.size(), values);
+
+            chunked_dataset_writer<double> values(dataset_group, "values", H5::PredType::NATIVE_DOUBLE, 1, options);
+            for (std::size_t j = 0; j < vertex_indices.size(); ++j)
+            {
+              void * value;
+              viennagrid_quantity_field_value_get(quantity.internal(), vertex_indices[j], &value);
+              values.push_back(static_cast<viennagrid_numeric const *>(value)[component]);
+            }
+            values.finish();
           }
         }
       }
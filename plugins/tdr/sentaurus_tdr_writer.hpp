@@ -23,12 +23,25 @@
 #include "viennagrid/mesh/mesh.hpp"
 #include "viennagrid/core/quantity_field.hpp"
 
+#include "H5Cpp.h"
+
 namespace viennamesh
 {
 
 struct tdr_writer_error : virtual viennautils::exception {};
 
-void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & mesh, std::vector<viennagrid::quantity_field> const & quantities);
+struct tdr_write_options
+{
+  tdr_write_options() : chunk_size(65536), compression_level(0) {}
+
+  hsize_t chunk_size;       //number of entries per chunk, datasets are written chunk by chunk
+  int compression_level;    //deflate level 1-9, 0 disables compression
+};
+
+//materials[i] is the material of the i-th region, "unknown" for missing entries
+void write_to_tdr(std::string const & filename, viennagrid::const_mesh const & mesh, std::vector<viennagrid::quantity_field> const & quantities,
+                  std::vector<std::string> const & materials = std::vector<std::string>(),
+                  tdr_write_options const & options = tdr_write_options());
 
 } //end of namespace viennamesh
 
@@ -33,6 +33,9 @@ bool tdr_writer::run(viennamesh::algorithm_handle &)
   string_handle filename = get_required_input<string_handle>("filename");
   mesh_handle input_mesh = get_required_input<mesh_handle>("mesh");
   quantity_field_handle quantities = get_input<viennagrid::quantity_field>("quantities");
+  string_handle materials = get_input<string_handle>("materials");
+  data_handle<int> chunk_size = get_input<int>("chunk_size");
+  data_handle<int> compression_level = get_input<int>("compression_level");
   
   info(1) << "About to write mesh to TDR file: " << filename() << std::endl;
   
@@ -41,9 +44,37 @@ bool tdr_writer::run(viennamesh::algorithm_handle &)
       warning(1) << "More than one input mesh found - only writing the first one!" << std::endl;
   }
   
+  tdr_write_options options;
+  if (chunk_size.valid() && chunk_size() > 0)
+    options.chunk_size = chunk_size();
+  if (compression_level.valid())
+    options.compression_level = compression_level();
+
+  //the TDR format only stores vertex quantities
+  std::vector<viennagrid::quantity_field> vertex_quantities;
+  if (quantities.valid())
+  {
+    for (int i = 0; i != quantities.size(); ++i)
+    {
+      if (quantities(i).topologic_dimension() != 0)
+      {
+        warning(1) << "Quantity field \"" << quantities(i).get_name() << "\" is not a vertex quantity field - skipping it!" << std::endl;
+        continue;
+      }
+      vertex_quantities.push_back( quantities(i) );
+    }
+  }
+
+  std::vector<std::string> region_materials;
+  if (materials.valid())
+  {
+    for (int i = 0; i != materials.size(); ++i)
+      region_materials.push_back( materials(i) );
+  }
+
   try
   {
-    write_to_tdr(filename(), input_mesh(), (quantities.valid() ? quantities.get_vector() : std::vector<viennagrid::quantity_field>()));
+    write_to_tdr(filename(), input_mesh(), vertex_quantities, region_materials, options);
   }
   catch (tdr_writer_error const & e)
   {
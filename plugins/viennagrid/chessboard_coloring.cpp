@@ -13,6 +13,7 @@
 =============================================================================== */
 
 #include "chessboard_coloring.hpp"
+#include "coloring.hpp"
 
 namespace viennamesh
 {
@@ -28,111 +29,113 @@ namespace viennamesh
         mesh_handle input_mesh = get_required_input<mesh_handle>("mesh");
         mesh_handle output_mesh = make_data<mesh_handle>();
 
-        //Typedefs
-        typedef viennagrid::mesh                                                                  MeshType;
-        // typedef viennagrid::result_of::element<MeshType>::type                                    VertexType;
-        typedef viennagrid::result_of::element<MeshType>::type                                    EdgeType;
-        typedef viennagrid::result_of::element<MeshType>::type                                    TriangleType;
+        viennagrid_dimension cell_dimension = viennagrid::cell_dimension( input_mesh() );
 
-        //typedef viennagrid::result_of::element_range<MeshType, 0>::type                           VertexRange;
+        //dimension of the colored items, 0 colors vertices, default are the cells
+        int topological_dimension = cell_dimension;
+        if ( get_input<int>("topological_dimension").valid() )
+            topological_dimension = get_input<int>("topological_dimension")();
 
-        typedef viennagrid::result_of::element_range<MeshType, 2>::type                           TriangleRange; 
-        typedef viennagrid::result_of::iterator<TriangleRange>::type                              TriangleIterator; 
+        //distance 1: items sharing a vertex (elements) or a cell (vertices) get different colors
+        //distance 2: additionally items sharing a neighbor get different colors
+        int distance = 1;
+        if ( get_input<int>("distance").valid() )
+            distance = get_input<int>("distance")();
 
-        typedef viennagrid::result_of::neighbor_range<MeshType, 1, 2>::type                       TriangleNeighborRangeType;
-        typedef viennagrid::result_of::iterator<TriangleNeighborRangeType>::type                  TriangleNeighborIterator;
-                        
-        //get number of vertices and triangles
-        int num_vertices = viennagrid::vertex_count(input_mesh());
-        int num_triangles = viennagrid::element_count(input_mesh(), 2);
-/*
-        viennamesh::info(2) << "Number of vertices in mesh : " << num_vertices << std::endl;
-        viennamesh::info(2) << "Number of triangles in mesh: " << num_triangles << std::endl;
-*/
-        //set up accessor
-        std::vector<bool> color_triangles(num_triangles, false);
-        std::vector<bool> touched (num_triangles, false);
-
-        viennagrid::result_of::accessor<std::vector<bool>, TriangleType>::type color_accessor(color_triangles);
-
-        //set first element to color "black" (BOOL = TRUE)
-        color_accessor.set(viennagrid::cells(input_mesh())[0], true);
-
-        //iterate triangles in mesh
-        TriangleRange triangles(input_mesh());
+        bool balance = true;
+        if ( get_input<bool>("balance").valid() )
+            balance = get_input<bool>("balance")();
 
-        //Iterate over all triangles in the mesh
-        viennagrid_element_id * triangle_ids_begin;
-        viennagrid_element_id * triangle_ids_end;
-        viennagrid_dimension topological_dimension = viennagrid::cell_dimension( input_mesh() );	
-
-        viennagrid_element_id * neighbor_begin;
-        viennagrid_element_id * neighbor_end;
-
-        viennagrid_dimension connector = 1;
+        if (topological_dimension < 0 || topological_dimension > cell_dimension || distance < 1 || distance > 2)
+        {
+            error(1) << "Invalid coloring: topological_dimension=" << topological_dimension << " distance=" << distance << std::endl;
+            return false;
+        }
 
-        viennagrid_mesh_elements_get(input_mesh().internal(), topological_dimension, &triangle_ids_begin, &triangle_ids_end);	
+        int num_vertices = viennagrid::vertex_count(input_mesh());
 
-        viennagrid::quantity_field color_field(2,1);
-       // viennagrid_quantity_field_create(&color_field);
-        color_field.set_name("color");
+        //relation of elements of dimension element_dimension to their vertices
+        int element_dimension = (topological_dimension == 0) ? cell_dimension : topological_dimension;
 
-        //viennagrid_quantity_field_init(color_field, 2, VIENNAGRID_QUANTITY_FIELD_TYPE_NUMERIC, 1 , VIENNAGRID_QUANTITY_FIELD_STORAGE_DENSE);
+        viennagrid_element_id * element_ids_begin;
+        viennagrid_element_id * element_ids_end;
+        viennagrid_mesh_elements_get(input_mesh().internal(), element_dimension, &element_ids_begin, &element_ids_end);
 
-        //get triangles from mesh
+        int num_elements = element_ids_end - element_ids_begin;
 
-        for (viennagrid_element_id *tri = triangle_ids_begin; tri != triangle_ids_end; ++tri)
+        coloring::csr_graph element_vertices;
+        element_vertices.offsets.resize(num_elements+1, 0);
+        for (int i = 0; i != num_elements; ++i)
         {
-            int tri_index = viennagrid_index_from_element_id( *tri );
-
-            //std::cout << tri_index << std::endl;
-
-            if ( !touched[tri_index])
-            { 
-                //color_accessor.set(viennagrid::cells(input_mesh())[tri_index], true);
-                color_triangles[tri_index] = true;
-                touched[tri_index] = true;
-
-                double clr = 1;
+            viennagrid_element_id * vertex_ids_begin;
+            viennagrid_element_id * vertex_ids_end;
+            viennagrid_element_boundary_elements(input_mesh().internal(), element_ids_begin[i], 0, &vertex_ids_begin, &vertex_ids_end);
 
-                color_field.set(*tri, clr);
-
-                viennagrid_element_neighbor_elements(input_mesh().internal(), *tri, 0, 2, &neighbor_begin, &neighbor_end);
+            for (viennagrid_element_id * vit = vertex_ids_begin; vit != vertex_ids_end; ++vit)
+                element_vertices.indices.push_back( viennagrid_index_from_element_id(*vit) );
+            element_vertices.offsets[i+1] = element_vertices.indices.size();
+        }
 
-                for (viennagrid_element_id *n_tri = neighbor_begin; n_tri != neighbor_end; ++n_tri)
-                {
-                    int n_tri_index = viennagrid_index_from_element_id( *n_tri );
+        //items are connected through connectors, elements through vertices and vertices through cells
+        coloring::csr_graph item_connectors;
+        coloring::csr_graph connector_items;
+        if (topological_dimension == 0)
+        {
+            connector_items.offsets.swap(element_vertices.offsets);
+            connector_items.indices.swap(element_vertices.indices);
+            item_connectors = coloring::transpose(connector_items, num_vertices);
+        }
+        else
+        {
+            item_connectors.offsets.swap(element_vertices.offsets);
+            item_connectors.indices.swap(element_vertices.indices);
+            connector_items = coloring::transpose(item_connectors, num_vertices);
+        }
 
-                    //std::cout << "  " << n_tri_index << std::endl;
+        coloring::csr_graph graph = coloring::adjacency(item_connectors, connector_items);
 
-                    viennagrid_element_id * n_neighbor_begin;
-                    viennagrid_element_id * n_neighbor_end;
+        std::vector<int> colors;
+        int color_count = coloring::jones_plassmann(graph, distance, colors);
+        if (balance)
+            coloring::balance(graph, distance, color_count, colors);
 
-                    viennagrid_element_neighbor_elements(input_mesh().internal(), *n_tri, 0, 2, &n_neighbor_begin, &n_neighbor_end);
+        coloring::csr_graph classes = coloring::color_classes(colors, color_count);
 
-                    for (viennagrid_element_id *n_n_tri = n_neighbor_begin; n_n_tri != n_neighbor_end; ++n_n_tri)
-                    {
-                        int n_n_tri_index = viennagrid_index_from_element_id( *n_n_tri );
+        info(1) << "Colored " << graph.size() << " items of dimension " << topological_dimension
+                << " with " << color_count << " colors (distance " << distance << ")" << std::endl;
+        for (int c = 0; c != color_count; ++c)
+            info(5) << "  color " << c << ": " << classes.offsets[c+1] - classes.offsets[c] << " items" << std::endl;
 
-                        if ( !touched[n_n_tri_index])
-                        { 
-                            //color_accessor.set(viennagrid::cells(input_mesh())[n_tri_index], false);
-                            touched[n_n_tri_index] = true;
+        viennagrid::quantity_field color_field(topological_dimension, 1);
+        color_field.set_name("color");
 
-                            clr = 0;
-                            color_field.set(*n_n_tri, clr);
-                        }
-                    }
-                }
-            }
+        if (topological_dimension == 0)
+        {
+            for (int i = 0; i != graph.size(); ++i)
+                color_field.set( viennagrid_compose_element_id(0, i), static_cast<viennagrid_numeric>(colors[i]) );
+        }
+        else
+        {
+            for (int i = 0; i != graph.size(); ++i)
+                color_field.set( element_ids_begin[i], static_cast<viennagrid_numeric>(colors[i]) );
         }
 
         output_mesh = input_mesh;
         quantity_field_handle quantities = make_data<viennagrid::quantity_field>();
 
         quantities.set(color_field);
-   
+
+        //color classes in CSR format: the items of color c are color_items[color_offsets[c]] ... color_items[color_offsets[c+1]-1],
+        //items are element indices of the colored dimension
+        data_handle<int> output_color_offsets = make_data<int>();
+        output_color_offsets.set(classes.offsets);
+        data_handle<int> output_color_items = make_data<int>();
+        output_color_items.set(classes.indices);
+
         set_output("color_field", quantities);
+        set_output("color_count", color_count);
+        set_output("color_offsets", output_color_offsets);
+        set_output("color_items", output_color_items);
         set_output("mesh", output_mesh());
 
         return true;
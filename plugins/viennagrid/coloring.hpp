@@ -0,0 +1,318 @@
+#ifndef VIENNAMESH_ALGORITHM_VIENNAGRID_COLORING_HPP
+#define VIENNAMESH_ALGORITHM_VIENNAGRID_COLORING_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Parallel graph coloring on compressed sparse row (CSR) graphs. Items (elements or vertices)
+// are connected if they share a connector (a vertex for elements, a cell for vertices). Colors
+// are computed with the Jones-Plassmann algorithm, which is deterministic and independent of
+// the number of threads, and optionally balanced afterwards.
+namespace viennamesh
+{
+  namespace coloring
+  {
+    struct csr_graph
+    {
+      std::vector<int> offsets;
+      std::vector<int> indices;
+
+      int size() const { return static_cast<int>(offsets.size()) - 1; }
+      int const * begin(int i) const { return indices.data() + offsets[i]; }
+      int const * end(int i) const { return indices.data() + offsets[i+1]; }
+    };
+
+
+    // transposes a CSR relation from count_from items to count_to targets
+    inline csr_graph transpose(csr_graph const & relation, int count_to)
+    {
+      csr_graph result;
+      result.offsets.assign(count_to+1, 0);
+
+      for (std::size_t i = 0; i != relation.indices.size(); ++i)
+        ++result.offsets[relation.indices[i]+1];
+      for (int i = 0; i != count_to; ++i)
+        result.offsets[i+1] += result.offsets[i];
+
+      result.indices.resize( relation.indices.size() );
+      std::vector<int> position(result.offsets.begin(), result.offsets.end()-1);
+      for (int i = 0; i != relation.size(); ++i)
+        for (int const * it = relation.begin(i); it != relation.end(i); ++it)
+          result.indices[position[*it]++] = i;
+
+      return result;
+    }
+
+
+    // Builds the adjacency graph of items which share a connector, item_connectors maps items to
+    // connectors and connector_items is its transpose. Neighbor lists are sorted.
+    inline csr_graph adjacency(csr_graph const & item_connectors, csr_graph const & connector_items)
+    {
+      int count = item_connectors.size();
+
+      csr_graph graph;
+      graph.offsets.assign(count+1, 0);
+
+      #pragma omp parallel
+      {
+        std::vector<int> marker(count, -1);
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < count; ++i)
+        {
+          int degree = 0;
+          marker[i] = i;
+          for (int const * c = item_connectors.begin(i); c != item_connectors.end(i); ++c)
+            for (int const * j = connector_items.begin(*c); j != connector_items.end(*c); ++j)
+              if (marker[*j] != i)
+              {
+                marker[*j] = i;
+                ++degree;
+              }
+          graph.offsets[i+1] = degree;
+        }
+      }
+
+      for (int i = 0; i != count; ++i)
+        graph.offsets[i+1] += graph.offsets[i];
+      graph.indices.resize( graph.offsets[count] );
+
+      #pragma omp parallel
+      {
+        std::vector<int> marker(count, -1);
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < count; ++i)
+        {
+          int * out = graph.indices.data() + graph.offsets[i];
+          marker[i] = i;
+          for (int const * c = item_connectors.begin(i); c != item_connectors.end(i); ++c)
+            for (int const * j = connector_items.begin(*c); j != connector_items.end(*c); ++j)
+              if (marker[*j] != i)
+              {
+                marker[*j] = i;
+                *out++ = *j;
+              }
+          std::sort(graph.indices.data() + graph.offsets[i], out);
+        }
+      }
+
+      return graph;
+    }
+
+
+
+    // pseudo random but reproducible priority of an item, ties are broken by the index
+    inline boost::uint32_t priority(boost::uint32_t index)
+    {
+      index ^= index >> 16;
+      index *= 0x7feb352dU;
+      index ^= index >> 15;
+      index *= 0x846ca68bU;
+      index ^= index >> 16;
+      return index;
+    }
+
+    inline bool has_priority(int i, int j)
+    {
+      boost::uint32_t pi = priority(i);
+      boost::uint32_t pj = priority(j);
+      return pi > pj || (pi == pj && i > j);
+    }
+
+
+    // Calls f for every item at distance 1 or 2 from item i.
+    template<typename FunctorT>
+    void for_each_neighbor(csr_graph const & graph, int i, int distance, FunctorT f)
+    {
+      for (int const * j = graph.begin(i); j != graph.end(i); ++j)
+      {
+        f(*j);
+        if (distance > 1)
+          for (int const * k = graph.begin(*j); k != graph.end(*j); ++k)
+            if (*k != i)
+              f(*k);
+      }
+    }
+
+
+    // Jones-Plassmann coloring: in every round all uncolored items which have the highest
+    // priority among their uncolored neighbors form an independent set and pick the smallest
+    // color not used by their neighbors. Returns the number of colors.
+    inline int jones_plassmann(csr_graph const & graph, int distance, std::vector<int> & colors)
+    {
+      int count = graph.size();
+      colors.assign(count, -1);
+
+      std::vector<int> uncolored(count);
+      for (int i = 0; i != count; ++i)
+        uncolored[i] = i;
+
+      std::vector<char> selected(count, 0);
+      int color_count = 0;
+
+      while (!uncolored.empty())
+      {
+        int uncolored_count = uncolored.size();
+
+        #pragma omp parallel for schedule(static)
+        for (int u = 0; u < uncolored_count; ++u)
+        {
+          int i = uncolored[u];
+          bool is_max = true;
+          for_each_neighbor(graph, i, distance, [&](int j)
+          {
+            if (is_max && colors[j] < 0 && has_priority(j, i))
+              is_max = false;
+          });
+          selected[u] = is_max;
+        }
+
+        // selected items are never neighbors, their colors only depend on colors of previous rounds
+        #pragma omp parallel
+        {
+          std::vector<int> forbidden;
+          int local_color_count = 0;
+
+          #pragma omp for schedule(static)
+          for (int u = 0; u < uncolored_count; ++u)
+          {
+            if (!selected[u])
+              continue;
+
+            int i = uncolored[u];
+            for_each_neighbor(graph, i, distance, [&](int j)
+            {
+              if (colors[j] >= 0)
+              {
+                if (colors[j] >= static_cast<int>(forbidden.size()))
+                  forbidden.resize(colors[j]+1, -1);
+                forbidden[colors[j]] = i;
+              }
+            });
+
+            int color = 0;
+            while (color < static_cast<int>(forbidden.size()) && forbidden[color] == i)
+              ++color;
+
+            colors[i] = color;
+            local_color_count = std::max(local_color_count, color+1);
+          }
+
+          #pragma omp critical (viennamesh_coloring_color_count)
+          color_count = std::max(color_count, local_color_count);
+        }
+
+        std::vector<int> next_uncolored;
+        next_uncolored.reserve(uncolored_count);
+        for (int u = 0; u != uncolored_count; ++u)
+          if (!selected[u])
+            next_uncolored.push_back(uncolored[u]);
+        uncolored.swap(next_uncolored);
+      }
+
+      return color_count;
+    }
+
+
+    // Moves items from color classes larger than the average into the smallest permissible
+    // color class which is below the average. Items of one color are independent, so their
+    // candidates are computed in parallel, the moves are applied in item order.
+    inline void balance(csr_graph const & graph, int distance, int color_count, std::vector<int> & colors)
+    {
+      int count = graph.size();
+      if (color_count < 2)
+        return;
+
+      int target = (count + color_count - 1) / color_count;
+
+      std::vector< std::vector<int> > classes(color_count);
+      for (int i = 0; i != count; ++i)
+        classes[colors[i]].push_back(i);
+
+      std::vector<int> sizes(color_count);
+      for (int c = 0; c != color_count; ++c)
+        sizes[c] = classes[c].size();
+
+      for (int c = 0; c != color_count; ++c)
+      {
+        if (sizes[c] <= target)
+          continue;
+
+        std::vector<int> const & items = classes[c];
+        int item_count = items.size();
+        std::vector<int> candidates(item_count, -1);
+
+        #pragma omp parallel
+        {
+          std::vector<char> forbidden(color_count);
+
+          #pragma omp for schedule(static)
+          for (int u = 0; u < item_count; ++u)
+          {
+            int i = items[u];
+            std::fill(forbidden.begin(), forbidden.end(), 0);
+            for_each_neighbor(graph, i, distance, [&](int j) { forbidden[colors[j]] = 1; });
+
+            int best = -1;
+            for (int k = 0; k != color_count; ++k)
+              if (k != c && !forbidden[k] && sizes[k] < target && (best < 0 || sizes[k] < sizes[best]))
+                best = k;
+            candidates[u] = best;
+          }
+        }
+
+        for (int u = 0; u != item_count && sizes[c] > target; ++u)
+        {
+          int k = candidates[u];
+          if (k >= 0 && sizes[k] < target)
+          {
+            colors[items[u]] = k;
+            --sizes[c];
+            ++sizes[k];
+          }
+        }
+      }
+    }
+
+
+    // color classes as CSR, items of each color are sorted
+    inline csr_graph color_classes(std::vector<int> const & colors, int color_count)
+    {
+      csr_graph classes;
+      classes.offsets.assign(color_count+1, 0);
+      for (std::size_t i = 0; i != colors.size(); ++i)
+        ++classes.offsets[colors[i]+1];
+      for (int c = 0; c != color_count; ++c)
+        classes.offsets[c+1] += classes.offsets[c];
+
+      classes.indices.resize( colors.size() );
+      std::vector<int> position(classes.offsets.begin(), classes.offsets.end()-1);
+      for (std::size_t i = 0; i != colors.size(); ++i)
+        classes.indices[position[colors[i]]++] = i;
+
+      return classes;
+    }
+  }
+}
+
+#endif
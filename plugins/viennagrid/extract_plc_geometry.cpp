@@ -15,6 +15,7 @@
 #include "extract_plc_geometry.hpp"
 
 #include <set>
+#include <algorithm>
 #include "viennagrid/algorithm/extract_hole_points.hpp"
 #include "viennagrid/algorithm/plane_to_2d_projector.hpp"
 #include "viennagrid/algorithm/geometry.hpp"
@@ -81,16 +82,19 @@ namespace viennamesh
 
 
 
+  // Marks all cells which are connected to cell through cells fulfilling same_cell_functor with plc_id.
+  // Uses an explicit stack, large coplanar regions would overflow the call stack otherwise.
   template<typename MeshT, typename CellT, typename SamePLCCellFunctorT,
            typename VisitedAccessorT, typename PLCIDAccessorT>
-  void recursively_add_neighbours( MeshT const & mesh,
-                                   CellT const & cell,
-                                   SamePLCCellFunctorT same_cell_functor,
-                                   VisitedAccessorT & visited_accessor,
-                                   PLCIDAccessorT & plc_id_accessor,
-                                   int plc_id)
+  void add_neighbours( MeshT const & mesh,
+                       CellT const & cell,
+                       SamePLCCellFunctorT same_cell_functor,
+                       VisitedAccessorT & visited_accessor,
+                       PLCIDAccessorT & plc_id_accessor,
+                       int plc_id)
   {
-    typedef typename viennagrid::result_of::point<MeshT>::type PointType;
+    typedef typename viennagrid::result_of::const_neighbor_range<MeshT>::type NeighbourRangeType;
+    typedef typename viennagrid::result_of::iterator<NeighbourRangeType>::type NeighbourRangeIterator;
 
     if ( visited_accessor.get(cell) )
       return;
@@ -98,20 +102,25 @@ namespace viennamesh
     visited_accessor.set(cell, true);
     plc_id_accessor.set(cell, plc_id);
 
-    PointType normal_vector = viennagrid::normal_vector( cell );
-    normal_vector /= viennagrid::norm_2(normal_vector);
-
-    typedef typename viennagrid::result_of::const_neighbor_range<MeshT>::type NeighbourRangeType;
-    typedef typename viennagrid::result_of::iterator<NeighbourRangeType>::type NeighbourRangeIterator;
-
-    NeighbourRangeType neighbors(mesh, cell, 1, viennagrid::topologic_dimension(mesh));
-    for (NeighbourRangeIterator it = neighbors.begin(); it != neighbors.end(); ++it)
+    std::vector<CellT> stack(1, cell);
+    while (!stack.empty())
     {
-      if ( visited_accessor.get(*it) )
-        continue;
+      CellT current = stack.back();
+      stack.pop_back();
+
+      NeighbourRangeType neighbors(mesh, current, 1, viennagrid::topologic_dimension(mesh));
+      for (NeighbourRangeIterator it = neighbors.begin(); it != neighbors.end(); ++it)
+      {
+        if ( visited_accessor.get(*it) )
+          continue;
 
-      if ( same_cell_functor(cell, *it) )
-        recursively_add_neighbours( mesh, *it, same_cell_functor, visited_accessor, plc_id_accessor, plc_id );
+        if ( same_cell_functor(current, *it) )
+        {
+          visited_accessor.set(*it, true);
+          plc_id_accessor.set(*it, plc_id);
+          stack.push_back(*it);
+        }
+      }
     }
   }
 
@@ -133,6 +142,9 @@ namespace viennamesh
     typedef typename viennagrid::result_of::iterator<ConstCellRangeType>::type ConstCellIteratorType;
     typedef typename viennagrid::result_of::point<MeshType>::type PointType;
 
+    typedef typename viennagrid::result_of::const_vertex_range<MeshType>::type ConstVertexRangeType;
+    typedef typename viennagrid::result_of::iterator<ConstVertexRangeType>::type ConstVertexIteratorType;
+
     typedef typename viennagrid::result_of::const_element_range<MeshType, 1>::type ConstLineRangeType;
     typedef typename viennagrid::result_of::iterator<ConstLineRangeType>::type ConstLineIteratorType;
 
@@ -143,44 +155,69 @@ namespace viennamesh
 
     std::vector<int> plc_id_container( cells.size(), -1 );
     typename viennagrid::result_of::accessor< std::vector<int>, ElementType >::type plc_ids(plc_id_container);
-    int lowest_plc_id = 0;
+    int plc_count = 0;
 
     for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
     {
       if ( cell_visited.get(*cit) )
         continue;
 
-      recursively_add_neighbours( mesh, *cit, same_plc_functor, cell_visited, plc_ids, lowest_plc_id++ );
+      add_neighbours( mesh, *cit, same_plc_functor, cell_visited, plc_ids, plc_count++ );
     }
 
-    std::map<ElementType, viennagrid_int> vertex_map;
 
-    for (int i = 0; i < lowest_plc_id; ++i)
+    // flat copies of the vertex coordinates and the triangle vertex indices, the per PLC
+    // work below only reads these arrays and can run in parallel
+    ConstVertexRangeType vertices(mesh);
+    std::vector<PointType> points( vertices.size() );
+    for (ConstVertexIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+      points[ (*vit).id().index() ] = viennagrid::get_point(*vit);
+
+    // cells bucketed by PLC id: the cells of PLC i are plc_cells[plc_cell_offsets[i]] ... plc_cells[plc_cell_offsets[i+1]-1]
+    std::vector<int> plc_cell_offsets(plc_count+1, 0);
+    for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+      ++plc_cell_offsets[ plc_ids.get(*cit)+1 ];
+    for (int i = 0; i != plc_count; ++i)
+      plc_cell_offsets[i+1] += plc_cell_offsets[i];
+
+    std::vector<int> plc_cells( 3*plc_cell_offsets[plc_count] );
     {
-      std::vector<point> hole_points_3d;
+      std::vector<int> position( plc_cell_offsets.begin(), plc_cell_offsets.end()-1 );
+      for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        int * triangle = &plc_cells[ 3*position[plc_ids.get(*cit)]++ ];
+        for (int j = 0; j != 3; ++j)
+          triangle[j] = viennagrid::vertices(*cit)[j].id().index();
+      }
+    }
+
+
+    // extract PLC hole points
+    std::vector< std::vector<point> > plc_hole_points_3d(plc_count);
+
+    #pragma omp parallel
+    {
+      // vertex_to_point_index[v] is only valid if vertex_stamp[v] is the current PLC
+      std::vector<int> vertex_to_point_index( points.size() );
+      std::vector<int> vertex_stamp( points.size(), -1 );
+
+      #pragma omp for schedule(dynamic)
+      for (int i = 0; i < plc_count; ++i)
       {
-        // extract PLC hole points
-        typedef typename viennagrid::result_of::element_id<MeshType>::type VertexIDType;
-        std::map<VertexIDType, int> vertex_to_point_index;
         std::vector<point> plc_points_3d;
+        std::vector<int> plc_triangles;
+        plc_triangles.reserve( 3*(plc_cell_offsets[i+1]-plc_cell_offsets[i]) );
 
-        for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        for (int j = 3*plc_cell_offsets[i]; j != 3*plc_cell_offsets[i+1]; ++j)
         {
-          if (plc_ids.get(*cit) == i)
+          int vertex = plc_cells[j];
+          if (vertex_stamp[vertex] != i)
           {
-            typedef typename viennagrid::result_of::const_vertex_range<ElementType>::type VertexOnCellRangeType;
-            typedef typename viennagrid::result_of::iterator<VertexOnCellRangeType>::type VertexOnCellIteratorType;
-            VertexOnCellRangeType vertices_on_cells(*cit);
-            for (VertexOnCellIteratorType vcit = vertices_on_cells.begin(); vcit != vertices_on_cells.end(); ++vcit)
-            {
-              typename std::map<VertexIDType, int>::iterator it = vertex_to_point_index.find( (*vcit).id() );
-              if (it == vertex_to_point_index.end())
-              {
-                plc_points_3d.push_back( viennagrid::get_point(*vcit) );
-                vertex_to_point_index[(*vcit).id()] = plc_points_3d.size()-1;
-              }
-            }
+            vertex_stamp[vertex] = i;
+            vertex_to_point_index[vertex] = plc_points_3d.size();
+            plc_points_3d.push_back( points[vertex] );
           }
+          plc_triangles.push_back( vertex_to_point_index[vertex] );
         }
 
         std::vector<point> plc_points_2d( plc_points_3d.size() );
@@ -198,88 +235,87 @@ namespace viennamesh
         for (std::size_t j = 0; j < plc_points_2d.size(); ++j)
           vertex_handles_2d[j] = viennagrid::make_vertex(mesh2d, plc_points_2d[j]);
 
-        for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        for (std::size_t j = 0; j < plc_triangles.size(); j += 3)
         {
-          if (plc_ids.get(*cit) == i)
-          {
-            viennagrid::make_triangle(
-              mesh2d,
-              vertex_handles_2d[ vertex_to_point_index[viennagrid::vertices(*cit)[0].id()] ],
-              vertex_handles_2d[ vertex_to_point_index[viennagrid::vertices(*cit)[1].id()] ],
-              vertex_handles_2d[ vertex_to_point_index[viennagrid::vertices(*cit)[2].id()] ]
-            );
-          }
+          viennagrid::make_triangle(
+            mesh2d,
+            vertex_handles_2d[ plc_triangles[j+0] ],
+            vertex_handles_2d[ plc_triangles[j+1] ],
+            vertex_handles_2d[ plc_triangles[j+2] ]
+          );
         }
 
         std::vector<point> hole_points_2d;
         viennagrid::extract_hole_points( mesh2d, hole_points_2d );
 
+        projection_functor.unproject( hole_points_2d.begin(), hole_points_2d.end(), std::back_inserter(plc_hole_points_3d[i]) );
+      }
+    }
 
 
-        projection_functor.unproject( hole_points_2d.begin(), hole_points_2d.end(), std::back_inserter(hole_points_3d) );
-      }
+    // extract PLC lines in a single pass over all lines, a line belongs to every PLC with
+    // an adjacent triangle unless it is an inner line of that PLC
+    std::vector< std::vector< std::pair<int, int> > > plc_lines(plc_count);
 
+    ConstLineRangeType lines(mesh);
+    std::vector<int> line_plc_ids;
+    for (ConstLineIteratorType lit = lines.begin(); lit != lines.end(); ++lit)
+    {
+      typedef typename viennagrid::result_of::const_coboundary_range<MeshType>::type ConstCoboundaryRangeType;
+      typedef typename viennagrid::result_of::iterator<ConstCoboundaryRangeType>::type                                                 ConstCoboundaryRangeIterator;
 
-      // extract PLC lines
-      std::map<ElementType, viennagrid_int> plc_vertices;
-      std::set< std::pair<ElementType, ElementType> > plc_lines;
+      ConstCoboundaryRangeType triangles(mesh, *lit, 2);
 
-      ConstLineRangeType lines(mesh);
-      for (ConstLineIteratorType lit = lines.begin(); lit != lines.end(); ++lit)
-      {
-        typedef typename viennagrid::result_of::const_coboundary_range<MeshType>::type ConstCoboundaryRangeType;
-        typedef typename viennagrid::result_of::iterator<ConstCoboundaryRangeType>::type                                                 ConstCoboundaryRangeIterator;
+      line_plc_ids.clear();
+      for (ConstCoboundaryRangeIterator ctit = triangles.begin(); ctit != triangles.end(); ++ctit)
+        line_plc_ids.push_back( plc_ids.get(*ctit) );
 
-        ConstCoboundaryRangeType triangles(mesh, *lit, 2);
-        int triangle_in_plc_count = 0;
-        for (ConstCoboundaryRangeIterator ctit = triangles.begin(); ctit != triangles.end(); ++ctit)
-        {
-          if (plc_ids.get(*ctit) == i)
-            ++triangle_in_plc_count;
-        }
+      if (line_plc_ids.size() == 2 && line_plc_ids[0] == line_plc_ids[1])
+        continue;
 
-        if (triangle_in_plc_count == 2 && triangles.size() == 2)
-          continue;
+      std::sort( line_plc_ids.begin(), line_plc_ids.end() );
+      line_plc_ids.erase( std::unique(line_plc_ids.begin(), line_plc_ids.end()), line_plc_ids.end() );
 
-        if (triangle_in_plc_count > 0)
-        {
-          ElementType v0 = viennagrid::vertices(*lit)[0];
-          ElementType v1 = viennagrid::vertices(*lit)[1];
+      int v0 = viennagrid::vertices(*lit)[0].id().index();
+      int v1 = viennagrid::vertices(*lit)[1].id().index();
+      if (v1 < v0)
+        std::swap(v0, v1);
 
-          plc_vertices.insert( std::make_pair(v0, -1) );
-          plc_vertices.insert( std::make_pair(v1, -1) );
+      for (std::size_t j = 0; j != line_plc_ids.size(); ++j)
+        plc_lines[ line_plc_ids[j] ].push_back( std::make_pair(v0, v1) );
+    }
 
 
-          if (v1 < v0)
-            std::swap(v0, v1);
+    std::vector<viennagrid_int> vertex_map( points.size(), -1 );
+    std::vector<int> plc_vertices;
+    std::vector<viennagrid_int> line_ids;
 
-          plc_lines.insert( std::make_pair(v0, v1) );
-        }
+    for (int i = 0; i < plc_count; ++i)
+    {
+      std::sort( plc_lines[i].begin(), plc_lines[i].end() );
+
+      plc_vertices.clear();
+      for (std::size_t j = 0; j != plc_lines[i].size(); ++j)
+      {
+        plc_vertices.push_back( plc_lines[i][j].first );
+        plc_vertices.push_back( plc_lines[i][j].second );
       }
+      std::sort( plc_vertices.begin(), plc_vertices.end() );
+      plc_vertices.erase( std::unique(plc_vertices.begin(), plc_vertices.end()), plc_vertices.end() );
 
-      for (typename std::map<ElementType, viennagrid_int>::iterator vit = plc_vertices.begin(); vit != plc_vertices.end(); ++vit)
+      for (std::size_t j = 0; j != plc_vertices.size(); ++j)
       {
-        typename std::map<ElementType, viennagrid_int>::iterator gvit = vertex_map.find( (*vit).first );
-        if (gvit == vertex_map.end())
-        {
-          PointType p = viennagrid::get_point( vit->first );
-          viennagrid_plc_vertex_create(plc, &p[0], &vit->second);
-          vertex_map.insert( *vit );
-        }
-        else
-          vit->second = gvit->second;
+        if (vertex_map[ plc_vertices[j] ] == -1)
+          viennagrid_plc_vertex_create(plc, &points[ plc_vertices[j] ][0], &vertex_map[ plc_vertices[j] ]);
       }
 
-      std::vector<viennagrid_int> line_ids;
-      for (typename std::set< std::pair<ElementType, ElementType> >::iterator it = plc_lines.begin(); it != plc_lines.end(); ++it)
+      line_ids.clear();
+      for (std::size_t j = 0; j != plc_lines[i].size(); ++j)
       {
         viennagrid_int line_id;
-
-
-
         viennagrid_plc_line_create(plc,
-                                   plc_vertices[(*it).first],
-                                   plc_vertices[(*it).second],
+                                   vertex_map[ plc_lines[i][j].first ],
+                                   vertex_map[ plc_lines[i][j].second ],
                                    &line_id);
         line_ids.push_back(line_id);
       }
@@ -288,7 +324,7 @@ namespace viennamesh
       viennagrid_int facet_id;
       viennagrid_plc_facet_create(plc, line_ids.size(), &line_ids[0], &facet_id);
 
-      for (std::vector<point>::const_iterator hpit = hole_points_3d.begin(); hpit != hole_points_3d.end(); ++hpit)
+      for (std::vector<point>::const_iterator hpit = plc_hole_points_3d[i].begin(); hpit != plc_hole_points_3d[i].end(); ++hpit)
       {
         viennagrid_plc_facet_hole_point_add(plc, facet_id, &(*hpit)[0]);
       }
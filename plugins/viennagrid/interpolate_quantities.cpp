@@ -13,10 +13,103 @@
 =============================================================================== */
 
 #include "interpolate_quantities.hpp"
+#include "quantity_interpolation.hpp"
 #include "viennagrid/algorithm/quantity_interpolate.hpp"
 
 namespace viennamesh
 {
+  namespace
+  {
+    typedef viennagrid::mesh                                                MeshType;
+    typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
+
+    typedef viennagrid::result_of::const_element_range<MeshType>::type      ConstElementRangeType;
+    typedef viennagrid::result_of::iterator<ConstElementRangeType>::type    ConstElementIteratorType;
+
+    typedef viennagrid::result_of::const_element_range<ElementType>::type   ConstBoundaryRangeType;
+    typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type   ConstBoundaryIteratorType;
+
+
+    // vertex indices of all cells, field_indices are the indices of the cells in cell quantity fields
+    void gather_cells(viennagrid::mesh const & mesh,
+                      std::vector<viennagrid_int> & offsets,
+                      std::vector<viennagrid_int> & vertices,
+                      std::vector<viennagrid_int> & field_indices)
+    {
+      ConstElementRangeType cells( mesh, viennagrid::cell_dimension(mesh) );
+      offsets.assign(1, 0);
+      offsets.reserve( cells.size()+1 );
+      field_indices.reserve( cells.size() );
+
+      for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+      {
+        ConstBoundaryRangeType boundary_vertices(*cit, 0);
+        for (ConstBoundaryIteratorType bvit = boundary_vertices.begin(); bvit != boundary_vertices.end(); ++bvit)
+          vertices.push_back( (*bvit).id().index() );
+        offsets.push_back( vertices.size() );
+        field_indices.push_back( (*cit).id().index() );
+      }
+    }
+
+    // the point locator requires simplex cells of full dimension
+    bool supports_point_location(viennagrid::mesh const & mesh, std::vector<viennagrid_int> const & offsets)
+    {
+      int dimension = viennagrid::geometric_dimension(mesh);
+      if (dimension < 1 || dimension > 3 || viennagrid::cell_dimension(mesh) != dimension)
+        return false;
+
+      for (std::size_t i = 0; i+1 < offsets.size(); ++i)
+        if (offsets[i+1] - offsets[i] != dimension+1)
+          return false;
+      return true;
+    }
+
+
+    interpolation::dense_field make_dense_field(viennagrid::quantity_field const & field, viennagrid_int size,
+                                                std::vector<viennagrid_int> const * field_indices)
+    {
+      interpolation::dense_field result;
+      result.values_per_quantity = field.values_per_quantity();
+      result.values.assign( size*result.values_per_quantity, 0 );
+      result.valid.assign( size, 0 );
+
+      for (viennagrid_int j = 0; j < size; ++j)
+      {
+        viennagrid_int index = field_indices ? (*field_indices)[j] : j;
+        if (index >= static_cast<viennagrid_int>(field.size()) || !field.valid(index))
+          continue;
+
+        void * value;
+        viennagrid_quantity_field_value_get(field.internal(), index, &value);
+        std::copy( static_cast<viennagrid_numeric const *>(value), static_cast<viennagrid_numeric const *>(value) + result.values_per_quantity,
+                   result.values.begin() + j*result.values_per_quantity );
+        result.valid[j] = 1;
+      }
+
+      return result;
+    }
+
+    // targets without a value get default_value
+    viennagrid::quantity_field make_quantity_field(viennagrid::quantity_field const & src_field,
+                                                   interpolation::dense_field const & values,
+                                                   std::vector<viennagrid_int> const * field_indices,
+                                                   viennagrid_numeric default_value)
+    {
+      viennagrid::quantity_field field( src_field.topologic_dimension(), src_field.values_per_quantity(), src_field.storage_layout() );
+      field.set_name( src_field.get_name() );
+
+      std::vector<viennagrid_numeric> defaults( values.values_per_quantity, default_value );
+      for (viennagrid_int j = 0; j != values.size(); ++j)
+      {
+        viennagrid_int index = field_indices ? (*field_indices)[j] : j;
+        viennagrid_numeric const * value = values.valid[j] ? &values.values[j*values.values_per_quantity] : &defaults[0];
+        viennagrid_quantity_field_value_set(field.internal(), index, value);
+      }
+
+      return field;
+    }
+  }
+
 
   interpolate_quantities::interpolate_quantities() {}
   std::string interpolate_quantities::name() { return "interpolate_quantities"; }
@@ -31,11 +124,58 @@ namespace viennamesh
     quantity_field_handle dst_quantity_fields = make_data<viennagrid::quantity_field>();
     dst_quantity_fields.resize( src_quantity_fields.size() );
 
+    interpolation::interpolation_mode mode = interpolation::linear_interpolation;
+    if ( get_input<viennamesh_string>("mode").valid() )
+    {
+      std::string mode_name = get_input<viennamesh_string>("mode")();
+      if (mode_name == "linear")
+        mode = interpolation::linear_interpolation;
+      else if (mode_name == "nearest")
+        mode = interpolation::nearest_interpolation;
+      else if (mode_name == "conservative")
+        mode = interpolation::conservative_interpolation;
+      else
+      {
+        error(1) << "Unknown interpolation mode \"" << mode_name << "\", supported are linear, nearest and conservative" << std::endl;
+        return false;
+      }
+    }
+
+    interpolation::extrapolation_mode extrapolation = interpolation::no_extrapolation;
+    if ( get_input<viennamesh_string>("extrapolation").valid() )
+    {
+      std::string extrapolation_name = get_input<viennamesh_string>("extrapolation")();
+      if (extrapolation_name == "none")
+        extrapolation = interpolation::no_extrapolation;
+      else if (extrapolation_name == "nearest")
+        extrapolation = interpolation::nearest_extrapolation;
+      else if (extrapolation_name == "linear")
+        extrapolation = interpolation::linear_extrapolation;
+      else
+      {
+        error(1) << "Unknown extrapolation \"" << extrapolation_name << "\", supported are none, nearest and linear" << std::endl;
+        return false;
+      }
+    }
+
+    double default_value = 0.0;
+    if ( get_input<double>("default_value").valid() )
+      default_value = get_input<double>("default_value")();
+
+    int sample_level = 3;
+    if ( get_input<int>("sample_level").valid() )
+      sample_level = get_input<int>("sample_level")();
+
+
+    // fields are grouped by their topologic dimension, each group shares one weight table
+    int cell_dimension = viennagrid::cell_dimension( src_mesh() );
+    std::vector<int> vertex_field_indices;
+    std::vector<int> cell_field_indices;
 
     for (int i = 0; i != src_quantity_fields.size(); ++i)
     {
       viennagrid::quantity_field src_qf = src_quantity_fields(i);
-      if (src_qf.topologic_dimension() != 0)
+      if (src_qf.topologic_dimension() != 0 && src_qf.topologic_dimension() != cell_dimension)
       {
         info(1) << "Quantity field \"" << src_qf.get_name() << "\" has unsupported topologic dimension = " << (int)src_qf.topologic_dimension() << " -> skipping" << std::endl;
         continue;
@@ -44,12 +184,96 @@ namespace viennamesh
       info(1) << "Found quantity field \"" << src_qf.get_name() << "\" with topologic dimension " << (int)src_qf.topologic_dimension() <<
       " and values dimension " << (int)src_qf.values_per_quantity() << std::endl;
 
-      viennagrid::quantity_field dst_qf( 0, src_qf.values_per_quantity(), src_qf.storage_layout() );
-      dst_qf.set_name( src_qf.get_name() );
+      if (src_qf.topologic_dimension() == 0)
+        vertex_field_indices.push_back(i);
+      else
+        cell_field_indices.push_back(i);
+    }
+
+
+    std::vector<viennagrid_int> src_cell_offsets;
+    std::vector<viennagrid_int> src_cell_vertices;
+    std::vector<viennagrid_int> src_cell_field_indices;
+    gather_cells( src_mesh(), src_cell_offsets, src_cell_vertices, src_cell_field_indices );
+
+    int dimension = viennagrid::geometric_dimension( src_mesh() );
+    if ( !supports_point_location(src_mesh(), src_cell_offsets) || viennagrid::geometric_dimension(dst_mesh()) != dimension )
+    {
+      // element wise interpolation of vertex fields, cell fields are not supported
+      info(1) << "Source mesh is not a simplex mesh of full dimension, using element wise vertex interpolation" << std::endl;
+
+      for (std::size_t k = 0; k != vertex_field_indices.size(); ++k)
+      {
+        viennagrid::quantity_field src_qf = src_quantity_fields(vertex_field_indices[k]);
+        viennagrid::quantity_field dst_qf( 0, src_qf.values_per_quantity(), src_qf.storage_layout() );
+        dst_qf.set_name( src_qf.get_name() );
+
+        viennagrid::interpolate_vertex_quantity( src_mesh(), src_qf, dst_mesh(), dst_qf, default_value );
+
+        dst_quantity_fields.set(vertex_field_indices[k], dst_qf);
+      }
+
+      for (std::size_t k = 0; k != cell_field_indices.size(); ++k)
+        info(1) << "Quantity field \"" << src_quantity_fields(cell_field_indices[k]).get_name() << "\" is a cell field -> skipping" << std::endl;
+
+      set_output( "quantities", dst_quantity_fields );
+      return true;
+    }
+
+
+    viennagrid_numeric * src_coords;
+    viennagrid_mesh_vertex_coords_pointer(src_mesh().internal(), &src_coords);
+    viennagrid_numeric * dst_coords;
+    viennagrid_mesh_vertex_coords_pointer(dst_mesh().internal(), &dst_coords);
+
+    interpolation::point_locator locator(src_coords, dimension, src_cell_vertices);
+    info(1) << "Built point locator for " << locator.cell_count() << " source cells" << std::endl;
+
+
+    if (!vertex_field_indices.empty())
+    {
+      if (mode == interpolation::conservative_interpolation)
+        info(1) << "Conservative interpolation is only defined for cell fields, vertex fields are interpolated linearly" << std::endl;
+
+      viennagrid_int src_vertex_count = viennagrid::vertex_count( src_mesh() );
+      viennagrid_int dst_vertex_count = viennagrid::vertex_count( dst_mesh() );
+
+      interpolation::weight_table table;
+      interpolation::vertex_weights(locator, dst_coords, dst_vertex_count, mode, extrapolation, table);
+
+      std::vector<interpolation::dense_field> src_values;
+      std::vector<interpolation::dense_field> dst_values;
+      for (std::size_t k = 0; k != vertex_field_indices.size(); ++k)
+        src_values.push_back( make_dense_field(src_quantity_fields(vertex_field_indices[k]), src_vertex_count, NULL) );
+
+      interpolation::apply(table, src_values, dst_values);
+
+      for (std::size_t k = 0; k != vertex_field_indices.size(); ++k)
+        dst_quantity_fields.set( vertex_field_indices[k],
+                                 make_quantity_field(src_quantity_fields(vertex_field_indices[k]), dst_values[k], NULL, default_value) );
+    }
+
+
+    if (!cell_field_indices.empty())
+    {
+      std::vector<viennagrid_int> dst_cell_offsets;
+      std::vector<viennagrid_int> dst_cell_vertices;
+      std::vector<viennagrid_int> dst_cell_field_indices;
+      gather_cells( dst_mesh(), dst_cell_offsets, dst_cell_vertices, dst_cell_field_indices );
+
+      interpolation::weight_table table;
+      interpolation::cell_weights(locator, dst_coords, dst_cell_offsets, dst_cell_vertices, mode, extrapolation, sample_level, table);
+
+      std::vector<interpolation::dense_field> src_values;
+      std::vector<interpolation::dense_field> dst_values;
+      for (std::size_t k = 0; k != cell_field_indices.size(); ++k)
+        src_values.push_back( make_dense_field(src_quantity_fields(cell_field_indices[k]), locator.cell_count(), &src_cell_field_indices) );
 
-      viennagrid::interpolate_vertex_quantity( src_mesh(), src_qf, dst_mesh(), dst_qf, 0 );
+      interpolation::apply(table, src_values, dst_values);
 
-      dst_quantity_fields.set(i, dst_qf);
+      for (std::size_t k = 0; k != cell_field_indices.size(); ++k)
+        dst_quantity_fields.set( cell_field_indices[k],
+                                 make_quantity_field(src_quantity_fields(cell_field_indices[k]), dst_values[k], &dst_cell_field_indices, default_value) );
     }
 
 
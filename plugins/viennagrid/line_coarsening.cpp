@@ -14,27 +14,20 @@
 
 #include "line_coarsening.hpp"
 
+#include <atomic>
+
 #include "viennagrid/algorithm/angle.hpp"
+#include "viennameshpp/vertex_welding.hpp"
 
 
 namespace viennamesh
 {
 
-  template<typename ElementRangeT, typename AccessorT, typename T>
-  void merge_lines(ElementRangeT const & elements,
-                   AccessorT accessor,
-                   T from, T to)
-  {
-    typedef typename viennagrid::result_of::const_iterator<ElementRangeT>::type ElementRangeIterator;
-    for (ElementRangeIterator eit = elements.begin(); eit != elements.end(); ++eit)
-    {
-      if ( accessor.get(*eit) == from )
-        accessor.set(*eit, to);
-    }
-  }
-
-
-
+  // Two lines are joined at a vertex if no other line uses that vertex, both lines belong to the
+  // same regions and their angle at the vertex is larger than angle. Joined lines form polylines
+  // which are collected with the lock free union-find of the vertex welding in near linear time,
+  // every polyline is replaced by a line between its two end points. Closed polylines have no
+  // end points and are copied unchanged.
   template<typename MeshT>
   void coarsen(MeshT const & mesh,
                viennagrid::mesh const & output_mesh,
@@ -48,91 +41,168 @@ namespace viennamesh
 
 
     ElementRangeType lines(mesh, 1);
+    viennagrid_int line_count = lines.size();
 
+    // lines and their end points, vertices are identified by the index of their id
+    std::vector<ElementType> line_elements;
+    line_elements.reserve(line_count);
+    std::vector<viennagrid_int> line_vertices(2*line_count);
+
+    viennagrid_int vertex_count = 0;
+    for (ElementIteratorType lit = lines.begin(); lit != lines.end(); ++lit)
+    {
+      viennagrid_int line = line_elements.size();
+      line_elements.push_back(*lit);
 
+      for (int i = 0; i != 2; ++i)
+      {
+        line_vertices[2*line+i] = viennagrid::vertices(*lit)[i].id().index();
+        vertex_count = std::max(vertex_count, line_vertices[2*line+i]+1);
+      }
+    }
 
-    typedef std::vector<viennagrid::element_id> NewLineIDContainerType;
-    typedef typename viennagrid::result_of::accessor<NewLineIDContainerType, ElementType>::type NewLineIDAcessorType;
 
-    NewLineIDContainerType line_id_container( lines.size() );
-    NewLineIDAcessorType line_ids(line_id_container);
+    // number of lines using a vertex and the first two of them
+    std::vector<int> degree(vertex_count, 0);
+    std::vector<viennagrid_int> vertex_lines(2*vertex_count, -1);
+    for (viennagrid_int line = 0; line != line_count; ++line)
+    {
+      for (int i = 0; i != 2; ++i)
+      {
+        viennagrid_int vertex = line_vertices[2*line+i];
+        if (degree[vertex] < 2)
+          vertex_lines[2*vertex + degree[vertex]] = line;
+        ++degree[vertex];
+      }
+    }
 
-    for (ElementIteratorType lit = lines.begin(); lit != lines.end(); ++lit)
-      line_ids.set(*lit, (*lit).id());
 
+    // join the lines at every mergeable vertex, each vertex touches only its own two lines
+    std::vector< std::atomic<viennagrid_int> > parent(line_count);
+    std::vector<char> inner_vertex(vertex_count, 0);
 
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int line = 0; line < line_count; ++line)
+      parent[line].store(line, std::memory_order_relaxed);
 
-    ElementRangeType vertices(mesh, 0);
-    for (ElementIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (viennagrid_int vertex = 0; vertex < vertex_count; ++vertex)
     {
-      typedef typename viennagrid::result_of::coboundary_range<MeshT>::type CoboundaryVertexRangeType;
-
-      CoboundaryVertexRangeType coboundary_lines(mesh, *vit, 1);
-      if (coboundary_lines.size() != 2)
+      if (degree[vertex] != 2)
         continue;
 
-      if (!viennagrid::equal_regions(viennagrid::regions(coboundary_lines[0]),
-                                     viennagrid::regions(coboundary_lines[1])))
+      viennagrid_int line0 = vertex_lines[2*vertex];
+      viennagrid_int line1 = vertex_lines[2*vertex+1];
+      if (line0 == line1)
         continue;
 
-      ElementType middle = (*vit);
-      ElementType first = viennagrid::vertices(coboundary_lines[0])[0] == middle ?
-                                viennagrid::vertices(coboundary_lines[0])[1] :
-                                viennagrid::vertices(coboundary_lines[0])[0];
-      ElementType last = viennagrid::vertices(coboundary_lines[1])[0] == middle ?
-                                viennagrid::vertices(coboundary_lines[1])[1] :
-                                viennagrid::vertices(coboundary_lines[1])[0];
+      if (!viennagrid::equal_regions(viennagrid::regions(line_elements[line0]),
+                                     viennagrid::regions(line_elements[line1])))
+        continue;
 
+      int middle_index = (line_vertices[2*line0] == vertex) ? 0 : 1;
+      ElementType middle = viennagrid::vertices(line_elements[line0])[middle_index];
+      ElementType first = viennagrid::vertices(line_elements[line0])[1-middle_index];
+      ElementType last = viennagrid::vertices(line_elements[line1])[(line_vertices[2*line1] == vertex) ? 1 : 0];
 
       double current_angle = viennagrid::angle( viennagrid::get_point(mesh, first),
                                                 viennagrid::get_point(mesh, last),
                                                 viennagrid::get_point(mesh, middle) );
       if (current_angle > angle)
       {
-        merge_lines( lines,
-                     line_ids,
-                     line_ids.get(coboundary_lines[0]),
-                     line_ids.get(coboundary_lines[1]) );
+        inner_vertex[vertex] = 1;
+        welding::unite(&parent[0], line0, line1);
       }
-
     }
 
 
-    std::map<viennagrid::element_id, std::vector<ElementType> > new_lines;
+    // lines of every polyline in CSR format, polylines are ordered by their first line
+    std::vector<viennagrid_int> roots(line_count);
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int line = 0; line < line_count; ++line)
+      roots[line] = welding::find_root(&parent[0], line);
 
-    for (ElementIteratorType lit = lines.begin(); lit != lines.end(); ++lit)
-      new_lines[line_ids.get(*lit)].push_back( *lit );
+    std::vector<viennagrid_int> polyline_index(line_count, -1);
+    viennagrid_int polyline_count = 0;
+    for (viennagrid_int line = 0; line != line_count; ++line)
+      if (roots[line] == line)
+        polyline_index[line] = polyline_count++;
 
+    std::vector<viennagrid_int> polyline_offsets(polyline_count+1, 0);
+    for (viennagrid_int line = 0; line != line_count; ++line)
+      ++polyline_offsets[ polyline_index[roots[line]]+1 ];
+    for (viennagrid_int polyline = 0; polyline != polyline_count; ++polyline)
+      polyline_offsets[polyline+1] += polyline_offsets[polyline];
+
+    std::vector<viennagrid_int> polyline_lines(line_count);
+    {
+      std::vector<viennagrid_int> fill( polyline_offsets.begin(), polyline_offsets.end()-1 );
+      for (viennagrid_int line = 0; line != line_count; ++line)
+        polyline_lines[ fill[polyline_index[roots[line]]]++ ] = line;
+    }
 
-    typedef typename viennagrid::result_of::element_copy_map<>::type CopyMapType;
-    CopyMapType copy_map( output_mesh, false );
 
-    for (typename std::map<viennagrid::element_id, std::vector<ElementType> >::iterator nlit = new_lines.begin(); nlit != new_lines.end(); ++nlit)
+    // end points of every polyline as line end point positions (2*line+i), -1 for closed polylines
+    std::vector<viennagrid_int> polyline_ends(2*polyline_count, -1);
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (viennagrid_int polyline = 0; polyline < polyline_count; ++polyline)
     {
-      std::map<ElementType, int> points;
+      int end_count = 0;
+      viennagrid_int ends[2] = {-1, -1};
 
-      for (std::size_t i = 0; i != (*nlit).second.size(); ++i)
+      for (viennagrid_int k = polyline_offsets[polyline]; k != polyline_offsets[polyline+1]; ++k)
       {
-        points[ viennagrid::vertices((*nlit).second[i])[0] ]++;
-        points[ viennagrid::vertices((*nlit).second[i])[1] ]++;
+        for (int i = 0; i != 2; ++i)
+        {
+          viennagrid_int position = 2*polyline_lines[k]+i;
+          if (inner_vertex[ line_vertices[position] ])
+            continue;
+
+          if (end_count < 2)
+            ends[end_count] = position;
+          ++end_count;
+        }
       }
 
-      std::vector<ElementType> line_to_create;
+      if (end_count == 2 && line_vertices[ends[0]] != line_vertices[ends[1]])
+      {
+        polyline_ends[2*polyline] = ends[0];
+        polyline_ends[2*polyline+1] = ends[1];
+      }
+    }
+
 
-      for (typename std::map<ElementType, int>::iterator pit = points.begin(); pit != points.end(); ++pit)
+    typedef typename viennagrid::result_of::element_copy_map<>::type CopyMapType;
+    CopyMapType copy_map( output_mesh, false );
+
+    for (viennagrid_int polyline = 0; polyline != polyline_count; ++polyline)
+    {
+      viennagrid_int begin = polyline_offsets[polyline];
+      viennagrid_int end = polyline_offsets[polyline+1];
+
+      if (polyline_ends[2*polyline] < 0)
       {
-        if ((*pit).second == 1)
-          line_to_create.push_back( (*pit).first );
+        for (viennagrid_int k = begin; k != end; ++k)
+        {
+          ElementType const & line = line_elements[ polyline_lines[k] ];
+          ElementType nl = viennagrid::make_line(output_mesh,
+                                                 copy_map( viennagrid::vertices(line)[0] ),
+                                                 copy_map( viennagrid::vertices(line)[1] ));
+          viennagrid::copy_region_information(line, nl);
+        }
+        continue;
       }
 
-      assert( line_to_create.size() == 2 );
+      viennagrid_int end0 = polyline_ends[2*polyline];
+      viennagrid_int end1 = polyline_ends[2*polyline+1];
 
-      ElementType nv0 = copy_map( line_to_create[0] );
-      ElementType nv1 = copy_map( line_to_create[1] );
+      ElementType nv0 = copy_map( viennagrid::vertices(line_elements[end0/2])[end0%2] );
+      ElementType nv1 = copy_map( viennagrid::vertices(line_elements[end1/2])[end1%2] );
 
       ElementType nl = viennagrid::make_line(output_mesh, nv0, nv1);
 
-      viennagrid::copy_region_information((*nlit).second[0], nl);
+      viennagrid::copy_region_information(line_elements[ polyline_lines[begin] ], nl);
     }
   }
 
@@ -13,16 +13,40 @@
 =============================================================================== */
 
 #include "merge_meshes.hpp"
+#include "viennameshpp/vertex_welding.hpp"
+#include "viennameshpp/cell_batch.hpp"
+
+#include <set>
+#include <algorithm>
 
 namespace viennamesh
 {
+  // All input meshes are gathered into one vertex and one cell array, the vertices are welded at once
+  // and the merged mesh is created in a single batch.
+  struct merged_mesh_buffer
+  {
+    merged_mesh_buffer() : geometric_dimension(0) {}
+
+    viennagrid_dimension geometric_dimension;
+    std::vector<viennagrid_numeric> coords;
+
+    std::vector<viennagrid_element_type> cell_types;
+    std::vector<viennagrid_int> cell_vertex_offsets;
+    std::vector<viennagrid_int> cell_vertices;         // indices into coords
+    std::vector<viennagrid_int> cell_region_offsets;
+    std::vector<viennagrid_region_id> cell_region_ids;
+
+    std::set<viennagrid_region_id> region_ids;
+
+    viennagrid_int vertex_count() const { return geometric_dimension ? coords.size() / geometric_dimension : 0; }
+  };
+
+
   template<bool mesh_is_const>
   void merge_meshes_impl(viennagrid::base_mesh<mesh_is_const> const & src_mesh,
-                         viennagrid::mesh const & dst_mesh,
-                         double tolerance, bool region_offset)
+                         merged_mesh_buffer & dst,
+                         bool region_offset)
   {
-    viennagrid::result_of::element_copy_map<>::type copy_map(dst_mesh, tolerance, false);
-
     typedef viennagrid::base_mesh<mesh_is_const>                                    SrcMeshType;
 
     typedef typename viennagrid::result_of::element<SrcMeshType>::type              CellType;
@@ -30,28 +54,96 @@ namespace viennamesh
     typedef typename viennagrid::result_of::const_cell_range<SrcMeshType>::type     ConstCellRangeType;
     typedef typename viennagrid::result_of::iterator<ConstCellRangeType>::type      ConstCellIteratorType;
 
-    typedef typename viennagrid::result_of::region_range<SrcMeshType>::type         SrcRegionRangeType;
+    typedef typename viennagrid::result_of::const_element_range<CellType>::type     ConstBoundaryRangeType;
+    typedef typename viennagrid::result_of::iterator<ConstBoundaryRangeType>::type  ConstBoundaryIteratorType;
+
+    typedef typename viennagrid::result_of::region_range<CellType>::type            SrcRegionRangeType;
     typedef typename viennagrid::result_of::iterator<SrcRegionRangeType>::type      SrcRegionRangeIterator;
 
-    int region_id_offset = dst_mesh.region_count();
+    viennagrid_int src_vertex_count = viennagrid::vertex_count(src_mesh);
+    viennagrid_dimension src_geometric_dimension = viennagrid::geometric_dimension(src_mesh);
+
+    if (dst.geometric_dimension == 0)
+      dst.geometric_dimension = src_geometric_dimension;
+
+    viennagrid_int vertex_offset = dst.vertex_count();
+    if (src_vertex_count > 0)
+    {
+      viennagrid_numeric * coords;
+      viennagrid_mesh_vertex_coords_pointer(src_mesh.internal(), &coords);
+
+      // meshes of lower geometric dimension are padded with zeros
+      dst.coords.resize( dst.coords.size() + src_vertex_count*dst.geometric_dimension, 0.0 );
+      viennagrid_numeric * dst_coords = &dst.coords[vertex_offset*dst.geometric_dimension];
+      int copied_dimension = std::min(src_geometric_dimension, dst.geometric_dimension);
+      for (viennagrid_int i = 0; i != src_vertex_count; ++i)
+        std::copy( coords + i*src_geometric_dimension, coords + i*src_geometric_dimension + copied_dimension,
+                   dst_coords + i*dst.geometric_dimension );
+    }
+
+    int region_id_offset = dst.region_ids.size();
     int source_region_count = src_mesh.region_count();
 
+    if (dst.cell_vertex_offsets.empty())
+      dst.cell_vertex_offsets.push_back(0);
+    if (dst.cell_region_offsets.empty())
+      dst.cell_region_offsets.push_back(0);
+    std::size_t first_region_entry = dst.cell_region_ids.size();
+
     ConstCellRangeType cells(src_mesh);
     for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
     {
-      CellType cell = copy_map(*cit);
+      dst.cell_types.push_back( (*cit).tag().internal() );
+
+      ConstBoundaryRangeType boundary_vertices(*cit, 0);
+      for (ConstBoundaryIteratorType bvit = boundary_vertices.begin(); bvit != boundary_vertices.end(); ++bvit)
+        dst.cell_vertices.push_back( vertex_offset + (*bvit).id().index() );
+      dst.cell_vertex_offsets.push_back( dst.cell_vertices.size() );
 
       if (source_region_count <= 1)
-        viennagrid::add( dst_mesh.get_or_create_region(region_offset ? region_id_offset : 0), cell );
+        dst.cell_region_ids.push_back( region_offset ? region_id_offset : 0 );
       else
       {
         SrcRegionRangeType region_range(*cit);
         for (SrcRegionRangeIterator rit = region_range.begin(); rit != region_range.end(); ++rit)
-        {
-          viennagrid::add( dst_mesh.get_or_create_region((*rit).id() + (region_offset ? region_id_offset : 0)), cell );
-        }
+          dst.cell_region_ids.push_back( (*rit).id() + (region_offset ? region_id_offset : 0) );
       }
+      dst.cell_region_offsets.push_back( dst.cell_region_ids.size() );
     }
+
+    dst.region_ids.insert( dst.cell_region_ids.begin() + first_region_entry, dst.cell_region_ids.end() );
+  }
+
+
+  void create_merged_mesh(merged_mesh_buffer const & src, double tolerance, viennagrid::mesh const & dst_mesh)
+  {
+    viennagrid_int vertex_count = src.vertex_count();
+    if (vertex_count == 0)
+      return;
+
+    std::vector<viennagrid_int> new_index;
+    std::vector<viennagrid_numeric> new_coords;
+    viennagrid_int new_vertex_count = weld_vertices(&src.coords[0], vertex_count, src.geometric_dimension, tolerance,
+                                                    new_index, new_coords);
+
+    viennagrid_element_id first_vertex_id;
+    viennagrid_mesh_geometric_dimension_set(dst_mesh.internal(), src.geometric_dimension);
+    viennagrid_mesh_vertex_batch_create(dst_mesh.internal(), new_vertex_count, &new_coords[0], &first_vertex_id);
+
+    viennagrid_int cell_count = src.cell_types.size();
+    if (cell_count == 0)
+      return;
+
+    for (std::set<viennagrid_region_id>::const_iterator rit = src.region_ids.begin(); rit != src.region_ids.end(); ++rit)
+      dst_mesh.get_or_create_region(*rit);
+
+    std::vector<viennagrid_element_id> cell_vertices( src.cell_vertices.size() );
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < static_cast<long>(cell_vertices.size()); ++i)
+      cell_vertices[i] = first_vertex_id + new_index[ src.cell_vertices[i] ];
+
+    batch_create_cells(dst_mesh, cell_count, &src.cell_types[0], &src.cell_vertex_offsets[0], &cell_vertices[0],
+                       &src.cell_region_offsets[0], src.cell_region_ids.empty() ? NULL : &src.cell_region_ids[0]);
   }
 
 
@@ -74,13 +166,15 @@ namespace viennamesh
 
     info(1) << "Using region offset: " << std::boolalpha << region_offset << std::endl;
 
+    merged_mesh_buffer buffer;
+
     int merged_count = 0;
     if (input_mesh.valid())
     {
       int mesh_count = input_mesh.size();
       for (int i = 0; i != mesh_count; ++i)
       {
-        merge_meshes_impl( input_mesh(i), output_mesh(), (merged_count == 0 ? -1 : tolerance), region_offset );
+        merge_meshes_impl( input_mesh(i), buffer, region_offset );
         ++merged_count;
       }
     }
@@ -97,27 +191,14 @@ namespace viennamesh
       int mesh_count = another_input_mesh.size();
       for (int i = 0; i != mesh_count; ++i)
       {
-        merge_meshes_impl( another_input_mesh(i), output_mesh(), (merged_count == 0 ? -1 : tolerance), region_offset );
+        merge_meshes_impl( another_input_mesh(i), buffer, region_offset );
         ++merged_count;
       }
 
       ++mesh_index;
     }
 
-//
-
-
-
-//     if (input_mesh)
-//       merge_meshes_impl( input_mesh(), output_mesh() );
-//
-//     int index = 0;
-//     input_mesh = get_input<mesh_handle>("mesh[" + lexical_cast<std::string>(index++) + "]");
-//     while (input_mesh)
-//     {
-//       merge_meshes_impl( input_mesh(), output_mesh() );
-//       input_mesh = get_input<mesh_handle>("mesh[" + lexical_cast<std::string>(index++) + "]");
-//     }
+    create_merged_mesh( buffer, tolerance, output_mesh() );
 
     info(1) << "Merged " << merged_count << " meshes" << std::endl;
 
@@ -0,0 +1,677 @@
+#ifndef VIENNAMESH_ALGORITHM_VIENNAGRID_QUANTITY_INTERPOLATION_HPP
+#define VIENNAMESH_ALGORITHM_VIENNAGRID_QUANTITY_INTERPOLATION_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <cmath>
+#include <limits>
+
+#include "viennagrid/viennagrid.h"
+
+// Interpolation of quantities between meshes. The source mesh consists of simplices whose dimension
+// equals the geometric dimension (lines, triangles or tetrahedra). A point locator is built once,
+// the destination points are located in parallel and the resulting interpolation weights are stored
+// in a table which is applied to all quantity fields in one pass.
+namespace viennamesh
+{
+  namespace interpolation
+  {
+    enum interpolation_mode
+    {
+      linear_interpolation,        // barycentric weights of the source cell vertices
+      nearest_interpolation,       // nearest vertex of the source cell
+      conservative_interpolation   // cell fields: volume weighted average of the overlapped source cells
+    };
+
+    enum extrapolation_mode
+    {
+      no_extrapolation,            // points outside the source mesh get no value
+      nearest_extrapolation,       // value on the closest point of the closest source cell
+      linear_extrapolation         // linear continuation of the closest source cell
+    };
+
+
+    // Uniform grid of bins over the source cells, every bin stores the cells whose bounding box overlaps it
+    class point_locator
+    {
+    public:
+
+      // cells holds dimension+1 vertex indices per cell, vertex i is at coords[i*dimension]
+      point_locator(viennagrid_numeric const * coords_, int dimension_, std::vector<viennagrid_int> const & cells_) :
+          coords(coords_), dim(dimension_), cells(cells_)
+      {
+        viennagrid_int count = cell_count();
+        int n = dim;
+
+        // barycentric coordinates 1..dim of a point p are inverse * (p - first vertex)
+        inverses.assign(count*n*n, 0.0);
+        degenerate.assign(count, 0);
+
+        #pragma omp parallel for schedule(static)
+        for (viennagrid_int c = 0; c < count; ++c)
+        {
+          viennagrid_numeric m[9];
+          viennagrid_numeric const * v0 = vertex(cells[c*(n+1)]);
+          for (int j = 0; j != n; ++j)
+          {
+            viennagrid_numeric const * vj = vertex(cells[c*(n+1)+j+1]);
+            for (int i = 0; i != n; ++i)
+              m[i*n+j] = vj[i] - v0[i];
+          }
+
+          if (!invert(m, n, &inverses[c*n*n]))
+            degenerate[c] = 1;
+        }
+
+        build_bins();
+      }
+
+      int dimension() const { return dim; }
+      viennagrid_int cell_count() const { return cells.size() / (dim+1); }
+      viennagrid_int const * cell_vertices(viennagrid_int cell) const { return &cells[cell*(dim+1)]; }
+
+
+      // cell which contains point, -1 if there is none, the lowest cell index is taken on shared boundaries
+      viennagrid_int locate(viennagrid_numeric const * point, viennagrid_numeric * barycentric) const
+      {
+        viennagrid_int bin = bin_index(point);
+        for (viennagrid_int k = bin_offsets[bin]; k != bin_offsets[bin+1]; ++k)
+        {
+          viennagrid_int cell = bin_cells[k];
+          if (!degenerate[cell] && compute_barycentric(cell, point, barycentric) >= -eps())
+            return cell;
+        }
+        return -1;
+      }
+
+      // cell with the smallest distance to point, also for points outside the mesh, -1 for empty meshes
+      viennagrid_int closest(viennagrid_numeric const * point, viennagrid_numeric * barycentric) const
+      {
+        int center[3];
+        for (int i = 0; i != dim; ++i)
+          center[i] = axis_bin(point[i], i);
+
+        int max_radius = 0;
+        for (int i = 0; i != dim; ++i)
+          max_radius = std::max(max_radius, bin_counts[i]);
+
+        viennagrid_int best = -1;
+        viennagrid_numeric best_distance = std::numeric_limits<viennagrid_numeric>::max();
+        viennagrid_numeric lambda[4];
+
+        for (int radius = 0; radius <= max_radius; ++radius)
+        {
+          // all bins with a Chebyshev distance of radius to the center bin
+          int low[3] = {0, 0, 0};
+          int high[3] = {0, 0, 0};
+          for (int i = 0; i != dim; ++i)
+          {
+            low[i] = center[i] - radius;
+            high[i] = center[i] + radius;
+          }
+
+          int idx[3] = {low[0], low[1], low[2]};
+          while (true)
+          {
+            bool on_ring = false;
+            bool in_grid = true;
+            for (int i = 0; i != dim; ++i)
+            {
+              on_ring = on_ring || idx[i] == low[i] || idx[i] == high[i];
+              in_grid = in_grid && idx[i] >= 0 && idx[i] < bin_counts[i];
+            }
+
+            if (on_ring && in_grid)
+            {
+              viennagrid_int bin = linear_bin(idx);
+              for (viennagrid_int k = bin_offsets[bin]; k != bin_offsets[bin+1]; ++k)
+              {
+                viennagrid_int cell = bin_cells[k];
+                if (degenerate[cell])
+                  continue;
+
+                compute_barycentric(cell, point, lambda);
+                viennagrid_numeric distance = clamped_distance(cell, point, lambda);
+                if (distance < best_distance || (distance == best_distance && cell < best))
+                {
+                  best = cell;
+                  best_distance = distance;
+                }
+              }
+            }
+
+            int i = 0;
+            for (; i != dim; ++i)
+            {
+              if (++idx[i] <= high[i])
+                break;
+              idx[i] = low[i];
+            }
+            if (i == dim)
+              break;
+          }
+
+          // cells in bins further out are at least radius bin widths away
+          if (best >= 0 && best_distance <= radius * min_bin_size)
+            break;
+        }
+
+        if (best >= 0)
+          compute_barycentric(best, point, barycentric);
+        return best;
+      }
+
+
+      // barycentric coordinates of point with respect to cell, returns the smallest coordinate
+      viennagrid_numeric compute_barycentric(viennagrid_int cell, viennagrid_numeric const * point, viennagrid_numeric * barycentric) const
+      {
+        int n = dim;
+        viennagrid_numeric const * v0 = vertex(cells[cell*(n+1)]);
+        viennagrid_numeric const * inverse = &inverses[cell*n*n];
+
+        viennagrid_numeric sum = 0.0;
+        viennagrid_numeric min = std::numeric_limits<viennagrid_numeric>::max();
+        for (int i = 0; i != n; ++i)
+        {
+          viennagrid_numeric value = 0.0;
+          for (int j = 0; j != n; ++j)
+            value += inverse[i*n+j] * (point[j] - v0[j]);
+          barycentric[i+1] = value;
+          sum += value;
+          min = std::min(min, value);
+        }
+        barycentric[0] = 1.0 - sum;
+        return std::min(min, barycentric[0]);
+      }
+
+      viennagrid_numeric const * vertex(viennagrid_int index) const { return coords + index*dim; }
+
+    private:
+
+      static viennagrid_numeric eps() { return 1e-10; }
+
+      static bool invert(viennagrid_numeric const * m, int n, viennagrid_numeric * inverse)
+      {
+        if (n == 1)
+        {
+          if (m[0] == 0.0)
+            return false;
+          inverse[0] = 1.0 / m[0];
+          return true;
+        }
+
+        if (n == 2)
+        {
+          viennagrid_numeric det = m[0]*m[3] - m[1]*m[2];
+          if (std::abs(det) <= std::numeric_limits<viennagrid_numeric>::min())
+            return false;
+          inverse[0] =  m[3] / det;
+          inverse[1] = -m[1] / det;
+          inverse[2] = -m[2] / det;
+          inverse[3] =  m[0] / det;
+          return true;
+        }
+
+        viennagrid_numeric c[9];
+        c[0] = m[4]*m[8] - m[5]*m[7];
+        c[1] = m[2]*m[7] - m[1]*m[8];
+        c[2] = m[1]*m[5] - m[2]*m[4];
+        c[3] = m[5]*m[6] - m[3]*m[8];
+        c[4] = m[0]*m[8] - m[2]*m[6];
+        c[5] = m[2]*m[3] - m[0]*m[5];
+        c[6] = m[3]*m[7] - m[4]*m[6];
+        c[7] = m[1]*m[6] - m[0]*m[7];
+        c[8] = m[0]*m[4] - m[1]*m[3];
+
+        viennagrid_numeric det = m[0]*c[0] + m[1]*c[3] + m[2]*c[6];
+        if (std::abs(det) <= std::numeric_limits<viennagrid_numeric>::min())
+          return false;
+        for (int i = 0; i != 9; ++i)
+          inverse[i] = c[i] / det;
+        return true;
+      }
+
+      // squared distance of point to the point of cell given by the clamped and renormalized barycentric coordinates
+      viennagrid_numeric clamped_distance(viennagrid_int cell, viennagrid_numeric const * point, viennagrid_numeric const * barycentric) const
+      {
+        viennagrid_numeric lambda[4];
+        viennagrid_numeric sum = 0.0;
+        for (int i = 0; i <= dim; ++i)
+        {
+          lambda[i] = std::max<viennagrid_numeric>(barycentric[i], 0.0);
+          sum += lambda[i];
+        }
+
+        viennagrid_numeric distance = 0.0;
+        for (int j = 0; j != dim; ++j)
+        {
+          viennagrid_numeric q = 0.0;
+          for (int i = 0; i <= dim; ++i)
+            q += lambda[i] / sum * vertex(cells[cell*(dim+1)+i])[j];
+          distance += (point[j]-q)*(point[j]-q);
+        }
+        return std::sqrt(distance);
+      }
+
+      int axis_bin(viennagrid_numeric value, int i) const
+      {
+        int b = static_cast<int>( std::floor((value - lower[i]) / bin_sizes[i]) );
+        return std::max(0, std::min(bin_counts[i]-1, b));
+      }
+
+      viennagrid_int linear_bin(int const * idx) const
+      {
+        viennagrid_int bin = 0;
+        for (int i = dim-1; i >= 0; --i)
+          bin = bin * bin_counts[i] + idx[i];
+        return bin;
+      }
+
+      viennagrid_int bin_index(viennagrid_numeric const * point) const
+      {
+        int idx[3];
+        for (int i = 0; i != dim; ++i)
+          idx[i] = axis_bin(point[i], i);
+        return linear_bin(idx);
+      }
+
+      void build_bins()
+      {
+        viennagrid_int count = cell_count();
+        int n = dim;
+
+        for (int i = 0; i != 3; ++i)
+        {
+          lower[i] = 0.0;
+          bin_sizes[i] = 1.0;
+          bin_counts[i] = 1;
+        }
+
+        viennagrid_numeric upper[3];
+        for (int i = 0; i != n; ++i)
+        {
+          lower[i] = std::numeric_limits<viennagrid_numeric>::max();
+          upper[i] = -std::numeric_limits<viennagrid_numeric>::max();
+        }
+        for (std::size_t k = 0; k != cells.size(); ++k)
+          for (int i = 0; i != n; ++i)
+          {
+            lower[i] = std::min(lower[i], vertex(cells[k])[i]);
+            upper[i] = std::max(upper[i], vertex(cells[k])[i]);
+          }
+
+        // about one cell per bin
+        viennagrid_numeric volume = 1.0;
+        int extended_axes = 0;
+        for (int i = 0; i != n; ++i)
+          if (count > 0 && upper[i] > lower[i])
+          {
+            volume *= upper[i] - lower[i];
+            ++extended_axes;
+          }
+
+        viennagrid_numeric width = (extended_axes > 0) ? std::pow(volume / std::max<viennagrid_int>(count, 1), 1.0 / extended_axes) : 1.0;
+        viennagrid_int total_bins = 1;
+        for (int i = 0; i != n; ++i)
+        {
+          viennagrid_numeric extent = (count > 0) ? upper[i] - lower[i] : 0.0;
+          bin_counts[i] = (extent > 0.0) ? std::max(1, std::min(1024, static_cast<int>(std::ceil(extent / width)))) : 1;
+          bin_sizes[i] = (extent > 0.0) ? extent / bin_counts[i] : 1.0;
+          total_bins *= bin_counts[i];
+        }
+
+        min_bin_size = bin_sizes[0];
+        for (int i = 1; i != n; ++i)
+          min_bin_size = std::min(min_bin_size, bin_sizes[i]);
+
+        // bin range of every cell, the bins are filled in cell order so that bin lists are sorted
+        std::vector<int> ranges(count*2*n);
+        #pragma omp parallel for schedule(static)
+        for (viennagrid_int c = 0; c < count; ++c)
+        {
+          for (int i = 0; i != n; ++i)
+          {
+            viennagrid_numeric lo = std::numeric_limits<viennagrid_numeric>::max();
+            viennagrid_numeric hi = -std::numeric_limits<viennagrid_numeric>::max();
+            for (int j = 0; j <= n; ++j)
+            {
+              lo = std::min(lo, vertex(cells[c*(n+1)+j])[i]);
+              hi = std::max(hi, vertex(cells[c*(n+1)+j])[i]);
+            }
+            ranges[(c*n+i)*2+0] = axis_bin(lo, i);
+            ranges[(c*n+i)*2+1] = axis_bin(hi, i);
+          }
+        }
+
+        bin_offsets.assign(total_bins+1, 0);
+        for (int pass = 0; pass != 2; ++pass)
+        {
+          std::vector<viennagrid_int> position;
+          if (pass == 1)
+          {
+            for (viennagrid_int b = 0; b != total_bins; ++b)
+              bin_offsets[b+1] += bin_offsets[b];
+            bin_cells.resize( bin_offsets[total_bins] );
+            position.assign(bin_offsets.begin(), bin_offsets.end()-1);
+          }
+
+          for (viennagrid_int c = 0; c != count; ++c)
+          {
+            int low[3] = {0, 0, 0};
+            int high[3] = {0, 0, 0};
+            for (int i = 0; i != n; ++i)
+            {
+              low[i] = ranges[(c*n+i)*2+0];
+              high[i] = ranges[(c*n+i)*2+1];
+            }
+
+            int idx[3] = {low[0], low[1], low[2]};
+            while (true)
+            {
+              viennagrid_int bin = linear_bin(idx);
+              if (pass == 0)
+                ++bin_offsets[bin+1];
+              else
+                bin_cells[position[bin]++] = c;
+
+              int i = 0;
+              for (; i != n; ++i)
+              {
+                if (++idx[i] <= high[i])
+                  break;
+                idx[i] = low[i];
+              }
+              if (i == n)
+                break;
+            }
+          }
+        }
+      }
+
+      viennagrid_numeric const * coords;
+      int dim;
+      std::vector<viennagrid_int> cells;
+
+      std::vector<viennagrid_numeric> inverses;
+      std::vector<char> degenerate;
+
+      viennagrid_numeric lower[3];
+      viennagrid_numeric bin_sizes[3];
+      int bin_counts[3];
+      viennagrid_numeric min_bin_size;
+
+      std::vector<viennagrid_int> bin_offsets;
+      std::vector<viennagrid_int> bin_cells;
+    };
+
+
+
+    // Interpolation weights in CSR format, target i is the sum of weights[k] * source value sources[k]
+    // for offsets[i] <= k < offsets[i+1]. Targets without entries get no value.
+    struct weight_table
+    {
+      std::vector<viennagrid_int> offsets;
+      std::vector<viennagrid_int> sources;
+      std::vector<viennagrid_numeric> weights;
+
+      viennagrid_int size() const { return offsets.empty() ? 0 : offsets.size()-1; }
+
+      void assign(std::vector< std::vector< std::pair<viennagrid_int, viennagrid_numeric> > > const & entries)
+      {
+        viennagrid_int count = entries.size();
+        offsets.assign(count+1, 0);
+        for (viennagrid_int i = 0; i != count; ++i)
+          offsets[i+1] = offsets[i] + entries[i].size();
+
+        sources.resize( offsets[count] );
+        weights.resize( offsets[count] );
+
+        #pragma omp parallel for schedule(static)
+        for (viennagrid_int i = 0; i < count; ++i)
+          for (std::size_t k = 0; k != entries[i].size(); ++k)
+          {
+            sources[offsets[i]+k] = entries[i][k].first;
+            weights[offsets[i]+k] = entries[i][k].second;
+          }
+      }
+    };
+
+
+    // locates point and handles points outside the source mesh according to extrapolation, -1 if the point gets no value
+    inline viennagrid_int locate(point_locator const & locator, viennagrid_numeric const * point,
+                                 extrapolation_mode extrapolation, viennagrid_numeric * barycentric)
+    {
+      viennagrid_int cell = locator.locate(point, barycentric);
+      if (cell >= 0 || extrapolation == no_extrapolation)
+        return cell;
+
+      cell = locator.closest(point, barycentric);
+      if (cell >= 0 && extrapolation == nearest_extrapolation)
+      {
+        viennagrid_numeric sum = 0.0;
+        for (int i = 0; i <= locator.dimension(); ++i)
+        {
+          barycentric[i] = std::max<viennagrid_numeric>(barycentric[i], 0.0);
+          sum += barycentric[i];
+        }
+        for (int i = 0; i <= locator.dimension(); ++i)
+          barycentric[i] /= sum;
+      }
+      return cell;
+    }
+
+
+    // Weights of the source vertices for every point (vertex i at points[i*dimension]),
+    // conservative interpolation is not defined for vertex values and uses linear weights.
+    inline void vertex_weights(point_locator const & locator,
+                               viennagrid_numeric const * points, viennagrid_int point_count,
+                               interpolation_mode mode, extrapolation_mode extrapolation,
+                               weight_table & table)
+    {
+      int n = locator.dimension();
+      std::vector< std::vector< std::pair<viennagrid_int, viennagrid_numeric> > > entries(point_count);
+
+      #pragma omp parallel for schedule(dynamic, 256)
+      for (viennagrid_int i = 0; i < point_count; ++i)
+      {
+        viennagrid_numeric lambda[4];
+        viennagrid_int cell = locate(locator, points + i*n, extrapolation, lambda);
+        if (cell < 0)
+          continue;
+
+        viennagrid_int const * vertices = locator.cell_vertices(cell);
+        if (mode == nearest_interpolation)
+        {
+          int nearest = std::max_element(lambda, lambda+n+1) - lambda;
+          entries[i].push_back( std::make_pair(vertices[nearest], 1.0) );
+        }
+        else
+        {
+          for (int j = 0; j <= n; ++j)
+            entries[i].push_back( std::make_pair(vertices[j], lambda[j]) );
+        }
+      }
+
+      table.assign(entries);
+    }
+
+
+    // Weights of the source cells (index into the locator cells) for every destination cell. Cells are given by
+    // their vertex indices cell_vertices[cell_offsets[i]] ... cell_vertices[cell_offsets[i+1]-1] into points.
+    // Conservative interpolation samples simplex cells with sample_level^dimension points of equal volume,
+    // all other modes and cells use the centroid.
+    inline void cell_weights(point_locator const & locator,
+                             viennagrid_numeric const * points,
+                             std::vector<viennagrid_int> const & cell_offsets,
+                             std::vector<viennagrid_int> const & cell_vertices,
+                             interpolation_mode mode, extrapolation_mode extrapolation,
+                             int sample_level,
+                             weight_table & table)
+    {
+      int n = locator.dimension();
+      viennagrid_int cell_count = static_cast<viennagrid_int>(cell_offsets.size()) - 1;
+      std::vector< std::vector< std::pair<viennagrid_int, viennagrid_numeric> > > entries(cell_count);
+
+      int sample_count = 1;
+      for (int i = 0; i != n; ++i)
+        sample_count *= std::max(sample_level, 1);
+
+      #pragma omp parallel
+      {
+        std::vector<viennagrid_int> located;
+        viennagrid_numeric sample[3];
+        viennagrid_numeric lambda[4];
+
+        #pragma omp for schedule(dynamic, 64)
+        for (viennagrid_int c = 0; c < cell_count; ++c)
+        {
+          viennagrid_int const * vertices = &cell_vertices[cell_offsets[c]];
+          int vertex_count = cell_offsets[c+1] - cell_offsets[c];
+          located.clear();
+
+          if (mode == conservative_interpolation && vertex_count == n+1 && sample_count > 1)
+          {
+            // stratified points of the unit cube mapped to the simplex by sorting their coordinates,
+            // this map preserves volume so every sample represents the same part of the cell
+            for (int s = 0; s != sample_count; ++s)
+            {
+              viennagrid_numeric u[3];
+              for (int i = 0, code = s; i != n; ++i, code /= sample_level)
+                u[i] = ((code % sample_level) + 0.5) / sample_level;
+              std::sort(u, u+n);
+
+              viennagrid_numeric b[4];
+              b[0] = u[0];
+              for (int i = 1; i != n; ++i)
+                b[i] = u[i] - u[i-1];
+              b[n] = 1.0 - u[n-1];
+
+              for (int i = 0; i != n; ++i)
+              {
+                sample[i] = 0.0;
+                for (int j = 0; j <= n; ++j)
+                  sample[i] += b[j] * points[vertices[j]*n+i];
+              }
+
+              viennagrid_int cell = locate(locator, sample, extrapolation, lambda);
+              if (cell >= 0)
+                located.push_back(cell);
+            }
+          }
+          else if (vertex_count > 0)
+          {
+            for (int i = 0; i != n; ++i)
+            {
+              sample[i] = 0.0;
+              for (int j = 0; j != vertex_count; ++j)
+                sample[i] += points[vertices[j]*n+i];
+              sample[i] /= vertex_count;
+            }
+
+            viennagrid_int cell = locate(locator, sample, extrapolation, lambda);
+            if (cell >= 0)
+              located.push_back(cell);
+          }
+
+          // samples outside the source mesh are dropped, the others are weighted equally
+          std::sort(located.begin(), located.end());
+          for (std::size_t k = 0; k != located.size(); )
+          {
+            std::size_t next = k;
+            while (next != located.size() && located[next] == located[k])
+              ++next;
+            entries[c].push_back( std::make_pair(located[k], static_cast<viennagrid_numeric>(next-k) / located.size()) );
+            k = next;
+          }
+        }
+      }
+
+      table.assign(entries);
+    }
+
+
+
+    // A quantity field as dense arrays with a validity flag per element
+    struct dense_field
+    {
+      int values_per_quantity;
+      std::vector<viennagrid_numeric> values;
+      std::vector<char> valid;
+
+      viennagrid_int size() const { return valid.size(); }
+    };
+
+    // Applies the table to all fields in one pass over the targets. Invalid source values are skipped and the
+    // remaining weights are renormalized, targets without valid source values are invalid.
+    inline void apply(weight_table const & table, std::vector<dense_field> const & src, std::vector<dense_field> & dst)
+    {
+      viennagrid_int count = table.size();
+      int field_count = src.size();
+
+      dst.resize(field_count);
+      for (int f = 0; f != field_count; ++f)
+      {
+        dst[f].values_per_quantity = src[f].values_per_quantity;
+        dst[f].values.assign(count*src[f].values_per_quantity, 0.0);
+        dst[f].valid.assign(count, 0);
+      }
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int i = 0; i < count; ++i)
+      {
+        for (int f = 0; f != field_count; ++f)
+        {
+          dense_field const & in = src[f];
+          dense_field & out = dst[f];
+          int vpq = in.values_per_quantity;
+          viennagrid_numeric * result = &out.values[0] + i*vpq;
+
+          viennagrid_numeric weight_sum = 0.0;
+          bool all_valid = true;
+          bool any_valid = false;
+          for (viennagrid_int k = table.offsets[i]; k != table.offsets[i+1]; ++k)
+          {
+            viennagrid_int source = table.sources[k];
+            if (source < 0 || source >= in.size() || !in.valid[source])
+            {
+              all_valid = false;
+              continue;
+            }
+
+            viennagrid_numeric weight = table.weights[k];
+            for (int j = 0; j != vpq; ++j)
+              result[j] += weight * in.values[source*vpq+j];
+            weight_sum += weight;
+            any_valid = true;
+          }
+
+          if (!any_valid)
+            continue;
+
+          if (!all_valid && weight_sum != 0.0)
+            for (int j = 0; j != vpq; ++j)
+              result[j] /= weight_sum;
+
+          out.valid[i] = 1;
+        }
+      }
+    }
+  }
+}
+
+#endif
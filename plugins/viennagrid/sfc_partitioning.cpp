@@ -0,0 +1,299 @@
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <limits>
+
+#include "sfc_partitioning.hpp"
+#include "space_filling_curve.hpp"
+
+/* Partitions the cells of a mesh along a space filling curve through the cell centroids, without METIS or MPI.
+
+Inputs:
+  -> "mesh", "region_count" (number of partitions) and "multi_mesh_output" as for metis_mesh_partitioning
+  -> "curve": "hilbert" (default) or "morton"
+  -> "weights": optional cell quantity field with the weight of every cell, parts have equal weight
+  -> "refine": improve the cut by moving cells at partition boundaries (default false), "imbalance_tolerance"
+     is the allowed relative excess weight of a partition (default 0.05), "refinement_passes" the maximum
+     number of passes (default 10)
+
+Outputs:
+  -> "mesh": one mesh per partition with "multi_mesh_output", otherwise the input mesh with the partitions as regions
+  -> "partition_field": cell quantity field "partition" with the partition of every cell of the input mesh
+ */
+
+namespace viennamesh
+{
+
+    sfc_partitioning::sfc_partitioning() {}
+    std::string sfc_partitioning::name() { return "sfc_partitioning"; }
+
+    bool sfc_partitioning::run(viennamesh::algorithm_handle &)
+    {
+        typedef viennagrid::mesh                                                MeshType;
+        typedef viennagrid::result_of::const_cell_range<MeshType>::type         ConstCellRangeType;
+        typedef viennagrid::result_of::iterator<ConstCellRangeType>::type       ConstCellIteratorType;
+
+        typedef viennagrid::result_of::element<MeshType>::type                  ElementType;
+        typedef viennagrid::result_of::const_element_range<ElementType>::type   ConstBoundaryRangeType;
+        typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type   ConstBoundaryIteratorType;
+
+        mesh_handle input_mesh = get_required_input<mesh_handle>("mesh");
+        data_handle<int> region_count = get_required_input<int>("region_count");
+        data_handle<bool> multi_mesh_output = get_input<bool>("multi_mesh_output");
+        quantity_field_handle weight_field = get_input<viennagrid::quantity_field>("weights");
+
+        std::string curve = "hilbert";
+        if ( get_input<viennamesh_string>("curve").valid() )
+            curve = get_input<viennamesh_string>("curve")();
+
+        bool refine = false;
+        if ( get_input<bool>("refine").valid() )
+            refine = get_input<bool>("refine")();
+
+        double imbalance_tolerance = 0.05;
+        if ( get_input<double>("imbalance_tolerance").valid() )
+            imbalance_tolerance = get_input<double>("imbalance_tolerance")();
+
+        int refinement_passes = 10;
+        if ( get_input<int>("refinement_passes").valid() )
+            refinement_passes = get_input<int>("refinement_passes")();
+
+        int part_count = region_count();
+        if (part_count < 1 || (curve != "hilbert" && curve != "morton"))
+        {
+            error(1) << "Invalid partitioning: region_count=" << part_count << " curve=" << curve << std::endl;
+            return false;
+        }
+
+        info(1) << "Using region count " << part_count << " and " << curve << " curve" << std::endl;
+
+
+        viennagrid_dimension geometric_dimension = viennagrid::geometric_dimension( input_mesh() );
+        viennagrid_dimension cell_dimension = viennagrid::cell_dimension( input_mesh() );
+        int vertex_count = viennagrid::vertex_count( input_mesh() );
+
+        viennagrid_numeric * coords = NULL;
+        if (vertex_count > 0)
+            viennagrid_mesh_vertex_coords_pointer(input_mesh().internal(), &coords);
+
+        //cells with their types and vertex indices in CSR format
+        std::vector<viennagrid_element_type> cell_types;
+        coloring::csr_graph cell_vertices;
+        cell_vertices.offsets.push_back(0);
+
+        ConstCellRangeType cells( input_mesh() );
+        cell_types.reserve( cells.size() );
+        cell_vertices.offsets.reserve( cells.size()+1 );
+        for (ConstCellIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+        {
+            cell_types.push_back( (*cit).tag().internal() );
+
+            ConstBoundaryRangeType vertices(*cit, 0);
+            for (ConstBoundaryIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+                cell_vertices.indices.push_back( (*vit).id().index() );
+            cell_vertices.offsets.push_back( cell_vertices.indices.size() );
+        }
+
+        int cell_count = cell_types.size();
+
+        std::vector<double> weights;
+        if (weight_field.valid())
+        {
+            viennagrid::quantity_field field = weight_field();
+            if (field.topologic_dimension() != cell_dimension || field.values_per_quantity() != 1)
+            {
+                error(1) << "Weights have to be a scalar cell quantity field" << std::endl;
+                return false;
+            }
+
+            weights.resize(cell_count, 1.0);
+            for (int i = 0; i < std::min<int>(cell_count, field.size()); ++i)
+            {
+                if (!field.valid(i))
+                    continue;
+
+                void * value;
+                viennagrid_quantity_field_value_get(field.internal(), i, &value);
+                weights[i] = std::max(0.0, *static_cast<viennagrid_numeric const *>(value));
+            }
+        }
+
+
+        //centroids and their bounding box
+        std::vector<double> centroids(3*cell_count, 0.0);
+
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < cell_count; ++i)
+        {
+            int n = cell_vertices.end(i) - cell_vertices.begin(i);
+            for (int const * v = cell_vertices.begin(i); v != cell_vertices.end(i); ++v)
+                for (int j = 0; j < geometric_dimension && j < 3; ++j)
+                    centroids[3*i+j] += coords[geometric_dimension*(*v) + j] / n;
+        }
+
+        double min[3];
+        double max[3];
+        for (int j = 0; j != 3; ++j)
+        {
+            double lo = std::numeric_limits<double>::max();
+            double hi = -std::numeric_limits<double>::max();
+
+            #pragma omp parallel for reduction(min:lo) reduction(max:hi) schedule(static)
+            for (int i = 0; i < cell_count; ++i)
+            {
+                lo = std::min(lo, centroids[3*i+j]);
+                hi = std::max(hi, centroids[3*i+j]);
+            }
+
+            min[j] = lo;
+            max[j] = hi;
+        }
+
+        //cubic box, so the curve does not distort elongated meshes
+        double extent = std::max( std::max(max[0]-min[0], max[1]-min[1]), max[2]-min[2] );
+        for (int j = 0; j != 3; ++j)
+            max[j] = min[j] + extent;
+
+        //curve order of the cells, O(n log n)
+        std::vector< std::pair<boost::uint64_t, int> > keys(cell_count);
+        bool hilbert = (curve == "hilbert");
+
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < cell_count; ++i)
+        {
+            boost::uint32_t x = sfc::quantize(centroids[3*i+0], min[0], max[0]);
+            boost::uint32_t y = sfc::quantize(centroids[3*i+1], min[1], max[1]);
+            boost::uint32_t z = sfc::quantize(centroids[3*i+2], min[2], max[2]);
+            keys[i] = std::make_pair( hilbert ? sfc::hilbert_key(x, y, z) : sfc::morton_key(x, y, z), i );
+        }
+
+        sfc::parallel_sort(keys);
+
+        std::vector<int> order(cell_count);
+        for (int i = 0; i < cell_count; ++i)
+            order[i] = keys[i].second;
+
+        std::vector<int> parts;
+        sfc::split(order, weights, part_count, parts);
+
+
+        if (refine && part_count > 1 && cell_count > 0)
+        {
+            //cells are neighbors if they share a facet, i.e. at least cell_dimension vertices
+            coloring::csr_graph vertex_cells = coloring::transpose(cell_vertices, vertex_count);
+            coloring::csr_graph graph = sfc::shared_adjacency(cell_vertices, vertex_cells, cell_dimension);
+
+            long cut_before = sfc::cut_size(graph, parts);
+            long moved = sfc::refine(graph, weights, part_count, imbalance_tolerance, refinement_passes, parts);
+            long cut_after = sfc::cut_size(graph, parts);
+
+            info(1) << "Refinement moved " << moved << " cells, cut facets " << cut_before << " -> " << cut_after << std::endl;
+        }
+
+
+        mesh_handle output_mesh = make_data<mesh_handle>();
+
+        if ( multi_mesh_output.valid() && multi_mesh_output() )
+        {
+            output_mesh.resize( part_count );
+
+            std::vector<MeshType> part_meshes;
+            for (int p = 0; p != part_count; ++p)
+                part_meshes.push_back( output_mesh(p) );
+
+            //cells of every partition, extraction is linear in the number of cells
+            coloring::csr_graph part_cells = coloring::color_classes(parts, part_count);
+
+            #pragma omp parallel for schedule(dynamic)
+            for (int p = 0; p < part_count; ++p)
+            {
+                int local_cell_count = part_cells.end(p) - part_cells.begin(p);
+                if (local_cell_count == 0)
+                    continue;
+
+                std::vector<int> local_vertices;
+                for (int const * c = part_cells.begin(p); c != part_cells.end(p); ++c)
+                    local_vertices.insert( local_vertices.end(), cell_vertices.begin(*c), cell_vertices.end(*c) );
+                std::sort( local_vertices.begin(), local_vertices.end() );
+                local_vertices.erase( std::unique(local_vertices.begin(), local_vertices.end()), local_vertices.end() );
+
+                std::vector<viennagrid_numeric> local_coords( geometric_dimension * local_vertices.size() );
+                for (std::size_t v = 0; v != local_vertices.size(); ++v)
+                    std::copy( coords + geometric_dimension*local_vertices[v], coords + geometric_dimension*(local_vertices[v]+1),
+                               local_coords.begin() + geometric_dimension*v );
+
+                viennagrid_element_id first_vertex_id;
+                viennagrid_mesh_geometric_dimension_set(part_meshes[p].internal(), geometric_dimension);
+                viennagrid_mesh_vertex_batch_create(part_meshes[p].internal(), local_vertices.size(), &local_coords[0], &first_vertex_id);
+
+                std::vector<viennagrid_element_type> local_types(local_cell_count);
+                std::vector<viennagrid_int> local_offsets(local_cell_count+1, 0);
+                std::vector<viennagrid_element_id> local_cell_vertices;
+                for (int k = 0; k != local_cell_count; ++k)
+                {
+                    int c = part_cells.begin(p)[k];
+                    local_types[k] = cell_types[c];
+                    for (int const * v = cell_vertices.begin(c); v != cell_vertices.end(c); ++v)
+                        local_cell_vertices.push_back( first_vertex_id +
+                            (std::lower_bound(local_vertices.begin(), local_vertices.end(), *v) - local_vertices.begin()) );
+                    local_offsets[k+1] = local_cell_vertices.size();
+                }
+
+                viennagrid_mesh_element_batch_create(part_meshes[p].internal(),
+                                                     local_cell_count, &local_types[0],
+                                                     &local_offsets[0], &local_cell_vertices[0],
+                                                     NULL, NULL);
+            }
+        }
+        else if (vertex_count > 0)
+        {
+            viennagrid_element_id first_vertex_id;
+            viennagrid_mesh_geometric_dimension_set(output_mesh().internal(), geometric_dimension);
+            viennagrid_mesh_vertex_batch_create(output_mesh().internal(), vertex_count, coords, &first_vertex_id);
+
+            for (int p = 0; p != part_count; ++p)
+                output_mesh().get_or_create_region(p);
+
+            if (cell_count > 0)
+            {
+                std::vector<viennagrid_element_id> vertex_ids( cell_vertices.indices.size() );
+                for (std::size_t i = 0; i != vertex_ids.size(); ++i)
+                    vertex_ids[i] = first_vertex_id + cell_vertices.indices[i];
+
+                std::vector<viennagrid_int> offsets( cell_vertices.offsets.begin(), cell_vertices.offsets.end() );
+                std::vector<viennagrid_region_id> region_ids( parts.begin(), parts.end() );
+
+                viennagrid_mesh_element_batch_create(output_mesh().internal(),
+                                                     cell_count, &cell_types[0],
+                                                     &offsets[0], &vertex_ids[0],
+                                                     &region_ids[0], NULL);
+            }
+        }
+
+
+        viennagrid::quantity_field partition_field(cell_dimension, 1);
+        partition_field.set_name("partition");
+        for (int i = 0; i != cell_count; ++i)
+            partition_field.set( viennagrid_compose_element_id(cell_dimension, i), static_cast<viennagrid_numeric>(parts[i]) );
+
+        quantity_field_handle quantities = make_data<viennagrid::quantity_field>();
+        quantities.set(partition_field);
+
+        set_output( "mesh", output_mesh );
+        set_output( "partition_field", quantities );
+
+        return true;
+    }
+
+}
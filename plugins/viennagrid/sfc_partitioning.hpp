@@ -0,0 +1,31 @@
+#ifndef VIENNAMESH_ALGORITHM_VIENNAGRID_SFC_PARTITIONING_HPP
+#define VIENNAMESH_ALGORITHM_VIENNAGRID_SFC_PARTITIONING_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+#include "viennameshpp/plugin.hpp"
+
+namespace viennamesh
+{
+  class sfc_partitioning : public plugin_algorithm
+  {
+  public:
+    sfc_partitioning();
+
+    static std::string name();
+    bool run(viennamesh::algorithm_handle &);
+  };
+}
+
+#endif
\ No newline at end of file
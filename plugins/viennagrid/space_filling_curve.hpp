@@ -0,0 +1,380 @@
+#ifndef VIENNAMESH_ALGORITHM_VIENNAGRID_SPACE_FILLING_CURVE_HPP
+#define VIENNAMESH_ALGORITHM_VIENNAGRID_SPACE_FILLING_CURVE_HPP
+
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <boost/cstdint.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "coloring.hpp"
+
+// Partitioning along space filling curves. Items (usually cell centroids) are ordered by their
+// Morton or Hilbert key, the ordered items are split into parts of equal weight and the cut between
+// the parts can be improved by moving items at part boundaries afterwards.
+namespace viennamesh
+{
+  namespace sfc
+  {
+    // number of bits per coordinate of a key, 3*21 bits fit into 64 bits
+    static const int key_bits = 21;
+
+
+    // spreads the lower 21 bits of x so that there are two zero bits between consecutive bits
+    inline boost::uint64_t spread_bits(boost::uint64_t x)
+    {
+      x &= 0x1fffff;
+      x = (x | x << 32) & 0x1f00000000ffffULL;
+      x = (x | x << 16) & 0x1f0000ff0000ffULL;
+      x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+      x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+      x = (x | x << 2)  & 0x1249249249249249ULL;
+      return x;
+    }
+
+    // bit i of x is bit 3i+2 of the key, x is the most significant coordinate
+    inline boost::uint64_t interleave(boost::uint32_t x, boost::uint32_t y, boost::uint32_t z)
+    {
+      return spread_bits(x) << 2 | spread_bits(y) << 1 | spread_bits(z);
+    }
+
+    inline boost::uint64_t morton_key(boost::uint32_t x, boost::uint32_t y, boost::uint32_t z)
+    {
+      return interleave(x, y, z);
+    }
+
+    // Hilbert index of a point on the 2^21 grid, using Skilling's transpose algorithm
+    // ("Programming the Hilbert curve", AIP Conference Proceedings 707, 2004)
+    inline boost::uint64_t hilbert_key(boost::uint32_t x, boost::uint32_t y, boost::uint32_t z)
+    {
+      boost::uint32_t X[3] = {x, y, z};
+      boost::uint32_t const M = 1u << (key_bits-1);
+
+      // inverse undo excess work
+      for (boost::uint32_t Q = M; Q > 1; Q >>= 1)
+      {
+        boost::uint32_t P = Q - 1;
+        for (int i = 0; i != 3; ++i)
+        {
+          if (X[i] & Q)
+            X[0] ^= P;
+          else
+          {
+            boost::uint32_t t = (X[0] ^ X[i]) & P;
+            X[0] ^= t;
+            X[i] ^= t;
+          }
+        }
+      }
+
+      // gray encode
+      for (int i = 1; i != 3; ++i)
+        X[i] ^= X[i-1];
+      boost::uint32_t t = 0;
+      for (boost::uint32_t Q = M; Q > 1; Q >>= 1)
+        if (X[2] & Q)
+          t ^= Q - 1;
+      for (int i = 0; i != 3; ++i)
+        X[i] ^= t;
+
+      return interleave(X[0], X[1], X[2]);
+    }
+
+
+    // position of value in [min, max] on the 2^21 grid
+    inline boost::uint32_t quantize(double value, double min, double max)
+    {
+      static const double cells = static_cast<double>((1u << key_bits) - 1);
+      if (max <= min)
+        return 0;
+      double scaled = (value - min) / (max - min) * cells;
+      return static_cast<boost::uint32_t>( std::max(0.0, std::min(cells, scaled)) );
+    }
+
+
+
+    // Sorts chunks in parallel and merges them pairwise, O(n log n) work.
+    template<typename T>
+    void parallel_sort(std::vector<T> & values)
+    {
+      long count = values.size();
+
+#ifdef _OPENMP
+      int chunk_count = omp_get_max_threads();
+#else
+      int chunk_count = 1;
+#endif
+      if (chunk_count < 2 || count < 10000)
+      {
+        std::sort(values.begin(), values.end());
+        return;
+      }
+
+      std::vector<long> bounds(chunk_count+1);
+      for (int i = 0; i <= chunk_count; ++i)
+        bounds[i] = count * i / chunk_count;
+
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < chunk_count; ++i)
+        std::sort(values.begin() + bounds[i], values.begin() + bounds[i+1]);
+
+      for (int width = 1; width < chunk_count; width *= 2)
+      {
+        #pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < chunk_count - width; i += 2*width)
+        {
+          long last = bounds[ std::min(i + 2*width, chunk_count) ];
+          std::inplace_merge(values.begin() + bounds[i], values.begin() + bounds[i+width], values.begin() + last);
+        }
+      }
+    }
+
+
+    // Splits items ordered by their curve key into part_count parts of equal weight: an item goes
+    // into the part which contains the center of its weight interval. order[k] is the item at
+    // position k of the curve, weights are per item (empty for unit weights).
+    inline void split(std::vector<int> const & order, std::vector<double> const & weights,
+                      int part_count, std::vector<int> & parts)
+    {
+      long count = order.size();
+      parts.resize(count);
+      if (count == 0)
+        return;
+
+      // prefix sums of the weights in curve order, computed per chunk and offset afterwards
+      std::vector<double> prefix(count);
+
+#ifdef _OPENMP
+      int chunk_count = omp_get_max_threads();
+#else
+      int chunk_count = 1;
+#endif
+      std::vector<double> chunk_sums(chunk_count+1, 0.0);
+
+      #pragma omp parallel for schedule(static)
+      for (int c = 0; c < chunk_count; ++c)
+      {
+        double sum = 0.0;
+        for (long k = count * c / chunk_count; k < count * (c+1) / chunk_count; ++k)
+        {
+          prefix[k] = sum;
+          sum += weights.empty() ? 1.0 : weights[ order[k] ];
+        }
+        chunk_sums[c+1] = sum;
+      }
+
+      for (int c = 0; c != chunk_count; ++c)
+        chunk_sums[c+1] += chunk_sums[c];
+      double total = chunk_sums[chunk_count];
+
+      #pragma omp parallel for schedule(static)
+      for (int c = 0; c < chunk_count; ++c)
+      {
+        for (long k = count * c / chunk_count; k < count * (c+1) / chunk_count; ++k)
+        {
+          double weight = weights.empty() ? 1.0 : weights[ order[k] ];
+          double center = chunk_sums[c] + prefix[k] + weight / 2;
+          int part = (total > 0.0) ? static_cast<int>(center / total * part_count) : 0;
+          parts[ order[k] ] = std::max(0, std::min(part_count-1, part));
+        }
+      }
+    }
+
+
+
+    // Builds the graph of items which share at least shared_count connectors, e.g. cells which
+    // share a facet (cell dimension many vertices). Neighbor lists are sorted.
+    inline coloring::csr_graph shared_adjacency(coloring::csr_graph const & item_connectors,
+                                                coloring::csr_graph const & connector_items,
+                                                int shared_count)
+    {
+      int count = item_connectors.size();
+      std::vector< std::vector<int> > neighbors(count);
+
+      #pragma omp parallel
+      {
+        std::vector<int> candidates;
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < count; ++i)
+        {
+          candidates.clear();
+          for (int const * c = item_connectors.begin(i); c != item_connectors.end(i); ++c)
+            for (int const * j = connector_items.begin(*c); j != connector_items.end(*c); ++j)
+              if (*j != i)
+                candidates.push_back(*j);
+          std::sort(candidates.begin(), candidates.end());
+
+          for (std::size_t k = 0; k != candidates.size(); )
+          {
+            std::size_t next = k;
+            while (next != candidates.size() && candidates[next] == candidates[k])
+              ++next;
+            if (static_cast<int>(next - k) >= shared_count)
+              neighbors[i].push_back(candidates[k]);
+            k = next;
+          }
+        }
+      }
+
+      coloring::csr_graph graph;
+      graph.offsets.assign(count+1, 0);
+      for (int i = 0; i != count; ++i)
+        graph.offsets[i+1] = graph.offsets[i] + neighbors[i].size();
+      graph.indices.resize( graph.offsets[count] );
+
+      #pragma omp parallel for schedule(static)
+      for (int i = 0; i < count; ++i)
+        std::copy(neighbors[i].begin(), neighbors[i].end(), graph.indices.begin() + graph.offsets[i]);
+
+      return graph;
+    }
+
+
+    // number of graph edges between different parts
+    inline long cut_size(coloring::csr_graph const & graph, std::vector<int> const & parts)
+    {
+      long cut = 0;
+      int count = graph.size();
+
+      #pragma omp parallel for reduction(+:cut) schedule(static)
+      for (int i = 0; i < count; ++i)
+        for (int const * j = graph.begin(i); j != graph.end(i); ++j)
+          if (*j > i && parts[*j] != parts[i])
+            ++cut;
+
+      return cut;
+    }
+
+
+    // gain of moving item i into the neighboring part with the most neighbors of i, -1 if i has no
+    // neighbor in another part
+    inline int best_move(coloring::csr_graph const & graph, std::vector<int> const & parts, int i, int & gain)
+    {
+      std::pair<int, int> counts[64];
+      int used = 0;
+      int own = 0;
+
+      for (int const * j = graph.begin(i); j != graph.end(i); ++j)
+      {
+        int part = parts[*j];
+        if (part == parts[i])
+        {
+          ++own;
+          continue;
+        }
+
+        int k = 0;
+        while (k != used && counts[k].first != part)
+          ++k;
+        if (k == used)
+        {
+          if (used == 64)
+            continue;
+          counts[used++] = std::make_pair(part, 0);
+        }
+        ++counts[k].second;
+      }
+
+      int best = -1;
+      gain = 0;
+      for (int k = 0; k != used; ++k)
+        if (best < 0 || counts[k].second - own > gain || (counts[k].second - own == gain && counts[k].first < best))
+        {
+          best = counts[k].first;
+          gain = counts[k].second - own;
+        }
+
+      return best;
+    }
+
+
+    // Greedy boundary refinement: items with a positive gain move into their best neighboring part
+    // as long as that part stays below (1+imbalance_tolerance) times the average part weight. Gains
+    // are computed in parallel, moves are applied in order of decreasing gain and re-checked.
+    // Returns the number of moved items.
+    inline long refine(coloring::csr_graph const & graph, std::vector<double> const & weights,
+                       int part_count, double imbalance_tolerance, int pass_count,
+                       std::vector<int> & parts)
+    {
+      int count = graph.size();
+
+      std::vector<double> part_weights(part_count, 0.0);
+      double total = 0.0;
+      for (int i = 0; i != count; ++i)
+      {
+        double weight = weights.empty() ? 1.0 : weights[i];
+        part_weights[parts[i]] += weight;
+        total += weight;
+      }
+      double max_weight = (1.0 + imbalance_tolerance) * total / part_count;
+
+      long moved = 0;
+      for (int pass = 0; pass != pass_count; ++pass)
+      {
+        std::vector< std::pair<int, int> > candidates;   // (-gain, item)
+
+        #pragma omp parallel
+        {
+          std::vector< std::pair<int, int> > local_candidates;
+
+          #pragma omp for schedule(static) nowait
+          for (int i = 0; i < count; ++i)
+          {
+            int gain;
+            if (best_move(graph, parts, i, gain) >= 0 && gain > 0)
+              local_candidates.push_back( std::make_pair(-gain, i) );
+          }
+
+          #pragma omp critical (viennamesh_sfc_refine_candidates)
+          candidates.insert(candidates.end(), local_candidates.begin(), local_candidates.end());
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+
+        long pass_moved = 0;
+        for (std::size_t c = 0; c != candidates.size(); ++c)
+        {
+          int i = candidates[c].second;
+          int gain;
+          int target = best_move(graph, parts, i, gain);
+          double weight = weights.empty() ? 1.0 : weights[i];
+
+          // parts are never emptied
+          if (target < 0 || gain <= 0 || part_weights[target] + weight > max_weight || part_weights[parts[i]] <= weight)
+            continue;
+
+          part_weights[parts[i]] -= weight;
+          part_weights[target] += weight;
+          parts[i] = target;
+          ++pass_moved;
+        }
+
+        moved += pass_moved;
+        if (pass_moved == 0)
+          break;
+      }
+
+      return moved;
+    }
+  }
+}
+
+#endif
@@ -15,29 +15,523 @@
 #include "uniform_refine.hpp"
 #include "viennagrid/viennagrid.hpp"
 #include "viennagrid/algorithm/refine.hpp"
+#include "viennameshpp/cell_batch.hpp"
+
+#include <algorithm>
 
 namespace viennamesh
 {
 
+  // Flat representation of a simplex mesh (triangles or tetrahedra) which is refined level
+  // by level without building intermediate ViennaGrid meshes.
+  struct simplex_refinement_mesh
+  {
+    int geometric_dimension;
+    int cell_vertex_count;                        // 3 for triangles, 4 for tetrahedra
+
+    std::vector<viennagrid_numeric> coords;
+    std::vector<viennagrid_int> cells;            // cell_vertex_count vertex indices per cell
+    std::vector<viennagrid_int> parent_cells;     // index of the input cell each cell originates from
+
+    viennagrid_int vertex_count() const { return coords.size() / geometric_dimension; }
+    viennagrid_int cell_count() const { return cells.size() / cell_vertex_count; }
+  };
+
+  // A vertex quantity field or a cell quantity field as dense arrays with a validity flag per element
+  struct refinement_quantity
+  {
+    int topologic_dimension;
+    int values_per_quantity;
+    std::string name;
+    viennagrid_quantity_field_storage_layout storage_layout;
+
+    std::vector<viennagrid_numeric> values;
+    std::vector<char> valid;
+  };
+
+
+  namespace
+  {
+    // local edges of a triangle and a tetrahedron
+    int const triangle_edges[3][2] = { {0,1}, {0,2}, {1,2} };
+    int const tetrahedron_edges[6][2] = { {0,1}, {0,2}, {0,3}, {1,2}, {1,3}, {2,3} };
+
+    // children in local indices, 0..2 are the vertices and 3..5 the midpoints of the triangle edges
+    int const triangle_children[4][3] = { {0,3,4}, {3,1,5}, {4,5,2}, {3,5,4} };
+
+    // corner children of a tetrahedron, 0..3 are the vertices and 4..9 the midpoints of the tetrahedron edges
+    int const tetrahedron_corner_children[4][4] = { {0,4,5,6}, {4,1,7,8}, {5,7,2,9}, {6,8,9,3} };
+
+    // the inner octahedron is split along one of its three diagonals into four tetrahedra,
+    // for each diagonal the remaining four midpoints are listed in cyclic order
+    int const octahedron_diagonals[3][2] = { {4,9}, {5,8}, {6,7} };
+    int const octahedron_cycles[3][4] = { {5,7,8,6}, {4,7,9,6}, {4,5,9,8} };
+
+
+    viennagrid_numeric squared_distance(viennagrid_numeric const * p0, viennagrid_numeric const * p1, int dimension)
+    {
+      viennagrid_numeric result = 0;
+      for (int d = 0; d != dimension; ++d)
+        result += (p1[d]-p0[d])*(p1[d]-p0[d]);
+      return result;
+    }
+
+    viennagrid_numeric signed_volume(viennagrid_numeric const * p0, viennagrid_numeric const * p1,
+                                     viennagrid_numeric const * p2, viennagrid_numeric const * p3)
+    {
+      viennagrid_numeric a[3] = { p1[0]-p0[0], p1[1]-p0[1], p1[2]-p0[2] };
+      viennagrid_numeric b[3] = { p2[0]-p0[0], p2[1]-p0[1], p2[2]-p0[2] };
+      viennagrid_numeric c[3] = { p3[0]-p0[0], p3[1]-p0[1], p3[2]-p0[2] };
+
+      return a[0]*(b[1]*c[2]-b[2]*c[1]) - a[1]*(b[0]*c[2]-b[2]*c[0]) + a[2]*(b[0]*c[1]-b[1]*c[0]);
+    }
+  }
+
+
+  // Unique edges of a simplex mesh. Every edge is stored at its smaller vertex, the edges of
+  // vertex v are the sorted targets edge_targets[edge_offsets[v]] ... edge_targets[edge_offsets[v+1]-1]
+  // and the index of an edge is its position in edge_targets.
+  class simplex_edge_table
+  {
+  public:
+
+    simplex_edge_table(simplex_refinement_mesh const & mesh)
+    {
+      viennagrid_int vertex_count = mesh.vertex_count();
+      viennagrid_int cell_count = mesh.cell_count();
+      int edges_per_cell = (mesh.cell_vertex_count == 3) ? 3 : 6;
+      int const (*local_edges)[2] = (mesh.cell_vertex_count == 3) ? triangle_edges : tetrahedron_edges;
+
+      // bucket all cell edges (with duplicates) by their smaller vertex
+      std::vector<viennagrid_int> bucket_offsets(vertex_count+1, 0);
+      for (viennagrid_int c = 0; c != cell_count; ++c)
+      {
+        viennagrid_int const * cell = &mesh.cells[c*mesh.cell_vertex_count];
+        for (int e = 0; e != edges_per_cell; ++e)
+          ++bucket_offsets[ std::min(cell[local_edges[e][0]], cell[local_edges[e][1]]) + 1 ];
+      }
+      for (viennagrid_int v = 0; v != vertex_count; ++v)
+        bucket_offsets[v+1] += bucket_offsets[v];
+
+      std::vector<viennagrid_int> buckets( bucket_offsets[vertex_count] );
+      {
+        std::vector<viennagrid_int> position(bucket_offsets.begin(), bucket_offsets.end()-1);
+        for (viennagrid_int c = 0; c != cell_count; ++c)
+        {
+          viennagrid_int const * cell = &mesh.cells[c*mesh.cell_vertex_count];
+          for (int e = 0; e != edges_per_cell; ++e)
+          {
+            viennagrid_int v0 = cell[local_edges[e][0]];
+            viennagrid_int v1 = cell[local_edges[e][1]];
+            buckets[ position[std::min(v0,v1)]++ ] = std::max(v0,v1);
+          }
+        }
+      }
+
+      // remove duplicates within each bucket and compact
+      edge_offsets.assign(vertex_count+1, 0);
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int v = 0; v < vertex_count; ++v)
+      {
+        viennagrid_int * begin = buckets.data() + bucket_offsets[v];
+        viennagrid_int * end = buckets.data() + bucket_offsets[v+1];
+        std::sort(begin, end);
+        edge_offsets[v+1] = std::unique(begin, end) - begin;
+      }
+
+      for (viennagrid_int v = 0; v != vertex_count; ++v)
+        edge_offsets[v+1] += edge_offsets[v];
+
+      edge_targets.resize( edge_offsets[vertex_count] );
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int v = 0; v < vertex_count; ++v)
+        std::copy( buckets.begin() + bucket_offsets[v],
+                   buckets.begin() + bucket_offsets[v] + (edge_offsets[v+1]-edge_offsets[v]),
+                   edge_targets.begin() + edge_offsets[v] );
+    }
+
+    viennagrid_int size() const { return edge_targets.size(); }
+
+    viennagrid_int index(viennagrid_int v0, viennagrid_int v1) const
+    {
+      if (v1 < v0)
+        std::swap(v0, v1);
+      return std::lower_bound( edge_targets.begin() + edge_offsets[v0], edge_targets.begin() + edge_offsets[v0+1], v1 ) - edge_targets.begin();
+    }
+
+    // the smaller vertex of an edge
+    viennagrid_int source(viennagrid_int edge) const
+    {
+      return std::upper_bound( edge_offsets.begin(), edge_offsets.end(), edge ) - edge_offsets.begin() - 1;
+    }
+
+    viennagrid_int target(viennagrid_int edge) const { return edge_targets[edge]; }
+
+  private:
+    std::vector<viennagrid_int> edge_offsets;
+    std::vector<viennagrid_int> edge_targets;
+  };
+
+
+
+  // Refines every cell into 4 triangles or 8 tetrahedra. The new vertices are the edge midpoints,
+  // vertex quantities are interpolated linearly and cell quantities are injected into the children.
+  void refine_simplex_mesh_uniformly(simplex_refinement_mesh & mesh, std::vector<refinement_quantity> & quantities)
+  {
+    int const dimension = mesh.geometric_dimension;
+    int const cell_vertex_count = mesh.cell_vertex_count;
+    int const edges_per_cell = (cell_vertex_count == 3) ? 3 : 6;
+    int const children_per_cell = (cell_vertex_count == 3) ? 4 : 8;
+    int const (*local_edges)[2] = (cell_vertex_count == 3) ? triangle_edges : tetrahedron_edges;
+
+    viennagrid_int vertex_count = mesh.vertex_count();
+    viennagrid_int cell_count = mesh.cell_count();
+
+    simplex_edge_table edges(mesh);
+    viennagrid_int edge_count = edges.size();
+
+    // vertices: the old ones followed by one midpoint per edge
+    std::vector<viennagrid_numeric> coords( (vertex_count + edge_count) * dimension );
+    std::copy(mesh.coords.begin(), mesh.coords.end(), coords.begin());
+
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int e = 0; e < edge_count; ++e)
+    {
+      viennagrid_numeric const * p0 = &mesh.coords[ edges.source(e)*dimension ];
+      viennagrid_numeric const * p1 = &mesh.coords[ edges.target(e)*dimension ];
+      for (int d = 0; d != dimension; ++d)
+        coords[ (vertex_count+e)*dimension + d ] = (p0[d] + p1[d]) / 2;
+    }
+
+
+    std::vector<viennagrid_int> cells( cell_count * children_per_cell * cell_vertex_count );
+    std::vector<viennagrid_int> parent_cells( cell_count * children_per_cell );
+
+    #pragma omp parallel for schedule(static)
+    for (viennagrid_int c = 0; c < cell_count; ++c)
+    {
+      viennagrid_int const * cell = &mesh.cells[c*cell_vertex_count];
+
+      viennagrid_int local[10];
+      for (int i = 0; i != cell_vertex_count; ++i)
+        local[i] = cell[i];
+      for (int e = 0; e != edges_per_cell; ++e)
+        local[cell_vertex_count+e] = vertex_count + edges.index( cell[local_edges[e][0]], cell[local_edges[e][1]] );
+
+      viennagrid_int * children = &cells[ c*children_per_cell*cell_vertex_count ];
+      for (int i = 0; i != children_per_cell; ++i)
+        parent_cells[c*children_per_cell + i] = mesh.parent_cells[c];
+
+      if (cell_vertex_count == 3)
+      {
+        for (int i = 0; i != 4; ++i)
+          for (int j = 0; j != 3; ++j)
+            children[3*i+j] = local[ triangle_children[i][j] ];
+        continue;
+      }
+
+      for (int i = 0; i != 4; ++i)
+        for (int j = 0; j != 4; ++j)
+          children[4*i+j] = local[ tetrahedron_corner_children[i][j] ];
+
+      // split the octahedron along its shortest diagonal
+      int diagonal = 0;
+      viennagrid_numeric shortest = -1;
+      for (int d = 0; d != 3; ++d)
+      {
+        viennagrid_numeric length = squared_distance( &coords[ local[octahedron_diagonals[d][0]]*dimension ],
+                                                      &coords[ local[octahedron_diagonals[d][1]]*dimension ],
+                                                      dimension );
+        if (shortest < 0 || length < shortest)
+        {
+          shortest = length;
+          diagonal = d;
+        }
+      }
+
+      for (int i = 0; i != 4; ++i)
+      {
+        viennagrid_int * child = children + 16 + 4*i;
+        child[0] = local[ octahedron_diagonals[diagonal][0] ];
+        child[1] = local[ octahedron_diagonals[diagonal][1] ];
+        child[2] = local[ octahedron_cycles[diagonal][i] ];
+        child[3] = local[ octahedron_cycles[diagonal][(i+1)%4] ];
+      }
+
+      // keep the orientation of the parent tetrahedron
+      if (dimension == 3)
+      {
+        bool positive = signed_volume( &coords[cell[0]*3], &coords[cell[1]*3], &coords[cell[2]*3], &coords[cell[3]*3] ) > 0;
+        for (int i = 0; i != 8; ++i)
+        {
+          viennagrid_int * child = children + 4*i;
+          if ( (signed_volume( &coords[child[0]*3], &coords[child[1]*3], &coords[child[2]*3], &coords[child[3]*3] ) > 0) != positive )
+            std::swap(child[2], child[3]);
+        }
+      }
+    }
+
+
+    for (std::size_t q = 0; q != quantities.size(); ++q)
+    {
+      refinement_quantity & quantity = quantities[q];
+      int vpq = quantity.values_per_quantity;
+
+      if (quantity.topologic_dimension == 0)
+      {
+        quantity.values.resize( (vertex_count + edge_count) * vpq, 0 );
+        quantity.valid.resize( vertex_count + edge_count, 0 );
+
+        #pragma omp parallel for schedule(static)
+        for (viennagrid_int e = 0; e < edge_count; ++e)
+        {
+          viennagrid_int v0 = edges.source(e);
+          viennagrid_int v1 = edges.target(e);
+          if (!quantity.valid[v0] || !quantity.valid[v1])
+            continue;
+
+          for (int i = 0; i != vpq; ++i)
+            quantity.values[ (vertex_count+e)*vpq + i ] = (quantity.values[v0*vpq+i] + quantity.values[v1*vpq+i]) / 2;
+          quantity.valid[vertex_count+e] = 1;
+        }
+      }
+      else
+      {
+        std::vector<viennagrid_numeric> values( cell_count * children_per_cell * vpq );
+        std::vector<char> valid( cell_count * children_per_cell );
+
+        #pragma omp parallel for schedule(static)
+        for (viennagrid_int c = 0; c < cell_count; ++c)
+          for (int i = 0; i != children_per_cell; ++i)
+          {
+            viennagrid_int child = c*children_per_cell + i;
+            valid[child] = quantity.valid[c];
+            std::copy( quantity.values.begin() + c*vpq, quantity.values.begin() + (c+1)*vpq, values.begin() + child*vpq );
+          }
+
+        quantity.values.swap(values);
+        quantity.valid.swap(valid);
+      }
+    }
+
+    mesh.coords.swap(coords);
+    mesh.cells.swap(cells);
+    mesh.parent_cells.swap(parent_cells);
+  }
+
+
+
+
   uniform_refine::uniform_refine() {}
   std::string uniform_refine::name() { return "uniform_refine"; }
 
 
   bool uniform_refine::run(viennamesh::algorithm_handle &)
   {
+    typedef viennagrid::mesh                                                      MeshType;
+    typedef viennagrid::result_of::const_element_range<MeshType>::type           ConstElementRangeType;
+    typedef viennagrid::result_of::iterator<ConstElementRangeType>::type         ConstElementIteratorType;
+    typedef viennagrid::result_of::element<MeshType>::type                       ElementType;
+    typedef viennagrid::result_of::const_element_range<ElementType>::type        ConstBoundaryRangeType;
+    typedef viennagrid::result_of::iterator<ConstBoundaryRangeType>::type        ConstBoundaryIteratorType;
+    typedef viennagrid::result_of::const_region_range<MeshType>::type            ConstRegionRangeType;
+    typedef viennagrid::result_of::iterator<ConstRegionRangeType>::type          ConstRegionIteratorType;
+    typedef viennagrid::result_of::region_range<ElementType>::type               CellRegionRangeType;
+    typedef viennagrid::result_of::iterator<CellRegionRangeType>::type           CellRegionIteratorType;
+
     mesh_handle input_mesh = get_required_input<mesh_handle>("mesh");
     if (!input_mesh.valid())
       return false;
 
+    quantity_field_handle input_quantity_fields = get_input<viennagrid::quantity_field>("quantities");
+
+    int levels = 1;
+    if ( get_input<int>("levels").valid() )
+      levels = get_input<int>("levels")();
+
+    if (levels < 0)
+    {
+      error(1) << "Number of refinement levels is negative: " << levels << std::endl;
+      return false;
+    }
+
     mesh_handle output_mesh = make_data<mesh_handle>();
 
     if (output_mesh == input_mesh)
       return false;
 
-    viennagrid::cell_refine_uniformly(input_mesh(), output_mesh());
+
+    int cell_dimension = viennagrid::cell_dimension( input_mesh() );
+    ConstElementRangeType cells( input_mesh(), cell_dimension );
+
+    bool is_simplex_mesh = (cell_dimension == 2 || cell_dimension == 3);
+    viennagrid_element_type simplex_type = (cell_dimension == 2) ? VIENNAGRID_ELEMENT_TYPE_TRIANGLE : VIENNAGRID_ELEMENT_TYPE_TETRAHEDRON;
+    for (ConstElementIteratorType cit = cells.begin(); is_simplex_mesh && cit != cells.end(); ++cit)
+      is_simplex_mesh = ( (*cit).tag().internal() == simplex_type );
+
+    // other cell types are refined level by level with ViennaGrid, quantities are not supported there
+    if (!is_simplex_mesh)
+    {
+      if (input_quantity_fields.valid())
+        warning(1) << "Quantity fields are only prolonged for triangle and tetrahedral meshes, they are dropped" << std::endl;
+
+      if (levels == 0)
+      {
+        set_output( "mesh", input_mesh );
+        return true;
+      }
+
+      viennagrid::mesh current = input_mesh();
+      for (int level = 1; level < levels; ++level)
+      {
+        viennagrid::mesh refined;
+        viennagrid::cell_refine_uniformly(current, refined);
+        current = refined;
+      }
+
+      viennagrid::cell_refine_uniformly(current, output_mesh());
+
+      set_output( "mesh", output_mesh );
+      return true;
+    }
+
+
+    simplex_refinement_mesh mesh;
+    mesh.geometric_dimension = viennagrid::geometric_dimension( input_mesh() );
+    mesh.cell_vertex_count = cell_dimension + 1;
+
+    viennagrid_int vertex_count = viennagrid::vertex_count( input_mesh() );
+    if (vertex_count > 0)
+    {
+      viennagrid_numeric * coords;
+      viennagrid_mesh_vertex_coords_pointer(input_mesh().internal(), &coords);
+      mesh.coords.assign(coords, coords + vertex_count*mesh.geometric_dimension);
+    }
+
+    // regions of the input cells in CSR format, refined cells keep the regions of their input cell
+    std::vector<viennagrid_int> cell_region_offsets(1, 0);
+    std::vector<viennagrid_region_id> cell_region_ids;
+
+    mesh.cells.reserve( cells.size()*mesh.cell_vertex_count );
+    mesh.parent_cells.reserve( cells.size() );
+    for (ConstElementIteratorType cit = cells.begin(); cit != cells.end(); ++cit)
+    {
+      ConstBoundaryRangeType vertices(*cit, 0);
+      for (ConstBoundaryIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+        mesh.cells.push_back( (*vit).id().index() );
+      mesh.parent_cells.push_back( mesh.parent_cells.size() );
+
+      CellRegionRangeType cell_regions(*cit);
+      for (CellRegionIteratorType rit = cell_regions.begin(); rit != cell_regions.end(); ++rit)
+        cell_region_ids.push_back( (*rit).id() );
+      cell_region_offsets.push_back( cell_region_ids.size() );
+    }
+
+
+    std::vector<refinement_quantity> quantities;
+    for (int i = 0; input_quantity_fields.valid() && i != input_quantity_fields.size(); ++i)
+    {
+      viennagrid::quantity_field field = input_quantity_fields(i);
+      if (field.topologic_dimension() != 0 && field.topologic_dimension() != cell_dimension)
+      {
+        warning(1) << "Quantity field \"" << field.get_name() << "\" is neither a vertex nor a cell field, it is dropped" << std::endl;
+        continue;
+      }
+
+      refinement_quantity quantity;
+      quantity.topologic_dimension = field.topologic_dimension();
+      quantity.values_per_quantity = field.values_per_quantity();
+      quantity.name = field.get_name();
+      quantity.storage_layout = field.storage_layout();
+
+      viennagrid_int size = (quantity.topologic_dimension == 0) ? mesh.vertex_count() : mesh.cell_count();
+      quantity.values.resize( size*quantity.values_per_quantity, 0 );
+      quantity.valid.resize( size, 0 );
+
+      for (viennagrid_int j = 0; j < std::min<viennagrid_int>(size, field.size()); ++j)
+      {
+        if (!field.valid(j))
+          continue;
+
+        void * value;
+        viennagrid_quantity_field_value_get(field.internal(), j, &value);
+        std::copy( static_cast<viennagrid_numeric const *>(value), static_cast<viennagrid_numeric const *>(value) + quantity.values_per_quantity,
+                   quantity.values.begin() + j*quantity.values_per_quantity );
+        quantity.valid[j] = 1;
+      }
+
+      quantities.push_back(quantity);
+    }
+
+
+    for (int level = 0; level != levels; ++level)
+    {
+      refine_simplex_mesh_uniformly(mesh, quantities);
+      info(1) << "Refinement level " << level+1 << ": " << mesh.vertex_count() << " vertices, " << mesh.cell_count() << " cells" << std::endl;
+    }
+
+
+    ConstRegionRangeType regions( input_mesh() );
+    for (ConstRegionIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
+      output_mesh().get_or_create_region( (*rit).id() ).set_name( (*rit).get_name() );
+
+    viennagrid_mesh_geometric_dimension_set(output_mesh().internal(), mesh.geometric_dimension);
+
+    viennagrid_element_id first_vertex_id = 0;
+    if (mesh.vertex_count() > 0)
+      viennagrid_mesh_vertex_batch_create(output_mesh().internal(), mesh.vertex_count(), &mesh.coords[0], &first_vertex_id);
+
+    viennagrid_int cell_count = mesh.cell_count();
+    if (cell_count > 0)
+    {
+      std::vector<viennagrid_element_type> cell_types(cell_count, simplex_type);
+      std::vector<viennagrid_int> cell_vertex_offsets(cell_count+1);
+      std::vector<viennagrid_element_id> cell_vertices( mesh.cells.size() );
+
+      #pragma omp parallel for schedule(static)
+      for (viennagrid_int c = 0; c < cell_count; ++c)
+      {
+        cell_vertex_offsets[c+1] = (c+1)*mesh.cell_vertex_count;
+        for (int j = 0; j != mesh.cell_vertex_count; ++j)
+          cell_vertices[c*mesh.cell_vertex_count+j] = first_vertex_id + mesh.cells[c*mesh.cell_vertex_count+j];
+      }
+      cell_vertex_offsets[0] = 0;
+
+      // refined cells have the regions of their input cell
+      batch_create_cells(output_mesh(), cell_count, &cell_types[0], &cell_vertex_offsets[0], &cell_vertices[0],
+                         &cell_region_offsets[0], cell_region_ids.empty() ? NULL : &cell_region_ids[0],
+                         &mesh.parent_cells[0]);
+    }
 
     set_output( "mesh", output_mesh );
 
+
+    if (input_quantity_fields.valid())
+    {
+      quantity_field_handle output_quantity_fields = make_data<viennagrid::quantity_field>();
+      output_quantity_fields.resize( quantities.size() );
+
+      for (std::size_t i = 0; i != quantities.size(); ++i)
+      {
+        refinement_quantity & quantity = quantities[i];
+
+        viennagrid::quantity_field field(quantity.topologic_dimension, quantity.values_per_quantity, quantity.storage_layout);
+        field.set_name( quantity.name );
+
+        for (std::size_t j = 0; j != quantity.valid.size(); ++j)
+        {
+          if (quantity.valid[j])
+            viennagrid_quantity_field_value_set(field.internal(), j, &quantity.values[j*quantity.values_per_quantity]);
+        }
+
+        output_quantity_fields.set(i, field);
+      }
+
+      set_output( "quantities", output_quantity_fields );
+    }
+
     return true;
   }
 
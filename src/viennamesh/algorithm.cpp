@@ -1,5 +1,9 @@
+#include <sstream>
+#include <sys/stat.h>
+
 #include "algorithm.hpp"
 #include "context.hpp"
+#include "profiler.hpp"
 
 void input_parameter::unset()
 {
@@ -50,9 +54,83 @@ void viennamesh_algorithm_wrapper_t::init()
 }
 
 
+namespace
+{
+  // type and size of data for profiling, meshes are described by their vertex and cell counts
+  std::string describe_data(viennamesh_data_wrapper data)
+  {
+    std::ostringstream ss;
+    ss << data->type_name();
+
+    if (data->type_name() == "viennagrid_mesh")
+    {
+      for (int i = 0; i != data->size(); ++i)
+      {
+        viennagrid_mesh mesh = *static_cast<viennagrid_mesh *>( data->data(i) );
+
+        viennagrid_element_id * begin;
+        viennagrid_element_id * end;
+        viennagrid_mesh_elements_get(mesh, 0, &begin, &end);
+        ss << " (" << (end-begin) << " vertices";
+
+        for (viennagrid_dimension dimension = 3; dimension > 0; --dimension)
+        {
+          viennagrid_mesh_elements_get(mesh, dimension, &begin, &end);
+          if (begin != end)
+          {
+            ss << ", " << (end-begin) << " cells of dimension " << static_cast<int>(dimension);
+            break;
+          }
+        }
+        ss << ")";
+      }
+    }
+    else if (data->size() != 1)
+      ss << " [" << data->size() << "]";
+
+    return ss.str();
+  }
+}
+
+
 void viennamesh_algorithm_wrapper_t::run()
 {
-  algorithm_template()->run(this);
+  viennamesh::backend::profiler & profiler = viennamesh::backend::get_profiler();
+  if (!profiler.begin(type(), "algorithm"))
+  {
+    algorithm_template()->run(this);
+    return;
+  }
+
+  for (InputMapType::const_iterator it = inputs.begin(); it != inputs.end(); ++it)
+  {
+    viennamesh_data_wrapper input = it->second.unpack();
+    if (input)
+      profiler.add_argument("input " + it->first, describe_data(input));
+  }
+
+  if (default_source)
+  {
+    for (OutputMapType::const_iterator it = default_source->outputs.begin(); it != default_source->outputs.end(); ++it)
+      if (inputs.find(it->first) == inputs.end())
+        profiler.add_argument("input " + it->first, describe_data(it->second));
+  }
+
+  try
+  {
+    algorithm_template()->run(this);
+  }
+  catch (...)
+  {
+    profiler.add_argument("failed", "true");
+    profiler.end();
+    throw;
+  }
+
+  for (OutputMapType::const_iterator it = outputs.begin(); it != outputs.end(); ++it)
+    profiler.add_argument("output " + it->first, describe_data(it->second));
+
+  profiler.end();
 }
 
 viennamesh_context viennamesh_algorithm_wrapper_t::context()
@@ -65,6 +143,11 @@ std::string const & viennamesh_algorithm_wrapper_t::type()
   return algorithm_template()->type();
 }
 
+std::string const & viennamesh_algorithm_wrapper_t::build_id()
+{
+  return algorithm_template()->build_id();
+}
+
 void viennamesh_algorithm_wrapper_t::delete_this()
 {
 #ifdef VIENNAMESH_BACKEND_RETAIN_RELEASE_LOGGING
@@ -143,7 +226,26 @@ viennamesh_data_wrapper viennamesh_algorithm_wrapper_t::get_input(std::string co
 
   viennamesh::backend::info(1) << "Requested input \"" << name << "\" of type \"" << type_name << "\" but input is of type \"" << input->type_name() << "\"";
 
-  viennamesh_data_wrapper result = context()->convert_to(input, type_name);
+  viennamesh::backend::profiler & profiler = viennamesh::backend::get_profiler();
+  bool profiled = profiler.begin("convert " + input->type_name() + " to " + type_name, "conversion");
+
+  viennamesh_data_wrapper result = 0;
+  try
+  {
+    result = context()->convert_to(input, type_name);
+  }
+  catch (...)
+  {
+    if (profiled)
+      profiler.end();
+    throw;
+  }
+
+  if (profiled)
+  {
+    profiler.add_argument("input", name);
+    profiler.end();
+  }
 
   viennamesh::backend::info(1) << "; conversion: " << ((result)?"success":"failed") << std::endl;
 
@@ -196,3 +298,35 @@ viennamesh_data_wrapper viennamesh_algorithm_wrapper_t::get_output(std::string c
 
   return context()->convert_to(it->second, type_name);
 }
+
+std::string const & viennamesh_algorithm_wrapper_t::output_name(int index) const
+{
+  if (index < 0 || index >= output_count())
+    VIENNAMESH_ERROR(VIENNAMESH_ERROR_INVALID_ARGUMENT, "viennamesh_algorithm_wrapper_t::output_name invalid index: " + boost::lexical_cast<std::string>(index));
+
+  OutputMapType::const_iterator it = outputs.begin();
+  std::advance(it, index);
+  return it->first;
+}
+
+
+namespace viennamesh
+{
+  std::string make_build_id(viennamesh_algorithm_run_function function)
+  {
+    std::ostringstream ss;
+    ss << VIENNAMESH_VERSION;
+
+    Dl_info info;
+    if ( function && dladdr((void*)function, &info) && info.dli_fname )
+    {
+      ss << " " << info.dli_fname;
+
+      struct stat file_stat;
+      if ( stat(info.dli_fname, &file_stat) == 0 )
+        ss << " " << file_stat.st_size << " " << file_stat.st_mtime;
+    }
+
+    return ss.str();
+  }
+}
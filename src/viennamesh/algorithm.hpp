@@ -2,6 +2,7 @@
 #define _VIENNAMESH_BACKEND_ALGORITHM_HPP_
 
 #include <iostream>
+#include <atomic>
 #include "data.hpp"
 
 class input_parameter
@@ -63,11 +64,14 @@ public:
   viennamesh_data_wrapper get_output(std::string const & name);
   viennamesh_data_wrapper get_output(std::string const & name,
                                      std::string const & type_name);
+  int output_count() const { return outputs.size(); }
+  std::string const & output_name(int index) const;
 
   viennamesh_algorithm internal_algorithm() { return internal_algorithm_; }
   void set_internal_algorithm(viennamesh_algorithm internal_algorithm_in) { internal_algorithm_ = internal_algorithm_in; }
   viennamesh::algorithm_template algorithm_template() { return algorithm_template_; }
   std::string const & type();
+  std::string const & build_id();
   viennamesh_context context();
 
   void retain() { ++use_count_; }
@@ -120,12 +124,16 @@ private:
   OutputMapType outputs;
 
   void delete_this();
-  mutable int use_count_;
+  std::atomic<int> use_count_;
 };
 
 
 namespace viennamesh
 {
+  // identifies the build of the library providing function, based on the library file's path, size and
+  // modification time and on the ViennaMesh version
+  std::string make_build_id(viennamesh_algorithm_run_function function);
+
   class algorithm_template_t
   {
   public:
@@ -143,6 +151,8 @@ namespace viennamesh
 
       init_function_ = init_function_in;
       run_function_ = run_function_in;
+
+      build_id_ = make_build_id(run_function_in);
     }
 
     viennamesh_algorithm make_algorithm() const
@@ -173,12 +183,14 @@ namespace viennamesh
 
     viennamesh_context context() { return context_; }
     std::string const & type() const { return algorithm_type_; }
+    std::string const & build_id() const { return build_id_; }
     void set_context(viennamesh_context context_in) { context_ = context_in; }
 
   private:
     viennamesh_context context_;
 
     std::string algorithm_type_;
+    std::string build_id_;
 
     viennamesh_algorithm_make_function make_function_;
     viennamesh_algorithm_delete_function delete_function_;
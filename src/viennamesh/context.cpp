@@ -20,11 +20,16 @@ viennamesh_context_t::~viennamesh_context_t()
 
 
 
-int viennamesh_context_t::registered_data_type_count() const { return data_types.size(); }
+int viennamesh_context_t::registered_data_type_count() const
+{
+  viennamesh::backend::read_lock lock(registry_mutex);
+  return data_types.size();
+}
 
 std::string const & viennamesh_context_t::registered_data_type_name(int index_) const
 {
-  if (index_ < 0 || index_ >= registered_data_type_count())
+  viennamesh::backend::read_lock lock(registry_mutex);
+  if (index_ < 0 || index_ >= static_cast<int>(data_types.size()))
     VIENNAMESH_ERROR(VIENNAMESH_ERROR_INVALID_ARGUMENT, "viennamesh_context_t::registered_data_type_name invalid index: " + boost::lexical_cast<std::string>(index_));
 
   std::map<std::string, viennamesh::data_template_t>::const_iterator it = data_types.begin();
@@ -33,6 +38,12 @@ std::string const & viennamesh_context_t::registered_data_type_name(int index_)
 }
 
 viennamesh::data_template_t & viennamesh_context_t::get_data_type(std::string const & data_type_name_)
+{
+  viennamesh::backend::read_lock lock(registry_mutex);
+  return find_data_type(data_type_name_);
+}
+
+viennamesh::data_template_t & viennamesh_context_t::find_data_type(std::string const & data_type_name_)
 {
   std::map<std::string, viennamesh::data_template_t>::iterator it = data_types.find(data_type_name_);
   if (it == data_types.end())
@@ -48,14 +59,18 @@ void viennamesh_context_t::register_data_type(std::string const & data_type_name
   if (data_type_name_.empty())
     VIENNAMESH_ERROR(VIENNAMESH_ERROR_INVALID_ARGUMENT, "data_type_name_ is empty");
 
-  std::map<std::string, viennamesh::data_template_t>::iterator it = data_types.find(data_type_name_);
-  if (it == data_types.end())
   {
-    // TODO logging
-    it = data_types.insert( std::make_pair(data_type_name_, viennamesh::data_template_t()) ).first;
-    it->second.name() = data_type_name_;
-    it->second.set_context(this);
-    it->second.set_make_delete_function(make_function_, delete_function_);
+    viennamesh::backend::write_lock lock(registry_mutex);
+
+    std::map<std::string, viennamesh::data_template_t>::iterator it = data_types.find(data_type_name_);
+    if (it == data_types.end())
+    {
+      // TODO logging
+      it = data_types.insert( std::make_pair(data_type_name_, viennamesh::data_template_t()) ).first;
+      it->second.name() = data_type_name_;
+      it->second.set_context(this);
+      it->second.set_make_delete_function(make_function_, delete_function_);
+    }
   }
 
   viennamesh::backend::info(10) << "Data type \"" << data_type_name_ << "\" sucessfully registered" << std::endl;
@@ -79,11 +94,26 @@ void viennamesh_context_t::register_conversion_function(std::string const & data
                                   std::string const & data_type_to,
                                   viennamesh_data_convert_function convert_function)
 {
-  get_data_type(data_type_from).add_conversion_function(data_type_to, convert_function);
+  {
+    viennamesh::backend::write_lock lock(registry_mutex);
+    find_data_type(data_type_from).add_conversion_function(data_type_to, convert_function);
+  }
 
   viennamesh::backend::info(10) << "Conversion function from data type \"" << data_type_from << "\" to data type \"" << data_type_to << "\" sucessfully registered" << std::endl;
 }
 
+void viennamesh_context_t::register_container_conversion_function(std::string const & data_type_from,
+                                  std::string const & data_type_to,
+                                  viennamesh_data_container_convert_function convert_function)
+{
+  {
+    viennamesh::backend::write_lock lock(registry_mutex);
+    find_data_type(data_type_from).add_container_conversion_function(data_type_to, convert_function);
+  }
+
+  viennamesh::backend::info(10) << "Container conversion function from data type \"" << data_type_from << "\" to data type \"" << data_type_to << "\" sucessfully registered" << std::endl;
+}
+
 void viennamesh_context_t::convert(viennamesh_data_wrapper from, viennamesh_data_wrapper to)
 {
   if (from->context() != to->context())
@@ -91,7 +121,13 @@ void viennamesh_context_t::convert(viennamesh_data_wrapper from, viennamesh_data
 
   std::string from_data_type_name = from->type_name();
 
-  get_data_type(from_data_type_name).convert( from, to );
+  viennamesh::data_template_t::conversion convert_function;
+  {
+    viennamesh::backend::read_lock lock(registry_mutex);
+    convert_function = find_data_type(from_data_type_name).conversion_function( from, to );
+  }
+
+  viennamesh::data_template_t::convert( convert_function, from, to );
 }
 
 viennamesh_data_wrapper viennamesh_context_t::convert_to(viennamesh_data_wrapper from,
@@ -104,6 +140,7 @@ viennamesh_data_wrapper viennamesh_context_t::convert_to(viennamesh_data_wrapper
 
 viennamesh::algorithm_template viennamesh_context_t::get_algorithm_template(std::string const & algorithm_name_)
 {
+  viennamesh::backend::read_lock lock(registry_mutex);
   std::map<std::string, viennamesh::algorithm_template_t>::iterator it = algorithm_templates.find(algorithm_name_);
   if (it == algorithm_templates.end())
     VIENNAMESH_ERROR(VIENNAMESH_ERROR_ALGORITHM_NOT_REGISTERED, "Algorithm \"" + algorithm_name_ + "\" not registered");
@@ -150,8 +187,13 @@ viennamesh_plugin viennamesh_context_t::load_plugin(std::string const & plugin_f
     return 0;
   }
 
+  // plugin initialization registers data types and algorithms and takes the registry lock itself
   init_function( this );
-  loaded_plugins.insert(dl);
+
+  {
+    viennamesh::backend::write_lock lock(registry_mutex);
+    loaded_plugins.insert(dl);
+  }
 
 //   viennamesh::backend::info(1) << "Plugin \"" << plugin_filename << "\" successfully loaded" << std::endl;
 
@@ -2,9 +2,14 @@
 #define _VIENNAMESH_BACKEND_CONTEXT_HPP_
 
 #include <set>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <dlfcn.h>
 
 #include "forwards.hpp"
+#include "locks.hpp"
 #include "data.hpp"
 #include "algorithm.hpp"
 #include "logger.hpp"
@@ -35,6 +40,10 @@ public:
                                     std::string const & data_type_to,
                                     viennamesh_data_convert_function convert_function);
 
+  void register_container_conversion_function(std::string const & data_type_from,
+                                              std::string const & data_type_to,
+                                              viennamesh_data_container_convert_function convert_function);
+
 
   void convert(viennamesh_data_wrapper from, viennamesh_data_wrapper to);
   viennamesh_data_wrapper convert_to(viennamesh_data_wrapper from,
@@ -51,15 +60,19 @@ public:
                           viennamesh_algorithm_init_function init_function,
                           viennamesh_algorithm_run_function run_function)
   {
-    std::map<std::string, viennamesh::algorithm_template_t>::iterator it = algorithm_templates.find(algorithm_id);
-    if (it != algorithm_templates.end())
-      VIENNAMESH_ERROR(VIENNAMESH_ERROR_ALGORITHM_ALREADY_REGISTERED, "Algorithm \"" + algorithm_id + "\" already registered");
+    {
+      viennamesh::backend::write_lock lock(registry_mutex);
 
-    viennamesh::algorithm_template_t & algorithm_template = algorithm_templates[algorithm_id];
-    algorithm_template.set_context(this);
-    algorithm_template.init(algorithm_id,
-                            make_function, delete_function,
-                            init_function, run_function);
+      std::map<std::string, viennamesh::algorithm_template_t>::iterator it = algorithm_templates.find(algorithm_id);
+      if (it != algorithm_templates.end())
+        VIENNAMESH_ERROR(VIENNAMESH_ERROR_ALGORITHM_ALREADY_REGISTERED, "Algorithm \"" + algorithm_id + "\" already registered");
+
+      viennamesh::algorithm_template_t & algorithm_template = algorithm_templates[algorithm_id];
+      algorithm_template.set_context(this);
+      algorithm_template.init(algorithm_id,
+                              make_function, delete_function,
+                              init_function, run_function);
+    }
 
     viennamesh::backend::info(10) << "Algorithm \"" << algorithm_id << "\" sucessfully registered" << std::endl;
   }
@@ -81,21 +94,23 @@ public:
     delete algorithm;
   }
 
-  viennamesh_error error_code() const { return error_code_; }
-  std::string const & error_function() const { return error_function_; };
-  std::string const & error_file() const  { return error_file_; };
-  int error_line() const { return error_line_; }
-  std::string const & error_message() const { return error_message_; }
+  // the error state is kept per thread, concurrent pipelines on one context do not overwrite each others errors
+  viennamesh_error error_code() const { return current_error().code; }
+  std::string const & error_function() const { return current_error().function; };
+  std::string const & error_file() const  { return current_error().file; };
+  int error_line() const { return current_error().line; }
+  std::string const & error_message() const { return current_error().message; }
 
   void set_error(viennamesh_error error_code_in,
                  std::string const & function_in, std::string const & file_in, int line_in,
                  std::string const & error_message_in)
   {
-    error_code_ = error_code_in;
-    error_function_ = function_in;
-    error_file_ = file_in;
-    error_line_ = line_in;
-    error_message_ = error_message_in;
+    error_state & error = thread_error();
+    error.code = error_code_in;
+    error.function = function_in;
+    error.file = file_in;
+    error.line = line_in;
+    error.message = error_message_in;
     viennamesh::backend::error(1) << error_message() << std::endl;
   }
 
@@ -104,13 +119,11 @@ public:
     set_error( ex.error_code(), ex.function(), ex.file(), ex.line(), ex.what() );
   }
 
+  // removes the error state of the calling thread, only threads with an uncleared error have an entry
   void clear_error()
   {
-    error_code_ = VIENNAMESH_SUCCESS;
-    error_function_.clear();
-    error_file_.clear();
-    error_line_ = -1;
-    error_message_.clear();
+    std::lock_guard<std::mutex> lock(error_mutex);
+    error_states.erase(std::this_thread::get_id());
   }
 
 
@@ -133,11 +146,42 @@ public:
   }
 
 private:
-  viennamesh_error error_code_;
-  std::string error_function_;
-  std::string error_file_;
-  int error_line_;
-  std::string error_message_;
+  struct error_state
+  {
+    error_state() : code(VIENNAMESH_SUCCESS), line(-1) {}
+
+    viennamesh_error code;
+    std::string function;
+    std::string file;
+    int line;
+    std::string message;
+  };
+
+  // entries of a std::map are never moved, a thread may use its entry while others are inserted or erased
+  error_state & thread_error()
+  {
+    std::lock_guard<std::mutex> lock(error_mutex);
+    return error_states[std::this_thread::get_id()];
+  }
+
+  // does not create an entry, threads without an error get the default state
+  error_state const & current_error() const
+  {
+    static const error_state no_error;
+
+    std::lock_guard<std::mutex> lock(error_mutex);
+    std::map<std::thread::id, error_state>::const_iterator it = error_states.find(std::this_thread::get_id());
+    return (it != error_states.end()) ? it->second : no_error;
+  }
+
+  std::map<std::thread::id, error_state> error_states;
+  mutable std::mutex error_mutex;
+
+  viennamesh::data_template_t & find_data_type(std::string const & data_type_name_);
+
+  // guards data_types, algorithm_templates and loaded_plugins, which are written when plugins
+  // are loaded and read by every pipeline
+  mutable viennamesh::backend::read_write_mutex registry_mutex;
 
   std::map<std::string, viennamesh::data_template_t> data_types;
   std::map<std::string, viennamesh::algorithm_template_t> algorithm_templates;
@@ -152,7 +196,7 @@ private:
 
   std::set<viennamesh_plugin> loaded_plugins;
 
-  int use_count_;
+  std::atomic<int> use_count_;
 };
 
 
@@ -6,6 +6,7 @@
 #include <map>
 #include <string>
 #include <iostream>
+#include <atomic>
 
 #include "forwards.hpp"
 #include "viennamesh/cpp_error.hpp"
@@ -70,7 +71,7 @@ private:
   void release_internal_data();
 
   void delete_this();
-  int use_count_;
+  std::atomic<int> use_count_;
 };
 
 
@@ -115,8 +116,36 @@ namespace viennamesh
       convert_functions[to_data_type] = convert_function;
     }
 
-    void convert(viennamesh_data_wrapper from, viennamesh_data_wrapper to) const
+    void add_container_conversion_function(std::string const & to_data_type,
+                                           viennamesh_data_container_convert_function convert_function)
     {
+      container_convert_functions[to_data_type] = convert_function;
+    }
+
+
+    // a container conversion converts all elements of a data wrapper at once and is preferred
+    // over an elementwise conversion to the same data type
+    struct conversion
+    {
+      conversion() : element_function(0), container_function(0) {}
+
+      viennamesh_data_convert_function element_function;
+      viennamesh_data_container_convert_function container_function;
+    };
+
+    // the conversion function is looked up under the registry lock of the context,
+    // the conversion itself runs without holding it
+    conversion conversion_function(viennamesh_data_wrapper from, viennamesh_data_wrapper to) const
+    {
+      conversion result;
+
+      ContainerConvertFunctionMap::const_iterator cit = container_convert_functions.find( to->type_name() );
+      if (cit != container_convert_functions.end())
+      {
+        result.container_function = cit->second;
+        return result;
+      }
+
       ConvertFunctionMap::const_iterator it = convert_functions.find( to->type_name() );
       if (it == convert_functions.end())
       {
@@ -124,11 +153,26 @@ namespace viennamesh
         VIENNAMESH_ERROR(VIENNAMESH_ERROR_NO_CONVERSION_TO_DATA_TYPE, "No conversion found from data type \"" + from->type_name() + "\" to \"" + to->type_name() + "\"");
       }
 
+      result.element_function = it->second;
+      return result;
+    }
+
+    static void convert(conversion const & convert_function,
+                        viennamesh_data_wrapper from, viennamesh_data_wrapper to)
+    {
+      if (convert_function.container_function)
+      {
+        viennamesh_error result = convert_function.container_function(from, to);
+        if (result != VIENNAMESH_SUCCESS)
+          VIENNAMESH_ERROR(result, "Conversion from data type \"" + from->type_name() + "\" to \"" + to->type_name() + "\" failed");
+        return;
+      }
+
       to->resize( from->size() );
       for (int i = 0; i != from->size(); ++i)
       {
         to->make_data(i);
-        it->second( from->data(i), to->data(i) );
+        convert_function.element_function( from->data(i), to->data(i) );
       }
     }
 
@@ -148,6 +192,9 @@ namespace viennamesh
 
     typedef std::map<std::string, viennamesh_data_convert_function> ConvertFunctionMap;
     ConvertFunctionMap convert_functions;
+
+    typedef std::map<std::string, viennamesh_data_container_convert_function> ContainerConvertFunctionMap;
+    ContainerConvertFunctionMap container_convert_functions;
   };
 
 }
@@ -0,0 +1,58 @@
+#ifndef _VIENNAMESH_BACKEND_LOCKS_HPP_
+#define _VIENNAMESH_BACKEND_LOCKS_HPP_
+
+#include <pthread.h>
+
+namespace viennamesh
+{
+  namespace backend
+  {
+    // Readers-writer mutex for read-mostly registries: any number of readers or a single writer.
+    class read_write_mutex
+    {
+    public:
+      read_write_mutex() { pthread_rwlock_init(&lock_, NULL); }
+      ~read_write_mutex() { pthread_rwlock_destroy(&lock_); }
+
+      void lock_read() { pthread_rwlock_rdlock(&lock_); }
+      void lock_write() { pthread_rwlock_wrlock(&lock_); }
+      void unlock() { pthread_rwlock_unlock(&lock_); }
+
+    private:
+      read_write_mutex(read_write_mutex const &);
+      read_write_mutex & operator=(read_write_mutex const &);
+
+      pthread_rwlock_t lock_;
+    };
+
+
+    class read_lock
+    {
+    public:
+      read_lock(read_write_mutex & mutex_in) : mutex(mutex_in) { mutex.lock_read(); }
+      ~read_lock() { mutex.unlock(); }
+
+    private:
+      read_lock(read_lock const &);
+      read_lock & operator=(read_lock const &);
+
+      read_write_mutex & mutex;
+    };
+
+
+    class write_lock
+    {
+    public:
+      write_lock(read_write_mutex & mutex_in) : mutex(mutex_in) { mutex.lock_write(); }
+      ~write_lock() { mutex.unlock(); }
+
+    private:
+      write_lock(write_lock const &);
+      write_lock & operator=(write_lock const &);
+
+      read_write_mutex & mutex;
+    };
+  }
+}
+
+#endif
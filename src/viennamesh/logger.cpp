@@ -29,16 +29,20 @@ namespace viennamesh
       return register_callback( new FileStreamCallback<FileStreamFormater>(filename) );
     }
 
+    int Logger::register_thread_file_callback( std::string const & filename )
+    {
+      BaseCallback * callback = new FileStreamCallback<FileStreamFormater>(filename);
+      callback->thread_only = true;
+      callback->thread = std::this_thread::get_id();
+      return register_callback( callback );
+    }
+
     Logger & logger()
     {
-      static bool is_init = false;
+      // function local statics are initialized exactly once, even if several threads log at the same time
       static Logger logger_;
-
-      if (!is_init)
-      {
-        logger_.register_color_cout_callback();
-        is_init = true;
-      }
+      static bool is_init = (logger_.register_color_cout_callback(), true);
+      (void)is_init;
 
       return logger_;
     }
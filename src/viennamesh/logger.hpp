@@ -22,6 +22,9 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #ifndef _WIN32
 #include <fcntl.h>
@@ -197,8 +200,15 @@ namespace viennamesh
 
     struct BaseCallback
     {
+      BaseCallback() : thread_only(false) {}
       virtual ~BaseCallback() {}
 
+      // callbacks registered for a thread only receive messages logged by that thread
+      bool accepts_current_thread() const { return !thread_only || thread == std::this_thread::get_id(); }
+
+      bool thread_only;
+      std::thread::id thread;
+
       virtual std::string make(
                 Logger const & logger,
                 std::string const & tag_name,
@@ -276,11 +286,11 @@ namespace viennamesh
     {
     public:
 
-      Logger() : indentation_count_(0), log_levels_(5) {}
+      Logger() : indentation_count_(0), log_levels_(5), next_callback_handle_(0) {}
       ~Logger()
       {
-        for (std::vector<BaseCallback *>::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
-          delete *it;
+        for (std::map<int, BaseCallback *>::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+          delete it->second;
       }
 
       template<typename LoggingTagT>
@@ -304,20 +314,30 @@ namespace viennamesh
 
 
 
+      // messages are written under a lock, concurrent pipelines never interleave within a message
       template<typename LoggingTagT>
       void log( int log_level,
                     std::string const & message )
       {
-        for (std::vector< BaseCallback * >::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
-          (*it)->log<LoggingTagT>(*this, log_level, message);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::map<int, BaseCallback *>::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+          if (it->second->accepts_current_thread())
+            it->second->log<LoggingTagT>(*this, log_level, message);
       }
 
       int register_color_cout_callback();
       int register_file_callback( std::string const & filename );
+      // the file only receives messages logged by the calling thread
+      int register_thread_file_callback( std::string const & filename );
       void unregister_callback( int callback_handle )
       {
-        delete callbacks[callback_handle];
-        callbacks.erase( callbacks.begin()+callback_handle );
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<int, BaseCallback *>::iterator it = callbacks.find(callback_handle);
+        if (it != callbacks.end())
+        {
+          delete it->second;
+          callbacks.erase(it);
+        }
       }
 
       LoggingLevels< int > const & log_levels() const { return log_levels_; }
@@ -337,14 +357,19 @@ namespace viennamesh
 
       int register_callback( BaseCallback * callback )
       {
-        callbacks.push_back( callback );
-        return callbacks.size()-1;
+        std::lock_guard<std::mutex> lock(mutex_);
+        int callback_handle = next_callback_handle_++;
+        callbacks[callback_handle] = callback;
+        return callback_handle;
       }
 
-      int indentation_count_;
+      std::atomic<int> indentation_count_;
       LoggingLevels< int > log_levels_;
 
-      std::vector<BaseCallback *> callbacks;
+      // handles stay valid when other callbacks are unregistered
+      std::map<int, BaseCallback *> callbacks;
+      int next_callback_handle_;
+      std::mutex mutex_;
     };
 
 
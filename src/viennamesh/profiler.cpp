@@ -0,0 +1,325 @@
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sys/resource.h>
+
+#include "profiler.hpp"
+#include "logger.hpp"
+
+namespace viennamesh
+{
+  namespace backend
+  {
+    namespace
+    {
+      double now()
+      {
+        return std::chrono::duration<double, std::micro>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+      }
+
+      // small consecutive thread ids, used as tid in traces
+      int thread_index()
+      {
+        static std::atomic<int> thread_count(0);
+        thread_local int index = thread_count++;
+        return index;
+      }
+
+      // open spans of the calling thread, innermost last
+      std::vector<int> & open_spans()
+      {
+        thread_local std::vector<int> spans;
+        return spans;
+      }
+
+      std::string escape_json(std::string const & str)
+      {
+        std::string result;
+        result.reserve(str.size());
+        for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+        {
+          switch (*it)
+          {
+            case '"': result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            case '\t': result += "\\t"; break;
+            case '\r': result += "\\r"; break;
+            default:
+              if (static_cast<unsigned char>(*it) < 0x20)
+              {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(*it));
+                result += buffer;
+              }
+              else
+                result += *it;
+          }
+        }
+        return result;
+      }
+
+      void write_arguments(std::ostream & out, profiling_span const & span)
+      {
+        out << "{";
+        for (std::size_t i = 0; i != span.arguments.size(); ++i)
+        {
+          if (i != 0)
+            out << ", ";
+          out << "\"" << escape_json(span.arguments[i].first) << "\": \"" << escape_json(span.arguments[i].second) << "\"";
+        }
+        out << "}";
+      }
+    }
+
+
+
+    resource_usage resource_usage::current()
+    {
+      resource_usage usage;
+
+      timespec ts;
+      if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        usage.thread_cpu_time = ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+      if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+        usage.process_cpu_time = ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+
+      rusage ru;
+      if (getrusage(RUSAGE_SELF, &ru) == 0)
+        usage.peak_rss = ru.ru_maxrss;
+
+      return usage;
+    }
+
+
+
+    void profiler::set_enabled(bool enabled_in)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (enabled_in && !enabled_ && spans_.empty())
+        epoch_ = now();
+      enabled_ = enabled_in;
+    }
+
+    bool profiler::clear()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      // open spans are referenced by index from the stacks of their threads
+      if (open_span_count_ > 0)
+      {
+        warning(1) << "Profiling data is not cleared, " << open_span_count_ << " spans are still open" << std::endl;
+        return false;
+      }
+
+      spans_.clear();
+      epoch_ = now();
+      return true;
+    }
+
+
+    bool profiler::begin(std::string const & name, std::string const & category)
+    {
+      if (!enabled_)
+        return false;
+
+      std::vector<int> & stack = open_spans();
+
+      profiling_span span;
+      span.name = name;
+      span.category = category;
+      span.thread = thread_index();
+      span.parent = stack.empty() ? -1 : stack.back();
+      span.depth = stack.size();
+      span.usage_at_begin = resource_usage::current();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      span.start = now() - epoch_;
+      stack.push_back( spans_.size() );
+      spans_.push_back(span);
+      ++open_span_count_;
+      return true;
+    }
+
+    void profiler::end()
+    {
+      std::vector<int> & stack = open_spans();
+      if (stack.empty())
+        return;
+
+      int index = stack.back();
+      stack.pop_back();
+
+      resource_usage usage = resource_usage::current();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (index >= static_cast<int>(spans_.size()))
+        return;
+
+      --open_span_count_;
+
+      profiling_span & span = spans_[index];
+      span.wall_time = now() - epoch_ - span.start;
+      span.thread_cpu_time = usage.thread_cpu_time - span.usage_at_begin.thread_cpu_time;
+      span.process_cpu_time = usage.process_cpu_time - span.usage_at_begin.process_cpu_time;
+      span.peak_rss_delta = usage.peak_rss - span.usage_at_begin.peak_rss;
+
+      // conversions are accounted to the algorithm which requested them
+      if (span.category == "conversion" && span.parent >= 0)
+        spans_[span.parent].conversion_time += span.wall_time;
+    }
+
+
+    void profiler::add_argument(std::string const & key, std::string const & value)
+    {
+      std::vector<int> & stack = open_spans();
+      if (!enabled_ || stack.empty())
+        return;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stack.back() < static_cast<int>(spans_.size()))
+        spans_[stack.back()].arguments.push_back( std::make_pair(key, value) );
+    }
+
+    void profiler::add_argument(std::string const & key, double value)
+    {
+      std::ostringstream ss;
+      ss << value;
+      add_argument(key, ss.str());
+    }
+
+
+
+    bool profiler::write_json(std::string const & filename) const
+    {
+      std::ofstream out(filename.c_str());
+      if (!out)
+      {
+        error(1) << "Could not open profiling report file \"" << filename << "\"" << std::endl;
+        return false;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      out << std::fixed;
+      out.precision(3);
+
+      // totals per algorithm type
+      struct algorithm_summary
+      {
+        algorithm_summary() : runs(0), wall_time(0.0), thread_cpu_time(0.0), process_cpu_time(0.0), conversion_time(0.0), peak_rss_delta(0) {}
+
+        int runs;
+        double wall_time;
+        double thread_cpu_time;
+        double process_cpu_time;
+        double conversion_time;
+        long peak_rss_delta;
+      };
+      std::map<std::string, algorithm_summary> summaries;
+
+      out << "{\n  \"spans\": [\n";
+      for (std::size_t i = 0; i != spans_.size(); ++i)
+      {
+        profiling_span const & span = spans_[i];
+        out << "    {\"name\": \"" << escape_json(span.name) << "\", \"category\": \"" << escape_json(span.category) << "\""
+            << ", \"thread\": " << span.thread << ", \"parent\": " << span.parent << ", \"depth\": " << span.depth
+            << ", \"start_us\": " << span.start << ", \"wall_time_us\": " << span.wall_time
+            << ", \"thread_cpu_time_us\": " << span.thread_cpu_time << ", \"process_cpu_time_us\": " << span.process_cpu_time
+            << ", \"peak_rss_delta_kib\": " << span.peak_rss_delta
+            << ", \"conversion_time_us\": " << span.conversion_time << ", \"arguments\": ";
+        write_arguments(out, span);
+        out << "}" << (i+1 != spans_.size() ? "," : "") << "\n";
+
+        if (span.category == "algorithm" && span.wall_time >= 0.0)
+        {
+          algorithm_summary & summary = summaries[span.name];
+          ++summary.runs;
+          summary.wall_time += span.wall_time;
+          summary.thread_cpu_time += span.thread_cpu_time;
+          summary.process_cpu_time += span.process_cpu_time;
+          summary.conversion_time += span.conversion_time;
+          summary.peak_rss_delta = std::max(summary.peak_rss_delta, span.peak_rss_delta);
+        }
+      }
+      out << "  ],\n  \"algorithms\": [\n";
+
+      for (std::map<std::string, algorithm_summary>::const_iterator it = summaries.begin(); it != summaries.end(); ++it)
+      {
+        out << "    {\"type\": \"" << escape_json(it->first) << "\", \"runs\": " << it->second.runs
+            << ", \"wall_time_us\": " << it->second.wall_time << ", \"thread_cpu_time_us\": " << it->second.thread_cpu_time
+            << ", \"process_cpu_time_us\": " << it->second.process_cpu_time
+            << ", \"conversion_time_us\": " << it->second.conversion_time
+            << ", \"max_peak_rss_delta_kib\": " << it->second.peak_rss_delta << "}";
+        std::map<std::string, algorithm_summary>::const_iterator next = it;
+        out << (++next != summaries.end() ? "," : "") << "\n";
+      }
+      out << "  ]\n}\n";
+      return true;
+    }
+
+
+    bool profiler::write_trace(std::string const & filename) const
+    {
+      std::ofstream out(filename.c_str());
+      if (!out)
+      {
+        error(1) << "Could not open profiling trace file \"" << filename << "\"" << std::endl;
+        return false;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      out << std::fixed;
+      out.precision(3);
+
+      // Chrome trace event format with complete events, readable by chrome://tracing and Perfetto
+      out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+      bool first = true;
+      for (std::size_t i = 0; i != spans_.size(); ++i)
+      {
+        profiling_span const & span = spans_[i];
+        if (span.wall_time < 0.0)
+          continue;
+
+        out << (first ? "" : ",\n");
+        first = false;
+
+        out << "  {\"name\": \"" << escape_json(span.name) << "\", \"cat\": \"" << escape_json(span.category) << "\""
+            << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << span.thread
+            << ", \"ts\": " << span.start << ", \"dur\": " << span.wall_time << ", \"args\": ";
+
+        profiling_span with_metrics = span;
+        std::ostringstream ss;
+        ss << span.thread_cpu_time;
+        with_metrics.arguments.push_back( std::make_pair("thread_cpu_time_us", ss.str()) );
+        ss.str("");
+        ss << span.process_cpu_time;
+        with_metrics.arguments.push_back( std::make_pair("process_cpu_time_us", ss.str()) );
+        ss.str("");
+        ss << span.peak_rss_delta;
+        with_metrics.arguments.push_back( std::make_pair("peak_rss_delta_kib", ss.str()) );
+        if (span.conversion_time > 0.0)
+        {
+          ss.str("");
+          ss << span.conversion_time;
+          with_metrics.arguments.push_back( std::make_pair("conversion_time_us", ss.str()) );
+        }
+        write_arguments(out, with_metrics);
+        out << "}";
+      }
+      out << "\n]}\n";
+      return true;
+    }
+
+
+
+    profiler & get_profiler()
+    {
+      static profiler profiler_;
+      return profiler_;
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef _VIENNAMESH_BACKEND_PROFILER_HPP_
+#define _VIENNAMESH_BACKEND_PROFILER_HPP_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace viennamesh
+{
+  namespace backend
+  {
+    struct resource_usage
+    {
+      resource_usage() : thread_cpu_time(0.0), process_cpu_time(0.0), peak_rss(0) {}
+
+      double thread_cpu_time;   // CPU time of the calling thread in microseconds
+      double process_cpu_time;  // CPU time of all threads of the process in microseconds
+      long peak_rss;            // peak resident set size of the process in KiB
+
+      static resource_usage current();
+    };
+
+
+    // A timed section, spans of one thread are nested. Algorithm runs, data conversions and
+    // plugin defined sections are recorded as spans.
+    struct profiling_span
+    {
+      profiling_span() : thread(0), parent(-1), depth(0), start(0.0), wall_time(-1.0),
+                         thread_cpu_time(0.0), process_cpu_time(0.0), peak_rss_delta(0), conversion_time(0.0) {}
+
+      std::string name;
+      std::string category;
+
+      int thread;
+      int parent;
+      int depth;
+
+      double start;            // microseconds since the profiler was enabled
+      double wall_time;        // microseconds, negative while the span is open
+      double thread_cpu_time;  // microseconds of CPU time of the thread running the span, excludes threads it starts
+      double process_cpu_time; // microseconds of CPU time of the whole process, includes concurrent spans of other threads
+      long peak_rss_delta;     // KiB
+      double conversion_time;  // microseconds spent in nested data conversions
+
+      std::vector< std::pair<std::string, std::string> > arguments;
+
+      resource_usage usage_at_begin;
+    };
+
+
+    // Collects spans of all threads while enabled. If disabled, begin returns false and records
+    // nothing, so instrumentation costs a single atomic load.
+    class profiler
+    {
+    public:
+
+      profiler() : enabled_(false), epoch_(0.0), open_span_count_(0) {}
+
+      bool enabled() const { return enabled_; }
+      void set_enabled(bool enabled_in);
+      // removes all recorded spans, fails if a span of any thread is still open
+      bool clear();
+
+      bool begin(std::string const & name, std::string const & category);
+      void end();
+
+      // arguments of the innermost open span of the calling thread
+      void add_argument(std::string const & key, std::string const & value);
+      void add_argument(std::string const & key, double value);
+
+      bool write_json(std::string const & filename) const;
+      bool write_trace(std::string const & filename) const;
+
+    private:
+
+      std::atomic<bool> enabled_;
+      double epoch_;
+      int open_span_count_;
+
+      mutable std::mutex mutex_;
+      std::vector<profiling_span> spans_;
+    };
+
+    profiler & get_profiler();
+  }
+}
+
+#endif
@@ -1,6 +1,10 @@
 #include "viennamesh/viennamesh.h"
 #include "viennagrid/viennagrid.hpp"
 #include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <algorithm>
 
 
 
@@ -115,3 +119,243 @@ viennamesh_error viennamesh_seed_point_get(viennamesh_seed_point seed_point,
   *region = seed_point->region;
   return VIENNAMESH_SUCCESS;
 }
+
+
+
+
+struct viennamesh_point_cloud_t
+{
+  viennamesh_point_cloud_t() : dimension(0), point_count(0), use_count(1) {}
+
+  struct attribute
+  {
+    int components;
+    std::vector<viennagrid_numeric> values;
+  };
+
+  int dimension;
+  int point_count;
+  std::vector<viennagrid_numeric> coords;
+  std::vector<viennagrid_numeric> normals;
+
+  std::vector<std::string> attribute_names;
+  std::map<std::string, attribute> attributes;
+
+  std::atomic<int> use_count;
+};
+
+viennamesh_error viennamesh_point_cloud_make(viennamesh_point_cloud * point_cloud)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *point_cloud = new viennamesh_point_cloud_t;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_retain(viennamesh_point_cloud point_cloud)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  ++point_cloud->use_count;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_release(viennamesh_point_cloud point_cloud)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (--point_cloud->use_count == 0)
+    delete point_cloud;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_copy(viennamesh_point_cloud src,
+                                             viennamesh_point_cloud dst)
+{
+  if (!src || !dst)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (src == dst)
+    return VIENNAMESH_SUCCESS;
+
+  dst->dimension = src->dimension;
+  dst->point_count = src->point_count;
+  dst->coords = src->coords;
+  dst->normals = src->normals;
+  dst->attribute_names = src->attribute_names;
+  dst->attributes = src->attributes;
+  return VIENNAMESH_SUCCESS;
+}
+
+
+viennamesh_error viennamesh_point_cloud_resize(viennamesh_point_cloud point_cloud,
+                                               int dimension, int point_count)
+{
+  if (!point_cloud || dimension < 0 || point_count < 0)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (dimension != point_cloud->dimension && point_cloud->point_count != 0)
+  {
+    // values are kept per point, missing coordinates are zero
+    std::size_t shared_dimension = std::min(dimension, point_cloud->dimension);
+    std::size_t shared_count = std::min(point_count, point_cloud->point_count);
+
+    std::vector<viennagrid_numeric> coords( static_cast<std::size_t>(dimension)*point_count, 0.0 );
+    std::vector<viennagrid_numeric> normals( point_cloud->normals.empty() ? 0 : coords.size(), 0.0 );
+    for (std::size_t i = 0; i != shared_count; ++i)
+    {
+      std::copy( point_cloud->coords.begin() + i*point_cloud->dimension,
+                 point_cloud->coords.begin() + i*point_cloud->dimension + shared_dimension,
+                 coords.begin() + i*dimension );
+      if (!normals.empty())
+        std::copy( point_cloud->normals.begin() + i*point_cloud->dimension,
+                   point_cloud->normals.begin() + i*point_cloud->dimension + shared_dimension,
+                   normals.begin() + i*dimension );
+    }
+
+    point_cloud->coords.swap(coords);
+    point_cloud->normals.swap(normals);
+  }
+  else
+  {
+    point_cloud->coords.resize( static_cast<std::size_t>(dimension)*point_count, 0.0 );
+    if (!point_cloud->normals.empty())
+      point_cloud->normals.resize( point_cloud->coords.size(), 0.0 );
+  }
+
+  for (std::map<std::string, viennamesh_point_cloud_t::attribute>::iterator it = point_cloud->attributes.begin();
+                                                                          it != point_cloud->attributes.end(); ++it)
+    it->second.values.resize( static_cast<std::size_t>(it->second.components)*point_count, 0.0 );
+
+  point_cloud->dimension = dimension;
+  point_cloud->point_count = point_count;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_get(viennamesh_point_cloud point_cloud,
+                                            int * dimension, int * point_count,
+                                            viennagrid_numeric ** coords)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (dimension)
+    *dimension = point_cloud->dimension;
+  if (point_count)
+    *point_count = point_cloud->point_count;
+  if (coords)
+    *coords = point_cloud->coords.empty() ? NULL : point_cloud->coords.data();
+  return VIENNAMESH_SUCCESS;
+}
+
+
+viennamesh_error viennamesh_point_cloud_normals_make(viennamesh_point_cloud point_cloud,
+                                                     viennagrid_numeric ** normals)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  point_cloud->normals.resize( point_cloud->coords.size(), 0.0 );
+  if (normals)
+    *normals = point_cloud->normals.empty() ? NULL : point_cloud->normals.data();
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_normals_get(viennamesh_point_cloud point_cloud,
+                                                    viennagrid_numeric ** normals)
+{
+  if (!point_cloud || !normals)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *normals = point_cloud->normals.empty() ? NULL : point_cloud->normals.data();
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_normals_clear(viennamesh_point_cloud point_cloud)
+{
+  if (!point_cloud)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  std::vector<viennagrid_numeric>().swap(point_cloud->normals);
+  return VIENNAMESH_SUCCESS;
+}
+
+
+viennamesh_error viennamesh_point_cloud_attribute_make(viennamesh_point_cloud point_cloud,
+                                                       const char * name, int components,
+                                                       viennagrid_numeric ** values)
+{
+  if (!point_cloud || !name || components <= 0)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  std::map<std::string, viennamesh_point_cloud_t::attribute>::iterator it = point_cloud->attributes.find(name);
+  if (it == point_cloud->attributes.end())
+  {
+    point_cloud->attribute_names.push_back(name);
+    it = point_cloud->attributes.insert( std::make_pair(std::string(name), viennamesh_point_cloud_t::attribute()) ).first;
+  }
+
+  it->second.components = components;
+  it->second.values.resize( static_cast<std::size_t>(components)*point_cloud->point_count, 0.0 );
+
+  if (values)
+    *values = it->second.values.empty() ? NULL : it->second.values.data();
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_attribute_get(viennamesh_point_cloud point_cloud,
+                                                      const char * name, int * components,
+                                                      viennagrid_numeric ** values)
+{
+  if (!point_cloud || !name || !values)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  std::map<std::string, viennamesh_point_cloud_t::attribute>::iterator it = point_cloud->attributes.find(name);
+  if (it == point_cloud->attributes.end())
+  {
+    *values = NULL;
+    if (components)
+      *components = 0;
+    return VIENNAMESH_SUCCESS;
+  }
+
+  *values = it->second.values.empty() ? NULL : it->second.values.data();
+  if (components)
+    *components = it->second.components;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_attribute_remove(viennamesh_point_cloud point_cloud,
+                                                         const char * name)
+{
+  if (!point_cloud || !name)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  point_cloud->attributes.erase(name);
+  point_cloud->attribute_names.erase( std::remove(point_cloud->attribute_names.begin(), point_cloud->attribute_names.end(), std::string(name)),
+                                      point_cloud->attribute_names.end() );
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_attribute_get_count(viennamesh_point_cloud point_cloud,
+                                                            int * count)
+{
+  if (!point_cloud || !count)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *count = point_cloud->attribute_names.size();
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_point_cloud_attribute_get_name(viennamesh_point_cloud point_cloud,
+                                                           int index, const char ** name)
+{
+  if (!point_cloud || !name || index < 0 || index >= static_cast<int>(point_cloud->attribute_names.size()))
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *name = point_cloud->attribute_names[index].c_str();
+  return VIENNAMESH_SUCCESS;
+}
@@ -5,6 +5,7 @@
 #include "algorithm.hpp"
 #include "context.hpp"
 #include "logger.hpp"
+#include "profiler.hpp"
 
 
 
@@ -466,6 +467,29 @@ viennamesh_error viennamesh_data_conversion_register(viennamesh_context context,
   return VIENNAMESH_SUCCESS;
 }
 
+viennamesh_error viennamesh_data_container_conversion_register(viennamesh_context context,
+                                        const char * data_type_from,
+                                        const char * data_type_to,
+                                        viennamesh_data_container_convert_function convert_function)
+{
+  if (!context)
+    return VIENNAMESH_ERROR_INVALID_CONTEXT;
+
+  if (!data_type_from || !data_type_to || !convert_function)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  try
+  {
+    context->register_container_conversion_function(data_type_from, data_type_to, convert_function);
+  }
+  catch (...)
+  {
+    return viennamesh::handle_error(context);
+  }
+
+  return VIENNAMESH_SUCCESS;
+}
+
 
 viennamesh_error viennamesh_data_wrapper_convert(viennamesh_data_wrapper data_from,
                                     viennamesh_data_wrapper data_to)
@@ -652,6 +676,24 @@ viennamesh_error viennamesh_algorithm_get_type(viennamesh_algorithm_wrapper algo
   return VIENNAMESH_SUCCESS;
 }
 
+viennamesh_error viennamesh_algorithm_get_build_id(viennamesh_algorithm_wrapper algorithm,
+                                                   const char ** build_id)
+{
+  if (!algorithm || !build_id)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  try
+  {
+    *build_id = algorithm->build_id().c_str();
+  }
+  catch (...)
+  {
+    return viennamesh::handle_error(algorithm->context());
+  }
+
+  return VIENNAMESH_SUCCESS;
+}
+
 viennamesh_error viennamesh_algorithm_get_context(viennamesh_algorithm_wrapper algorithm,
                                                     viennamesh_context * context)
 {
@@ -909,6 +951,37 @@ viennamesh_error viennamesh_algorithm_get_output_with_type(viennamesh_algorithm_
 }
 
 
+viennamesh_error viennamesh_algorithm_get_output_count(viennamesh_algorithm_wrapper algorithm,
+                                                      int * count)
+{
+  if (!algorithm || !count)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *count = algorithm->output_count();
+
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_algorithm_get_output_name(viennamesh_algorithm_wrapper algorithm,
+                                                     int index,
+                                                     const char ** name)
+{
+  if (!algorithm || !name)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  try
+  {
+    *name = algorithm->output_name(index).c_str();
+  }
+  catch (...)
+  {
+    return viennamesh::handle_error(algorithm->context());
+  }
+
+  return VIENNAMESH_SUCCESS;
+}
+
+
 viennamesh_error viennamesh_algorithm_init(viennamesh_algorithm_wrapper algorithm)
 {
   if (!algorithm)
@@ -1088,3 +1161,93 @@ viennamesh_error viennamesh_log_add_logging_file(char const * filename, vienname
   return VIENNAMESH_SUCCESS;
 }
 
+viennamesh_error viennamesh_log_add_thread_logging_file(char const * filename, viennamesh_log_callback_handle * handle)
+{
+  if (!filename)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  viennamesh_log_callback_handle tmp = viennamesh::backend::logger().register_thread_file_callback(filename);
+  if (handle)
+    *handle = tmp;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_log_remove_logging_file(viennamesh_log_callback_handle handle)
+{
+  viennamesh::backend::logger().unregister_callback(handle);
+  return VIENNAMESH_SUCCESS;
+}
+
+
+
+
+viennamesh_error viennamesh_profiling_set_enabled(int enabled)
+{
+  viennamesh::backend::get_profiler().set_enabled(enabled != 0);
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_get_enabled(int * enabled)
+{
+  if (!enabled)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  *enabled = viennamesh::backend::get_profiler().enabled() ? 1 : 0;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_clear()
+{
+  if (!viennamesh::backend::get_profiler().clear())
+    return VIENNAMESH_UNKNOWN_ERROR;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_span_begin(const char * name,
+                                                 const char * category,
+                                                 int * started)
+{
+  if (!name)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  bool tmp = viennamesh::backend::get_profiler().begin(name, category ? category : "plugin");
+  if (started)
+    *started = tmp ? 1 : 0;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_span_end()
+{
+  viennamesh::backend::get_profiler().end();
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_span_add_argument(const char * key,
+                                                        const char * value)
+{
+  if (!key || !value)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  viennamesh::backend::get_profiler().add_argument(key, std::string(value));
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_write_json(const char * filename)
+{
+  if (!filename)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (!viennamesh::backend::get_profiler().write_json(filename))
+    return VIENNAMESH_UNKNOWN_ERROR;
+  return VIENNAMESH_SUCCESS;
+}
+
+viennamesh_error viennamesh_profiling_write_trace(const char * filename)
+{
+  if (!filename)
+    return VIENNAMESH_ERROR_INVALID_ARGUMENT;
+
+  if (!viennamesh::backend::get_profiler().write_trace(filename))
+    return VIENNAMESH_UNKNOWN_ERROR;
+  return VIENNAMESH_SUCCESS;
+}
@@ -103,6 +103,20 @@ namespace viennamesh
     return abstract_data_handle(data_);
   }
 
+  int algorithm_handle::output_count() const
+  {
+    int count;
+    handle_error(viennamesh_algorithm_get_output_count(internal(), &count), algorithm);
+    return count;
+  }
+
+  std::string algorithm_handle::output_name(int index) const
+  {
+    const char * name_;
+    handle_error(viennamesh_algorithm_get_output_name(internal(), index, &name_), algorithm);
+    return name_;
+  }
+
 
 
   void algorithm_handle::init()
@@ -133,6 +147,13 @@ namespace viennamesh
     return type_;
   }
 
+  std::string algorithm_handle::build_id() const
+  {
+    const char * build_id_;
+    handle_error(viennamesh_algorithm_get_build_id(internal(), &build_id_), algorithm);
+    return build_id_;
+  }
+
 
   std::string algorithm_handle::base_path() const
   {
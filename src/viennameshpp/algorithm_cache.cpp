@@ -0,0 +1,868 @@
+/* ============================================================================
+   Copyright (c) 2011-2014, Institute for Microelectronics,
+                            Institute for Analysis and Scientific Computing,
+                            TU Wien.
+
+                            -----------------
+                ViennaMesh - The Vienna Meshing Framework
+                            -----------------
+
+                    http://viennamesh.sourceforge.net/
+
+   License:         MIT (X11), see file LICENSE in the base directory
+=============================================================================== */
+
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "viennameshpp/algorithm_cache.hpp"
+#include "viennameshpp/cell_batch.hpp"
+
+namespace viennamesh
+{
+
+  void cache_key_builder::add(void const * data, std::size_t size)
+  {
+    unsigned char const * bytes = static_cast<unsigned char const *>(data);
+    for (std::size_t i = 0; i != size; ++i)
+    {
+      hash_ ^= bytes[i];
+      hash_ *= 1099511628211ULL;
+    }
+  }
+
+  void cache_key_builder::add(std::string const & str)
+  {
+    add(str.size());
+    add(str.data(), str.size());
+  }
+
+  void cache_key_builder::add(std::size_t value)
+  {
+    add(&value, sizeof(value));
+  }
+
+  bool cache_key_builder::add_file_content(std::string const & filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file)
+      return false;
+
+    std::vector<char> buffer(1 << 20);
+    while (file)
+    {
+      file.read(&buffer[0], buffer.size());
+      add(&buffer[0], file.gcount());
+    }
+
+    return true;
+  }
+
+  std::string cache_key_builder::str() const
+  {
+    char buffer[17];
+    std::sprintf(buffer, "%016llx", hash_);
+    return buffer;
+  }
+
+
+
+
+  namespace
+  {
+    char const cache_file_magic[8] = {'V', 'M', 'C', 'A', 'C', 'H', 'E', '2'};
+    std::string const cache_file_extension = ".vmc";
+
+
+    class binary_writer
+    {
+    public:
+      binary_writer(std::ostream & stream_) : stream(stream_) {}
+
+      template<typename T>
+      void write(T const & value)
+      { stream.write(reinterpret_cast<char const *>(&value), sizeof(T)); }
+
+      template<typename T>
+      void write_array(T const * values, std::size_t count)
+      {
+        if (count > 0)
+          stream.write(reinterpret_cast<char const *>(values), sizeof(T)*count);
+      }
+
+      template<typename T>
+      void write_vector(std::vector<T> const & values)
+      {
+        write<viennagrid_int>(values.size());
+        write_array(values.empty() ? NULL : &values[0], values.size());
+      }
+
+      void write_string(std::string const & str)
+      {
+        write<viennagrid_int>(str.size());
+        write_array(str.data(), str.size());
+      }
+
+      bool good() const { return stream.good(); }
+
+    private:
+      std::ostream & stream;
+    };
+
+
+    class binary_reader
+    {
+    public:
+      binary_reader(std::istream & stream_) : stream(stream_) {}
+
+      template<typename T>
+      bool read(T & value)
+      { return stream.read(reinterpret_cast<char *>(&value), sizeof(T)).good(); }
+
+      template<typename T>
+      bool read_array(T * values, std::size_t count)
+      {
+        if (count == 0)
+          return true;
+        return stream.read(reinterpret_cast<char *>(values), sizeof(T)*count).good();
+      }
+
+      template<typename T>
+      bool read_vector(std::vector<T> & values)
+      {
+        viennagrid_int size;
+        if (!read(size) || size < 0)
+          return false;
+        values.resize(size);
+        return read_array(values.empty() ? NULL : &values[0], values.size());
+      }
+
+      bool read_string(std::string & str)
+      {
+        std::vector<char> tmp;
+        if (!read_vector(tmp))
+          return false;
+        str.assign(tmp.begin(), tmp.end());
+        return true;
+      }
+
+    private:
+      std::istream & stream;
+    };
+
+
+
+
+    // bool, int, double
+    template<typename T>
+    void write_value(binary_writer & out, T const & value)
+    { out.write(value); }
+
+    template<typename T>
+    bool read_value(binary_reader & in, T & value)
+    { return in.read(value); }
+
+
+    // std::string
+    void write_value(binary_writer & out, std::string const & value)
+    { out.write_string(value); }
+
+    bool read_value(binary_reader & in, std::string & value)
+    { return in.read_string(value); }
+
+
+    // viennagrid::point
+    void write_value(binary_writer & out, point const & value)
+    {
+      out.write<viennagrid_int>(value.size());
+      out.write_array(value.empty() ? NULL : &value[0], value.size());
+    }
+
+    bool read_value(binary_reader & in, point & value)
+    {
+      viennagrid_int size;
+      if (!in.read(size) || size < 0)
+        return false;
+      value.resize(size);
+      return in.read_array(value.empty() ? NULL : &value[0], value.size());
+    }
+
+
+    // viennagrid::seed_point
+    void write_value(binary_writer & out, seed_point const & value)
+    {
+      write_value(out, value.first);
+      out.write<viennagrid_int>(value.second);
+    }
+
+    bool read_value(binary_reader & in, seed_point & value)
+    {
+      viennagrid_int region;
+      if (!read_value(in, value.first) || !in.read(region))
+        return false;
+      value.second = region;
+      return true;
+    }
+
+
+    // viennamesh::point_cloud, stored as coordinate array, optional normals and named attributes
+    void write_value(binary_writer & out, point_cloud const & value)
+    {
+      viennagrid_int dimension = value.dimension();
+      viennagrid_int size = value.size();
+
+      out.write(dimension);
+      out.write(size);
+      out.write_array(value.coords(), dimension*size);
+
+      char has_normals = value.has_normals() ? 1 : 0;
+      out.write(has_normals);
+      if (has_normals)
+        out.write_array(value.normals(), dimension*size);
+
+      std::vector<std::string> attribute_names = value.attribute_names();
+      out.write<viennagrid_int>(attribute_names.size());
+      for (std::size_t i = 0; i != attribute_names.size(); ++i)
+      {
+        int components;
+        viennagrid_numeric const * values = value.attribute(attribute_names[i], &components);
+        out.write_string(attribute_names[i]);
+        out.write<viennagrid_int>(components);
+        out.write_array(values, components*size);
+      }
+    }
+
+    bool read_value(binary_reader & in, point_cloud & value)
+    {
+      viennagrid_int dimension;
+      viennagrid_int size;
+      char has_normals;
+      viennagrid_int attribute_count;
+
+      if (!in.read(dimension) || !in.read(size) || dimension < 0 || size < 0)
+        return false;
+
+      value.clear_normals();
+      std::vector<std::string> old_attribute_names = value.attribute_names();
+      for (std::size_t i = 0; i != old_attribute_names.size(); ++i)
+        value.remove_attribute(old_attribute_names[i]);
+
+      value.resize(dimension, size);
+      if (!in.read_array(value.coords(), dimension*size) || !in.read(has_normals))
+        return false;
+
+      if (has_normals && !in.read_array(value.make_normals(), dimension*size))
+        return false;
+
+      if (!in.read(attribute_count) || attribute_count < 0)
+        return false;
+
+      for (viennagrid_int i = 0; i != attribute_count; ++i)
+      {
+        std::string name;
+        viennagrid_int components;
+        if (!in.read_string(name) || !in.read(components) || components <= 0)
+          return false;
+        if (!in.read_array(value.make_attribute(name, components), components*size))
+          return false;
+      }
+
+      return true;
+    }
+
+
+    // viennagrid::quantity_field, stored with a validity flag and the raw values of each element
+    void write_value(binary_writer & out, quantity_field const & value)
+    {
+      viennagrid_int size = value.size();
+      viennagrid_int values_per_quantity = value.values_per_quantity();
+
+      out.write<viennagrid_int>(value.topologic_dimension());
+      out.write<viennagrid_int>(values_per_quantity);
+      out.write<viennagrid_int>(value.storage_layout());
+      out.write_string(value.get_name());
+      out.write<viennagrid_int>(size);
+
+      for (viennagrid_int i = 0; i != size; ++i)
+      {
+        char valid = value.valid(i) ? 1 : 0;
+        out.write(valid);
+        if (valid)
+        {
+          void * values;
+          viennagrid_quantity_field_value_get(value.internal(), i, &values);
+          out.write_array(static_cast<viennagrid_numeric const *>(values), values_per_quantity);
+        }
+      }
+    }
+
+    bool read_value(binary_reader & in, quantity_field & value)
+    {
+      viennagrid_int topologic_dimension;
+      viennagrid_int values_per_quantity;
+      viennagrid_int storage_layout;
+      std::string name;
+      viennagrid_int size;
+
+      if (!in.read(topologic_dimension) || !in.read(values_per_quantity) || !in.read(storage_layout) ||
+          !in.read_string(name) || !in.read(size) || values_per_quantity < 0 || size < 0)
+        return false;
+
+      value = quantity_field(topologic_dimension, values_per_quantity, storage_layout);
+      value.set_name(name);
+
+      std::vector<viennagrid_numeric> values(values_per_quantity);
+      for (viennagrid_int i = 0; i != size; ++i)
+      {
+        char valid;
+        if (!in.read(valid))
+          return false;
+
+        if (valid)
+        {
+          if (!in.read_array(values.empty() ? NULL : &values[0], values.size()))
+            return false;
+          viennagrid_quantity_field_value_set(value.internal(), i, values.empty() ? NULL : &values[0]);
+        }
+      }
+
+      return true;
+    }
+
+
+    // elements of one dimension in CSR form, element i has the vertices
+    // vertex_indices[vertex_offsets[i], vertex_offsets[i+1]) and the regions region_ids[region_offsets[i], region_offsets[i+1])
+    struct element_block
+    {
+      element_block() : vertex_offsets(1, 0), region_offsets(1, 0) {}
+
+      template<typename ElementT>
+      void push_back(ElementT const & element)
+      {
+        typedef typename viennagrid::result_of::const_element_range<ElementT>::type   ConstBoundaryRangeType;
+        typedef typename viennagrid::result_of::iterator<ConstBoundaryRangeType>::type ConstBoundaryIteratorType;
+        typedef typename viennagrid::result_of::region_range<ElementT>::type          RegionRangeType;
+        typedef typename viennagrid::result_of::iterator<RegionRangeType>::type       RegionIteratorType;
+
+        types.push_back(element.tag().internal());
+
+        ConstBoundaryRangeType vertices(element, 0);
+        for (ConstBoundaryIteratorType vit = vertices.begin(); vit != vertices.end(); ++vit)
+          vertex_indices.push_back((*vit).id().index());
+        vertex_offsets.push_back(vertex_indices.size());
+
+        RegionRangeType element_regions(element);
+        for (RegionIteratorType rit = element_regions.begin(); rit != element_regions.end(); ++rit)
+          region_ids.push_back((*rit).id());
+        region_offsets.push_back(region_ids.size());
+      }
+
+      void write(binary_writer & out) const
+      {
+        out.write_vector(types);
+        out.write_vector(vertex_offsets);
+        out.write_vector(vertex_indices);
+        out.write_vector(region_offsets);
+        out.write_vector(region_ids);
+      }
+
+      // reads and validates the block, offsets have to start at 0 and must not decrease
+      bool read(binary_reader & in, viennagrid_int vertex_count)
+      {
+        if (!in.read_vector(types) || !in.read_vector(vertex_offsets) || !in.read_vector(vertex_indices) ||
+            !in.read_vector(region_offsets) || !in.read_vector(region_ids))
+          return false;
+
+        return valid_offsets(vertex_offsets, vertex_indices.size()) && valid_offsets(region_offsets, region_ids.size()) &&
+               std::find_if(vertex_indices.begin(), vertex_indices.end(), invalid_index(vertex_count)) == vertex_indices.end();
+      }
+
+      bool valid_offsets(std::vector<viennagrid_int> const & offsets, std::size_t size) const
+      {
+        if (offsets.size() != types.size()+1 || offsets.front() != 0 || offsets.back() != static_cast<viennagrid_int>(size))
+          return false;
+        for (std::size_t i = 0; i != types.size(); ++i)
+          if (offsets[i] > offsets[i+1])
+            return false;
+        return true;
+      }
+
+      struct invalid_index
+      {
+        invalid_index(viennagrid_int count_) : count(count_) {}
+        bool operator()(viennagrid_int index) const { return index < 0 || index >= count; }
+        viennagrid_int count;
+      };
+
+      void create(mesh const & value, viennagrid_element_id first_vertex_id) const
+      {
+        if (types.empty())
+          return;
+
+        std::vector<viennagrid_element_type> element_types(types.begin(), types.end());
+        std::vector<viennagrid_element_id> element_vertices(vertex_indices.size());
+        for (std::size_t i = 0; i != vertex_indices.size(); ++i)
+          element_vertices[i] = first_vertex_id + vertex_indices[i];
+
+        for (std::size_t i = 0; i != region_ids.size(); ++i)
+          value.get_or_create_region(region_ids[i]);
+
+        batch_create_cells(value, types.size(), &element_types[0], &vertex_offsets[0],
+                           element_vertices.empty() ? NULL : &element_vertices[0],
+                           &region_offsets[0], region_ids.empty() ? NULL : &region_ids[0]);
+      }
+
+      std::vector<viennagrid_int> types;
+      std::vector<viennagrid_int> vertex_offsets;
+      std::vector<viennagrid_int> vertex_indices;
+      std::vector<viennagrid_int> region_offsets;
+      std::vector<viennagrid_int> region_ids;
+    };
+
+
+    // viennagrid::mesh, stored as coordinate array, region table (ids and names), the cells and the
+    // lower dimensional elements which are not on the boundary of a cell (e.g. lines of a PLC), all
+    // with their regions. Boundary elements of cells are recreated with the cells.
+    void write_value(binary_writer & out, mesh const & value)
+    {
+      typedef viennagrid::result_of::const_element_range<mesh>::type                ConstElementRangeType;
+      typedef viennagrid::result_of::iterator<ConstElementRangeType>::type          ConstElementIteratorType;
+      typedef viennagrid::result_of::const_region_range<mesh>::type                 ConstRegionRangeType;
+      typedef viennagrid::result_of::iterator<ConstRegionRangeType>::type           ConstRegionIteratorType;
+      typedef viennagrid::result_of::const_coboundary_range<mesh>::type             ConstCoboundaryRangeType;
+
+      viennagrid_int vertex_count = viennagrid::vertex_count(value);
+      viennagrid_int geometric_dimension = vertex_count > 0 ? viennagrid::geometric_dimension(value) : 0;
+      viennagrid_int cell_dimension = vertex_count > 0 ? viennagrid::cell_dimension(value) : 0;
+
+      out.write(geometric_dimension);
+      out.write(cell_dimension);
+      out.write(vertex_count);
+
+      if (vertex_count == 0)
+        return;
+
+      viennagrid_numeric * coords;
+      viennagrid_mesh_vertex_coords_pointer(value.internal(), &coords);
+      out.write_array(coords, vertex_count*geometric_dimension);
+
+
+      ConstRegionRangeType regions(value);
+      out.write<viennagrid_int>(regions.size());
+      for (ConstRegionIteratorType rit = regions.begin(); rit != regions.end(); ++rit)
+      {
+        out.write<viennagrid_int>((*rit).id());
+        out.write_string((*rit).get_name());
+      }
+
+
+      // cells first, then the free elements of every lower dimension
+      for (viennagrid_int dimension = cell_dimension; dimension > 0; --dimension)
+      {
+        element_block block;
+
+        ConstElementRangeType elements(value, dimension);
+        for (ConstElementIteratorType eit = elements.begin(); eit != elements.end(); ++eit)
+        {
+          if (dimension == cell_dimension || ConstCoboundaryRangeType(value, *eit, cell_dimension).size() == 0)
+            block.push_back(*eit);
+        }
+
+        block.write(out);
+      }
+    }
+
+    bool read_value(binary_reader & in, mesh & value)
+    {
+      typedef viennagrid::result_of::region<mesh>::type RegionType;
+
+      viennagrid_int geometric_dimension;
+      viennagrid_int cell_dimension;
+      viennagrid_int vertex_count;
+
+      if (!in.read(geometric_dimension) || !in.read(cell_dimension) || !in.read(vertex_count) || vertex_count < 0 ||
+          geometric_dimension < 0 || cell_dimension < 0 || cell_dimension > 3)
+        return false;
+
+      if (vertex_count == 0)
+        return true;
+
+      std::vector<viennagrid_numeric> coords(vertex_count*geometric_dimension);
+      if (!in.read_array(&coords[0], coords.size()))
+        return false;
+
+      viennagrid_element_id first_vertex_id;
+      viennagrid_mesh_geometric_dimension_set(value.internal(), geometric_dimension);
+      viennagrid_mesh_vertex_batch_create(value.internal(), vertex_count, &coords[0], &first_vertex_id);
+
+
+      viennagrid_int region_count;
+      if (!in.read(region_count))
+        return false;
+      for (viennagrid_int i = 0; i != region_count; ++i)
+      {
+        viennagrid_int region_id;
+        std::string region_name;
+        if (!in.read(region_id) || !in.read_string(region_name))
+          return false;
+
+        RegionType region = value.get_or_create_region(region_id);
+        region.set_name(region_name);
+      }
+
+
+      for (viennagrid_int dimension = cell_dimension; dimension > 0; --dimension)
+      {
+        element_block block;
+        if (!block.read(in, vertex_count))
+          return false;
+        block.create(value, first_vertex_id);
+      }
+
+      return true;
+    }
+
+
+
+
+    template<typename DataT>
+    void write_data(binary_writer & out, data_handle<DataT> const & data)
+    {
+      out.write<viennagrid_int>(data.size());
+      for (int i = 0; i != data.size(); ++i)
+        write_value(out, data(i));
+    }
+
+    template<typename DataT>
+    bool read_data(binary_reader & in, data_handle<DataT> & data)
+    {
+      typedef typename data_handle<DataT>::CPPType CPPType;
+
+      viennagrid_int size;
+      if (!in.read(size) || size < 0)
+        return false;
+
+      data.resize(size);
+      for (int i = 0; i != size; ++i)
+      {
+        CPPType value = data(i);
+        if (!read_value(in, value))
+          return false;
+        data.set(i, value);
+      }
+
+      return true;
+    }
+
+    // meshes are filled in place, the data handle already owns an empty mesh
+    bool read_data(binary_reader & in, data_handle<viennagrid_mesh> & data)
+    {
+      viennagrid_int size;
+      if (!in.read(size) || size < 0)
+        return false;
+
+      data.resize(size);
+      for (int i = 0; i != size; ++i)
+      {
+        mesh value = data(i);
+        if (!read_value(in, value))
+          return false;
+      }
+
+      return true;
+    }
+
+
+    template<typename DataT>
+    bool cacheable(data_handle<DataT> const &)
+    {
+      return true;
+    }
+
+    // only the root mesh is written, meshes with child meshes would be restored incompletely
+    bool cacheable(data_handle<viennagrid_mesh> const & data)
+    {
+      for (int i = 0; i != data.size(); ++i)
+      {
+        viennagrid_int children_count;
+        viennagrid_mesh_children_count(data(i).internal(), &children_count);
+        if (children_count != 0)
+          return false;
+      }
+      return true;
+    }
+
+    template<typename DataT>
+    bool store_output(binary_writer & out, algorithm_handle & algorithm, std::string const & name)
+    {
+      data_handle<DataT> data = algorithm.get_output<DataT>(name);
+      if (!cacheable(data))
+        return false;
+
+      write_data(out, data);
+      return true;
+    }
+
+    template<typename DataT>
+    bool load_output(binary_reader & in, algorithm_handle & algorithm, std::string const & name)
+    {
+      data_handle<DataT> data = algorithm.context().make_data<DataT>();
+      if (!read_data(in, data))
+        return false;
+
+      algorithm.set_output(name, data);
+      return true;
+    }
+
+
+    bool store_output(binary_writer & out, algorithm_handle & algorithm,
+                      std::string const & name, std::string const & type_name)
+    {
+      if (type_name == result_of::data_information<bool>::type_name())
+        return store_output<bool>(out, algorithm, name);
+      if (type_name == result_of::data_information<int>::type_name())
+        return store_output<int>(out, algorithm, name);
+      if (type_name == result_of::data_information<double>::type_name())
+        return store_output<double>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_string>::type_name())
+        return store_output<viennamesh_string>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_point>::type_name())
+        return store_output<viennamesh_point>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_seed_point>::type_name())
+        return store_output<viennamesh_seed_point>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_point_cloud>::type_name())
+        return store_output<viennamesh_point_cloud>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennagrid_quantity_field>::type_name())
+        return store_output<viennagrid_quantity_field>(out, algorithm, name);
+      if (type_name == result_of::data_information<viennagrid_mesh>::type_name())
+        return store_output<viennagrid_mesh>(out, algorithm, name);
+
+      return false;
+    }
+
+    bool load_output(binary_reader & in, algorithm_handle & algorithm,
+                     std::string const & name, std::string const & type_name)
+    {
+      if (type_name == result_of::data_information<bool>::type_name())
+        return load_output<bool>(in, algorithm, name);
+      if (type_name == result_of::data_information<int>::type_name())
+        return load_output<int>(in, algorithm, name);
+      if (type_name == result_of::data_information<double>::type_name())
+        return load_output<double>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_string>::type_name())
+        return load_output<viennamesh_string>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_point>::type_name())
+        return load_output<viennamesh_point>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_seed_point>::type_name())
+        return load_output<viennamesh_seed_point>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennamesh_point_cloud>::type_name())
+        return load_output<viennamesh_point_cloud>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennagrid_quantity_field>::type_name())
+        return load_output<viennagrid_quantity_field>(in, algorithm, name);
+      if (type_name == result_of::data_information<viennagrid_mesh>::type_name())
+        return load_output<viennagrid_mesh>(in, algorithm, name);
+
+      return false;
+    }
+
+
+
+    std::size_t file_size(std::string const & filename)
+    {
+      struct stat st;
+      if (stat(filename.c_str(), &st) != 0)
+        return 0;
+      return st.st_size;
+    }
+
+    void make_directories(std::string const & path)
+    {
+      for (std::string::size_type pos = path.find('/', 1); pos != std::string::npos; pos = path.find('/', pos+1))
+        mkdir(path.substr(0, pos).c_str(), 0755);
+      mkdir(path.c_str(), 0755);
+    }
+
+    struct cache_entry
+    {
+      std::string filename;
+      std::size_t size;
+      time_t last_access;
+
+      bool operator<(cache_entry const & rhs) const { return last_access < rhs.last_access; }
+    };
+  }
+
+
+
+
+  algorithm_cache::algorithm_cache(std::string const & directory_in, std::size_t max_size_in) :
+      directory_(directory_in), max_size_(max_size_in)
+  {
+    if (directory_.size() > 1 && directory_[directory_.size()-1] == '/')
+      directory_.erase(directory_.size()-1);
+
+    make_directories(directory_);
+  }
+
+  std::string algorithm_cache::filename(std::string const & key) const
+  {
+    return directory_ + "/" + key + cache_file_extension;
+  }
+
+
+  bool algorithm_cache::load(std::string const & key, algorithm_handle & algorithm)
+  {
+    std::string cache_filename = filename(key);
+    std::ifstream file(cache_filename.c_str(), std::ios::binary);
+    if (!file)
+    {
+      ++statistics_.misses;
+      return false;
+    }
+
+    binary_reader in(file);
+
+    char magic[sizeof(cache_file_magic)];
+    viennagrid_int output_count;
+    bool success = in.read_array(magic, sizeof(magic)) &&
+                   std::equal(magic, magic+sizeof(magic), cache_file_magic) &&
+                   in.read(output_count);
+
+    for (viennagrid_int i = 0; success && i != output_count; ++i)
+    {
+      std::string name;
+      std::string type_name;
+      success = in.read_string(name) && in.read_string(type_name) &&
+                load_output(in, algorithm, name, type_name);
+    }
+
+    if (!success)
+    {
+      warning(1) << "Cache entry \"" << cache_filename << "\" is corrupt -> removing" << std::endl;
+      file.close();
+      std::remove(cache_filename.c_str());
+      algorithm.clear_outputs();
+      ++statistics_.misses;
+      return false;
+    }
+
+    // update the access time, eviction removes least recently used entries first
+    utime(cache_filename.c_str(), NULL);
+
+    ++statistics_.hits;
+    statistics_.bytes_read += file_size(cache_filename);
+    return true;
+  }
+
+
+  bool algorithm_cache::store(std::string const & key, algorithm_handle & algorithm)
+  {
+    std::string cache_filename = filename(key);
+    // caches of concurrent pipelines may share the directory, every writer uses its own temporary file
+    std::string tmp_filename = cache_filename + "." + boost::lexical_cast<std::string>(getpid()) + "_" + boost::lexical_cast<std::string>(this) + ".tmp";
+
+    bool success;
+    {
+      std::ofstream file(tmp_filename.c_str(), std::ios::binary);
+      binary_writer out(file);
+
+      int output_count = algorithm.output_count();
+      out.write_array(cache_file_magic, sizeof(cache_file_magic));
+      out.write<viennagrid_int>(output_count);
+
+      success = file.good();
+      for (int i = 0; success && i != output_count; ++i)
+      {
+        std::string name = algorithm.output_name(i);
+        std::string type_name = algorithm.get_output(name).type_name();
+
+        out.write_string(name);
+        out.write_string(type_name);
+        if (!store_output(out, algorithm, name, type_name))
+        {
+          info(5) << "Output \"" << name << "\" of type \"" << type_name << "\" cannot be cached" << std::endl;
+          success = false;
+        }
+      }
+
+      success = success && out.good();
+    }
+
+    // write to a temporary file first so that an interrupted run never leaves a partial entry behind
+    if (!success || std::rename(tmp_filename.c_str(), cache_filename.c_str()) != 0)
+    {
+      std::remove(tmp_filename.c_str());
+      ++statistics_.skipped_stores;
+      return false;
+    }
+
+    ++statistics_.stores;
+    statistics_.bytes_written += file_size(cache_filename);
+
+    evict();
+    return true;
+  }
+
+
+  void algorithm_cache::evict()
+  {
+    DIR * dir = opendir(directory_.c_str());
+    if (!dir)
+      return;
+
+    std::vector<cache_entry> entries;
+    std::size_t total_size = 0;
+
+    struct dirent * ent;
+    while ((ent = readdir(dir)) != NULL)
+    {
+      std::string name = ent->d_name;
+      if ( (name.size() <= cache_file_extension.size()) ||
+           (name.compare(name.size()-cache_file_extension.size(), cache_file_extension.size(), cache_file_extension) != 0) )
+        continue;
+
+      cache_entry entry;
+      entry.filename = directory_ + "/" + name;
+
+      struct stat st;
+      if (stat(entry.filename.c_str(), &st) != 0)
+        continue;
+
+      entry.size = st.st_size;
+      entry.last_access = st.st_mtime;
+      total_size += entry.size;
+      entries.push_back(entry);
+    }
+    closedir(dir);
+
+    if (total_size <= max_size_)
+      return;
+
+    std::sort(entries.begin(), entries.end());
+    for (std::size_t i = 0; i != entries.size() && total_size > max_size_; ++i)
+    {
+      if (std::remove(entries[i].filename.c_str()) == 0)
+      {
+        total_size -= entries[i].size;
+        ++statistics_.evictions;
+      }
+    }
+  }
+
+
+  void algorithm_cache::log_statistics() const
+  {
+    info(1) << "Algorithm cache \"" << directory_ << "\"" << std::endl;
+    info(1) << "  hits = " << statistics_.hits.load() << ", misses = " << statistics_.misses.load() << std::endl;
+    info(1) << "  stored entries = " << statistics_.stores.load() << ", not cacheable = " << statistics_.skipped_stores.load()
+            << ", evicted entries = " << statistics_.evictions.load() << std::endl;
+    info(1) << "  bytes read = " << statistics_.bytes_read.load() << ", bytes written = " << statistics_.bytes_written.load() << std::endl;
+  }
+
+}
@@ -13,7 +13,12 @@
 =============================================================================== */
 
 #include <list>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
 #include <boost/config/posix_features.hpp>
+#include "boost/algorithm/string.hpp"
 #include "viennameshpp/algorithm_pipeline.hpp"
 
 namespace viennamesh
@@ -122,6 +127,304 @@ namespace viennamesh
 
 
 
+  std::string sweep_value_string( double value, int precision )
+  {
+    std::ostringstream ss;
+    ss.precision(precision);
+    ss << value;
+    return ss.str();
+  }
+
+  bool parse_integer( std::string const & str, long long & value )
+  {
+    try
+    {
+      value = boost::lexical_cast<long long>( boost::algorithm::trim_copy(str) );
+      return true;
+    }
+    catch (boost::bad_lexical_cast const &)
+    {
+      return false;
+    }
+  }
+
+  bool sweep_parameter_values( pugi::xml_node const & parameter_node, std::string const & name, std::vector<std::string> & values )
+  {
+    pugi::xml_attribute values_attribute = parameter_node.attribute("values");
+    if ( !values_attribute.empty() )
+    {
+      std::list<std::string> tokens = split_string_brackets( values_attribute.as_string(), "," );
+      for (std::list<std::string>::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+        values.push_back( boost::algorithm::trim_copy(*it) );
+      return true;
+    }
+
+    pugi::xml_attribute from_attribute = parameter_node.attribute("from");
+    pugi::xml_attribute to_attribute = parameter_node.attribute("to");
+    pugi::xml_attribute step_attribute = parameter_node.attribute("step");
+    if ( from_attribute.empty() || to_attribute.empty() || step_attribute.empty() )
+    {
+      error(1) << "Sweep parameter \"" << name << "\" has neither values nor from, to and step attributes" << std::endl;
+      return false;
+    }
+
+    // integer ranges are generated exactly
+    long long int_from, int_to, int_step;
+    if ( parse_integer(from_attribute.as_string(), int_from) && parse_integer(to_attribute.as_string(), int_to) &&
+         parse_integer(step_attribute.as_string(), int_step) )
+    {
+      if ( int_step == 0 || (int_to - int_from) * (int_step > 0 ? 1 : -1) < 0 )
+      {
+        error(1) << "Sweep parameter \"" << name << "\": step " << int_step << " does not lead from " << int_from << " to " << int_to << std::endl;
+        return false;
+      }
+
+      for (long long i = 0; i <= (int_to - int_from) / int_step; ++i)
+        values.push_back( boost::lexical_cast<std::string>(int_from + i*int_step) );
+      return true;
+    }
+
+    double from = boost::lexical_cast<double>( from_attribute.as_string() );
+    double to = boost::lexical_cast<double>( to_attribute.as_string() );
+    double step = boost::lexical_cast<double>( step_attribute.as_string() );
+    if ( step == 0.0 || (to - from) / step < 0.0 )
+    {
+      error(1) << "Sweep parameter \"" << name << "\": step " << step << " does not lead from " << from << " to " << to << std::endl;
+      return false;
+    }
+
+    // values are computed from the index to avoid accumulating rounding errors, to is included
+    int count = static_cast<int>( std::floor( (to - from) / step + 1e-9 ) ) + 1;
+
+    std::vector<std::string> range_values(count);
+    for (int i = 0; i != count; ++i)
+      range_values[i] = sweep_value_string(from + i*step, std::numeric_limits<double>::digits10);
+
+    // digits10 hides the rounding noise of from + i*step, if that merges neighbouring values
+    // all digits which identify a double are used
+    if ( std::adjacent_find(range_values.begin(), range_values.end()) != range_values.end() )
+    {
+      for (int i = 0; i != count; ++i)
+        range_values[i] = sweep_value_string(from + i*step, std::numeric_limits<double>::max_digits10);
+    }
+
+    values.insert( values.end(), range_values.begin(), range_values.end() );
+    return true;
+  }
+
+  bool expand_sweep( pugi::xml_node const & xml, std::vector< std::map<std::string, std::string> > & variants )
+  {
+    variants.clear();
+
+    pugi::xml_node sweep_node = xml.child("sweep");
+    if (!sweep_node)
+      return true;
+
+    std::string mode = sweep_node.attribute("mode").empty() ? "cartesian" : sweep_node.attribute("mode").as_string();
+    if (mode != "cartesian" && mode != "zip")
+    {
+      error(1) << "Sweep mode \"" << mode << "\" is not supported, use \"cartesian\" or \"zip\"" << std::endl;
+      return false;
+    }
+
+    std::vector<std::string> names;
+    std::vector< std::vector<std::string> > values;
+    for (pugi::xml_node parameter_node = sweep_node.child("parameter");
+          parameter_node;
+          parameter_node = parameter_node.next_sibling("parameter"))
+    {
+      pugi::xml_attribute name_attribute = parameter_node.attribute("name");
+      if (name_attribute.empty())
+      {
+        error(1) << "Sweep parameter has no name attribute" << std::endl;
+        return false;
+      }
+
+      names.push_back( name_attribute.as_string() );
+      values.push_back( std::vector<std::string>() );
+      if (!sweep_parameter_values( parameter_node, names.back(), values.back() ))
+        return false;
+
+      if (values.back().empty())
+      {
+        error(1) << "Sweep parameter \"" << names.back() << "\" has no values" << std::endl;
+        return false;
+      }
+
+      if (mode == "zip" && values.back().size() != values.front().size())
+      {
+        error(1) << "Sweep parameter \"" << names.back() << "\" has " << values.back().size() << " values, zipped parameters need "
+                 << values.front().size() << " values like \"" << names.front() << "\"" << std::endl;
+        return false;
+      }
+    }
+
+    if (names.empty())
+    {
+      error(1) << "Sweep has no parameters" << std::endl;
+      return false;
+    }
+
+    std::size_t variant_count = 1;
+    if (mode == "zip")
+      variant_count = values.front().size();
+    else
+    {
+      for (std::size_t i = 0; i != values.size(); ++i)
+        variant_count *= values[i].size();
+    }
+
+    for (std::size_t v = 0; v != variant_count; ++v)
+    {
+      std::map<std::string, std::string> variant;
+      std::string variant_name;
+
+      // in cartesian mode the last parameter varies fastest
+      std::size_t index = v;
+      std::vector<std::size_t> value_indices(names.size(), v);
+      if (mode == "cartesian")
+      {
+        for (std::size_t i = names.size(); i-- != 0;)
+        {
+          value_indices[i] = index % values[i].size();
+          index /= values[i].size();
+        }
+      }
+
+      for (std::size_t i = 0; i != names.size(); ++i)
+      {
+        std::string const & value = values[i][ value_indices[i] ];
+        variant[ names[i] ] = value;
+
+        if (!variant_name.empty())
+          variant_name += "_";
+        variant_name += names[i] + "-" + value;
+      }
+
+      variant["sweep_variant"] = boost::lexical_cast<std::string>(v);
+      variant["sweep_name"] = variant_name;
+      variants.push_back(variant);
+    }
+
+    return true;
+  }
+
+
+
+
+  // meshes and quantity fields are copied, all other data types are not modified after creation
+  abstract_data_handle copy_shared_output( context_handle & context, abstract_data_handle const & data )
+  {
+    if ( data.is_type<viennagrid_mesh>() )
+    {
+      data_handle<viennagrid_mesh> src(data.internal());
+      data_handle<viennagrid_mesh> dst = context.make_data<viennagrid_mesh>();
+      dst.resize( src.size() );
+      for (int i = 0; i != src.size(); ++i)
+        viennagrid::copy( src(i), dst(i) );
+      return dst;
+    }
+
+    if ( data.is_type<viennagrid_quantity_field>() )
+    {
+      data_handle<viennagrid_quantity_field> src(data.internal());
+      data_handle<viennagrid_quantity_field> dst = context.make_data<viennagrid_quantity_field>();
+      dst.resize( src.size() );
+      for (int i = 0; i != src.size(); ++i)
+      {
+        viennagrid::quantity_field field = src(i);
+        viennagrid::quantity_field field_copy(field.topologic_dimension(), field.values_per_quantity(), field.storage_layout());
+        field_copy.set_name( field.get_name() );
+
+        for (viennagrid_int j = 0; j != static_cast<viennagrid_int>(field.size()); ++j)
+        {
+          if (!field.valid(j))
+            continue;
+
+          void * values;
+          viennagrid_quantity_field_value_get(field.internal(), j, &values);
+          viennagrid_quantity_field_value_set(field_copy.internal(), j, static_cast<viennagrid_numeric *>(values));
+        }
+
+        dst.set(i, field_copy);
+      }
+      return dst;
+    }
+
+    return data;
+  }
+
+
+  bool shared_pipeline_inputs::acquire(std::string const & key, algorithm_handle & algorithm)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+      std::map<std::string, entry>::iterator it = entries.find(key);
+
+      // nobody computes the outputs yet, the caller does
+      if (it == entries.end())
+      {
+        entries[key];
+        return false;
+      }
+
+      // every pipeline gets its own copy, the stored outputs are only read (with the lock held)
+      if (it->second.ready)
+      {
+        context_handle context = algorithm.context();
+        for (std::size_t i = 0; i != it->second.outputs.size(); ++i)
+          algorithm.set_output( it->second.outputs[i].first, copy_shared_output(context, it->second.outputs[i].second) );
+        ++hits_;
+        return true;
+      }
+
+      ready_condition.wait(lock);
+    }
+  }
+
+  void shared_pipeline_inputs::store(std::string const & key, algorithm_handle & algorithm)
+  {
+    // the computing pipeline keeps using its outputs, other pipelines get copies of a private snapshot
+    context_handle context = algorithm.context();
+    std::vector< std::pair<std::string, abstract_data_handle> > outputs;
+    for (int i = 0; i != algorithm.output_count(); ++i)
+    {
+      std::string name = algorithm.output_name(i);
+      outputs.push_back( std::make_pair(name, copy_shared_output(context, algorithm.get_output(name))) );
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entry & e = entries[key];
+      e.outputs.swap(outputs);
+      e.ready = true;
+    }
+
+    ready_condition.notify_all();
+  }
+
+  void shared_pipeline_inputs::abandon(std::string const & key)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entries.erase(key);
+    }
+
+    // one of the waiting pipelines computes the outputs instead
+    ready_condition.notify_all();
+  }
+
+  std::size_t shared_pipeline_inputs::hits() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits_;
+  }
+
+
+
+
   bool algorithm_pipeline::add_algorithm( pugi::xml_node const & algorithm_node )
   {
     pugi::xml_attribute algorithm_name_attribute = algorithm_node.attribute("name");
@@ -189,6 +492,14 @@ namespace viennamesh
       return false;
     }
 
+    {
+      pugi::xml_attribute algorithm_cache_attribute = algorithm_node.attribute("cache");
+      if ( !algorithm_cache_attribute.empty() )
+        pipeline_element.cacheable = algorithm_cache_attribute.as_bool();
+    }
+
+    pipeline_element.cache_signature = "type=" + algorithm_type + ";";
+
 
     pugi::xml_node default_source_algorithm_node = algorithm_node.child("default_source");
     if (default_source_algorithm_node)
@@ -200,6 +511,7 @@ namespace viennamesh
         return false;
 
       algorithm.set_default_source( default_source_element->algorithm );
+      pipeline_element.cache_signature += "default_source;";
       ++(default_source_element->reference_count);
       pipeline_element.referenced_elements.push_back( default_source_element );
     }
@@ -227,6 +539,8 @@ namespace viennamesh
       std::string parameter_type = parameter_type_attribute.as_string();
       std::string parameter_value = paramater_node.text().as_string();
 
+      pipeline_element.cache_signature += parameter_name + ":" + parameter_type + "=" + parameter_value + ";";
+
 
       if (parameter_type == "xml")
       {
@@ -236,6 +550,7 @@ namespace viennamesh
           child.print(ss);
 
         algorithm.set_input( parameter_name, ss.str() );
+        pipeline_element.cache_signature += ss.str() + ";";
       }
       else
       {
@@ -248,6 +563,7 @@ namespace viennamesh
         if (parameter_type == "string")
         {
           algorithm.push_back_input( parameter_name, parameter_value );
+          pipeline_element.cache_input_files.push_back( parameter_value );
         }
         else if (parameter_type == "bool")
         {
@@ -278,6 +594,30 @@ namespace viennamesh
 
           algorithm.set_input( parameter_name, point_handle );
         }
+        else if (parameter_type == "point_cloud")
+        {
+          // same syntax as "points", but stored as one point cloud with contiguous coordinates
+          std::list<std::string> split_mappings = split_string_brackets( parameter_value, "," );
+          point_cloud cloud;
+          int index = 0;
+          for (std::list<std::string>::const_iterator sit = split_mappings.begin();
+                                                      sit != split_mappings.end();
+                                                    ++sit, ++index)
+          {
+            point p = boost::lexical_cast<point>(*sit);
+            if (index == 0)
+              cloud.resize( p.size(), split_mappings.size() );
+            else if (static_cast<int>(p.size()) != cloud.dimension())
+            {
+              error(1) << "Parameter \"" << parameter_name << "\": point " << index << " has dimension " << p.size()
+                       << ", expected " << cloud.dimension() << std::endl;
+              return false;
+            }
+            cloud.set_point(index, p);
+          }
+
+          algorithm.set_input( parameter_name, context.make_data<point_cloud>(cloud) );
+        }
         else if (parameter_type == "seed_point")
         {
           std::list<std::string> split_mappings = split_string_brackets( parameter_value, ";" );
@@ -326,6 +666,41 @@ namespace viennamesh
   }
 
 
+  bool algorithm_pipeline::add_statistic( pugi::xml_node const & statistic_node )
+  {
+    pugi::xml_attribute name_attribute = statistic_node.attribute("name");
+    pugi::xml_attribute source_attribute = statistic_node.attribute("source");
+    if ( name_attribute.empty() || source_attribute.empty() )
+    {
+      error(1) << "Statistic needs a name and a source attribute" << std::endl;
+      return false;
+    }
+
+    std::string source = source_attribute.as_string();
+    std::string::size_type slash = source.find("/");
+    if (slash == std::string::npos)
+    {
+      error(1) << "Statistic \"" << name_attribute.as_string() << "\": source \"" << source << "\" is not of the form algorithm/output" << std::endl;
+      return false;
+    }
+
+    algorithm_pipeline_statistic statistic;
+    statistic.name = name_attribute.as_string();
+    statistic.algorithm_name = source.substr(0, slash);
+    statistic.output_name = source.substr(slash+1);
+
+    algorithm_pipeline_element * element = get_element( statistic.algorithm_name );
+    if (!element)
+      return false;
+
+    // the algorithm has to be kept until the statistics are collected
+    ++(element->reference_count);
+
+    statistics_.push_back(statistic);
+    return true;
+  }
+
+
   bool algorithm_pipeline::from_xml( pugi::xml_node const & xml )
   {
     for (pugi::xml_node algorithm_node = xml.child("algorithm");
@@ -339,9 +714,56 @@ namespace viennamesh
       }
     }
 
+    for (pugi::xml_node statistic_node = xml.child("statistic");
+          statistic_node;
+          statistic_node = statistic_node.next_sibling("statistic"))
+    {
+      if (!add_statistic( statistic_node ))
+      {
+        clear();
+        return false;
+      }
+    }
+
     return true;
   }
 
+
+  std::vector< std::pair<std::string, std::string> > algorithm_pipeline::statistics()
+  {
+    std::vector< std::pair<std::string, std::string> > result;
+
+    for (std::size_t i = 0; i != statistics_.size(); ++i)
+    {
+      algorithm_pipeline_statistic const & statistic = statistics_[i];
+      std::string value;
+
+      algorithm_pipeline_element * element = get_element( statistic.algorithm_name );
+      abstract_data_handle output;
+      if (element)
+        output = element->algorithm.get_output( statistic.output_name );
+
+      if (!output.valid())
+        value = "-";
+      else if (output.is_type<int>())
+        value = boost::lexical_cast<std::string>( element->algorithm.get_output<int>(statistic.output_name)() );
+      else if (output.is_type<double>())
+        value = boost::lexical_cast<std::string>( element->algorithm.get_output<double>(statistic.output_name)() );
+      else if (output.is_type<bool>())
+        value = element->algorithm.get_output<bool>(statistic.output_name)() ? "true" : "false";
+      else if (output.is_type<viennamesh_string>())
+        value = element->algorithm.get_output<viennamesh_string>(statistic.output_name)();
+      else if (output.is_type<viennagrid_mesh>())
+        value = boost::lexical_cast<std::string>( viennagrid::cells( element->algorithm.get_output<viennagrid_mesh>(statistic.output_name)() ).size() );
+      else
+        value = output.type_name();
+
+      result.push_back( std::make_pair(statistic.name, value) );
+    }
+
+    return result;
+  }
+
   bool algorithm_pipeline::run(bool cleanup_after_algorithm_step)
   {
     for (std::list<algorithm_pipeline_element>::iterator it = algorithms.begin(); it != algorithms.end(); ++it)
@@ -357,8 +779,43 @@ namespace viennamesh
         stack_name += " (type = \"" + pe.algorithm.type() + "\")";
 
         viennamesh::LoggingStack stack(stack_name);
-        if (!pe.algorithm.run())
-          return false;
+        viennamesh::profiling_span span(pe.name.empty() ? pe.algorithm.type() : pe.name, "pipeline_step");
+
+        bool has_cache_key = (cache_ || shared_inputs_) && pe.cacheable && make_cache_key(pe);
+        bool shared = has_cache_key && shared_inputs_ && (share_intermediate_ || pe.referenced_elements.empty());
+
+        if (shared && shared_inputs_->acquire(pe.cache_key, pe.algorithm))
+        {
+          info(1) << "Using outputs shared with other pipelines (key = " << pe.cache_key << ")" << std::endl;
+          span.add("source", "shared");
+        }
+        else
+        {
+          // algorithm failures are reported by exceptions, pipelines waiting for the shared outputs
+          // have to be released in any case
+          bool success = false;
+          try
+          {
+            success = run_element(pe, has_cache_key);
+          }
+          catch (...)
+          {
+            if (shared)
+              shared_inputs_->abandon(pe.cache_key);
+            throw;
+          }
+
+          if (shared)
+          {
+            if (success)
+              shared_inputs_->store(pe.cache_key, pe.algorithm);
+            else
+              shared_inputs_->abandon(pe.cache_key);
+          }
+
+          if (!success)
+            return false;
+        }
       }
 
       if (cleanup_after_algorithm_step)
@@ -383,12 +840,38 @@ namespace viennamesh
       pe.change_log_levels();
     }
 
+    if (cache_)
+      cache_->log_statistics();
+
+    return true;
+  }
+
+  bool algorithm_pipeline::run_element(algorithm_pipeline_element & pe, bool has_cache_key)
+  {
+    if (!cache_ || !has_cache_key)
+      return pe.algorithm.run();
+
+    if (cache_->load(pe.cache_key, pe.algorithm))
+    {
+      info(1) << "Using cached outputs (key = " << pe.cache_key << ")" << std::endl;
+      viennamesh_profiling_span_add_argument("source", "cache");
+      return true;
+    }
+
+    if (!pe.algorithm.run())
+      return false;
+
+    // algorithms without outputs (e.g. writers) are only run for their side effects
+    if (pe.algorithm.output_count() > 0)
+      cache_->store(pe.cache_key, pe.algorithm);
+
     return true;
   }
 
   void algorithm_pipeline::clear()
   {
     algorithms.clear();
+    statistics_.clear();
   }
 
 
@@ -399,6 +882,51 @@ namespace viennamesh
   }
 
 
+  void algorithm_pipeline::enable_cache( std::string const & directory, std::size_t max_size )
+  {
+    cache_.reset( new algorithm_cache(directory, max_size) );
+  }
+
+  void algorithm_pipeline::disable_cache()
+  {
+    cache_.reset();
+  }
+
+
+  bool algorithm_pipeline::make_cache_key(algorithm_pipeline_element & element)
+  {
+    element.cache_key.clear();
+
+    cache_key_builder key;
+    key.add( element.cache_signature );
+
+    // a rebuilt plugin or library must not reuse results of the previous build
+    key.add( element.algorithm.build_id() );
+
+    // upstream results are identified by their own keys, results of uncached algorithms can't be identified
+    for (std::size_t i = 0; i != element.referenced_elements.size(); ++i)
+    {
+      if (element.referenced_elements[i]->cache_key.empty())
+        return false;
+      key.add( element.referenced_elements[i]->cache_key );
+    }
+
+    // string parameters naming existing files (e.g. input meshes) contribute with the file content
+    std::string path = element.algorithm.base_path();
+    for (std::size_t i = 0; i != element.cache_input_files.size(); ++i)
+    {
+      std::string const & filename = element.cache_input_files[i];
+      if (!path.empty() && !filename.empty() && filename[0] != '/')
+        key.add_file_content( path + "/" + filename );
+      else
+        key.add_file_content( filename );
+    }
+
+    element.cache_key = key.str();
+    return true;
+  }
+
+
   algorithm_pipeline_element * algorithm_pipeline::get_element(std::string const & algorithm_name)
   {
     algorithm_pipeline_element * result = 0;
@@ -5,6 +5,96 @@
 
 namespace viennamesh
 {
+  namespace
+  {
+    // gathers a container of points into one point cloud, points of lower dimension are padded with zeros
+    viennamesh_error convert_points_to_point_cloud(viennamesh_data_wrapper from, viennamesh_data_wrapper to)
+    {
+      int point_count;
+      viennamesh_error err = viennamesh_data_wrapper_get_size(from, &point_count);
+      if (err != VIENNAMESH_SUCCESS)
+        return err;
+
+      std::vector<viennamesh_point> points(point_count);
+      int dimension = 0;
+      for (int i = 0; i != point_count; ++i)
+      {
+        viennamesh_point * point_ptr;
+        if ((err = viennamesh_data_wrapper_internal_get(from, i, (viennamesh_data*)&point_ptr)) != VIENNAMESH_SUCCESS)
+          return err;
+        points[i] = *point_ptr;
+
+        viennagrid_numeric * values;
+        int size;
+        viennamesh_point_get(points[i], &values, &size);
+        dimension = std::max(dimension, size);
+      }
+
+      viennamesh_point_cloud * cloud_ptr;
+      if ((err = viennamesh_data_wrapper_resize(to, 1)) != VIENNAMESH_SUCCESS ||
+          (err = viennamesh_data_wrapper_internal_get(to, 0, (viennamesh_data*)&cloud_ptr)) != VIENNAMESH_SUCCESS ||
+          (err = viennamesh_point_cloud_resize(*cloud_ptr, dimension, point_count)) != VIENNAMESH_SUCCESS)
+        return err;
+
+      viennagrid_numeric * coords;
+      viennamesh_point_cloud_get(*cloud_ptr, NULL, NULL, &coords);
+      for (int i = 0; i != point_count; ++i)
+      {
+        viennagrid_numeric * values;
+        int size;
+        viennamesh_point_get(points[i], &values, &size);
+        std::copy(values, values + size, coords + i*dimension);
+      }
+
+      return VIENNAMESH_SUCCESS;
+    }
+
+    // scatters all points of all point clouds into one container of points
+    viennamesh_error convert_point_cloud_to_points(viennamesh_data_wrapper from, viennamesh_data_wrapper to)
+    {
+      int cloud_count;
+      viennamesh_error err = viennamesh_data_wrapper_get_size(from, &cloud_count);
+      if (err != VIENNAMESH_SUCCESS)
+        return err;
+
+      std::vector<viennamesh_point_cloud> clouds(cloud_count);
+      int point_count = 0;
+      for (int i = 0; i != cloud_count; ++i)
+      {
+        viennamesh_point_cloud * cloud_ptr;
+        if ((err = viennamesh_data_wrapper_internal_get(from, i, (viennamesh_data*)&cloud_ptr)) != VIENNAMESH_SUCCESS)
+          return err;
+        clouds[i] = *cloud_ptr;
+
+        int size;
+        viennamesh_point_cloud_get(clouds[i], NULL, &size, NULL);
+        point_count += size;
+      }
+
+      if ((err = viennamesh_data_wrapper_resize(to, point_count)) != VIENNAMESH_SUCCESS)
+        return err;
+
+      int index = 0;
+      for (int i = 0; i != cloud_count; ++i)
+      {
+        int dimension;
+        int size;
+        viennagrid_numeric * coords;
+        viennamesh_point_cloud_get(clouds[i], &dimension, &size, &coords);
+
+        for (int j = 0; j != size; ++j, ++index)
+        {
+          viennamesh_point * point_ptr;
+          if ((err = viennamesh_data_wrapper_internal_get(to, index, (viennamesh_data*)&point_ptr)) != VIENNAMESH_SUCCESS ||
+              (err = viennamesh_point_set(*point_ptr, coords + j*dimension, dimension)) != VIENNAMESH_SUCCESS)
+            return err;
+        }
+      }
+
+      return VIENNAMESH_SUCCESS;
+    }
+  }
+
 
   context_handle::context_handle() : ctx(0)
   {
@@ -19,12 +109,16 @@ namespace viennamesh
       register_data_type<viennamesh_string>();
       register_data_type<viennamesh_point>();
       register_data_type<viennamesh_seed_point>();
+      register_data_type<viennamesh_point_cloud>();
       register_data_type<viennagrid_quantity_field>();
       register_data_type<viennagrid_mesh>();
       register_data_type<viennagrid_plc>();
 
       register_conversion<int,double>();
       register_conversion<double,int>();
+
+      register_container_conversion<viennamesh_point, viennamesh_point_cloud>( convert_points_to_point_cloud );
+      register_container_conversion<viennamesh_point_cloud, viennamesh_point>( convert_point_cloud_to_points );
     }
 
     load_plugins_in_directories(VIENNAMESH_DEFAULT_PLUGIN_DIRECTORY, ";");
@@ -64,6 +158,15 @@ namespace viennamesh
       ctx);
   }
 
+  void context_handle::register_container_conversion(std::string const & data_type_from,
+                                                     std::string const & data_type_to,
+                                                     viennamesh_data_container_convert_function convert_function)
+  {
+    handle_error(
+      viennamesh_data_container_conversion_register(ctx, data_type_from.c_str(), data_type_to.c_str(), convert_function),
+      ctx);
+  }
+
   void context_handle::register_algorithm(std::string const & algorithm_name,
                                           viennamesh_algorithm_make_function make_function,
                                           viennamesh_algorithm_delete_function delete_function,
@@ -143,6 +143,21 @@ namespace viennamesh
   }
 
 
+  // viennamesh::point_cloud
+  point_cloud to_cpp(viennamesh_point_cloud & src)
+  {
+    return point_cloud(src);
+  }
+
+  void to_c(point_cloud const & src, viennamesh_point_cloud & dst)
+  {
+    // retain first, src and dst might be the same point cloud
+    viennamesh_point_cloud_retain(src.internal());
+    viennamesh_point_cloud_release(dst);
+    dst = src.internal();
+  }
+
+
   // std::string
   std::string to_cpp(viennamesh_string & src)
   {
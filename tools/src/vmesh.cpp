@@ -12,14 +12,324 @@
    License:         MIT (X11), see file LICENSE in the base directory
 =============================================================================== */
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
 #include "viennameshpp/algorithm_pipeline.hpp"
+#include "boost/algorithm/string.hpp"
 #include <tclap/CmdLine.h>
 
+
+// one pipeline run of a batch, a pipeline file with an optional row of parameter substitutions
+// and an optional variant of the parameter sweep declared in the pipeline
+struct pipeline_job
+{
+  pipeline_job() : substitution_row(-1), sweep_variant(-1), success(false), time(0.0) {}
+
+  std::string pipeline_filename;
+  int substitution_row;
+  int sweep_variant;
+  std::string sweep_name;
+  std::map<std::string, std::string> substitutions;
+
+  std::string log_filename;
+  bool success;
+  double time;
+  std::vector< std::pair<std::string, std::string> > statistics;
+};
+
+
+// Reads a table of parameter substitutions. The first line holds the parameter names, every
+// further line the values of one job. Columns are separated by commas, semicolons or whitespace,
+// empty lines and lines starting with '#' are ignored.
+bool read_substitution_table(std::string const & filename,
+                             std::vector< std::map<std::string, std::string> > & rows)
+{
+  std::ifstream file(filename.c_str());
+  if (!file)
+  {
+    viennamesh::error(1) << "Could not open substitution table \"" << filename << "\"" << std::endl;
+    return false;
+  }
+
+  std::vector<std::string> names;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(file, line))
+  {
+    ++line_number;
+    boost::algorithm::trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::vector<std::string> columns;
+    boost::algorithm::split( columns, line, boost::is_any_of(",; \t"), boost::token_compress_on );
+
+    if (names.empty())
+    {
+      names = columns;
+      continue;
+    }
+
+    if (columns.size() != names.size())
+    {
+      viennamesh::error(1) << "Substitution table \"" << filename << "\" line " << line_number << ": expected "
+                           << names.size() << " values, got " << columns.size() << std::endl;
+      return false;
+    }
+
+    std::map<std::string, std::string> row;
+    for (std::size_t i = 0; i != names.size(); ++i)
+      row[names[i]] = columns[i];
+    rows.push_back(row);
+  }
+
+  return true;
+}
+
+
+// replaces every ${name} in text by the value of name
+std::string substitute(std::string text, std::map<std::string, std::string> const & substitutions)
+{
+  for (std::map<std::string, std::string>::const_iterator it = substitutions.begin(); it != substitutions.end(); ++it)
+    boost::algorithm::replace_all( text, "${" + it->first + "}", it->second );
+  return text;
+}
+
+
+bool load_pipeline_xml(pipeline_job const & job, pugi::xml_document & pipeline_xml)
+{
+  pugi::xml_parse_result result;
+  if (job.substitutions.empty())
+    result = pipeline_xml.load_file( job.pipeline_filename.c_str() );
+  else
+  {
+    std::ifstream file(job.pipeline_filename.c_str());
+    std::stringstream ss;
+    ss << file.rdbuf();
+    if (!file)
+    {
+      viennamesh::error(1) << "Error loading XML file " << job.pipeline_filename << std::endl;
+      return false;
+    }
+
+    result = pipeline_xml.load_string( substitute(ss.str(), job.substitutions).c_str() );
+  }
+
+  if (!result)
+  {
+    viennamesh::error(1) << "Error loading or parsing XML file " << job.pipeline_filename << std::endl;
+    viennamesh::error(1) << "XML error: " << result.description() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// parameter sweep variants declared in a pipeline file, empty if the pipeline has no sweep
+bool read_sweep_variants(std::string const & filename,
+                         std::vector< std::map<std::string, std::string> > & variants)
+{
+  pugi::xml_document pipeline_xml;
+  pugi::xml_parse_result result = pipeline_xml.load_file( filename.c_str() );
+  if (!result)
+  {
+    viennamesh::error(1) << "Error loading or parsing XML file " << filename << std::endl;
+    viennamesh::error(1) << "XML error: " << result.description() << std::endl;
+    return false;
+  }
+
+  return viennamesh::expand_sweep( pipeline_xml, variants );
+}
+
+
+bool run_pipeline(viennamesh::context_handle & context,
+                  pipeline_job & job,
+                  std::string const & cache_directory,
+                  std::size_t cache_size,
+                  boost::shared_ptr<viennamesh::shared_pipeline_inputs> const & shared_inputs)
+{
+  pugi::xml_document pipeline_xml;
+  if (!load_pipeline_xml(job, pipeline_xml))
+    return false;
+
+  viennamesh::algorithm_pipeline pipeline(context);
+
+  if (!pipeline.from_xml( pipeline_xml ))
+  {
+    viennamesh::error(1) << "Error loading creating pipeline from XML" << std::endl;
+    return false;
+  }
+
+  std::string path = viennamesh::extract_path( job.pipeline_filename );
+  if (!path.empty())
+    pipeline.set_base_path(path);
+
+  if ( !cache_directory.empty() )
+    pipeline.enable_cache( cache_directory, cache_size );
+
+  // variants of a sweep also share upstream results which do not depend on the swept parameters
+  if (shared_inputs)
+    pipeline.share_inputs( shared_inputs, job.sweep_variant >= 0 );
+
+  if (!pipeline.run( true ))
+    return false;
+
+  job.statistics = pipeline.statistics();
+  return true;
+}
+
+
+// one line per job with its parameters and statistics, columns separated by commas
+void write_summary(std::ostream & stream, std::vector<pipeline_job> const & jobs)
+{
+  std::vector<std::string> statistic_names;
+  for (std::size_t i = 0; i != jobs.size(); ++i)
+    for (std::size_t j = 0; j != jobs[i].statistics.size(); ++j)
+      if (std::find(statistic_names.begin(), statistic_names.end(), jobs[i].statistics[j].first) == statistic_names.end())
+        statistic_names.push_back( jobs[i].statistics[j].first );
+
+  stream << "job,pipeline,substitution_row,sweep_name,status,time";
+  for (std::size_t j = 0; j != statistic_names.size(); ++j)
+    stream << "," << statistic_names[j];
+  stream << std::endl;
+
+  for (std::size_t i = 0; i != jobs.size(); ++i)
+  {
+    pipeline_job const & job = jobs[i];
+    stream << i << "," << job.pipeline_filename << "," << job.substitution_row << "," << job.sweep_name << ","
+           << (job.success ? "succeeded" : "failed") << "," << job.time;
+
+    for (std::size_t j = 0; j != statistic_names.size(); ++j)
+    {
+      std::string value;
+      for (std::size_t k = 0; k != job.statistics.size(); ++k)
+        if (job.statistics[k].first == statistic_names[j])
+          value = job.statistics[k].second;
+      stream << "," << value;
+    }
+    stream << std::endl;
+  }
+}
+
+
+// Runs all jobs on one context with job_count concurrent jobs. Plugins are loaded once and
+// pipeline inputs with identical parameters and input files are only computed once.
+int run_batch(viennamesh::context_handle & context,
+              std::vector<pipeline_job> & jobs,
+              int job_count,
+              std::string const & cache_directory,
+              std::size_t cache_size,
+              std::string const & summary_filename)
+{
+  boost::shared_ptr<viennamesh::shared_pipeline_inputs> shared_inputs( new viennamesh::shared_pipeline_inputs() );
+
+  std::chrono::steady_clock::time_point batch_start = std::chrono::steady_clock::now();
+
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(job_count)
+  for (int i = 0; i < static_cast<int>(jobs.size()); ++i)
+  {
+    pipeline_job & job = jobs[i];
+
+    // every job logs into its own file, messages of other jobs are not written there
+    viennamesh_log_callback_handle log_handle;
+    viennamesh_log_add_thread_logging_file( job.log_filename.c_str(), &log_handle );
+
+    std::chrono::steady_clock::time_point job_start = std::chrono::steady_clock::now();
+    try
+    {
+      job.success = run_pipeline(context, job, cache_directory, cache_size, shared_inputs);
+    }
+    catch (std::exception const & ex)
+    {
+      viennamesh::error(1) << "Pipeline failed: " << ex.what() << std::endl;
+      job.success = false;
+    }
+    job.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - job_start).count();
+
+    // the error of this job is reported, drop the error state of this thread in the shared context
+    viennamesh_context_clear_error( context.internal() );
+    viennamesh_log_remove_logging_file( log_handle );
+  }
+
+  double batch_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+
+
+  int failed = 0;
+  double total_job_time = 0.0;
+  double max_job_time = 0.0;
+  for (std::size_t i = 0; i != jobs.size(); ++i)
+  {
+    pipeline_job const & job = jobs[i];
+
+    std::cout << "job " << i << ": " << job.pipeline_filename;
+    if (job.substitution_row >= 0)
+      std::cout << " (substitution row " << job.substitution_row << ")";
+    if (job.sweep_variant >= 0)
+      std::cout << " (sweep " << job.sweep_name << ")";
+    std::cout << " " << (job.success ? "succeeded" : "FAILED") << " in " << job.time << "s, log: " << job.log_filename << std::endl;
+
+    if (!job.success)
+      ++failed;
+    total_job_time += job.time;
+    max_job_time = std::max(max_job_time, job.time);
+  }
+
+  std::cout << std::endl;
+  std::cout << "Batch summary" << std::endl;
+  std::cout << "  jobs:                " << jobs.size() << " (" << jobs.size()-failed << " succeeded, " << failed << " failed)" << std::endl;
+  std::cout << "  concurrent jobs:     " << job_count << std::endl;
+  std::cout << "  wall time:           " << batch_time << "s" << std::endl;
+  std::cout << "  throughput:          " << (batch_time > 0.0 ? jobs.size() / batch_time : 0.0) << " jobs/s" << std::endl;
+  std::cout << "  average job time:    " << (jobs.empty() ? 0.0 : total_job_time / jobs.size()) << "s" << std::endl;
+  std::cout << "  maximum job time:    " << max_job_time << "s" << std::endl;
+  std::cout << "  shared input reuses: " << shared_inputs->hits() << std::endl;
+
+  bool has_statistics = false;
+  for (std::size_t i = 0; i != jobs.size(); ++i)
+    has_statistics = has_statistics || !jobs[i].statistics.empty();
+
+  if (has_statistics)
+  {
+    std::cout << std::endl;
+    std::cout << "Statistics" << std::endl;
+    write_summary(std::cout, jobs);
+  }
+
+  if (!summary_filename.empty())
+  {
+    std::ofstream summary_file( summary_filename.c_str() );
+    write_summary(summary_file, jobs);
+    if (summary_file)
+      viennamesh::info(1) << "Summary written to \"" << summary_filename << "\"" << std::endl;
+    else
+      viennamesh::error(1) << "Could not write summary to \"" << summary_filename << "\"" << std::endl;
+  }
+
+  return (failed == 0) ? 0 : 1;
+}
+
+
+void write_profile(std::string const & report_filename, std::string const & trace_filename)
+{
+  if (!report_filename.empty() && viennamesh::write_profiling_report(report_filename))
+    viennamesh::info(1) << "Profiling report written to \"" << report_filename << "\"" << std::endl;
+
+  if (!trace_filename.empty() && viennamesh::write_profiling_trace(trace_filename))
+    viennamesh::info(1) << "Profiling trace written to \"" << trace_filename << "\"" << std::endl;
+}
+
+
 int main(int argc, char **argv)
 {
   try
   {
-    TCLAP::CmdLine cmd("ViennaMesh VMesh application, reads and executes a pipeline", ' ', "1.0");
+    TCLAP::CmdLine cmd("ViennaMesh VMesh application, reads and executes one or more pipelines", ' ', "1.0");
 
     TCLAP::ValueArg<std::string> log_filename("l","logfile", "Log file name", false, "", "string");
     cmd.add( log_filename );
@@ -28,8 +338,35 @@ int main(int argc, char **argv)
     cmd.add( info_loglevel );
 
 
-    TCLAP::UnlabeledValueArg<std::string> pipeline_filename( "filename", "Pipeline file name", true, "", "PipelineFile"  );
-    cmd.add( pipeline_filename );
+    TCLAP::ValueArg<std::string> cache_directory("c","cache-dir", "Directory of the algorithm result cache, caching is disabled if not given", false, "", "string");
+    cmd.add( cache_directory );
+
+    TCLAP::ValueArg<int> cache_size("","cache-size", "Maximum size of the algorithm result cache in MiB (default is 4096)", false, 4096, "int");
+    cmd.add( cache_size );
+
+
+    TCLAP::ValueArg<int> job_count("j","jobs", "Number of pipelines run concurrently in batch mode (default is 1)", false, 1, "int");
+    cmd.add( job_count );
+
+    TCLAP::ValueArg<std::string> substitution_table("s","substitutions", "Table of parameter substitutions, every row runs each pipeline once with ${name} replaced by the values of the row", false, "", "string");
+    cmd.add( substitution_table );
+
+    TCLAP::ValueArg<std::string> summary_filename("","summary", "Write a table of all jobs with their parameters and statistics to this file in batch mode", false, "", "string");
+    cmd.add( summary_filename );
+
+    TCLAP::ValueArg<std::string> job_log_directory("","job-log-dir", "Directory of the per job log files in batch mode (default is the current directory)", false, ".", "string");
+    cmd.add( job_log_directory );
+
+
+    TCLAP::ValueArg<std::string> profile_report("","profile-json", "Profile all algorithm runs and write a JSON report with per algorithm times, memory and mesh sizes", false, "", "string");
+    cmd.add( profile_report );
+
+    TCLAP::ValueArg<std::string> profile_trace("","profile-trace", "Profile all algorithm runs and write a Chrome trace event file (viewable in chrome://tracing or Perfetto)", false, "", "string");
+    cmd.add( profile_trace );
+
+
+    TCLAP::UnlabeledMultiArg<std::string> pipeline_filenames( "filenames", "Pipeline file names, more than one pipeline runs in batch mode", true, "PipelineFiles" );
+    cmd.add( pipeline_filenames );
 
     cmd.parse( argc, argv );
 
@@ -38,32 +375,85 @@ int main(int argc, char **argv)
 
     viennamesh_log_set_info_level( info_loglevel.getValue() );
 
+    std::size_t cache_size_bytes = static_cast<std::size_t>(cache_size.getValue()) * 1024 * 1024;
+    std::vector<std::string> const & filenames = pipeline_filenames.getValue();
+
 
-    pugi::xml_document pipeline_xml;
-    pugi::xml_parse_result result = pipeline_xml.load_file( pipeline_filename.getValue().c_str() );
+    std::vector< std::map<std::string, std::string> > substitution_rows;
+    if ( !substitution_table.getValue().empty() && !read_substitution_table(substitution_table.getValue(), substitution_rows) )
+      return 1;
 
-    if (!result)
+    // pipelines with a <sweep> node run once per variant
+    std::vector< std::vector< std::map<std::string, std::string> > > sweep_variants( filenames.size() );
+    bool has_sweep = false;
+    for (std::size_t i = 0; i != filenames.size(); ++i)
     {
-      viennamesh::error(1) << "Error loading or parsing XML file " << pipeline_filename.getValue().c_str() << std::endl;
-      viennamesh::error(1) << "XML error: " << result.description() << std::endl;
-      return 0;
+      if (!read_sweep_variants(filenames[i], sweep_variants[i]))
+        return 1;
+      has_sweep = has_sweep || !sweep_variants[i].empty();
     }
 
+    bool batch = filenames.size() > 1 || !substitution_table.getValue().empty() || has_sweep;
+
+    bool profile = !profile_report.getValue().empty() || !profile_trace.getValue().empty();
+    if (profile)
+      viennamesh::enable_profiling();
+
     viennamesh::context_handle context;
 //     context.load_plugins_in_directory(VIENNAMESH_DEFAULT_PLUGIN_DIRECTORY);
-    viennamesh::algorithm_pipeline pipeline(context);
 
-    if (!pipeline.from_xml( pipeline_xml ))
+    if (!batch)
     {
-      viennamesh::error(1) << "Error loading creating pipeline from XML" << std::endl;
+      pipeline_job job;
+      job.pipeline_filename = filenames.front();
+      run_pipeline(context, job, cache_directory.getValue(), cache_size_bytes, boost::shared_ptr<viennamesh::shared_pipeline_inputs>());
+      write_profile(profile_report.getValue(), profile_trace.getValue());
       return 0;
     }
 
-    std::string path = viennamesh::extract_path( pipeline_filename.getValue() );
-    if (!path.empty())
-      pipeline.set_base_path(path);
 
-    pipeline.run( true );
+    std::vector<pipeline_job> jobs;
+    for (std::size_t i = 0; i != filenames.size(); ++i)
+    {
+      std::size_t row_count = substitution_rows.empty() ? 1 : substitution_rows.size();
+      std::size_t variant_count = sweep_variants[i].empty() ? 1 : sweep_variants[i].size();
+      for (std::size_t row = 0; row != row_count; ++row)
+      {
+        // variants of one row run next to each other, so they are likely to share upstream results early
+        for (std::size_t variant = 0; variant != variant_count; ++variant)
+        {
+          pipeline_job job;
+          job.pipeline_filename = filenames[i];
+          if (!substitution_rows.empty())
+          {
+            job.substitution_row = row;
+            job.substitutions = substitution_rows[row];
+          }
+
+          std::string basename = filenames[i].substr( filenames[i].find_last_of('/') + 1 );
+          job.log_filename = job_log_directory.getValue() + "/job_" + boost::lexical_cast<std::string>(jobs.size()) + "_" + basename;
+
+          // sweep values take precedence over values of the substitution table
+          if (!sweep_variants[i].empty())
+          {
+            std::map<std::string, std::string> const & values = sweep_variants[i][variant];
+            for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+              job.substitutions[it->first] = it->second;
+
+            job.sweep_variant = variant;
+            job.sweep_name = values.find("sweep_name")->second;
+            job.log_filename += "_" + job.sweep_name;
+          }
+
+          job.log_filename += ".log";
+          jobs.push_back(job);
+        }
+      }
+    }
+
+    int result = run_batch(context, jobs, std::max(1, job_count.getValue()), cache_directory.getValue(), cache_size_bytes, summary_filename.getValue());
+    write_profile(profile_report.getValue(), profile_trace.getValue());
+    return result;
   }
   catch (TCLAP::ArgException &e)  // catch any exceptions
   {